@@ -0,0 +1,101 @@
+//++
+// Allocations.cpp - counting global operator new and operator delete
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   If COUNT_ALLOCATIONS is defined, this module replaces the global operator
+// new and operator delete (all the plain, array and nothrow flavors) with ones
+// that count allocations.  Each block is allocated with a small header in
+// front of it that remembers the block size, so that operator delete knows
+// how many bytes are being freed.  The header is a full max_align_t so that
+// the block we return to the caller is still suitably aligned.
+//
+//   The over-aligned (std::align_val_t) flavors aren't replaced - nothing in
+// this program uses them, and the standard ones pair up with each other.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // malloc(), free(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stddef.h>             // max_align_t ...
+#include <new>                  // std::bad_alloc, std::nothrow_t ...
+#include "Allocations.hpp"      // declarations for this module
+
+// Initialize all the static members of CAllocations ...
+std::atomic<uint64_t> CAllocations::m_nCount(0);
+std::atomic<uint64_t> CAllocations::m_nBytes(0);
+std::atomic<uint64_t> CAllocations::m_nLiveBytes(0);
+std::atomic<uint64_t> CAllocations::m_nPeakBytes(0);
+
+
+#ifdef COUNT_ALLOCATIONS
+/*static*/ bool CAllocations::IsEnabled() {return true;}
+
+// Size of the header in front of every block ...
+#define HEADER_SIZE sizeof(max_align_t)
+
+
+static void *CountedAllocate (size_t nBytes) noexcept
+{
+  //++
+  //   Allocate a block with a header, remember the size in the header, count
+  // it, and return a pointer to the caller's part of the block.  Returns NULL
+  // if we're out of memory ...
+  //--
+  if (nBytes == 0) nBytes = 1;
+  uint8_t *p = (uint8_t *) malloc(nBytes + HEADER_SIZE);
+  if (p == NULL) return NULL;
+  *((size_t *) p) = nBytes;
+  CAllocations::Allocate(nBytes);
+  return p + HEADER_SIZE;
+}
+
+
+static void CountedFree (void *pBlock) noexcept
+{
+  //++
+  // The opposite of CountedAllocate() ...
+  //--
+  if (pBlock == NULL) return;
+  uint8_t *p = ((uint8_t *) pBlock) - HEADER_SIZE;
+  CAllocations::Free(*((size_t *) p));
+  free(p);
+}
+
+
+void *operator new (size_t nBytes)
+  {void *p = CountedAllocate(nBytes);  if (p == NULL) throw std::bad_alloc();  return p;}
+void *operator new[] (size_t nBytes)
+  {void *p = CountedAllocate(nBytes);  if (p == NULL) throw std::bad_alloc();  return p;}
+void *operator new (size_t nBytes, const std::nothrow_t &) noexcept
+  {return CountedAllocate(nBytes);}
+void *operator new[] (size_t nBytes, const std::nothrow_t &) noexcept
+  {return CountedAllocate(nBytes);}
+void operator delete (void *p) noexcept {CountedFree(p);}
+void operator delete[] (void *p) noexcept {CountedFree(p);}
+void operator delete (void *p, size_t) noexcept {CountedFree(p);}
+void operator delete[] (void *p, size_t) noexcept {CountedFree(p);}
+void operator delete (void *p, const std::nothrow_t &) noexcept {CountedFree(p);}
+void operator delete[] (void *p, const std::nothrow_t &) noexcept {CountedFree(p);}
+
+#else
+/*static*/ bool CAllocations::IsEnabled() {return false;}
+#endif
@@ -0,0 +1,93 @@
+//++
+// Allocations.hpp -> heap allocation accounting
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   When this program is built with COUNT_ALLOCATIONS defined, Allocations.cpp
+// replaces the global operator new and operator delete with versions that
+// count every allocation and every byte allocated.  The CAllocations class
+// gives the rest of the program access to those counts.  If COUNT_ALLOCATIONS
+// is not defined then the standard operators are used, IsEnabled() returns
+// false, and all the counts are always zero.
+//
+//   Besides the running totals we keep a high-water mark for the bytes in use.
+// ResetPeak() starts a new high-water mark from the current live bytes, and
+// that's how CMetrics attributes allocations to each phase of a run - it takes
+// a snapshot of the counts and resets the peak at the start of every phase,
+// and then the difference at the end of the phase belongs to that phase.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add the high-water mark for CMetrics.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <atomic>               // std::atomic ...
+using std::size_t;              // ...
+
+
+class CAllocations {
+  //++
+  //   Global heap allocation counters.  Note that this class is never
+  // instantiated - everything here is static ...
+  //--
+
+public:
+  CAllocations() = delete;
+
+  // CAllocations public properties ...
+public:
+  // Return true if allocation counting was compiled in ...
+  static bool IsEnabled();
+  // Return the total number of allocations and bytes allocated so far ...
+  static uint64_t GetCount() {return m_nCount.load(std::memory_order_relaxed);}
+  static uint64_t GetBytes() {return m_nBytes.load(std::memory_order_relaxed);}
+  // Return the number of bytes currently allocated ...
+  static uint64_t GetLiveBytes() {return m_nLiveBytes.load(std::memory_order_relaxed);}
+  // Return the most bytes allocated at any one time since ResetPeak() ...
+  static uint64_t GetPeakBytes() {return m_nPeakBytes.load(std::memory_order_relaxed);}
+
+  // CAllocations public methods ...
+public:
+  // Record one allocation or one free (called by operator new/delete) ...
+  static void Allocate (size_t nBytes)
+    {m_nCount.fetch_add(1, std::memory_order_relaxed);
+     m_nBytes.fetch_add(nBytes, std::memory_order_relaxed);
+     UpdatePeak(m_nLiveBytes.fetch_add(nBytes, std::memory_order_relaxed) + nBytes);}
+  static void Free (size_t nBytes)
+    {m_nLiveBytes.fetch_sub(nBytes, std::memory_order_relaxed);}
+  // Start a new high-water mark from the bytes currently allocated ...
+  static void ResetPeak()
+    {m_nPeakBytes.store(m_nLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);}
+
+  // Private internal CAllocations methods ...
+protected:
+  // Raise the high-water mark, if necessary ...
+  static void UpdatePeak (uint64_t nLive)
+    {uint64_t nPeak = m_nPeakBytes.load(std::memory_order_relaxed);
+     while ((nLive > nPeak) && !m_nPeakBytes.compare_exchange_weak(nPeak, nLive, std::memory_order_relaxed)) {}}
+
+  // Local CAllocations members ...
+protected:
+  static std::atomic<uint64_t> m_nCount;        // total allocations
+  static std::atomic<uint64_t> m_nBytes;        // total bytes allocated
+  static std::atomic<uint64_t> m_nLiveBytes;    // bytes currently allocated
+  static std::atomic<uint64_t> m_nPeakBytes;    // high-water mark for the same
+};
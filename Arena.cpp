@@ -0,0 +1,110 @@
+//++
+// Arena.cpp - implementation of the CArena class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CArena class, which allocates fixed size
+// objects from big chunks of memory.  See Arena.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   One arena per thread, and release chunks when it's empty.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stddef.h>             // NULL, size_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <new>                  // ::operator new(), ::operator delete() ...
+#include "Arena.hpp"            // declarations for this module
+
+
+void *CArena::Allocate (size_t nBytes)
+{
+  //++
+  //   Allocate one object.  Use a slot from the free list if there is one,
+  // otherwise the next slot in the current chunk, and if that chunk is full
+  // then get a new one from the heap.  The first slot of every chunk links
+  // it to the previous one, so that Release() can find them all ...
+  //--
+  if (!IsMine(nBytes)) return ::operator new(nBytes);
+  void *pObject;
+  if (m_pFree != NULL) {
+    pObject = m_pFree;  m_pFree = m_pFree->pNext;
+  } else {
+    if ((m_pNext == NULL) || ((size_t) (m_pLimit-m_pNext) < m_nSlot)) {
+      uint8_t *pChunk = (uint8_t *) ::operator new(CHUNK_BYTES);
+      *((uint8_t **) pChunk) = m_pChunks;  m_pChunks = pChunk;  ++m_nChunks;
+      m_pNext = pChunk + ALIGNMENT;  m_pLimit = pChunk + CHUNK_BYTES;
+    }
+    pObject = m_pNext;  m_pNext += m_nSlot;
+  }
+  ++m_nLive;
+  return pObject;
+}
+
+
+void CArena::Free (void *pObject, size_t nBytes)
+{
+  //++
+  //   Free one object by putting its slot on the free list.  If that was the
+  // last one, then give all the chunks back to the heap at once instead ...
+  //--
+  if (pObject == NULL) return;
+  if (!IsMine(nBytes)) {::operator delete(pObject);  return;}
+  assert(m_nLive > 0);
+  if (--m_nLive == 0) {Recycle();  return;}
+  FREE_SLOT *pSlot = (FREE_SLOT *) pObject;
+  pSlot->pNext = m_pFree;  m_pFree = pSlot;
+}
+
+
+void CArena::Recycle()
+{
+  //++
+  //   Return every chunk except the current one (the first on the list) to
+  // the heap, and start over at the beginning of that one.  The free list
+  // only has slots in the chunks, so it goes too.  Like Release(), this is
+  // only allowed when there are no objects left ...
+  //--
+  assert(m_nLive == 0);
+  if (m_pChunks == NULL) return;
+  uint8_t *pChunk = *((uint8_t **) m_pChunks);
+  while (pChunk != NULL) {
+    uint8_t *pNext = *((uint8_t **) pChunk);
+    ::operator delete(pChunk);  pChunk = pNext;
+  }
+  *((uint8_t **) m_pChunks) = NULL;  m_nChunks = 1;
+  m_pNext = m_pChunks + ALIGNMENT;  m_pLimit = m_pChunks + CHUNK_BYTES;  m_pFree = NULL;
+}
+
+
+void CArena::Release()
+{
+  //++
+  //   Return every chunk to the heap at once.  This is only allowed when
+  // there are no objects left in any of them ...
+  //--
+  assert(m_nLive == 0);
+  while (m_pChunks != NULL) {
+    uint8_t *pChunk = m_pChunks;
+    m_pChunks = *((uint8_t **) pChunk);
+    ::operator delete(pChunk);
+  }
+  m_pNext = m_pLimit = NULL;  m_pFree = NULL;  m_nChunks = 0;
+}
@@ -0,0 +1,131 @@
+//++
+// Arena.hpp -> fixed size object arenas for CDog and CCSVRow
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   A big DIR turns into hundreds of thousands of CDog objects, and about the
+// same number of CCSVRow objects on the way, and every one of them used to be
+// a separate trip to the heap - both to allocate it and to free it again.
+// CArena hands out objects of one fixed size from big chunks instead.  A new
+// object is just the next slot in the current chunk, and a deleted one goes
+// on a free list to be used again, so neither one touches the heap.  The
+// chunks themselves go back to the heap all at once - whenever the last
+// object in the arena is deleted (e.g. when a CDogs collection is deleted)
+// every chunk but the current one is released, and the free list is thrown
+// away.  The last chunk is kept so that a loop that makes and deletes one
+// object at a time doesn't go to the heap every time, and it's released by
+// the destructor.
+//
+//   Be aware that this only makes giving the memory back cheap - it doesn't
+// make deleting a collection O(chunks).  CDogs::DeleteAll() still runs the
+// destructor of every single CDog (each one has strings and a CCSVRow to
+// free) and puts every slot back on the free list one at a time, so it's
+// still O(dogs).  The only path that skips all that is the normal update run,
+// which leaves everything allocated and calls FastExit() instead.
+//
+//   CDog and CCSVRow each have a thread_local CArena and class specific
+// versions of operator new and operator delete that use it.  Anything that
+// isn't the size the arena was made for (e.g. a class derived from one of
+// those) just goes to the global operator new instead.
+//
+//   Every thread has its own arenas (a batch run reads DIRs on several at
+// once), so there's no lock at all.  The catch is that an object must be
+// deleted by the same thread that created it, but that's already true - each
+// batch job runs start to finish on one worker (see CBatch::RunJob()).  And
+// the arenas go away when the worker thread does.
+//
+//   Note that the constructor is constexpr, so the arenas never need any
+// initialization at run time.  And if there are still any objects alive when
+// an arena is destroyed, it doesn't free its chunks at all - the program is
+// exiting anyway (see FastExit() in MicrochipUpdate.cpp).
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   One arena per thread, and release chunks when it's empty.
+// 17-OCT-26  AGT   Explain what bulk release does and doesn't buy DeleteAll().
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stddef.h>             // NULL, size_t, etc ...
+using std::size_t;              // ...
+
+
+class CArena {
+  //++
+  // Fixed size object allocator ...
+  //--
+
+public:
+  enum {
+    CHUNK_BYTES         = 256*1024,     // size of each chunk from the heap
+    ALIGNMENT           = 16,           // every slot is aligned to this
+  };
+
+public:
+  // Constructor and destructor ...
+  constexpr CArena (size_t nObject)
+    : m_nSlot(RoundUp(nObject)), m_nObject(nObject), m_pChunks(NULL), m_pNext(NULL),
+      m_pLimit(NULL), m_pFree(NULL), m_nLive(0), m_nChunks(0) {}
+  virtual ~CArena() {if (m_nLive == 0) Release();}
+  // Copy and assignment constructors ...
+  CArena (const CArena &a) = delete;
+  CArena& operator= (const CArena &a) = delete;
+
+  // CArena properties ...
+public:
+  // Return the number of objects allocated and not yet freed ...
+  size_t GetLive() const {return m_nLive;}
+  // Return the number of chunks allocated from the heap ...
+  size_t GetChunks() const {return m_nChunks;}
+
+  // CArena public methods ...
+public:
+  // Allocate or free one object ...
+  void *Allocate (size_t nBytes);
+  void Free (void *pObject, size_t nBytes);
+  // Return all the chunks to the heap ...
+  void Release();
+  // Return all but the current chunk to the heap (when it's empty) ...
+  void Recycle();
+
+  // Private internal CArena methods ...
+protected:
+  // Round an object size up to a whole number of slots ...
+  static constexpr size_t RoundUp (size_t n)
+    {return (n < (size_t) ALIGNMENT) ? (size_t) ALIGNMENT : ((n + ALIGNMENT-1) & ~((size_t) ALIGNMENT-1));}
+  // Return true if this size comes from the arena ...
+  bool IsMine (size_t nBytes) const
+    {return (nBytes == m_nObject) && (m_nSlot <= CHUNK_BYTES-ALIGNMENT);}
+
+  // Local CArena members ...
+protected:
+  // A slot on the free list ...
+  struct FREE_SLOT {
+    FREE_SLOT *pNext;           // next free slot (or NULL)
+  };
+  const size_t  m_nSlot;        // size of each slot, rounded up
+  const size_t  m_nObject;      // size of the objects we allocate
+  uint8_t      *m_pChunks;      // list of chunks (linked thru their first slot)
+  uint8_t      *m_pNext;        // next unused slot in the current chunk
+  uint8_t      *m_pLimit;       // end of the current chunk
+  FREE_SLOT    *m_pFree;        // list of freed slots
+  size_t        m_nLive;        // objects allocated and not yet freed
+  size_t        m_nChunks;      // number of chunks
+};
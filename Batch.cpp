@@ -0,0 +1,262 @@
+//++
+// Batch.cpp - implementation of the CBatch class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CBatch class, which runs the update jobs from a
+// manifest on a pool of worker threads.  See Batch.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Add the optional Domains column for CShards.
+// 17-Oct-26  AGT   Add the Households column.  File names are relative to
+//                  the manifest.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::ifstream ...
+#include <algorithm>            // std::min() ...
+#include <chrono>               // std::chrono::steady_clock, et al ...
+#include <thread>               // std::thread ...
+#include <set>                  // std::set ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Metrics.hpp"          // CMetrics, METRIC() macro, et al ...
+#include "Trace.hpp"            // TRACE_CHUNK() macro, et al ...
+#include "MicrochipUpdate.hpp"  // RunUpdate(), ChangeExtension()
+#include "Batch.hpp"            // declarations for this module
+
+// These are the expected header rows for the manifest ...
+const string CBatch::m_sColumnHeaders("Org, Old DIR, New DIR, Updates, Errors");
+const string CBatch::m_sDomainsColumnHeaders("Org, Old DIR, New DIR, Updates, Errors, Domains");
+const string CBatch::m_sShardColumnHeaders("Org, Old DIR, New DIR, Updates, Errors, Domains, Households");
+
+
+//   This stream buffer throws away everything written to it.  It's what
+// std::cout writes to while the jobs are running.  Unlike a NULL rdbuf (which
+// is what CBenchmark and CWhatIf use) it never sets badbit, so the workers
+// don't all change the state of std::cout at the same time ...
+class CNullBuffer : public std::streambuf {
+protected:
+  int overflow (int c) {return traits_type::not_eof(c);}
+};
+
+
+CBatch::CBatch()
+{
+  //++
+  // The defaults are the same as a normal update run ...
+  //--
+  m_nWorkers = m_nUsed = 0;  m_nCutoff = 2019;  m_dSeconds = 0.0;
+  m_fOldFormat = m_fNewFormat = true;  m_nNext = 0;
+}
+
+
+/*static*/ size_t CBatch::ReadManifestFile (const string &sFileName, CCSVFile &csv)
+{
+  //++
+  //   Read a manifest and return the number of columns it has.  The header
+  // row decides which of the optional columns it has, and CCSVFile checks it
+  // (and every row) against that.  The file names are all made relative to
+  // the manifest's directory here, so nobody else has to ...
+  //--
+  std::ifstream stm(sFileName);  CCSVRow hdr;
+  bool fHeader = stm.is_open() && (hdr.Read(stm) > 0);
+  stm.close();
+  size_t nColumns = COL_ERRORS;  const string *psHeaders = &m_sColumnHeaders;
+  if (fHeader && hdr.Verify(m_sShardColumnHeaders)) {
+    nColumns = COL_HOUSEHOLDS;  psHeaders = &m_sShardColumnHeaders;
+  } else if (fHeader && hdr.Verify(m_sDomainsColumnHeaders)) {
+    nColumns = COL_DOMAINS;  psHeaders = &m_sDomainsColumnHeaders;
+  }
+  csv.Read(sFileName, *psHeaders);
+  for (CCSVFile::iterator it = csv.begin();  it != csv.end();  ++it) {
+    CCSVRow &row = **it;
+    for (size_t i = COL_OLD_DIR-1;  (i < nColumns) && (i < row.size());  ++i)
+      row[i] = ResolveFileName(sFileName, row[i]);
+  }
+  return nColumns;
+}
+
+
+/*static*/ string CBatch::ResolveFileName (const string &sManifest, const string &sFileName)
+{
+  //++
+  //   Return the name of a file in a manifest, taking a relative name as
+  // relative to the manifest's directory.  An empty name stays empty, and an
+  // absolute name (with a drive or a leading slash) stays the way it is ...
+  //--
+  if (sFileName.empty() || (sFileName[0] == '/') || (sFileName[0] == '\\')) return sFileName;
+  if ((sFileName.length() > 1) && (sFileName[1] == ':')) return sFileName;
+  char szDrive[_MAX_DRIVE+1], szDirectory[_MAX_DIR+1];
+  char szFileName[_MAX_FNAME+1], szExtension[_MAX_EXT+1];
+  errno_t err = _splitpath_s(sManifest.c_str(), szDrive, sizeof(szDrive),
+                             szDirectory, sizeof(szDirectory), szFileName, sizeof(szFileName),
+                             szExtension, sizeof(szExtension));
+  if (err != 0) return sFileName;
+  return string(szDrive) + string(szDirectory) + sFileName;
+}
+
+
+void CBatch::ReadManifest (const string &sFileName)
+{
+  //++
+  //   Read the manifest and check it before anything runs.  Every job needs
+  // a known organization and all its file names, and no two jobs can write
+  // the same output file (or write over somebody's DIR!) ...
+  //--
+  CCSVFile csv;  std::set<string> setInputs, setOutputs;
+  size_t nColumns = ReadManifestFile(sFileName, csv);
+  m_vecJobs.clear();
+  for (size_t i = 0;  i < csv.size();  ++i) {
+    const CCSVRow &row = *csv[i];  JOB job;
+    if (row.size() != nColumns)
+      ERRS("wrong number of columns in row " << (i+2) << " of " << sFileName);
+    job.sOrg = row[COL_ORG-1];
+    job.sOldFile = row[COL_OLD_DIR-1];  job.sNewFile = row[COL_NEW_DIR-1];
+    job.sUpdatesFile = row[COL_UPDATES-1];  job.sErrorsFile = row[COL_ERRORS-1];
+    if (nColumns >= COL_DOMAINS) job.sDomainsFile = row[COL_DOMAINS-1];
+    if (nColumns >= COL_HOUSEHOLDS) job.sHouseholdsFile = row[COL_HOUSEHOLDS-1];
+    if (job.sOldFile.empty() || job.sNewFile.empty() || job.sUpdatesFile.empty() || job.sErrorsFile.empty())
+      ERRS("missing file name in row " << (i+2) << " of " << sFileName);
+    job.pProfile = m_Profiles.Find(job.sOrg);
+    if (job.pProfile == NULL)
+      ERRS("no profile for organization \"" << job.sOrg << "\" in row " << (i+2) << " of " << sFileName);
+    string asOutputs[3] = {job.sUpdatesFile, job.sErrorsFile, ChangeExtension(job.sErrorsFile, METRICS_EXTENSION)};
+    for (unsigned j = 0;  j < 3;  ++j)
+      if (!setOutputs.insert(asOutputs[j]).second)
+        ERRS(asOutputs[j] << " is written by more than one job in " << sFileName);
+    setInputs.insert(job.sOldFile);  setInputs.insert(job.sNewFile);
+    if (!job.sDomainsFile.empty()) setInputs.insert(job.sDomainsFile);
+    if (!job.sHouseholdsFile.empty()) setInputs.insert(job.sHouseholdsFile);
+    m_vecJobs.push_back(job);
+  }
+  for (std::set<string>::const_iterator it = setOutputs.begin();  it != setOutputs.end();  ++it)
+    if (setInputs.count(*it) != 0) ERRS(*it << " is both an input and an output in " << sFileName);
+  MSGS("Read " << m_vecJobs.size() << " jobs from " << sFileName);
+}
+
+
+CBatch::RESULT CBatch::RunJob (const JOB &job) const
+{
+  //++
+  //   Run one job, with its own organization profile and CMetrics, and
+  // collect the results.  RunUpdate() creates the CBadDogs.  If anything goes
+  // wrong the exception is saved as the reason the job failed ...
+  //--
+  RESULT result;
+  result.nOldDogs = result.nNewDogs = result.nUpdates = result.nErrors = 0;
+  std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+  COrgProfile::SetCurrent(job.pProfile);
+  try {
+    CMetrics metrics;
+    metrics.SetLabel("org", job.pProfile->GetOrg());
+    metrics.SetLabel("old_dir", job.sOldFile);
+    metrics.SetLabel("new_dir", job.sNewFile);
+    metrics.SetLabel("cutoff_year", std::to_string(m_nCutoff));
+    RunUpdate(job.sOldFile, m_fOldFormat, job.sNewFile, m_fNewFormat,
+              m_nCutoff, job.sUpdatesFile, job.sErrorsFile, false, false, job.sDomainsFile,
+              job.sHouseholdsFile);
+    metrics.WriteJSON(ChangeExtension(job.sErrorsFile, METRICS_EXTENSION));
+    result.nOldDogs = (size_t) metrics.GetCount(CMetrics::OLD_DOGS);
+    result.nNewDogs = (size_t) metrics.GetCount(CMetrics::NEW_DOGS);
+    result.nUpdates = (size_t) metrics.GetCount(CMetrics::UPDATES);
+    result.nErrors  = (size_t) metrics.GetCount(CMetrics::BAD_DOGS);
+  } catch (std::exception &e) {
+    result.sFailure = e.what();
+  }
+  COrgProfile::SetCurrent(NULL);
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - tStart;
+  result.dSeconds = dt.count();
+  return result;
+}
+
+
+void CBatch::Worker (unsigned nWorker)
+{
+  //++
+  //   This is the body of each worker thread.  It just keeps taking the next
+  // job from the list until they're all gone.  Each job writes only its own
+  // slot in m_vecResults, so no lock is needed for those ...
+  //--
+  CTracer::SetThreadName("worker " + std::to_string(nWorker));
+  for (;;) {
+    size_t nJob = m_nNext++;
+    if (nJob >= m_vecJobs.size()) break;
+    TRACE_CHUNK("batch job", (int64_t) nJob);
+    m_vecResults[nJob] = RunJob(m_vecJobs[nJob]);
+  }
+}
+
+
+void CBatch::Run()
+{
+  //++
+  //   Start the worker threads, wait for them all to finish, and then put
+  // std::cout back the way it was ...
+  //--
+  if (m_vecJobs.empty()) return;
+  m_vecResults.assign(m_vecJobs.size(), RESULT());  m_nNext = 0;
+  m_nUsed = (m_nWorkers != 0) ? m_nWorkers : std::thread::hardware_concurrency();
+  m_nUsed = (unsigned) std::min((size_t) std::max(m_nUsed, 1U), m_vecJobs.size());
+
+  std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+  CNullBuffer nullbuf;  std::streambuf *pCout = std::cout.rdbuf(&nullbuf);
+  vector<std::thread> vecThreads;
+  for (unsigned i = 0;  i < m_nUsed;  ++i)  vecThreads.push_back(std::thread(&CBatch::Worker, this, i+1));
+  for (vector<std::thread>::iterator it = vecThreads.begin();  it != vecThreads.end();  ++it)  it->join();
+  std::cout.rdbuf(pCout);  std::cout.clear();
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - tStart;
+  m_dSeconds = dt.count();
+}
+
+
+size_t CBatch::GetFailures() const
+{
+  //++
+  // Return the number of jobs that failed ...
+  //--
+  size_t nFailures = 0;
+  for (vector<RESULT>::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it)
+    if (!it->sFailure.empty()) ++nFailures;
+  return nFailures;
+}
+
+
+void CBatch::Report() const
+{
+  //++
+  // Print the results on stdout, one line per job in manifest order ...
+  //--
+  MSGS(CBadDogs::Print("%-8s %10s %10s %10s %10s %10s  %s", "Org", "Old dogs", "New dogs", "Updates", "Errors", "Seconds", "Errors file"));
+  for (size_t i = 0;  i < m_vecResults.size();  ++i) {
+    const JOB &job = m_vecJobs[i];  const RESULT &result = m_vecResults[i];
+    if (!result.sFailure.empty())
+      MSGS(CBadDogs::Print("%-8s FAILED - %s", job.pProfile->GetOrg().c_str(), result.sFailure.c_str()));
+    else
+      MSGS(CBadDogs::Print("%-8s %10zu %10zu %10zu %10zu %10.3f  %s", job.pProfile->GetOrg().c_str(),
+           result.nOldDogs, result.nNewDogs, result.nUpdates, result.nErrors, result.dSeconds, job.sErrorsFile.c_str()));
+  }
+  MSGS("Ran " << m_vecResults.size() << " jobs (" << GetFailures() << " failed) on " << m_nUsed
+       << " workers in " << CBadDogs::Print("%.3f", m_dSeconds) << " seconds");
+}
@@ -0,0 +1,184 @@
+//++
+// Batch.hpp -> run update jobs for several organizations at once
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   A CBatch runs a whole night's worth of update runs - NGRR's and each of
+// the partner rescues' - in one invocation.  The jobs come from a manifest,
+// which is a CSV file with one row per job -
+//
+//      Org, Old DIR, New DIR, Updates, Errors
+//
+// "Org" picks the organization profile (see COrgProfile) that's used for
+// that job's Found.org registrations, and the rest are the same file names
+// that a normal update run takes on the command line.  Every job must have
+// its own updates and errors files (and the metrics file that goes with the
+// errors file), and the manifest is rejected if two jobs would write the same
+// file.  The cutoff year and the DIR formats (-c and -o) apply to all jobs.
+//
+//   A manifest can also have a sixth column, "Domains", which is the name of a
+// file of email domain counts (see CDomainChecker::WriteCounts()).  CShards
+// writes that column for every shard.  A job that has one is only part of a
+// bigger update run, so it learns its email domains from that file instead
+// of from its own old DIR, and it leaves the re-entered dogs to whoever split
+// the DIRs (see CShards::Split()).  There can be a seventh column after that,
+// "Households", which is the file of adopter households for that shard's
+// dogs (see CHouseholds::ReadFile()), found by CShards from the whole DIR
+// pair.  Either way, all the rows in one manifest have the same number of
+// columns.
+//
+//   A file name in the manifest that isn't an absolute path is relative to
+// the directory the manifest is in, not to the current directory.  That way
+// a manifest and its files can be moved, or run from anywhere, together.
+//
+//   The jobs run on a pool of worker threads (--jobs, or one per processor,
+// but never more than the number of jobs).  Each worker takes the next job
+// that nobody has started yet, so a long job doesn't hold up the short ones
+// behind it.  A job is exactly the same as a normal update run, done by
+// RunUpdate(), with its own CBadDogs, CMetrics and organization profile -
+// those are all thread local, so the jobs can't see each other's errors or
+// counters.  The only things they share are the zip code tables, which never
+// change, the dog number prefix registry in CDog, which has a lock, and the
+// CTracer (if --trace was given), which already gives each thread its own
+// track in the timeline.
+//
+//   The console chatter from all the jobs at once would be unreadable, so it's
+// thrown away while the jobs run (everything that matters is in the errors
+// files anyway) and Report() prints one summary line per job instead.  A job
+// that fails (e.g. a missing DIR) is reported as such, and doesn't stop the
+// other jobs.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add the optional Domains column for CShards.
+// 17-OCT-26  AGT   Add the Households column and resolve the file names
+//                  against the manifest's directory.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <atomic>               // std::atomic ...
+#include "OrgProfile.hpp"       // rescue organization profiles
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+class CCSVFile;                 // ...
+
+
+class CBatch {
+  //++
+  // Concurrent update runs from a manifest ...
+  //--
+
+public:
+  // Column numbers in the manifest ...
+  enum {
+    COL_ORG             = 1,    // organization code (see COrgProfile)
+    COL_OLD_DIR         = 2,    // previous Dog Information Report
+    COL_NEW_DIR         = 3,    // current    "      "         "
+    COL_UPDATES         = 4,    // Found.org updates file
+    COL_ERRORS          = 5,    // bad dogs file
+    COL_DOMAINS         = 6,    // email domain counts (optional)
+    COL_HOUSEHOLDS      = 7,    // adopter households (optional)
+    TOTAL_COLUMNS       = 7     // number of columns in the manifest
+  };
+  //   This is the expected header row for the manifest, without and with the
+  // Domains column, and with the Households column too ...
+  static const string m_sColumnHeaders;
+  static const string m_sDomainsColumnHeaders;
+  static const string m_sShardColumnHeaders;
+
+  // One job from the manifest ...
+  struct JOB {
+    string  sOrg;                       // organization code
+    string  sOldFile, sNewFile;         // old and new DIRs
+    string  sUpdatesFile, sErrorsFile;  // output files
+    string  sDomainsFile;               // email domain counts (or empty)
+    string  sHouseholdsFile;            // adopter households (or empty)
+    const COrgProfile *pProfile;        // profile for this organization
+  };
+  // And its results ...
+  struct RESULT {
+    size_t  nOldDogs, nNewDogs;         // dogs kept from each DIR
+    size_t  nUpdates;                   // updates for Found.org
+    size_t  nErrors;                    // bad dogs
+    double  dSeconds;                   // elapsed time for this job
+    string  sFailure;                   // why the job failed (empty if it didn't)
+  };
+
+public:
+  // Constructor and destructor ...
+  CBatch();
+  virtual ~CBatch() {};
+  // Copy and assignment constructors ...
+  CBatch (const CBatch &b) = delete;
+  CBatch& operator= (const CBatch &b) = delete;
+
+  // CBatch properties ...
+public:
+  // Set the number of worker threads (zero means one per processor) ...
+  void SetWorkers (unsigned nWorkers) {m_nWorkers = nWorkers;}
+  // Set the cutoff year and the DIR formats for all jobs ...
+  void SetCutoffYear (uint32_t nYear) {m_nCutoff = nYear;}
+  void SetFormats (bool fOldFormat, bool fNewFormat)
+    {m_fOldFormat = fOldFormat;  m_fNewFormat = fNewFormat;}
+  // Return the jobs and their results ...
+  const vector<JOB> &GetJobs() const {return m_vecJobs;}
+  const vector<RESULT> &GetResults() const {return m_vecResults;}
+  // Return the number of jobs that failed ...
+  size_t GetFailures() const;
+
+  // CBatch public methods ...
+public:
+  // Read the organization profiles ...
+  void ReadProfiles (const string &sFileName) {m_Profiles.ReadFile(sFileName);}
+  // Read (and check) the manifest ...
+  void ReadManifest (const string &sFileName);
+  //   Read any manifest file (with or without the optional columns) and return
+  // the number of columns in it ...
+  static size_t ReadManifestFile (const string &sFileName, CCSVFile &csv);
+  // Return a file name from a manifest relative to the manifest ...
+  static string ResolveFileName (const string &sManifest, const string &sFileName);
+  // Run all the jobs ...
+  void Run();
+  // Print one line for each job ...
+  void Report() const;
+
+  // Private internal CBatch methods ...
+protected:
+  // Run jobs until there aren't any left ...
+  void Worker (unsigned nWorker);
+  // Run one job on the current thread ...
+  RESULT RunJob (const JOB &job) const;
+
+  // Local CBatch members ...
+protected:
+  COrgProfiles        m_Profiles;       // organization profiles
+  vector<JOB>         m_vecJobs;        // jobs, in manifest order
+  vector<RESULT>      m_vecResults;     // results, in the same order
+  unsigned            m_nWorkers;       // number of worker threads
+  unsigned            m_nUsed;          // number actually used by Run()
+  uint32_t            m_nCutoff;        // cutoff year for all jobs
+  bool                m_fOldFormat;     // true if the old DIRs are the new format
+  bool                m_fNewFormat;     //   "   "  "  new   "   "   "   "    "
+  double              m_dSeconds;       // elapsed time for the whole batch
+  std::atomic<size_t> m_nNext;          // next job to start
+};
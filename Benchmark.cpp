@@ -0,0 +1,373 @@
+//++
+// Benchmark.cpp - implementation of the end to end and micro benchmarks
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The benchmark calls RunUpdate(), the very same function that main() uses,
+// and reports the CMetrics phases that it times - read the old DIR, read the
+// new DIR, compare (which includes the households, similar chips and re-
+// entered dogs), build the updates (which includes the email domains), write
+// the updates and write the errors.  There's no second copy of the pipeline
+// to keep up to date.  Anything that isn't in a phase goes in one more stage,
+// "other", and that's almost all teardown (i.e. deleting all the CDog and
+// CChip objects), which is a surprisingly large part of the total for big
+// DIRs.
+//
+//   The micro benchmark times one function at a time.  Each function is
+// called over and over on a corpus of inputs, and the total time divided by
+// the number of calls gives the ns/call.  The corpora are all derived from a
+// synthetic DIR generated with a fixed seed, so the numbers from one build
+// can be compared to the numbers from the next.
+//
+//   All the usual console chatter (every bad dog gets printed!) is discarded
+// while the pipeline is running.  Otherwise we'd just be benchmarking the
+// console, and for ten million dogs that would take a while...
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Report the current RSS per stage, and the peak only once.
+// 17-Oct-26  AGT   Run RunUpdate() and report its CMetrics phases.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stdio.h>              // remove() ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::ifstream
+#include <sstream>              // std::ostringstream, std::istringstream
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Chip.hpp"             // CChip data and CChips collection
+#include "Generate.hpp"         // synthetic DIR generator
+#include "MicrochipUpdate.hpp"  // CompareDogs(), BuildUpdates(), etc
+#include "Allocations.hpp"      // heap allocation accounting
+#include "Metrics.hpp"          // CMetrics::GetCurrentRSS(), et al ...
+#include "Benchmark.hpp"        // declarations for this module
+
+
+/*static*/ uint64_t CBenchmark::GetFileSize (const string &sFileName)
+{
+  //++
+  // Return the size of a file in bytes, or zero if it doesn't exist ...
+  //--
+  std::ifstream stm(sFileName, std::ios::in|std::ios::binary|std::ios::ate);
+  if (!stm.is_open()) return 0;
+  return (uint64_t) stm.tellg();
+}
+
+
+string CBenchmark::MakeFileName (const char *pszName, size_t nDogs) const
+{
+  //++
+  // Return the full path for one of the synthetic files ...
+  //--
+  return m_sDirectory + "/bench-" + pszName + "-" + std::to_string(nDogs) + ".csv";
+}
+
+
+void CBenchmark::RunOne (size_t nDogs, const string &sOldFile, const string &sNewFile,
+                         uint32_t nCutoffYear, bool fOldFormat, bool fNewFormat)
+{
+  //++
+  //   Do one complete update run on one pair of DIR files, with RunUpdate()
+  // just like main(), and record a stage for each of the CMetrics phases it
+  // times.  fFastExit is false, so RunUpdate() deletes everything itself,
+  // and that's timed too - as the "other" stage, which is whatever time,
+  // memory and allocations the phases don't account for ...
+  //--
+  string sUpdates = MakeFileName("updates", nDogs);
+  string sErrors = MakeFileName("errors", nDogs);
+  std::streambuf *pCout = std::cout.rdbuf(NULL);
+
+  CMetrics metrics;
+  uint64_t nStartRSS = CMetrics::GetCurrentRSS();
+  uint64_t nStartAllocs = CAllocations::GetCount(), nStartBytes = CAllocations::GetBytes();
+  CLOCK::time_point tStart = CLOCK::now();
+  RunUpdate(sOldFile, fOldFormat, sNewFile, fNewFormat, nCutoffYear, sUpdates, sErrors, false, false);
+  std::chrono::duration<double> dt = CLOCK::now() - tStart;
+
+  uint64_t anBytes[CMetrics::MAXPHASE] = {0};
+  anBytes[CMetrics::PHASE_READ_OLD] = GetFileSize(sOldFile);
+  anBytes[CMetrics::PHASE_READ_NEW] = GetFileSize(sNewFile);
+  anBytes[CMetrics::PHASE_WRITE_UPDATES] = GetFileSize(sUpdates);
+  anBytes[CMetrics::PHASE_WRITE_ERRORS] = GetFileSize(sErrors);
+  STAGE other;
+  other.nDogs = nDogs;  other.sStage = "other";  other.dSeconds = dt.count();  other.nBytes = 0;
+  other.nRSS = CMetrics::GetCurrentRSS();  other.nRSSChange = (int64_t) other.nRSS - (int64_t) nStartRSS;
+  other.nAllocs = CAllocations::GetCount() - nStartAllocs;
+  other.nAllocBytes = CAllocations::GetBytes() - nStartBytes;
+  other.nPeakHeap = 0;
+  for (unsigned i = 0;  i < CMetrics::MAXPHASE;  ++i) {
+    CMetrics::PHASE nPhase = (CMetrics::PHASE) i;
+    STAGE stage;
+    stage.nDogs = nDogs;  stage.sStage = CMetrics::PhaseName(nPhase);
+    stage.dSeconds = metrics.GetSeconds(nPhase);  stage.nBytes = anBytes[i];
+    stage.nRSS = metrics.GetRSS(nPhase);  stage.nRSSChange = metrics.GetRSSChange(nPhase);
+    stage.nAllocs = metrics.GetAllocations(nPhase);
+    stage.nAllocBytes = metrics.GetAllocatedBytes(nPhase);
+    stage.nPeakHeap = metrics.GetPeakHeap(nPhase);
+    m_vecResults.push_back(stage);
+    other.dSeconds -= stage.dSeconds;  other.nRSSChange -= stage.nRSSChange;
+    other.nAllocs -= stage.nAllocs;  other.nAllocBytes -= stage.nAllocBytes;
+  }
+  if (other.dSeconds < 0.0) other.dSeconds = 0.0;
+  m_vecResults.push_back(other);
+
+  std::cout.rdbuf(pCout);  std::cout.clear();
+  if (!m_fKeepFiles) {remove(sUpdates.c_str());  remove(sErrors.c_str());}
+}
+
+
+void CBenchmark::Run (uint32_t nCutoffYear, bool fOldFormat, bool fNewFormat)
+{
+  //++
+  //   Run the benchmark for every size from MIN_DOGS to the maximum, going up
+  // by a factor of ten each time ...
+  //--
+  m_vecResults.clear();
+  for (size_t nDogs = MIN_DOGS;  nDogs <= m_nMaxDogs;  nDogs *= 10) {
+    string sOldFile = MakeFileName("old", nDogs);
+    string sNewFile = MakeFileName("new", nDogs);
+    MSGS("Benchmarking " << nDogs << " dogs ...");
+    m_Generator.SetDogCount(nDogs);
+    m_Generator.SetCutoffYear(nCutoffYear);
+    m_Generator.SetFormats(fOldFormat, fNewFormat);
+    m_Generator.Generate(sOldFile, sNewFile);
+    RunOne(nDogs, sOldFile, sNewFile, nCutoffYear, fOldFormat, fNewFormat);
+    if (!m_fKeepFiles) {remove(sOldFile.c_str());  remove(sNewFile.c_str());}
+  }
+}
+
+
+void CBenchmark::Report() const
+{
+  //++
+  //   Print the results table on stdout.  Throughput is reported both in dogs
+  // per second (for every stage) and megabytes per second (for the stages
+  // that read or write a file).  If we're counting allocations then the heap
+  // allocations per dog, MB allocated and heap high-water mark are added.
+  // The process' peak RSS only means anything for the whole run, so that's
+  // printed once at the end ...
+  //--
+  bool fAllocs = CAllocations::IsEnabled();
+  MSGS(CBadDogs::Print("%10s  %-14s %10s %12s %9s %9s %10s", "Dogs", "Stage", "Seconds",
+       "Dogs/sec", "MB/sec", "RSS MB", "Change MB")
+       + (fAllocs ? CBadDogs::Print(" %11s %10s %12s", "Allocs/dog", "Alloc MB", "Peak heap MB") : string("")));
+  double dTotal = 0.0;
+  for (STAGE_VECTOR::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it) {
+    double dSeconds = (it->dSeconds > 0.0) ? it->dSeconds : 1e-9;
+    double dMB = it->nBytes / (1024.0*1024.0);
+    string sMBs = (it->nBytes != 0) ? CBadDogs::Print("%9.1f", dMB/dSeconds) : string("");
+    string sAllocs = fAllocs ? CBadDogs::Print(" %11.1f %10.1f %12.1f",
+         ((double) it->nAllocs)/it->nDogs, it->nAllocBytes/(1024.0*1024.0),
+         it->nPeakHeap/(1024.0*1024.0)) : string("");
+    MSGS(CBadDogs::Print("%10zu  %-14s %10.3f %12.0f %9s %9.1f %+10.1f",
+         it->nDogs, it->sStage.c_str(), it->dSeconds, it->nDogs/dSeconds,
+         sMBs.c_str(), it->nRSS/(1024.0*1024.0), it->nRSSChange/(1024.0*1024.0)) + sAllocs);
+    dTotal += it->dSeconds;
+    if (((it+1) == m_vecResults.end()) || ((it+1)->nDogs != it->nDogs)) {
+      MSGS(CBadDogs::Print("%10zu  %-14s %10.3f %12.0f", it->nDogs, "TOTAL", dTotal, it->nDogs/dTotal));
+      dTotal = 0.0;
+    }
+  }
+  MSGS(CBadDogs::Print("Peak RSS for the whole benchmark %.1f MB", CMetrics::GetPeakRSS()/(1024.0*1024.0)));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+
+void CMicroBenchmark::BuildCorpora()
+{
+  //++
+  //   Build all the input corpora.  The DIR lines come from the synthetic DIR
+  // generator with a fixed seed, so they're the same every time, and all the
+  // other corpora (fields, dates, phones, etc) are pulled out of those lines.
+  // A few extra hand picked oddballs are thrown in for good measure ...
+  //--
+  CDIRGenerator gen;
+  gen.SetDogCount(CORPUS_DOGS);  gen.SetSeed(CORPUS_SEED);  gen.SetDirtyPercent(10);
+  gen.SetRecentPercent(100);
+  vector<CDIRGenerator::DOG> vecOld, vecNew;
+  gen.GenerateDogs(vecOld, vecNew);
+  std::ostringstream os;
+  gen.Write(os, vecNew, true);
+
+  // Split the DIR into lines and parse each one (skipping the header) ...
+  std::istringstream is(os.str());  string sLine;
+  std::getline(is, sLine);
+  while (std::getline(is, sLine)) {
+    m_vecLines.push_back(sLine);
+    m_vecRows.push_back(CCSVRow(sLine));
+  }
+
+  // Now extract the individual field corpora ...
+  for (vector<CCSVRow>::const_iterator it = m_vecRows.begin();  it != m_vecRows.end();  ++it) {
+    const CCSVRow &row = *it;
+    for (CCSVRow::const_iterator jt = row.begin();  jt != row.end();  ++jt) {
+      if (jt->empty()) continue;
+      m_vecRawFields.push_back(CCSVRow::FormatField(*jt));
+      m_vecPadFields.push_back(" " + *jt + "  ");
+    }
+    m_vecRawFields.push_back("=\"" + row[1] + "\"");
+    CDog dog;
+    if (!dog.FromRow(row, true)) continue;
+    m_vecDogs.push_back(dog);
+    m_vecNumbers.push_back(dog.GetNumber());
+    m_vecDates.push_back(dog.GetDateAcquired());
+    if (!dog.GetDispositionDate().empty()) m_vecDates.push_back(dog.GetDispositionDate());
+    if (dog.HasChip()) m_vecChips.push_back(dog.GetChip());
+    if (!dog.IsAdopted()) continue;
+    m_vecPhones.push_back(dog.GetAdoptionHomePhone());
+    m_vecZips.push_back(dog.GetAdoptionZip());
+    m_veceMails.push_back(dog.GetAdoptioneMail());
+    m_vecStates.push_back(dog.GetAdoptionState());
+  }
+  m_vecDates.push_back("0000-00-00");  m_vecDates.push_back("1/2/2020");
+  m_vecStates.push_back("XX");  m_vecStates.push_back("California");
+  m_vecChips.push_back("1A2B3C4D5E");  m_vecChips.push_back("ABC");
+
+  // RemoveEquals() gets the field after ParseField() has stripped the quotes ...
+  for (vector<string>::const_iterator it = m_vecRawFields.begin();  it != m_vecRawFields.end();  ++it) {
+    string::const_iterator jt = it->begin();
+    m_vecEqFields.push_back(CCSVRow::ParseField(*it, jt));
+  }
+
+  // And lastly, build a CDogs collection for the Find() tests ...
+  for (vector<CDog>::const_iterator it = m_vecDogs.begin();  it != m_vecDogs.end();  ++it)
+    m_Dogs.Add(new CDog(*it));
+}
+
+
+template <typename F> void CMicroBenchmark::Measure (const char *pszName, size_t nCorpus, F f)
+{
+  //++
+  //   Time one function.  We make one pass thru the corpus to warm up the
+  // caches, and then keep making passes until at least m_dMinSeconds has
+  // elapsed.  The allocation counts come from CAllocations and will be zero
+  // unless the program was built with COUNT_ALLOCATIONS ...
+  //--
+  typedef std::chrono::steady_clock CLOCK;
+  if (nCorpus == 0) return;
+  for (size_t i = 0;  i < nCorpus;  ++i) f(i);
+  uint64_t nOps = 0;  double dSeconds;
+  uint64_t nAllocs = CAllocations::GetCount(), nBytes = CAllocations::GetBytes();
+  CLOCK::time_point tStart = CLOCK::now();
+  do {
+    for (size_t i = 0;  i < nCorpus;  ++i) f(i);
+    nOps += nCorpus;
+    dSeconds = std::chrono::duration<double>(CLOCK::now() - tStart).count();
+  } while (dSeconds < m_dMinSeconds);
+  RESULT result;
+  result.sName = pszName;  result.nOps = nOps;
+  result.dNsPerOp = (dSeconds * 1e9) / nOps;
+  result.dAllocsPerOp = ((double) (CAllocations::GetCount() - nAllocs)) / nOps;
+  result.dBytesPerOp = ((double) (CAllocations::GetBytes() - nBytes)) / nOps;
+  m_vecResults.push_back(result);
+}
+
+
+void CMicroBenchmark::Run()
+{
+  //++
+  //   Time all the hot path functions.  Note that the validators modify the
+  // field they're checking (e.g. clearing it if it's invalid) so each call
+  // resets the field from the corpus first, and the cost of that copy is
+  // included in the result.  VerifyAll() likewise works on a fresh copy of
+  // the dog every time.
+  //
+  //   Validators that find an error log a bad dog, so we need a CBadDogs
+  // collection (which we throw away afterwards), and the console chatter
+  // is discarded while we're timing.
+  //--
+  m_vecResults.clear();
+  std::streambuf *pCout = std::cout.rdbuf(NULL);
+  CBadDogs *pBadDogs = new CBadDogs("");
+  BuildCorpora();
+  CDog scratch(m_vecDogs.front());
+  volatile size_t nSink = 0;
+
+  // CSV row and field methods ...
+  Measure("CCSVRow::Parse", m_vecLines.size(),
+    [&](size_t i) {CCSVRow row;  nSink += row.Parse(m_vecLines[i]);});
+  Measure("CCSVRow::ParseField", m_vecRawFields.size(),
+    [&](size_t i) {string::const_iterator it = m_vecRawFields[i].begin();
+                   nSink += CCSVRow::ParseField(m_vecRawFields[i], it).length();});
+  Measure("CCSVRow::TrimColumn", m_vecPadFields.size(),
+    [&](size_t i) {nSink += CCSVRow::TrimColumn(m_vecPadFields[i]).length();});
+  Measure("CCSVRow::RemoveEquals", m_vecEqFields.size(),
+    [&](size_t i) {nSink += CCSVRow::RemoveEquals(m_vecEqFields[i]).length();});
+  Measure("CCSVRow::Format", m_vecRows.size(),
+    [&](size_t i) {nSink += m_vecRows[i].Format().length();});
+
+  // CDog parsing ...
+  Measure("CDog::FromRow", m_vecRows.size(),
+    [&](size_t i) {CDog dog;  nSink += dog.FromRow(m_vecRows[i], true);});
+  Measure("CDog::ParseDate", m_vecDates.size(),
+    [&](size_t i) {uint32_t d, m, y;  nSink += CDog::ParseDate(m_vecDates[i], d, m, y);});
+  Measure("CDog::ComputeBirthday", m_vecDogs.size(),
+    [&](size_t i) {string s;  nSink += m_vecDogs[i].ComputeBirthday(s);});
+
+  // CDog validators ...
+  Measure("CDog::VerifyHomePhone", m_vecPhones.size(),
+    [&](size_t i) {scratch.SetAdoptionHomePhone(m_vecPhones[i]);  nSink += scratch.VerifyHomePhone(true);});
+  Measure("CDog::VerifyAdoptionZip", m_vecZips.size(),
+    [&](size_t i) {scratch.SetAdoptionZip(m_vecZips[i]);  nSink += scratch.VerifyAdoptionZip();});
+  Measure("CDog::VerifyAdoptioneMail", m_veceMails.size(),
+    [&](size_t i) {scratch.SetAdoptioneMail(m_veceMails[i]);  nSink += scratch.VerifyAdoptioneMail();});
+  Measure("CDog::VerifyAdoptionState", m_vecStates.size(),
+    [&](size_t i) {scratch.SetAdoptionState(m_vecStates[i]);  nSink += scratch.VerifyAdoptionState();});
+  Measure("CDog::VerifySex", m_vecDogs.size(),
+    [&](size_t i) {CDog &dog = m_vecDogs[i];  nSink += dog.VerifySex();});
+  Measure("CDog::VerifySpayNeuter", m_vecDogs.size(),
+    [&](size_t i) {CDog &dog = m_vecDogs[i];  nSink += dog.VerifySpayNeuter();});
+  Measure("CDog::VerifyAll", m_vecDogs.size(),
+    [&](size_t i) {CDog dog(m_vecDogs[i]);  nSink += dog.VerifyAll();});
+  Measure("CChip::VerifyMicrochip", m_vecChips.size(),
+    [&](size_t i) {string s(m_vecChips[i]);  nSink += CChip::VerifyMicrochip(s, false);});
+
+  // And lookups ...
+  Measure("CDogs::Find(number)", m_vecNumbers.size(),
+    [&](size_t i) {nSink += (m_Dogs.Find(m_vecNumbers[i]) != NULL);});
+  Measure("CDogs::Find(chip)", m_vecChips.size(),
+    [&](size_t i) {nSink += (m_Dogs.Find(m_vecChips[i]) != NULL);});
+
+  delete pBadDogs;
+  std::cout.rdbuf(pCout);  std::cout.clear();
+}
+
+
+void CMicroBenchmark::Report() const
+{
+  //++
+  // Print the results table on stdout ...
+  //--
+  bool fAllocs = CAllocations::IsEnabled();
+  MSGS(CBadDogs::Print("%-28s %12s %12s %12s %12s", "Function", "Calls", "ns/call", "allocs/call", "bytes/call"));
+  for (RESULT_VECTOR::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it) {
+    string sAllocs = fAllocs ? CBadDogs::Print("%12.2f %12.1f", it->dAllocsPerOp, it->dBytesPerOp)
+                             : CBadDogs::Print("%12s %12s", "n/a", "n/a");
+    MSGS(CBadDogs::Print("%-28s %12llu %12.1f ", it->sName.c_str(), (unsigned long long) it->nOps, it->dNsPerOp) << sAllocs);
+  }
+  if (!fAllocs) MSGS("(build with COUNT_ALLOCATIONS defined to count allocations)");
+}
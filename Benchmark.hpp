@@ -0,0 +1,203 @@
+//++
+// Benchmark.hpp -> end to end performance measurement
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The CBenchmark class generates synthetic DIR pairs of increasing size (see
+// CDIRGenerator) and then runs the whole MicrochipUpdate pipeline, RunUpdate(),
+// on each pair, and collects the time for each stage from the CMetrics phases
+// RunUpdate() already records.  At the end it prints a table with the wall
+// time, throughput and memory used by every stage at every size.
+//
+//   The memory is the resident set size at the end of each stage and how much
+// it changed during the stage.  The peak RSS that getrusage() gives us is the
+// high-water mark for the whole process, and it only ever goes up, so per
+// stage it would just be the biggest thing any earlier stage (or size!) ever
+// did.  Instead it's printed once, after the table.
+//
+//   The CMicroBenchmark class, on the other hand, times the individual parsing
+// and validation functions that the pipeline spends most of its time in, one
+// at a time, against fixed corpora of realistic input.  It reports the cost of
+// each one in nanoseconds and (if the program was built with COUNT_ALLOCATIONS,
+// see Allocations.hpp) in heap allocations per call.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add heap allocations to the end to end results.
+// 17-OCT-26  AGT   Report the current RSS per stage, and the peak only once.
+// 17-OCT-26  AGT   Run RunUpdate() and report its CMetrics phases.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <chrono>               // std::chrono::steady_clock, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "Dog.hpp"              // CDog data and CDogs collection
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+class CDIRGenerator;            // ...
+
+
+class CBenchmark {
+  //++
+  // End to end (aka "macro") benchmark for the whole program ...
+  //--
+
+public:
+  enum {
+    MIN_DOGS            = 10000,        // smallest benchmark size
+    MAX_DOGS            = 10000000,     // largest   "    "     "
+  };
+
+  // Results for one stage of one run ...
+  struct STAGE {
+    size_t    nDogs;                    // number of dogs in this run
+    string    sStage;                   // name of the stage
+    double    dSeconds;                 // wall time for this stage
+    uint64_t  nBytes;                   // bytes read or written (if any)
+    uint64_t  nRSS;                     // resident set size at the end, in bytes
+    int64_t   nRSSChange;               // change in the RSS during this stage
+    uint64_t  nAllocs;                  // heap allocations (COUNT_ALLOCATIONS only)
+    uint64_t  nAllocBytes;              // bytes allocated    "     "     "     "
+    uint64_t  nPeakHeap;                // heap high-water mark   "     "     "
+  };
+  typedef vector<STAGE> STAGE_VECTOR;
+
+public:
+  // Constructor and destructor ...
+  CBenchmark (CDIRGenerator &gen) : m_Generator(gen)
+    {m_nMaxDogs = MAX_DOGS;  m_sDirectory = ".";  m_fKeepFiles = false;}
+  virtual ~CBenchmark() {};
+  // Copy and assignment constructors ...
+  CBenchmark (const CBenchmark &bench) = delete;
+  CBenchmark& operator= (const CBenchmark &bench) = delete;
+
+  // CBenchmark public properties ...
+public:
+  // Set the largest number of dogs to try ...
+  void SetMaxDogs (size_t nDogs) {m_nMaxDogs = nDogs;}
+  // Set the directory used for the synthetic files ...
+  void SetDirectory (const string &sDir) {m_sDirectory = sDir;}
+  // Don't delete the synthetic files when we're done ...
+  void SetKeepFiles (bool fKeep=true) {m_fKeepFiles = fKeep;}
+  // Return the results so far ...
+  const STAGE_VECTOR &GetResults() const {return m_vecResults;}
+
+  // CBenchmark public methods ...
+public:
+  // Run the entire benchmark, for all sizes ...
+  void Run (uint32_t nCutoffYear, bool fOldFormat, bool fNewFormat);
+  // Run the pipeline (RunUpdate()) once for one pair of DIR files ...
+  void RunOne (size_t nDogs, const string &sOldFile, const string &sNewFile,
+               uint32_t nCutoffYear, bool fOldFormat, bool fNewFormat);
+  // Print the results table ...
+  void Report() const;
+  // Return the size of a file, in bytes ...
+  static uint64_t GetFileSize (const string &sFileName);
+
+  // Private internal CBenchmark methods ...
+protected:
+  typedef std::chrono::steady_clock CLOCK;
+  // Return the full path for a synthetic file ...
+  string MakeFileName (const char *pszName, size_t nDogs) const;
+
+  // Local CBenchmark members ...
+protected:
+  CDIRGenerator    &m_Generator;        // generates the DIR pairs for us
+  size_t            m_nMaxDogs;         // largest benchmark size
+  string            m_sDirectory;       // directory for synthetic files
+  bool              m_fKeepFiles;       // keep the synthetic files after
+  STAGE_VECTOR      m_vecResults;       // results for every stage
+};
+
+
+class CMicroBenchmark {
+  //++
+  // Per function (aka "micro") benchmarks for the hot paths ...
+  //--
+
+public:
+  enum {
+    CORPUS_DOGS         = 2000,         // number of dogs in the DIR corpus
+    CORPUS_SEED         = 4242,         // fixed seed for the DIR corpus
+  };
+
+  // Results for one function ...
+  struct RESULT {
+    string    sName;                    // name of the function tested
+    uint64_t  nOps;                     // number of calls timed
+    double    dNsPerOp;                 // nanoseconds per call
+    double    dAllocsPerOp;             // heap allocations per call
+    double    dBytesPerOp;              // bytes allocated per call
+  };
+  typedef vector<RESULT> RESULT_VECTOR;
+
+public:
+  // Constructor and destructor ...
+  CMicroBenchmark() {m_dMinSeconds = 0.25;}
+  virtual ~CMicroBenchmark() {};
+  // Copy and assignment constructors ...
+  CMicroBenchmark (const CMicroBenchmark &bench) = delete;
+  CMicroBenchmark& operator= (const CMicroBenchmark &bench) = delete;
+
+  // CMicroBenchmark public properties ...
+public:
+  // Set the minimum time spent timing each function ...
+  void SetMinSeconds (double dSeconds) {m_dMinSeconds = dSeconds;}
+  // Return the results so far ...
+  const RESULT_VECTOR &GetResults() const {return m_vecResults;}
+
+  // CMicroBenchmark public methods ...
+public:
+  // Build the corpora and time everything ...
+  void Run();
+  // Print the results table ...
+  void Report() const;
+
+  // Private internal CMicroBenchmark methods ...
+protected:
+  // Build the input corpora ...
+  void BuildCorpora();
+  //   Time one function, calling f(i) for i = 0..nCorpus-1 over and over
+  // until at least m_dMinSeconds has elapsed ...
+  template <typename F> void Measure (const char *pszName, size_t nCorpus, F f);
+
+  // Local CMicroBenchmark members ...
+protected:
+  double          m_dMinSeconds;        // minimum time for each function
+  RESULT_VECTOR   m_vecResults;         // results for every function
+  // Input corpora ...
+  vector<string>  m_vecLines;           // raw DIR lines
+  vector<CCSVRow> m_vecRows;            // parsed DIR rows
+  vector<string>  m_vecRawFields;       // raw (possibly quoted) CSV fields
+  vector<string>  m_vecPadFields;       // fields with leading/trailing blanks
+  vector<string>  m_vecEqFields;        // fields before RemoveEquals()
+  vector<string>  m_vecDates;           // YYYY-MM-DD dates (and junk)
+  vector<string>  m_vecPhones;          // phone numbers
+  vector<string>  m_vecZips;            // zip codes
+  vector<string>  m_veceMails;          // email addresses
+  vector<string>  m_vecStates;          // state abbreviations
+  vector<string>  m_vecChips;           // microchip numbers
+  vector<uint32_t> m_vecNumbers;        // dog numbers
+  vector<CDog>    m_vecDogs;            // parsed dogs
+  CDogs           m_Dogs;               // a collection of the same
+};
@@ -0,0 +1,179 @@
+//++
+// CSVDialect.cpp - implementation of the CCSVDialect class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CCSVDialect class, which figures out how a CSV
+// file is delimited and quoted.  See CSVDialect.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <vector>               // C++ vector collection ...
+#include <map>                  // C++ std::map (aka a sorted tree)
+#include "CSVDialect.hpp"       // declarations for this module
+using std::vector;              // ...
+using std::map;                 // ...
+
+// Delimiters we'll consider, in order of preference ...
+static const char g_achDelimiters[] = {',', '\t', ';', '|'};
+#define DELIMITER_COUNT  (sizeof(g_achDelimiters) / sizeof(g_achDelimiters[0]))
+
+
+/*static*/ size_t CCSVDialect::CountDelimiters (const string &sLine, char chDelimiter, char chQuote)
+{
+  //++
+  // Count the delimiters on one line, skipping any that are inside quotes ...
+  //--
+  size_t nCount = 0;  bool fInQuotes = false;
+  for (string::const_iterator it = sLine.begin();  it != sLine.end();  ++it) {
+    if (*it == chQuote)
+      fInQuotes = !fInQuotes;
+    else if ((*it == chDelimiter) && !fInQuotes)
+      ++nCount;
+  }
+  return nCount;
+}
+
+
+/*static*/ size_t CCSVDialect::CountQuoted (const string &sLine, char chDelimiter, char chQuote)
+{
+  //++
+  //   Count the fields on this line that start and end with this quote (not
+  // counting any spaces around them).  We don't worry about delimiters inside
+  // the quotes here - this is just a vote ...
+  //--
+  size_t nCount = 0, nStart = 0;
+  for (;;) {
+    size_t nEnd = sLine.find(chDelimiter, nStart);
+    if (nEnd == string::npos) nEnd = sLine.length();
+    size_t nFirst = sLine.find_first_not_of(" \t", nStart);
+    size_t nLast = sLine.find_last_not_of(" \t", (nEnd > 0) ? nEnd-1 : 0);
+    if ((nFirst != string::npos) && (nLast != string::npos) && (nFirst < nLast) && (nLast < nEnd)
+     && (sLine[nFirst] == chQuote) && (sLine[nLast] == chQuote)) ++nCount;
+    if (nEnd >= sLine.length()) break;
+    nStart = nEnd+1;
+  }
+  return nCount;
+}
+
+
+/*static*/ bool CCSVDialect::FindEquals (const string &sLine, char chDelimiter, char chQuote)
+{
+  //++
+  //   Return true if any field on this line starts with an "=" followed by a
+  // quote (again, ignoring any spaces in front of it) ...
+  //--
+  size_t nStart = 0;
+  for (;;) {
+    size_t nFirst = sLine.find_first_not_of(" \t", nStart);
+    if ((nFirst != string::npos) && (nFirst+1 < sLine.length())
+     && (sLine[nFirst] == '=') && (sLine[nFirst+1] == chQuote)) return true;
+    size_t nEnd = sLine.find(chDelimiter, nStart);
+    if (nEnd == string::npos) return false;
+    nStart = nEnd+1;
+  }
+}
+
+
+/*static*/ CCSVDialect CCSVDialect::Sniff (const string &sData)
+{
+  //++
+  //   Figure out the dialect of a CSV file from the first SNIFF_BYTES of it.
+  // If there's not enough to go on (say an empty file!) then the answer is
+  // the default NGRR dialect.  See the comments in CSVDialect.hpp for the
+  // rules ...
+  //--
+  string sSample = sData.substr(0, SNIFF_BYTES);
+
+  // The line ending is whatever ends the first line ...
+  char chEndOfLine = '\n';  bool fCRLF = false;
+  size_t nLF = sSample.find('\n'), nCR = sSample.find('\r');
+  if ((nCR != string::npos) && ((nLF == string::npos) || (nCR < nLF))) {
+    if (nCR+1 == nLF) fCRLF = true;  else chEndOfLine = '\r';
+  }
+
+  //   Break the sample into lines.  The last line is probably incomplete, so
+  // drop it unless the sample is the whole file ...
+  vector<string> vecLines;  size_t nStart = 0;
+  while ((nStart < sSample.length()) && (vecLines.size() < SNIFF_LINES)) {
+    size_t nEnd = sSample.find(chEndOfLine, nStart);
+    if ((nEnd == string::npos) && (sSample.length() < sData.length()) && !vecLines.empty()) break;
+    if (nEnd == string::npos) nEnd = sSample.length();
+    string sLine = sSample.substr(nStart, nEnd-nStart);
+    if (fCRLF && !sLine.empty() && (sLine[sLine.length()-1] == '\r')) sLine.erase(sLine.length()-1);
+    if (!sLine.empty()) vecLines.push_back(sLine);
+    nStart = nEnd+1;
+  }
+  if (vecLines.empty()) return CCSVDialect();
+
+  //   For each candidate delimiter, find the most common number of them per
+  // line and how many lines have exactly that many.  The most consistent one
+  // wins, and a tie goes to the one with more fields ...
+  char chDelimiter = ',';  size_t nBestLines = 0, nBestCount = 0;
+  for (size_t d = 0;  d < DELIMITER_COUNT;  ++d) {
+    map<size_t, size_t> mapCounts;
+    for (vector<string>::const_iterator it = vecLines.begin();  it != vecLines.end();  ++it)
+      ++mapCounts[CountDelimiters(*it, g_achDelimiters[d], '"')];
+    for (map<size_t, size_t>::const_iterator it = mapCounts.begin();  it != mapCounts.end();  ++it) {
+      if (it->first == 0) continue;
+      if ((it->second > nBestLines) || ((it->second == nBestLines) && (it->first > nBestCount))) {
+        chDelimiter = g_achDelimiters[d];  nBestLines = it->second;  nBestCount = it->first;
+      }
+    }
+  }
+
+  // Pick the quote, and check for ="..." ...
+  size_t nDouble = 0, nSingle = 0;  bool fAnyDouble = false;
+  for (vector<string>::const_iterator it = vecLines.begin();  it != vecLines.end();  ++it) {
+    nDouble += CountQuoted(*it, chDelimiter, '"');
+    nSingle += CountQuoted(*it, chDelimiter, '\'');
+    fAnyDouble |= (it->find('"') != string::npos);
+  }
+  char chQuote = ((nSingle > nDouble) && !fAnyDouble) ? '\'' : '"';
+  bool fEquals = false;
+  for (vector<string>::const_iterator it = vecLines.begin();  (it != vecLines.end()) && !fEquals;  ++it)
+    fEquals = FindEquals(*it, chDelimiter, chQuote);
+  return CCSVDialect(chDelimiter, chQuote, chEndOfLine, fCRLF, fEquals);
+}
+
+
+string CCSVDialect::Describe() const
+{
+  //++
+  // Describe this dialect, e.g. "tab delimited, CRLF line endings" ...
+  //--
+  string sResult;
+  switch (m_chDelimiter) {
+    case ',':   sResult = "comma";      break;
+    case '\t':  sResult = "tab";        break;
+    case ';':   sResult = "semicolon";  break;
+    case '|':   sResult = "vertical bar";  break;
+    default:    sResult = string("\"") + m_chDelimiter + "\"";  break;
+  }
+  sResult += " delimited";
+  if (m_chQuote != '"') sResult += ", single quoted";
+  sResult += m_fCRLF ? ", CRLF line endings" : (m_chEndOfLine == '\r') ? ", CR line endings" : ", LF line endings";
+  if (m_fEquals) sResult += ", =\"...\" fields";
+  return sResult;
+}
@@ -0,0 +1,107 @@
+//++
+// CSVDialect.hpp -> CSV file delimiter, quoting and line ending conventions
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   "CSV" is more of a family of file formats than a standard.  The NGRR web
+// page writes commas, double quotes and LF line endings, but once somebody
+// opens the file in Excel and saves it again it might have CRLF line endings,
+// tabs or semicolons between the fields, and ="..." wrapped around anything
+// that looks like a number.  A CCSVDialect records all that for one file.
+//
+//   Sniff() works it out from the first SNIFF_BYTES of the file.  The line
+// ending is whatever ends the first line.  The delimiter is the candidate
+// that appears (outside of quotes) the same number of times on the most
+// sample lines.  The quote is a double quote unless the fields are wrapped in
+// single quotes and double quotes never appear.  And the ="..." convention is
+// only turned on if one of the sample fields actually uses it.
+//
+//   CCSVRow uses the dialect to pick the parser - a line without any quote
+// characters is just split at the delimiters without running the quote state
+// machine.  Note that ="..." fields are always removed, no matter what the
+// sample said, since they can turn up anywhere in the file.  HasEquals() is
+// only used to tell the user.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <string>               // C++ std::string class, et al ...
+using std::size_t;              // ...
+using std::string;              // ...
+
+
+class CCSVDialect {
+  //++
+  // CSV file format conventions ...
+  //--
+
+public:
+  enum {
+    SNIFF_BYTES         = 4096,         // bytes sampled by Sniff()
+    SNIFF_LINES         = 32,           // maximum lines sampled
+  };
+
+public:
+  // Constructors (the default is what the NGRR web page writes) ...
+  CCSVDialect() {m_chDelimiter = ',';  m_chQuote = '"';  m_chEndOfLine = '\n';  m_fCRLF = false;  m_fEquals = true;}
+  CCSVDialect (char chDelimiter, char chQuote, char chEndOfLine, bool fCRLF, bool fEquals)
+    {m_chDelimiter = chDelimiter;  m_chQuote = chQuote;  m_chEndOfLine = chEndOfLine;  m_fCRLF = fCRLF;  m_fEquals = fEquals;}
+  // Destructor ...
+  virtual ~CCSVDialect() {};
+
+  // CCSVDialect properties ...
+public:
+  // Return the field delimiter and quote characters ...
+  char GetDelimiter() const {return m_chDelimiter;}
+  char GetQuote() const {return m_chQuote;}
+  // Return the character that ends a line (and whether a CR comes first) ...
+  char GetEndOfLine() const {return m_chEndOfLine;}
+  bool IsCRLF() const {return m_fCRLF;}
+  // Return true if the sample had fields wrapped in ="..." ...
+  bool HasEquals() const {return m_fEquals;}
+  // Return true if this is the plain comma, double quote, LF format ...
+  bool IsPlain() const
+    {return (m_chDelimiter == ',') && (m_chQuote == '"') && (m_chEndOfLine == '\n') && !m_fCRLF;}
+
+  // CCSVDialect public methods ...
+public:
+  // Figure out the dialect from the start of a file ...
+  static CCSVDialect Sniff (const string &sData);
+  // Describe this dialect in English (for messages) ...
+  string Describe() const;
+
+  // Private internal CCSVDialect methods ...
+protected:
+  // Count the delimiters on one line, ignoring any inside quotes ...
+  static size_t CountDelimiters (const string &sLine, char chDelimiter, char chQuote);
+  // Count the fields on one line that are wrapped in this quote ...
+  static size_t CountQuoted (const string &sLine, char chDelimiter, char chQuote);
+  // Return true if any field on this line is wrapped in ="..." ...
+  static bool FindEquals (const string &sLine, char chDelimiter, char chQuote);
+
+  // Local CCSVDialect members ...
+protected:
+  char    m_chDelimiter;        // character between fields
+  char    m_chQuote;            // character that quotes a field
+  char    m_chEndOfLine;        // character that ends a line
+  bool    m_fCRLF;              // true if lines end with CR LF
+  bool    m_fEquals;            // true if the sample had ="..." fields
+};
@@ -25,6 +25,14 @@
 //
 // REVISION HISTORY:
 //  5-Jul-19  RLA   New file.
+// 17-Oct-26  AGT   Count rows and bytes read and written for CMetrics.
+// 17-Oct-26  AGT   Normalize the input to UTF-8 before parsing it.
+// 17-Oct-26  AGT   Sniff the CSV dialect and parse with it.
+// 17-Oct-26  AGT   Report physical line numbers for multi-line records.
+// 17-Oct-26  AGT   Add ReadRow().
+// 17-Oct-26  AGT   Read() can filter the records with a CWhere expression.
+// 17-Oct-26  AGT   ReadRow() takes a dog ID, prefix and all.
+// 17-Oct-26  AGT   Only mention the dialect if it's not the usual one.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -33,8 +41,13 @@
 #include <assert.h>             // assert() (what else??)
 #include <iostream>             // std::ios, std::istream, std::cout
 #include <fstream>              // std::filebuf
+#include <sstream>              // std::ostringstream, std::istringstream
 #include "Messages.hpp"         // ERRS() macro, et al ...
 #include "CSVRow.hpp"           // class for each row of the spreadsheet
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "Encoding.hpp"         // CEncoding::Normalize() ...
+#include "RowIndex.hpp"         // sidecar row offset index
+#include "Where.hpp"            // "--where" record filters
 #include "CSVFile.hpp"          // declarations for this module
 
 
@@ -85,7 +98,7 @@ void CCSVFile::CopyRows (const ROW_VECTOR &rows)
 }
 
 
-size_t CCSVFile::Read (istream &stm, const string sHeader)
+size_t CCSVFile::Read (istream &stm, const string sHeader, const CCSVDialect &dialect, const CWhere *pWhere)
 {
   //++
   //   This method will attempt to read an entire spreadsheet from a CSV file.
@@ -97,23 +110,36 @@ size_t CCSVFile::Read (istream &stm, const string sHeader)
   //   If strHeader is omitted or null, then no hreader row is expected and no
   // check is made on the number of columns.  In this case it's possible for
   // different rows in this spreadsheet to have differing column counts!
+  //
+  //   The header string is always comma delimited, but the file itself can
+  // be in any dialect.
+  //
+  //   If pWhere is given then only the records that match it are kept.  It's
+  // applied to the raw text of each record, so the ones that don't match are
+  // never parsed (and their column count is never checked, either).
   //--
-  CCSVRow row;  size_t nCols = 0;  uint32_t nLines = 0;
+  CCSVRow row;  size_t nCols = 0;  uint32_t nLine = 0;  string sRecord;
 
   // If a header was specified, then verify that first ...
   if (!sHeader.empty()) {
-    stm >> row;  nCols = row.size();  ++nLines;
+    row.Read(stm, dialect, nLine);  nCols = row.size();
     if (!row.Verify(sHeader))
       MSGS("CCSVFile::Read() header does not match");
   }
 
-  // Now read the rest of the file ...
+  //   Now read the rest of the file.  A record can be more than one line
+  // long, so any error message gives the physical line where it starts ...
   for (;;) {
-    stm >> row;
-    if ((stm.eof()) && (row.size() == 0)) break;
-    ++nLines;
+    uint32_t nFirst = nLine+1;
+    if (!CCSVRow::ReadRecord(stm, dialect, nLine, sRecord)) sRecord.clear();
+    if ((stm.eof()) && sRecord.empty()) break;
+    METRIC(ROWS_READ);
+    if ((pWhere != NULL) && !pWhere->Match(sRecord, dialect)) {
+      METRIC(ROWS_FILTERED);  continue;
+    }
+    row.Parse(sRecord, dialect);
     if ((nCols > 0)  &&  (row.size() != nCols))
-      MSGS("CCSVFile::Read() wrong number of columns in line " << nLines);
+      MSGS("CCSVFile::Read() wrong number of columns in line " << nFirst);
     AddRow(row);
   }
 
@@ -122,19 +148,54 @@ size_t CCSVFile::Read (istream &stm, const string sHeader)
 }
 
 
-size_t CCSVFile::Read (const string &sFileName, const string sHeader)
+size_t CCSVFile::Read (const string &sFileName, const string sHeader, const CWhere *pWhere)
 {
   //++
   //   This method is similar to the previous one, but it also handles opening
-  // the file, reading the spreadsheet, and then closing the file.
+  // the file, reading the spreadsheet, and then closing the file.  The whole
+  // file is read into memory first so that CEncoding can get rid of any byte
+  // order mark and convert any Windows-1252 characters to UTF-8.  For the
+  // usual ASCII file that costs one quick scan and nothing else.  Then the
+  // first few KB are used to figure out the CSV dialect ...
   //--
   std::filebuf fb;
   if (!fb.open(sFileName, std::ios::in))
     ERRS("CCSVFile::Read() unable to open " << sFileName);
-  std::istream is(&fb);
-  Read(is, sHeader);
+  std::ostringstream os;
+  if (fb.sgetc() != std::filebuf::traits_type::eof()) os << &fb;
   fb.close();
-  return size();
+  string sData = os.str();
+  if (sData.length() > 0) METRICN(BYTES_READ, (uint64_t) sData.length());
+  size_t nConverted;
+  if (CEncoding::Normalize(sData, nConverted) == CEncoding::WINDOWS1252)
+    MSGS("Converted " << nConverted << " Windows-1252 characters in " << sFileName);
+  CCSVDialect dialect = CCSVDialect::Sniff(sData);
+  //   Only mention the dialect if its layout is different from the default
+  // CCSVDialect().  The NGRR web page writes ="..." fields and everything
+  // else doesn't, so that by itself isn't worth a message ...
+  if (!dialect.IsPlain())
+    MSGS(sFileName << " is " << dialect.Describe());
+  std::istringstream is(sData);
+  return Read(is, sHeader, dialect, pWhere);
+}
+
+
+/*static*/ bool CCSVFile::ReadRow (const string &sFileName, const string &sID, CCSVRow &row, uint32_t nKeyColumn)
+{
+  //++
+  //   Read the one row from a CSV file with this dog ID (e.g. "12345" or
+  // "ABC-123") in its key column, without reading the rest of the file.  The
+  // first time this builds a CRowIndex for the file, and after that it's just
+  // one seek.  Returns false if there's no such row (or the ID isn't valid).
+  // If you want more than a few rows, then it's better to keep a CRowIndex
+  // around and use that directly ...
+  //--
+  uint64_t nKey;
+  if (!CRowIndex::ParseKey(sID, nKey)) return false;
+  CRowIndex index(sFileName, nKeyColumn);
+  if (!index.Open())
+    ERRS("CCSVFile::ReadRow() unable to open " << sFileName);
+  return index.ReadRow(nKey, row);
 }
 
 
@@ -169,6 +230,8 @@ size_t CCSVFile::Write (const string &sFileName, const string sHeader) const
     ERRS("CCSVFile::Write() unable to create " << sFileName);
   std::ostream os(&fb);
   size_t nRows = Write(os, sHeader);
+  std::streamoff nBytes = os.tellp();
+  if (nBytes > 0) METRICN(BYTES_WRITTEN, (uint64_t) nBytes);
   fb.close();
   return nRows;
 }
@@ -26,19 +26,25 @@
 //
 // REVISION HISTORY:
 //  5-JUL-19  RLA   New file.
+// 17-OCT-26  AGT   Read() takes a CCSVDialect.
+// 17-OCT-26  AGT   Add ReadRow().
+// 17-OCT-26  AGT   ReadRow() takes a dog ID, prefix and all.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
 #pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
 #include <string>               // C++ std::string class, et al ...
 #include <iostream>             // C++ style output ...
 #include <vector>               // C++ vector collection ...
+#include "CSVDialect.hpp"       // delimiter, quote and line ending conventions
 using std::size_t;              // ...
 using std::string;              // ...
 using std::vector;              // ...
 using std::istream;             // ...
 using std::ostream;             // ...
 class CCSVRow;                  // need some forward references to these 
+class CWhere;                   // ...
 
 
 class CCSVFile {
@@ -87,8 +93,10 @@ public:
   void AddRows(const ROW_VECTOR &rows);
   void AddRows(const CCSVFile &csv) { AddRows(csv.m_vecRows); }
   // Read this spreadsheet from a file ...
-  size_t Read (istream &stm, const string sHeader="");
-  size_t Read (const string &sFileName, const string sHeader="");
+  size_t Read (istream &stm, const string sHeader="", const CCSVDialect &dialect=CCSVDialect(), const CWhere *pWhere=NULL);
+  size_t Read (const string &sFileName, const string sHeader="", const CWhere *pWhere=NULL);
+  // Read just one row, by the dog ID in its key column (see CRowIndex) ...
+  static bool ReadRow (const string &sFileName, const string &sID, CCSVRow &row, uint32_t nKeyColumn=1);
   // Write this spreadsheet to a file ...
   size_t Write (ostream &stm, const string sHeader="") const;
   size_t Write (const string &sFileName, const string sHeader="") const;
@@ -25,6 +25,11 @@
 //
 // REVISION HISTORY:
 //  4-Jul-19  RLA   New file.
+// 17-Oct-26  AGT   Add CCSVDialect versions of Parse() and Read().
+// 17-Oct-26  AGT   Read() handles quoted fields with embedded line breaks.
+// 17-Oct-26  AGT   Split ReadRecord() out of Read().
+// 17-Oct-26  AGT   Allocate CCSVRow objects from a CArena.
+// 17-Oct-26  AGT   One CCSVRow arena per thread.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -32,9 +37,12 @@
 #include <stdint.h>	        // uint8_t, uint32_t, etc ...
 #include <assert.h>             // assert() (what else??)
 #include <iostream>             // std::ios, std::istream, std::cout
+#include <algorithm>            // std::count() ...
 #include "Messages.hpp"         // ERRS() macro, et al ...
 #include "CSVRow.hpp"           // declarations for this module
 
+// Each thread's arena for its CCSVRow objects ...
+thread_local CArena CCSVRow::m_Arena(sizeof(CCSVRow));
 
 
 string CCSVRow::TrimColumn (const string &src)
@@ -49,7 +57,34 @@ string CCSVRow::TrimColumn (const string &src)
 }
 
 
-string CCSVRow::RemoveEquals(const string &src)
+string CCSVRow::TrimRange (const string &src, size_t nStart, size_t nEnd)
+{
+  //++
+  //   Return the characters from nStart up to (but not including) nEnd with
+  // any leading and trailing white space removed.  Unlike TrimColumn() this
+  // gets it right the first time, so the fast path in Parse() only has to
+  // call it once ...
+  //--
+  while ((nStart < nEnd) && ((src[nStart] == ' ') || (src[nStart] == '\t'))) ++nStart;
+  while ((nEnd > nStart) && ((src[nEnd-1] == ' ') || (src[nEnd-1] == '\t'))) --nEnd;
+  return src.substr(nStart, nEnd-nStart);
+}
+
+
+string CCSVRow::CleanField (const string &src, char chQuote)
+{
+  //++
+  //   Trim a field and, if it starts with "=", remove that the same way that
+  // Parse() always has ...
+  //--
+  size_t nFirst = src.find_first_not_of(" \t");
+  if ((nFirst != string::npos) && (src[nFirst] == '='))
+    return TrimColumn(RemoveEquals(TrimColumn(src), chQuote));
+  return TrimRange(src, 0, src.length());
+}
+
+
+string CCSVRow::RemoveEquals(const string &src, char chQuote)
 {
   //++
   //   Some CSV files force numeric data to be interpreted as a string by 
@@ -60,7 +95,7 @@ string CCSVRow::RemoveEquals(const string &src)
   if ((src.length() == 0)  ||  (src[0] != '='))  return src;
   string dst = src.substr(1);
   if (dst.length() < 2) return dst;
-  if ((dst[0] != QUOTE)  ||  (dst[dst.length()-1] != QUOTE))  return dst;
+  if ((dst[0] != chQuote)  ||  (dst[dst.length()-1] != chQuote))  return dst;
   return dst.substr(1, dst.length()-2);
 }
 
@@ -68,16 +103,17 @@ string CCSVRow::RemoveEquals(const string &src)
 bool CCSVRow::NeedsQuotes (const string &str)
 {
   //++
-  //   Return TRUE if the string contains either a quote or a comma (meaning
-  // that it needs to be quoted in the CSV file!) ...
+  //   Return TRUE if the string contains a quote, a comma or a line break
+  // (meaning that it needs to be quoted in the CSV file!) ...
   //--
   if (str.find(QUOTE) != string::npos) return true;
   if (str.find(COMMA) != string::npos) return true;
+  if (str.find_first_of("\r\n") != string::npos) return true;
   return false;
 }
 
 
-string CCSVRow::ParseField (const string &str, string::const_iterator &it)
+string CCSVRow::ParseField (const string &str, string::const_iterator &it, char chDelimiter, char chQuote)
 {
   //++
   //   This routine will scan the next field from the CSV line.  It essentially
@@ -86,10 +122,10 @@ string CCSVRow::ParseField (const string &str, string::const_iterator &it)
   //--
   bool fInQuotes = false, fQuoteLast = false;  string sResult("");
   for (;  it != str.end();  ++it) {
-    if ((*it == COMMA)  &&  !fInQuotes)  break;
-    if (*it == QUOTE) {
+    if ((*it == chDelimiter)  &&  !fInQuotes)  break;
+    if (*it == chQuote) {
       if (!fInQuotes) {
-        if (fQuoteLast) sResult.push_back(QUOTE);
+        if (fQuoteLast) sResult.push_back(chQuote);
         fQuoteLast = false;  fInQuotes = true;
       } else {
         fInQuotes = false;  fQuoteLast = true;
@@ -125,15 +161,122 @@ size_t CCSVRow::Parse (const string &str)
 }
 
 
+size_t CCSVRow::Parse (const string &str, const CCSVDialect &dialect)
+{
+  //++
+  //   Parse a row using the delimiter and quote from this dialect, and pick
+  // the cheapest way to do it.  If this line has no quotes at all, then
+  // there's nothing to do but split it at the delimiters.  Otherwise it's the
+  // same quote state machine as Parse() above.  Either way a field is just
+  // trimmed unless it starts with "=", and then it gets exactly the same
+  // treatment as Parse() gives it.  The dialect's HasEquals() isn't trusted
+  // here - Sniff() only looks at the start of the file and Excel is happy to
+  // put ="..." anywhere it likes.
+  //--
+  ClearColumns();
+  if (str.length() == 0) return 0;
+  char chDelimiter = dialect.GetDelimiter(), chQuote = dialect.GetQuote();
+  if (str.find(chQuote) == string::npos) {
+    for (size_t nStart = 0;;) {
+      size_t nEnd = str.find(chDelimiter, nStart);
+      if (nEnd == string::npos) nEnd = str.length();
+      AddColumn(CleanField(str.substr(nStart, nEnd-nStart), chQuote));
+      if (nEnd == str.length()) break;
+      nStart = nEnd+1;
+    }
+  } else {
+    for (string::const_iterator it = str.begin();; ++it) {
+      AddColumn(CleanField(ParseField(str, it, chDelimiter, chQuote), chQuote));
+      if (it == str.end()) break;
+    }
+  }
+  return size();
+}
+
+
 size_t CCSVRow::Read (istream &stm)
 {
   //++
-  // Read the next line/row from the stream and extract the columns ...
+  // Read the next record from a plain NGRR format CSV stream ...
+  //--
+  return Read(stm, CCSVDialect());
+}
+
+
+/*static*/ bool CCSVRow::ReadLine (istream &stm, string &str, const CCSVDialect &dialect)
+{
+  //++
+  //   Read one physical line using this dialect's line ending (and throw away
+  // the CR if it's a CRLF file).  Returns false if there was nothing left to
+  // read at all ...
+  //--
+  if (!std::getline(stm, str, dialect.GetEndOfLine())) return false;
+  if (dialect.IsCRLF() && !str.empty() && (str[str.length()-1] == '\r')) str.erase(str.length()-1);
+  return true;
+}
+
+
+/*static*/ bool CCSVRow::ReadRecord (istream &stm, const CCSVDialect &dialect, uint32_t &nLine, string &str)
+{
+  //++
+  //   Read the raw text of the next record from the stream.  A quoted
+  // field can contain line breaks, so a record can be more than one physical
+  // line.  Nearly every line has no quotes at all, and then it's the whole
+  // record and we're done.  Otherwise we count the quotes (an escaped "" is
+  // two of them, so it doesn't matter) and as long as there's an odd number
+  // we're still inside a field and the next line is part of this record.  The
+  // line breaks inside a field are stored as a plain LF (in a CRLF file the
+  // CR is dropped, just as it is at the end of a record).
+  //
+  //   A stray quote would swallow the rest of the file, so if the quotes
+  // still aren't matched after MAXLINES lines (or at the end of the file)
+  // we give up, back up and just use the first line, the same as we always
+  // used to.  nLine is the physical line number of the last line read, and
+  // it's updated for all the lines in this record.  Returns false if there
+  // was nothing left to read ...
+  //--
+  str.clear();
+  if (stm.eof() || !ReadLine(stm, str, dialect)) return false;
+  ++nLine;
+  char chQuote = dialect.GetQuote();
+  if (str.find(chQuote) != string::npos) {
+    size_t nQuotes = std::count(str.begin(), str.end(), chQuote);
+    std::streampos pos = stm.tellg();  size_t nLength = str.length();
+    uint32_t nLines = 1;  string sNext;
+    while (((nQuotes & 1) != 0) && (nLines < MAXLINES) && ReadLine(stm, sNext, dialect)) {
+      str.push_back('\n');  str.append(sNext);  ++nLines;
+      nQuotes += std::count(sNext.begin(), sNext.end(), chQuote);
+    }
+    if ((nQuotes & 1) != 0) {
+      MSGS("CCSVRow::Read() unmatched quote in line " << nLine);
+      if (pos != std::streampos(-1)) {
+        stm.clear();  stm.seekg(pos);  str.erase(nLength);  nLines = 1;
+      }
+    }
+    nLine += nLines-1;
+  }
+  return true;
+}
+
+
+size_t CCSVRow::Read (istream &stm, const CCSVDialect &dialect, uint32_t &nLine)
+{
+  //++
+  // Read the next record from the stream and extract the columns ...
+  //--
+  string str;  ClearColumns();
+  if (!ReadRecord(stm, dialect, nLine, str)) return 0;
+  return Parse(str, dialect);
+}
+
+
+size_t CCSVRow::Read (istream &stm, const CCSVDialect &dialect)
+{
+  //++
+  // Read the next record when we don't care about the line numbers ...
   //--
-  string str;
-  if (stm.eof()) return 0;
-  std::getline(stm, str);
-  return Parse(str);
+  uint32_t nLine = 0;
+  return Read(stm, dialect, nLine);
 }
 
 
@@ -170,8 +313,9 @@ string CCSVRow::FormatField (const string &col)
 {
   //++
   //   This method will format a single column/field into a string.  This is
-  // trivial UNLESS the field comtains an embedded comma or quote, in which
-  // case this field has to be quoted (and any embedded quotes escaped!).
+  // trivial UNLESS the field comtains an embedded comma, quote or line break,
+  // in which case this field has to be quoted (and any embedded quotes
+  // escaped!).
   //--
   if (!NeedsQuotes(col)) return col;
   string str("");    str.push_back(QUOTE);
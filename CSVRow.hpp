@@ -25,13 +25,20 @@
 //
 // REVISION HISTORY:
 //  4-JUL-19  RLA   New file.
+// 17-OCT-26  AGT   Add CCSVDialect versions of Parse() and Read().
+// 17-OCT-26  AGT   Records can span lines if a quoted field has a line break.
+// 17-OCT-26  AGT   Allocate CCSVRow objects from a CArena.
+// 17-OCT-26  AGT   One CCSVRow arena per thread.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
 #pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
 #include <string>               // C++ std::string class, et al ...
 #include <iostream>             // C++ style output ...
 #include <vector>               // C++ vector collection ...
+#include "CSVDialect.hpp"       // delimiter, quote and line ending conventions
+#include "Arena.hpp"            // fixed size object arenas
 using std::size_t;              // ...
 using std::string;              // ...
 using std::vector;              // ...
@@ -43,12 +50,14 @@ class CCSVRow
 {
   //++
   //--
+  friend class CMicroBenchmark;  // needs access to the field level methods
 
 public:
   // Magic constants ...
   enum {
     COMMA = ',',                // delimiter used between fields in CSV files
-    QUOTE = '"'                 // character used to quote literal strings
+    QUOTE = '"',                // character used to quote literal strings
+    MAXLINES = 64               // most physical lines in one record
   };
 
 public:
@@ -68,6 +77,9 @@ public:
   CCSVRow& operator= (const CCSVRow &row) {ClearColumns();  CopyColumns(row);  return *this;}
   // Destructor ...
   virtual ~CCSVRow() {};
+  // CCSVRow objects are allocated from this thread's m_Arena ...
+  static void *operator new (size_t nBytes) {return m_Arena.Allocate(nBytes);}
+  static void operator delete (void *pRow, size_t nBytes) {m_Arena.Free(pRow, nBytes);}
 
   // CCSVRow collection properties ...
 public:
@@ -88,8 +100,13 @@ public:
 public:
   // Parse a string and extract the fields/columns ...
   size_t Parse (const string &str);
-  // Read the next line/row from the stream and extract the columns ...
+  size_t Parse (const string &str, const CCSVDialect &dialect);
+  // Read the next record from the stream and extract the columns ...
   size_t Read (istream &stm);
+  size_t Read (istream &stm, const CCSVDialect &dialect);
+  size_t Read (istream &stm, const CCSVDialect &dialect, uint32_t &nLine);
+  // Read the raw text of the next record, without parsing it ...
+  static bool ReadRecord (istream &stm, const CCSVDialect &dialect, uint32_t &nLine, string &sRecord);
   // Verify the column headers ...
   bool Verify (const string &str) const;
   bool Verify (const CCSVRow &row) const;
@@ -109,18 +126,25 @@ protected:
   void AddColumn (const string &str)  {m_vecColumns.push_back(str);}
   // Trim leading and trailing white space from a field ...
   static string TrimColumn (const string &src);
+  // Trim white space from part of a string (correctly, unlike TrimColumn()!) ...
+  static string TrimRange (const string &src, size_t nStart, size_t nEnd);
+  // Trim a field and remove any ="..." from it ...
+  static string CleanField (const string &src, char chQuote);
   // Remove the "="..."" gaarbage ...
-  static string RemoveEquals (const string &src);
+  static string RemoveEquals (const string &src, char chQuote=QUOTE);
   // Return TRUE if a field contains a quote or comma itself ...
   static bool NeedsQuotes (const string &str);
+  // Read one physical line from a stream ...
+  static bool ReadLine (istream &stm, string &str, const CCSVDialect &dialect);
   // Parse a single field from a string ...
-  static string ParseField (const string &str, string::const_iterator &it);
+  static string ParseField (const string &str, string::const_iterator &it, char chDelimiter=COMMA, char chQuote=QUOTE);
   // Format a single column/field into a string ...
   static string FormatField (const string &col);
 
   // Local CCSVRow members ...
 protected:
   COLUMN_VECTOR m_vecColumns;   // fields/columns in this row
+  static thread_local CArena m_Arena;  // this thread's CCSVRow objects
 };
 
 // Allow streaming directly to and from CCSVRow objects ...
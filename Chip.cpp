@@ -59,6 +59,10 @@
 // 28-NOV-22  RLA   Always use today's date as the "Service Date".
 // 28-APR-23  RLA   Don't include the dog number in the name anymore!
 // 17-DEC-23  RLA   Add a special hack for Pumpkin's 202 chip
+// 17-OCT-26  AGT   Count microchip validations for CMetrics.
+// 17-OCT-26  AGT   Use the dog ID, which may have an organization prefix.
+// 17-OCT-26  AGT   Get the rescue's details from the current COrgProfile.
+// 17-OCT-26  AGT   Don't repeat the organization prefix in the notes.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -73,6 +77,8 @@
 #include "CSVFile.hpp"          // a collection of spreadsheet rows
 #include "Dog.hpp"              // dog data declarations
 #include "Chip.hpp"             // declarations for this module
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "OrgProfile.hpp"       // rescue organization profiles
 
 // This is the expected header row for the "Dogs Data" (DD) report generated by the NGRR web page ...
 const string CChip::m_sNGRRHeaders("Adoption FName,Adoption LName,Email Address,Address 1,Address 2,City,State,Zip Code,Home Phone,Work Phone,Cell Phone,Pet Name,Microchip Number,Service Date,Date of Birth,Species,Sex,Spayed/Neutered,Primary Breed,Secondary Breed,Rescue Group Email,Notes");
@@ -122,6 +128,7 @@ const string CChip::m_sFoundHeaders("First Name,Last Name,Email Address,Address
   // for removing the asterisks or spaces from the 9 digit chips.  Everything
   // else is either good or bad as it stands.
   //--
+  METRIC(VALIDATIONS);
   if (sChip.empty()) 
     {MSGS("microchip cannot be blank");   return false;}
 
@@ -194,7 +201,7 @@ bool CChip::FromDog (CDog *pDog)
   assert(pDog != NULL);
   m_sMicrochip = pDog->GetChip();  m_pDog = pDog;
   if (!VerifyMicrochip(m_sMicrochip, false)) {
-    MSGS("dog " << pDog->GetName() << " #" << pDog->GetNumber() << " has invalid microchip \"" << m_sMicrochip << "\"");
+    MSGS("dog " << pDog->GetName() << " #" << pDog->GetID() << " has invalid microchip \"" << m_sMicrochip << "\"");
     return false;
   } else
     return true;
@@ -274,6 +281,7 @@ void CChip::ToRow (CCSVRow &row) const
   // file in the NGRR format and no need to read one in the Found.org format!
   //--
   const CDog *pDog = GetDog();
+  const COrgProfile *pOrg = COrgProfile::Get();
   //   If there's no adopter name, then the dog is being registered to NGRR
   // (at least temporarily, until it gets adopted).  In that case Found.org
   // will not allow use to leave all the adopter fields blank - we're required
@@ -293,16 +301,16 @@ void CChip::ToRow (CCSVRow &row) const
     row[COL_FOUND_WORK_PHONE-1]         = m_pDog->GetAdoptionWorkPhone();
     row[COL_FOUND_CELL_PHONE-1]         = m_pDog->GetAdoptionCellPhone();
   } else {
-    // Not adopted - use the hardwired NGRR data ...
-    row[COL_FOUND_FIRST_NAME-1]         = NGRR_FIRST_NAME;
-    row[COL_FOUND_LAST_NAME-1]          = NGRR_LAST_NAME;
-    row[COL_FOUND_EMAIL_ADDRESS-1]      = NGRR_EMAIL_ADDRESS;
+    // Not adopted - use the rescue's own data ...
+    row[COL_FOUND_FIRST_NAME-1]         = pOrg->GetFirstName();
+    row[COL_FOUND_LAST_NAME-1]          = pOrg->GetLastName();
+    row[COL_FOUND_EMAIL_ADDRESS-1]      = pOrg->GeteMail();
     row[COL_FOUND_ADDRESS_1-1]          = "";
     row[COL_FOUND_ADDRESS_2-1]          = "";
     row[COL_FOUND_CITY-1]               = "";
     row[COL_FOUND_STATE-1]              = "";
     row[COL_FOUND_ZIP_CODE-1]           = "";
-    row[COL_FOUND_HOME_PHONE-1]         = NGRR_PHONE_NUMBER;
+    row[COL_FOUND_HOME_PHONE-1]         = pOrg->GetPhone();
     row[COL_FOUND_WORK_PHONE-1]         = "";
     row[COL_FOUND_CELL_PHONE-1]         = "";
   }
@@ -323,17 +331,21 @@ void CChip::ToRow (CCSVRow &row) const
   row[COL_FOUND_SERVICE_DATE-1]       = sServiceDate;
   string sDOB;
   row[COL_FOUND_DATE_OF_BIRTH-1]      = pDog->ComputeBirthday(sDOB) ? sDOB : "";
-  row[COL_FOUND_SPECIES-1]            = NGRR_SPECIES;
+  row[COL_FOUND_SPECIES-1]            = pOrg->GetSpecies();
   row[COL_FOUND_SEX-1]                = pDog->GetSex();
   //   Note that the SPAY/NEUTER field in the DIR represents the dogs' condition
   // when NGRR gets it, NOT the dogs' condition when it's adopted!  The assumption
   // is that we will ALWAYS spay or neuter our dogs before they're adopted...
   row[COL_FOUND_SPAYED_NEUTERED-1]    = "Yes";
-  row[COL_FOUND_PRIMARY_BREED-1]      = NGRR_PRIMARY_BREED;
+  row[COL_FOUND_PRIMARY_BREED-1]      = pOrg->GetBreed();
   row[COL_FOUND_SECONDARY_BREED-1]    = "";
-  row[COL_FOUND_RESCUE_GROUP_EMAIL-1] = NGRR_EMAIL_ADDRESS;
-  // Store the dogs' NGRR number and today's date in the notes field ...
-  string sNotes = "NGRR #" + std::to_string(pDog->GetNumber());
+  row[COL_FOUND_RESCUE_GROUP_EMAIL-1] = pOrg->GeteMail();
+  //   Store the rescue and the dog's number in the notes field.  If the dog's
+  // prefix is the profile's own organization then the name already says which
+  // rescue it is, so that's "GRRA #1234" and not "GRRA #GRRA-1234".  A dog
+  // from some other rescue keeps its whole ID ...
+  bool fSameOrg = CDog::GetOrgPrefix(pDog->GetOrg()) == pOrg->GetOrg();
+  string sNotes = pOrg->GetName() + " #" + (fSameOrg ? std::to_string(pDog->GetNumber()) : pDog->GetID());
   row[COL_FOUND_NOTES-1]              = sNotes;
 }
 
@@ -24,6 +24,8 @@
 //
 // REVISION HISTORY:
 //  9-JUL-19  RLA   New file.
+// 17-OCT-26  AGT   The NGRR_xyz constants are now just the defaults for the
+//                  built in NGRR organization profile (see COrgProfile).
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -38,7 +40,9 @@ class CCSVRow;                  // ...
 class CDog;                     // individual dog data
 class CDogs;                    // collection of all NGRR dogs
 
-// NGRR Magic constants ...
+//   NGRR Magic constants ...  CChip::ToRow() doesn't use these directly any
+// more - they're the built in NGRR profile, and other rescues have their own
+// (see OrgProfile.hpp) ...
 #define NGRR_CHIP_PREFIX    "98102"                   // prefix for all Datamars/NGRR chips
 #define NGRR_SPECIES        "Dog"                     // well, duh!
 #define NGRR_PRIMARY_BREED  "Golden Retriever"        // if it's not a Golden Retriever, it's just a dog...
@@ -0,0 +1,1262 @@
+//++
+// DiffHarness.cpp - differential testing of fast paths vs reference code
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CDiffHarness class.  The second half of the file
+// is the frozen reference code - these are copies of CCSVRow::Parse(), the
+// regex based CDog validators, CChip::VerifyMicrochip() and the seven pass
+// CompareDogs() exactly as they were in October 2026.  The only changes are
+// that the validators return their error message instead of calling BADDOGS()
+// (so that we can compare it) and that the metrics and trace calls are gone.
+// PLEASE DON'T "FIX" ANYTHING IN THE REFERENCE CODE, even the obvious bugs
+// (e.g. TrimColumn() with leading blanks) - the fast paths have to be bug for
+// bug compatible with it.
+//
+//   The pipeline check reads each DIR twice - once with the reference parser
+// and once with CDogs::ReadFile() - and then runs the reference or the real
+// CompareDogs(), followed by BuildUpdates().  The output compared is the
+// complete text of the updates file and the errors file.
+//
+//   All the usual console chatter is discarded while the checks are running,
+// just like the benchmarks.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   CDog::ComputeBirthday() accepts more age layouts now, so
+//                  the reference is a regex for the new grammar.
+// 17-Oct-26  AGT   Add the households pipeline check.
+// 17-Oct-26  AGT   Put the frozen ComputeBirthday() reference back, exempt
+//                  only the new age layouts from it, and check the new
+//                  grammar separately.
+// 17-Oct-26  AGT   Add the shards check (single run vs shard, batch, merge).
+// 17-Oct-26  AGT   Add households that span shards to the shards check.
+// 17-Oct-26  AGT   Add the CDomainChecker::Suggest check.
+// 17-Oct-26  AGT   Add the whatif check (CWhatIf vs a real run for each cutoff).
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stdio.h>              // remove() ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::ifstream, std::ofstream
+#include <sstream>              // std::ostringstream, std::istringstream
+#include <regex>                // regular expression matching ...
+#include <algorithm>            // std::min(), std::sort(), std::unique() ...
+#include <unordered_map>        // std::unordered_map ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Chip.hpp"             // CChip data and CChips collection
+#include "Generate.hpp"         // synthetic DIR generator
+#include "Household.hpp"        // CHouseholds adopter grouping
+#include "DomainChecker.hpp"    // CDomainChecker email domain typos
+#include "Batch.hpp"            // CBatch update runs from a manifest
+#include "Shard.hpp"            // CShards split and merge
+#include "WhatIf.hpp"           // CWhatIf several cutoff years at once
+#include "MicrochipUpdate.hpp"  // CompareDogs(), BuildUpdates(), etc
+#include "DiffHarness.hpp"      // declarations for this module
+
+
+CDiffHarness::CDiffHarness (CDIRGenerator &gen) : m_Generator(gen)
+{
+  //++
+  // Initialize everything to the defaults ...
+  //--
+  m_sDirectory = ".";  m_nCutoffYear = 2019;
+  m_fOldFormat = m_fNewFormat = true;
+  m_pScratch = new CDog;
+}
+
+
+CDiffHarness::~CDiffHarness()
+{
+  //++
+  // Delete the scratch dog ...
+  //--
+  delete m_pScratch;
+}
+
+
+size_t CDiffHarness::GetFailures() const
+{
+  //++
+  // Return the number of checks with one or more mismatches ...
+  //--
+  size_t nFailures = 0;
+  for (RESULT_VECTOR::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it)
+    if (it->nMismatches != 0) ++nFailures;
+  return nFailures;
+}
+
+
+/*static*/ string CDiffHarness::Escape (const string &str)
+{
+  //++
+  //   Make a string printable by escaping quotes, backslashes, control chars
+  // and anything that isn't plain ASCII ...
+  //--
+  string sResult("\"");
+  for (string::const_iterator it = str.begin();  it != str.end();  ++it) {
+    unsigned char ch = (unsigned char) *it;
+    if      (ch == '"')  sResult += "\\\"";
+    else if (ch == '\\') sResult += "\\\\";
+    else if (ch == '\n') sResult += "\\n";
+    else if (ch == '\r') sResult += "\\r";
+    else if (ch == '\t') sResult += "\\t";
+    else if ((ch < ' ') || (ch >= 0x7F)) sResult += CBadDogs::Print("\\x%02X", ch);
+    else sResult.push_back(ch);
+  }
+  return sResult + "\"";
+}
+
+
+/*static*/ vector<size_t> CDiffHarness::Shrink (const vector<size_t> &vecUnits,
+        std::function<bool(const vector<size_t> &)> fnFails, size_t nMaxTests)
+{
+  //++
+  //   Shrink a failing input to a minimal failing input using the classic
+  // "ddmin" delta debugging algorithm.  The input is a list of units (e.g.
+  // character positions or row numbers) and fnFails() returns true if the
+  // given subset of units still fails.  We split the list into n chunks and
+  // try each chunk alone, and then each complement (i.e. everything except
+  // one chunk).  If any of those still fails we keep it; otherwise we double
+  // n and try again, until the chunks are single units.
+  //
+  //   The result is "1-minimal" - removing any single unit makes the failure
+  // go away.  nMaxTests puts a limit on the number of calls to fnFails(), in
+  // which case the result is still failing, but maybe not minimal.
+  //--
+  vector<size_t> vecCurrent(vecUnits);  size_t n = 2, nTests = 0;
+  while ((vecCurrent.size() >= 2) && (nTests < nMaxTests)) {
+    size_t nChunk = (vecCurrent.size() + n - 1) / n;  bool fReduced = false;
+
+    // Try each chunk by itself ...
+    for (size_t i = 0;  (i < vecCurrent.size()) && !fReduced && (nTests < nMaxTests);  i += nChunk) {
+      vector<size_t> vecSubset(vecCurrent.begin()+i, vecCurrent.begin()+std::min(i+nChunk, vecCurrent.size()));
+      ++nTests;
+      if (fnFails(vecSubset)) {vecCurrent = vecSubset;  n = 2;  fReduced = true;}
+    }
+
+    // Then try each complement ...
+    for (size_t i = 0;  (i < vecCurrent.size()) && !fReduced && (n > 2) && (nTests < nMaxTests);  i += nChunk) {
+      vector<size_t> vecComplement(vecCurrent.begin(), vecCurrent.begin()+i);
+      vecComplement.insert(vecComplement.end(), vecCurrent.begin()+std::min(i+nChunk, vecCurrent.size()), vecCurrent.end());
+      ++nTests;
+      if (fnFails(vecComplement)) {vecCurrent = vecComplement;  n = std::max(n-1, (size_t) 2);  fReduced = true;}
+    }
+
+    // If nothing worked, then try smaller chunks ...
+    if (!fReduced) {
+      if (n >= vecCurrent.size()) break;
+      n = std::min(n*2, vecCurrent.size());
+    }
+  }
+  return vecCurrent;
+}
+
+
+/*static*/ void CDiffHarness::ReadLines (const string &sFileName, vector<string> &vecLines)
+{
+  //++
+  // Read a DIR file into a vector of lines, header and all ...
+  //--
+  std::ifstream stm(sFileName, std::ios::in|std::ios::binary);
+  if (!stm.is_open()) ERRS("CDiffHarness unable to open " << sFileName);
+  string sLine;  vecLines.clear();
+  while (std::getline(stm, sLine)) vecLines.push_back(sLine);
+}
+
+
+/*static*/ void CDiffHarness::WriteLines (const string &sFileName, const vector<string> &vecLines)
+{
+  //++
+  // Write a vector of lines to a file ...
+  //--
+  std::ofstream stm(sFileName, std::ios::out|std::ios::binary);
+  if (!stm.is_open()) ERRS("CDiffHarness unable to create " << sFileName);
+  for (vector<string>::const_iterator it = vecLines.begin();  it != vecLines.end();  ++it)
+    stm << *it << "\n";
+}
+
+
+/*static*/ string CDiffHarness::ReadAll (const string &sFileName)
+{
+  //++
+  // Return the entire contents of a file (or nothing if it doesn't exist) ...
+  //--
+  std::ifstream stm(sFileName, std::ios::in|std::ios::binary);
+  std::ostringstream os;
+  if (stm.is_open()) os << stm.rdbuf();
+  return os.str();
+}
+
+
+/*static*/ string CDiffHarness::ReadSorted (const string &sFileName)
+{
+  //++
+  //   Return the lines of a file sorted, except that the header stays first.
+  // That's for comparing files that have the same rows in a different order.
+  // (It's fine for a row that spans lines, too, as long as both files have
+  // it.)  A file that doesn't exist is empty ...
+  //--
+  std::ifstream stm(sFileName, std::ios::in|std::ios::binary);
+  vector<string> vecLines;  string sLine, sResult;
+  while (std::getline(stm, sLine)) vecLines.push_back(sLine);
+  if (!vecLines.empty()) std::sort(vecLines.begin()+1, vecLines.end());
+  for (vector<string>::const_iterator it = vecLines.begin();  it != vecLines.end();  ++it)
+    sResult += *it + "\n";
+  return sResult;
+}
+
+
+/*static*/ string CDiffHarness::LastError (size_t nBefore)
+{
+  //++
+  //   Return the text of the last bad dog message, if any were added since
+  // CBadDogs had nBefore rows.  This is how we capture the message from the
+  // real validators, which report errors with BADDOGS() ...
+  //--
+  const CBadDogs *pBadDogs = CBadDogs::Get();
+  if (pBadDogs->size() <= nBefore) return string("");
+  return (*(*pBadDogs)[pBadDogs->size()-1])[CBadDogs::COL_MESSAGE-1];
+}
+
+
+void CDiffHarness::AddFieldCheck (const string &sName, const vector<string> &vecCorpus,
+                                  FIELD_FUNCTION fnReference, FIELD_FUNCTION fnCandidate,
+                                  FIELD_FILTER fnExempt)
+{
+  //++
+  //   Add a field level check to the list.  If fnExempt is given then it
+  // picks out the inputs where the candidate is allowed to differ from the
+  // reference, because the real code has been changed on purpose ...
+  //--
+  CHECK check;
+  check.sName = sName;  check.pCorpus = &vecCorpus;
+  check.fnReference = fnReference;  check.fnCandidate = fnCandidate;
+  check.fnExempt = fnExempt;
+  m_vecChecks.push_back(check);
+}
+
+
+void CDiffHarness::AddDIR (const vector<string> &vecLines, bool fNew)
+{
+  //++
+  //   Add all the lines (except the header) from one DIR to the line corpus,
+  // and then pull the individual fields out of every dog for the field
+  // corpora.  Note that we use the reference parser here so that the field
+  // corpora don't depend on the code being tested ...
+  //--
+  size_t nColumns = fNew ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS;
+  for (size_t i = 1;  i < vecLines.size();  ++i) {
+    m_vecLines.push_back(vecLines[i]);
+    CCSVRow row(RefParse(vecLines[i]));
+    if (row.size() != nColumns) continue;
+    CDog dog;
+    if (!dog.FromRow(row, fNew)) continue;
+    m_vecAges.push_back(dog.m_sAge + "\t" + dog.m_sDateAcquired);
+    m_vecDates.push_back(dog.m_sDateAcquired);
+    if (!dog.m_sDispositionDate.empty()) m_vecDates.push_back(dog.m_sDispositionDate);
+    if (!dog.m_sMicrochip.empty()) m_vecChips.push_back(dog.m_sMicrochip);
+    m_vecZips.push_back(dog.m_sSurrenderZipCode);
+    m_vecStates.push_back(dog.m_sSurrenderState);
+    if (dog.m_sAdoptionFName.empty() && dog.m_sAdoptionLName.empty()) continue;
+    m_vecPhones.push_back(dog.m_sAdoptionHomePhone);
+    m_vecPhones.push_back(dog.m_sAdoptionWorkPhone);
+    m_vecPhones.push_back(dog.m_sAdoptionCellPhone);
+    m_vecZips.push_back(dog.m_sAdoptionZip);
+    m_veceMails.push_back(dog.m_sAdoptioneMail);
+    m_vecStates.push_back(dog.m_sAdoptionState);
+  }
+}
+
+
+void CDiffHarness::BuildCorpora()
+{
+  //++
+  //   Build all the input corpora - the generated DIR pair, the recorded DIR
+  // pair (if any), and all the fields extracted from them.  And a few hand
+  // picked oddballs are thrown in too, because the generator is too polite
+  // to produce some of the really bad stuff we've seen ...
+  //--
+  static const char *const apszLines[] = {
+    "", ",", ",,", "\"\"", "\"a,b\",c", "\"a\"\"b\"", "=\"123\"", "= \"123\" ", " a , b ",
+    "\"unterminated,x", "a\"b\"c", "\t=\"\"\t,", "x,\"\"\"\",y", "Jos\xC3\xA9,\"Caf\xC3\xA9\"", "a,b\r",
+  };
+  static const char *const apszPhones[] = {
+    "", "none", "None", "(408) 555-1212", "+1 408 555 1212", "408.555.1212", "408-555-121",
+    "408/555=1212", "1-408-555-1212", "4085551212 x12", "555-1212",
+  };
+  static const char *const apszZips[] = {"", "95014", "95014-1234", "9501", "95014-", "ABCDE", " 95014"};
+  static const char *const apszeMails[] = {
+    "", "a@b.co", "bob@gmial.com", "bob@@x.com", "bob@x", "bob.smith+dogs@mail.example.org", "@x.com",
+  };
+  static const char *const apszStates[] = {"", "CA", "ca", "XX", "California", "L|", "|A", "A"};
+  static const char *const apszChips[] = {
+    "", "981020012345678", "202123456789012", "1A2B3C4D5E", "123*456*789", "123 456 789",
+    "123456789", "98102001234567", "ABC", "0A0A0A0A0A",
+  };
+  static const char *const apszDates[] = {
+    "", "0000-00-00", "2020-13-01", "2020-02-30", "1989-01-01", "2020-1-1", "1/2/2020", "2020-01-01 ",
+  };
+  //   The email domain check has no old code to compare with, so its inputs
+  // are the answers too - each one is an address and the domain that
+  // CDomainChecker should suggest for it, with nothing but the built in
+  // domains known.  Other top level domains aren't typos ...
+  static const char *const apszDomains[] = {
+    "x@gmail.com\t", "x@GMail.com \t", "x@gmial.com\tgmail.com", "x@hotmial.com\thotmail.com",
+    "x@yahoo.con\tyahoo.com", "x@comcast.nt\tcomcast.net", "x@yahoo.ca\t", "x@hotmail.ca\t",
+    "x@gmail.de\t", "x@yahoo.co.uk\t", "x@pawsmail.org\t",
+  };
+  static const char *const apszAges[] = {
+    "\t2020-01-01", "3 Years 2 Months\t2020-01-01", "3 years 2 months\t2020-01-01",
+    "3 Years\t2020-06-01", "6 months\t2020-06-01", "21 Years 0 Months\t2020-06-01",
+    "1 Year 13 Months\t2020-06-01", "0 Years 0 Months\t0000-00-00", "3  Years 2 Months\t2020-01-01",
+    "2 yrs 3 mos\t2020-01-01", "2 years, 3 mos\t2020-01-01", "2years3months\t2020-01-01",
+    "2.5 years\t2020-01-01", "20.99 years\t2020-01-01", "0.0417 Years\t2020-01-01", ".5 years\t2020-01-01",
+    "2.5 months\t2020-01-01", "2.5 years 3 months\t2020-01-01", "3 years,\t2020-01-01",
+    "252 months\t2020-01-01", "240 MOS\t2020-01-01", "1234567 years\t2020-01-01", "3 yrs 12 mos\t2020-03-01",
+    " 1 yr \t2020-01-01", "3 years 2\t2020-01-01", "3 yearss\t2020-01-01", "3 months 2 years\t2020-01-01",
+  };
+
+  // Generate a synthetic DIR pair ...
+  vector<CDIRGenerator::DOG> vecOld, vecNew;
+  m_Generator.SetCutoffYear(m_nCutoffYear);
+  m_Generator.SetFormats(m_fOldFormat, m_fNewFormat);
+  m_Generator.GenerateDogs(vecOld, vecNew);
+  std::ostringstream osOld, osNew;
+  m_Generator.Write(osOld, vecOld, m_fOldFormat);
+  m_Generator.Write(osNew, vecNew, m_fNewFormat);
+  std::istringstream isOld(osOld.str()), isNew(osNew.str());  string sLine;
+  while (std::getline(isOld, sLine)) m_vecGenOld.push_back(sLine);
+  while (std::getline(isNew, sLine)) m_vecGenNew.push_back(sLine);
+  AddDIR(m_vecGenOld, m_fOldFormat);  AddDIR(m_vecGenNew, m_fNewFormat);
+  BuildHouseholds();
+  BuildShards();
+
+  // And read the recorded DIRs, if we have any ...
+  if (!m_sRecordedOld.empty()) {
+    ReadLines(m_sRecordedOld, m_vecRecOld);  ReadLines(m_sRecordedNew, m_vecRecNew);
+    AddDIR(m_vecRecOld, m_fOldFormat);  AddDIR(m_vecRecNew, m_fNewFormat);
+  }
+
+  // Throw in the oddballs ...
+  m_vecLines.insert(m_vecLines.end(), apszLines, apszLines+sizeof(apszLines)/sizeof(apszLines[0]));
+  m_vecPhones.insert(m_vecPhones.end(), apszPhones, apszPhones+sizeof(apszPhones)/sizeof(apszPhones[0]));
+  m_vecZips.insert(m_vecZips.end(), apszZips, apszZips+sizeof(apszZips)/sizeof(apszZips[0]));
+  m_veceMails.insert(m_veceMails.end(), apszeMails, apszeMails+sizeof(apszeMails)/sizeof(apszeMails[0]));
+  m_vecStates.insert(m_vecStates.end(), apszStates, apszStates+sizeof(apszStates)/sizeof(apszStates[0]));
+  m_vecChips.insert(m_vecChips.end(), apszChips, apszChips+sizeof(apszChips)/sizeof(apszChips[0]));
+  m_vecDates.insert(m_vecDates.end(), apszDates, apszDates+sizeof(apszDates)/sizeof(apszDates[0]));
+  m_vecAges.insert(m_vecAges.end(), apszAges, apszAges+sizeof(apszAges)/sizeof(apszAges[0]));
+  m_vecDomains.assign(apszDomains, apszDomains+sizeof(apszDomains)/sizeof(apszDomains[0]));
+
+  //   There's a lot of repetition (think how many times "CA" shows up!) and
+  // there's no point in checking the same input twice ...
+  vector<string> *apCorpora[] = {&m_vecLines, &m_vecPhones, &m_vecZips, &m_veceMails,
+                                 &m_vecStates, &m_vecChips, &m_vecDates, &m_vecAges, &m_vecDomains};
+  for (size_t i = 0;  i < sizeof(apCorpora)/sizeof(apCorpora[0]);  ++i) {
+    std::sort(apCorpora[i]->begin(), apCorpora[i]->end());
+    apCorpora[i]->erase(std::unique(apCorpora[i]->begin(), apCorpora[i]->end()), apCorpora[i]->end());
+  }
+}
+
+
+void CDiffHarness::AddStandardChecks()
+{
+  //++
+  //   Add the field checks for all the code that has a frozen reference.  The
+  // candidate for each one is whatever the program uses right now.  Each
+  // function returns everything the code produces - the result, the (maybe
+  // fixed) field and any bad dog message - encoded as a string.
+  //--
+  AddFieldCheck("CCSVRow::Parse", m_vecLines,
+    [](const string &s) {CCSVRow row(RefParse(s));  string r = std::to_string(row.size());
+                         for (size_t i = 0;  i < row.size();  ++i) r += "|" + std::to_string(row[i].size()) + ":" + row[i];
+                         return r;},
+    [](const string &s) {CCSVRow row;  row.Parse(s);  string r = std::to_string(row.size());
+                         for (size_t i = 0;  i < row.size();  ++i) r += "|" + std::to_string(row[i].size()) + ":" + row[i];
+                         return r;});
+  AddFieldCheck("CDog::ParseDate", m_vecDates,
+    [](const string &s) {uint32_t d=0, m=0, y=0;  bool f = RefParseDate(s, d, m, y);
+                         return f ? CDog::FormatDate(d, m, y) : string("0");},
+    [](const string &s) {uint32_t d=0, m=0, y=0;  bool f = CDog::ParseDate(s, d, m, y);
+                         return f ? CDog::FormatDate(d, m, y) : string("0");});
+  FIELD_FUNCTION fnBirthday = [this](const string &s) {size_t n = s.find('\t');  string sDOB;
+                         m_pScratch->m_sAge = s.substr(0, n);
+                         m_pScratch->m_sDateAcquired = (n == string::npos) ? string("") : s.substr(n+1);
+                         bool f = m_pScratch->ComputeBirthday(sDOB);  return Encode(f, sDOB, "");};
+  AddFieldCheck("CDog::ComputeBirthday", m_vecAges,
+    [](const string &s) {size_t n = s.find('\t');  string sDOB;
+                         string sAge = s.substr(0, n), sDate = (n == string::npos) ? string("") : s.substr(n+1);
+                         bool f = RefComputeBirthday(sAge, sDate, sDOB);  return Encode(f, sDOB, "");},
+    fnBirthday,
+    [](const string &s) {size_t n = s.find('\t');  string sDOB;
+                         string sAge = s.substr(0, n), sDate = (n == string::npos) ? string("") : s.substr(n+1);
+                         return !RefComputeBirthday(sAge, sDate, sDOB) && IsNewAgeLayout(sAge);});
+  AddFieldCheck("CDog::ComputeBirthday (new)", m_vecAges,
+    [](const string &s) {size_t n = s.find('\t');  string sDOB;
+                         string sAge = s.substr(0, n), sDate = (n == string::npos) ? string("") : s.substr(n+1);
+                         bool f = NewComputeBirthday(sAge, sDate, sDOB);  return Encode(f, sDOB, "");},
+    fnBirthday);
+  AddFieldCheck("CDog::VerifyPhone", m_vecPhones,
+    [](const string &s) {string v(s), m;  bool f = RefVerifyPhone(v, m);  return Encode(f, v, m);},
+    [this](const string &s) {size_t n = CBadDogs::Get()->size();  m_pScratch->SetAdoptionHomePhone(s);
+                         bool f = m_pScratch->VerifyHomePhone(false);
+                         return Encode(f, m_pScratch->GetAdoptionHomePhone(), LastError(n));});
+  AddFieldCheck("CDog::VerifyZip", m_vecZips,
+    [](const string &s) {string v(s), m;  bool f = RefVerifyZip(v, m);  return Encode(f, v, m);},
+    [this](const string &s) {size_t n = CBadDogs::Get()->size();  m_pScratch->SetAdoptionZip(s);
+                         bool f = m_pScratch->VerifyAdoptionZip();
+                         return Encode(f, m_pScratch->GetAdoptionZip(), LastError(n));});
+  AddFieldCheck("CDog::VerifyeMail", m_veceMails,
+    [](const string &s) {string v(s), m;  bool f = RefVerifyeMail(v, m);  return Encode(f, v, m);},
+    [this](const string &s) {size_t n = CBadDogs::Get()->size();  m_pScratch->SetAdoptioneMail(s);
+                         bool f = m_pScratch->VerifyAdoptioneMail();
+                         return Encode(f, m_pScratch->GetAdoptioneMail(), LastError(n));});
+  AddFieldCheck("CDog::VerifyState", m_vecStates,
+    [](const string &s) {string v(s), m;  bool f = RefVerifyState(v, m);  return Encode(f, v, m);},
+    [this](const string &s) {size_t n = CBadDogs::Get()->size();  m_pScratch->SetAdoptionState(s);
+                         bool f = m_pScratch->VerifyAdoptionState();
+                         return Encode(f, m_pScratch->GetAdoptionState(), LastError(n));});
+  AddFieldCheck("CChip::VerifyMicrochip", m_vecChips,
+    [](const string &s) {string v(s);  bool f = RefVerifyMicrochip(v);  return Encode(f, v, "");},
+    [](const string &s) {string v(s);  bool f = CChip::VerifyMicrochip(v, false);  return Encode(f, v, "");});
+  AddFieldCheck("CDomainChecker::Suggest", m_vecDomains,
+    [](const string &s) {size_t n = s.find('\t');  return (n == string::npos) ? string("") : s.substr(n+1);},
+    [](const string &s) {CDomainChecker Domains;
+                         return Domains.Suggest(CDomainChecker::GetDomain(s.substr(0, s.find('\t'))));});
+}
+
+
+void CDiffHarness::RunFieldCheck (const CHECK &check)
+{
+  //++
+  //   Run one field check on every input in its corpus.  If there are any
+  // mismatches, then take the shortest one and shrink it, one character at a
+  // time, to the smallest input that still doesn't match.  Exempt inputs are
+  // counted but never compared (and never shrunk to, either) ...
+  //--
+  RESULT result;
+  result.sName = check.sName;  result.nInputs = check.pCorpus->size();
+  result.nMismatches = result.nExempt = 0;
+  std::function<bool(const string &)> fnDiffers = [&](const string &s)
+    {return (!check.fnExempt || !check.fnExempt(s)) && (check.fnReference(s) != check.fnCandidate(s));};
+  const string *psFirst = NULL;
+  for (vector<string>::const_iterator it = check.pCorpus->begin();  it != check.pCorpus->end();  ++it) {
+    if (check.fnExempt && check.fnExempt(*it)) {++result.nExempt;  continue;}
+    if (check.fnReference(*it) == check.fnCandidate(*it)) continue;
+    ++result.nMismatches;
+    if ((psFirst == NULL) || (it->length() < psFirst->length())) psFirst = &*it;
+  }
+
+  if (psFirst != NULL) {
+    const string &sInput = *psFirst;
+    vector<size_t> vecUnits;
+    for (size_t i = 0;  i < sInput.length();  ++i) vecUnits.push_back(i);
+    std::function<string(const vector<size_t> &)> fnBuild = [&](const vector<size_t> &v)
+      {string s;  for (size_t i = 0;  i < v.size();  ++i) s.push_back(sInput[v[i]]);  return s;};
+    vector<size_t> vecMin = Shrink(vecUnits, [&](const vector<size_t> &v) {return fnDiffers(fnBuild(v));});
+    result.sInput = fnBuild(vecMin);
+    //   Shrink() never tries the empty string, but that might be the minimal
+    // input, so give it a shot ...
+    if ((vecMin.size() == 1) && fnDiffers("")) result.sInput.clear();
+    result.sReference = check.fnReference(result.sInput);
+    result.sCandidate = check.fnCandidate(result.sInput);
+  }
+  m_vecResults.push_back(result);
+}
+
+
+/*static*/ void CDiffHarness::RefReadDogs (CDogs &Dogs, const vector<string> &vecLines, uint32_t nYear, bool fNew)
+{
+  //++
+  //   Build a CDogs collection from the lines of a DIR, using the reference
+  // CSV parser.  Other than that, this does the same thing as CDogs::ReadFile().
+  //--
+  for (size_t i = 1;  i < vecLines.size();  ++i) {
+    CCSVRow row(RefParse(vecLines[i]));
+    CDog *pDog = new CDog;
+    if (pDog->FromRow(row, fNew)) {
+      if (pDog->WasAcquiredAfter(nYear)) Dogs.Add(pDog);
+    }
+  }
+}
+
+
+void CDiffHarness::BuildHouseholds()
+{
+  //++
+  //   Make the DIR pair for the households check.  Each dog is one of the
+  // generated adopted dogs with the adopter replaced by one of the families
+  // below.  Every dog that changes families here changes to a different
+  // household, so "adopting family changed" has to be reported for all of
+  // them (just like the reference, which never heard of households).  The
+  // last four dogs don't change - they're just there to crowd the address.
+  //--
+  struct FAMILY {
+    const char *pszFName, *pszLName, *pszAddress, *pszZip, *pszeMail, *pszHome, *pszWork, *pszCell;
+  };
+  static const FAMILY aFamilies[] = {
+    // Two families that work for the same company ...
+    {"Alice", "Jones",  "10 Oak St",   "95001", "ajones@gmail.com", "408-201-1001", "408-900-0000", ""},
+    {"Carl",  "Brown",  "20 Elm St",   "95002", "cbrown@yahoo.com", "408-201-1002", "408-900-0000", ""},
+    // Two families that don't want to give us their phone numbers ...
+    {"Dana",  "White",  "30 Pine St",  "95003", "dwhite@gmail.com", "408-555-0100", "", "000-000-0000"},
+    {"Evan",  "Green",  "40 Ash St",   "95004", "egreen@gmail.com", "408-555-0100", "", "000-000-0000"},
+    //  ... or their email addresses ...
+    {"Fay",   "Hall",   "50 Fir St",   "95005", "none@none.com",    "408-201-1005", "", ""},
+    {"Gus",   "King",   "60 Bay St",   "95006", "none@none.com",    "408-201-1006", "", ""},
+    // Smyth sounds like Smith, and Smith shares a phone with Jones ...
+    {"Jon",   "Smyth",  "70 Oak Ave",  "95007", "jsmyth@gmail.com", "408-201-1007", "", ""},
+    {"John",  "Smith",  "80 Elm Ave",  "95007", "jsmith@gmail.com", "408-201-1008", "", ""},
+    {"Mary",  "Jones",  "90 Pine Ave", "95008", "mjones@gmail.com", "408-201-1008", "", ""},
+    // And six different families that all give the same (shelter) address ...
+    {"Ann",   "Lee",    "11 Main St",  "95009", "alee@gmail.com",   "408-201-1011", "", ""},
+    {"Bo",    "Chan",   "11 Main St",  "95009", "bchan@gmail.com",  "408-201-1012", "", ""},
+    {"Cy",    "Diaz",   "11 Main St",  "95009", "cdiaz@gmail.com",  "408-201-1013", "", ""},
+    {"Di",    "Ford",   "11 Main St",  "95009", "dford@gmail.com",  "408-201-1014", "", ""},
+    {"Ed",    "Gray",   "11 Main St",  "95009", "egray@gmail.com",  "408-201-1015", "", ""},
+    {"Flo",   "Hunt",   "11 Main St",  "95009", "fhunt@gmail.com",  "408-201-1016", "", ""},
+  };
+  //   The old and new families of every dog (indices into aFamilies), and the
+  // Smith dog that's needed to bridge Smyth and Jones ...
+  static const uint8_t anFamilies[][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 8}, {7, 7}, {9, 10}, {11, 11}, {12, 12}, {13, 13}, {14, 14},
+  };
+  const size_t nDogs = sizeof(anFamilies)/sizeof(anFamilies[0]);
+  m_vecHouseOld.clear();  m_vecHouseNew.clear();
+  if (m_vecGenNew.size() < 2) return;
+
+  //   Find enough generated dogs that are adopted and will make it past the
+  // cutoff year, and aren't dead or returned ...
+  vector<CCSVRow::COLUMN_VECTOR> vecTemplates;
+  size_t nColumns = m_fNewFormat ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS;
+  for (size_t i = 1;  (i < m_vecGenNew.size()) && (vecTemplates.size() < nDogs);  ++i) {
+    CCSVRow::COLUMN_VECTOR cols(RefParse(m_vecGenNew[i]));
+    if (cols.size() != nColumns) continue;
+    CDog dog;
+    if (!dog.FromRow(CCSVRow(cols), m_fNewFormat)) continue;
+    if (!dog.IsAdopted() || !dog.WasAcquiredAfter(m_nCutoffYear)) continue;
+    if (dog.IsDead() || dog.IsReturned()) continue;
+    vecTemplates.push_back(cols);
+  }
+  if (vecTemplates.size() < nDogs) return;
+
+  //   Fill in one family and format the row.  The adopter fields start right
+  // after the originating area, plus the county in the new format ...
+  std::function<string(CCSVRow::COLUMN_VECTOR, bool, const FAMILY &)> fnRow =
+    [this](CCSVRow::COLUMN_VECTOR cols, bool fNew, const FAMILY &family) {
+      if (fNew != m_fNewFormat) {
+        if (fNew) cols.insert(cols.begin()+20, string(""));  else cols.erase(cols.begin()+20);
+      }
+      size_t nCol = fNew ? 21 : 20;
+      cols[nCol+0] = family.pszFName;  cols[nCol+1] = family.pszLName;
+      cols[nCol+4] = family.pszAddress;  cols[nCol+7] = family.pszZip;
+      cols[nCol+9] = family.pszeMail;  cols[nCol+10] = family.pszHome;
+      cols[nCol+11] = family.pszWork;  cols[nCol+12] = family.pszCell;
+      return CCSVRow(cols).Format();
+    };
+  m_vecHouseOld.push_back(m_vecGenOld[0]);  m_vecHouseNew.push_back(m_vecGenNew[0]);
+  for (size_t i = 0;  i < nDogs;  ++i) {
+    m_vecHouseOld.push_back(fnRow(vecTemplates[i], m_fOldFormat, aFamilies[anFamilies[i][0]]));
+    m_vecHouseNew.push_back(fnRow(vecTemplates[i], m_fNewFormat, aFamilies[anFamilies[i][1]]));
+  }
+}
+
+
+void CDiffHarness::BuildShards()
+{
+  //++
+  //   Make the DIR pair for the shards check.  It's the generated pair with
+  // REENTERED_DOGS adopted dogs given a new dog number in the new DIR, so
+  // that the old number disappears and CDogMatcher should find the new one
+  // (which is usually in a different shard).  Those same adopters get an
+  // email at "pawsmial.org", and DOMAIN_DOGS other adopters use the real
+  // "pawsmail.org" in both DIRs.  That's just enough for the whole old DIR
+  // to learn it, but not any one shard, so only a CDomainChecker that knows
+  // about every old dog can tell that "pawsmial.org" is a typo.
+  //
+  //   And HOUSEHOLD_DOGS more dogs change adopters, to somebody with a
+  // different name, phone and address.  Each one has a partner dog in a
+  // different shard whose adopter has both the old and the new adopter's
+  // phone numbers, so they're all one household and nothing is reported -
+  // but only if the households were found from the whole DIR pair ...
+  //--
+  m_vecShardOld = m_vecGenOld;  m_vecShardNew = m_vecGenNew;
+  if ((m_vecGenOld.size() < 2) || (m_vecGenNew.size() < 2)) return;
+
+  // Find the rows for each dog number in the old DIR ...
+  size_t nOldColumns = m_fOldFormat ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS;
+  size_t nNewColumns = m_fNewFormat ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS;
+  std::unordered_map<string, size_t> mapOld;
+  for (size_t i = 1;  i < m_vecShardOld.size();  ++i) {
+    CCSVRow::COLUMN_VECTOR cols(RefParse(m_vecShardOld[i]));
+    if (cols.size() == nOldColumns) mapOld.insert({cols[1], i});
+  }
+
+  //   And change the adopted dogs that are in both.  The new dog numbers are
+  // just bigger than any the generator makes.  The adopter's email is right
+  // after the originating area, plus the county in the new format (see
+  // BuildHouseholds()) ...
+  size_t nOldMail = m_fOldFormat ? 30 : 29, nNewMail = m_fNewFormat ? 30 : 29;
+  size_t nReentered = 0, nDomains = 0;  uint32_t nNumber = 9000000;
+  for (size_t i = 1;  (i < m_vecShardNew.size()) && ((nReentered < REENTERED_DOGS) || (nDomains < DOMAIN_DOGS));  ++i) {
+    CCSVRow::COLUMN_VECTOR cols(RefParse(m_vecShardNew[i]));
+    if (cols.size() != nNewColumns) continue;
+    std::unordered_map<string, size_t>::const_iterator it = mapOld.find(cols[1]);
+    if (it == mapOld.end()) continue;
+    CDog dog;
+    if (!dog.FromRow(CCSVRow(cols), m_fNewFormat) || !dog.HasChip()) continue;
+    if (!dog.IsAdopted() || !dog.WasAcquiredAfter(m_nCutoffYear)) continue;
+    if (dog.IsDead() || dog.IsReturned()) continue;
+    if (nReentered < REENTERED_DOGS) {
+      cols[1] = std::to_string(nNumber++);
+      cols[nNewMail] = "dog" + cols[1] + "@pawsmial.org";  ++nReentered;
+    } else {
+      CCSVRow::COLUMN_VECTOR old(RefParse(m_vecShardOld[it->second]));
+      old[nOldMail] = cols[nNewMail] = "dog" + cols[1] + "@pawsmail.org";  ++nDomains;
+      m_vecShardOld[it->second] = CCSVRow(old).Format();
+    }
+    m_vecShardNew[i] = CCSVRow(cols).Format();
+  }
+
+  //   Now find pairs of dogs for the households, both adopted in both DIRs
+  // but in different shards.  The adopter fields start right after the
+  // originating area, plus the county in the new format ...
+  size_t nOldAdopter = m_fOldFormat ? 21 : 20, nNewAdopter = m_fNewFormat ? 21 : 20;
+  vector<std::pair<size_t, size_t> > vecDogs;  size_t nFirst = 0;  bool fFirst = false;
+  for (size_t i = 1;  (i < m_vecShardNew.size()) && (vecDogs.size() < 2*HOUSEHOLD_DOGS);  ++i) {
+    CCSVRow::COLUMN_VECTOR cols(RefParse(m_vecShardNew[i]));
+    if (cols.size() != nNewColumns) continue;
+    std::unordered_map<string, size_t>::const_iterator it = mapOld.find(cols[1]);
+    if (it == mapOld.end()) continue;
+    CDog dog, old;
+    if (!dog.FromRow(CCSVRow(cols), m_fNewFormat) || !dog.IsAdopted() || !dog.WasAcquiredAfter(m_nCutoffYear)) continue;
+    if (dog.IsDead() || dog.IsReturned() || dog.GetAdoptioneMail().find("@paws") != string::npos) continue;
+    if (!old.FromRow(CCSVRow(RefParse(m_vecShardOld[it->second])), m_fOldFormat) || !old.IsAdopted()) continue;
+    if (fFirst && (CShards::GetShard(cols[1], SHARDS) == CShards::GetShard(RefParse(m_vecShardNew[nFirst])[1], SHARDS))) continue;
+    vecDogs.push_back({i, it->second});
+    if (fFirst) fFirst = false;  else {fFirst = true;  nFirst = i;}
+  }
+  if (fFirst) vecDogs.pop_back();
+
+  //   The first dog of each pair changes adopters, and the second one's
+  // adopter has both their phones.  Everything else is different, and none
+  // of the names sound alike ...
+  std::function<void(size_t, bool, size_t, const string &, const string &, const string &)> fnAdopter =
+    [&](size_t nRow, bool fNew, size_t n, const string &sName, const string &sHome, const string &sCell) {
+      string &sLine = fNew ? m_vecShardNew[nRow] : m_vecShardOld[nRow];
+      CCSVRow::COLUMN_VECTOR cols(RefParse(sLine));
+      size_t nCol = fNew ? nNewAdopter : nOldAdopter;
+      cols[nCol+0] = sName;  cols[nCol+1] = "Household" + std::to_string(n);
+      cols[nCol+4] = std::to_string(100+n) + " " + sName + " Rd";  cols[nCol+7] = "95010";
+      cols[nCol+9] = sName + std::to_string(n) + "@gmail.com";
+      cols[nCol+10] = sHome;  cols[nCol+11] = "";  cols[nCol+12] = sCell;
+      sLine = CCSVRow(cols).Format();
+    };
+  for (size_t i = 0;  i+1 < vecDogs.size();  i += 2) {
+    string sPhone1 = CBadDogs::Print("408-301-%04zu", 2*i), sPhone2 = CBadDogs::Print("408-301-%04zu", 2*i+1);
+    fnAdopter(vecDogs[i].second, false, i, "Quincy", sPhone1, "");
+    fnAdopter(vecDogs[i].first, true, i, "Velma", sPhone2, "");
+    fnAdopter(vecDogs[i+1].second, false, i+1, "Xavier", sPhone1, sPhone2);
+    fnAdopter(vecDogs[i+1].first, true, i+1, "Xavier", sPhone1, sPhone2);
+  }
+}
+
+
+string CDiffHarness::RunPipeline (const vector<string> &vecOld, const vector<string> &vecNew, bool fReference, bool fHouseholds)
+{
+  //++
+  //   Run the entire pipeline, either reference or candidate, on a pair of
+  // DIRs and return the complete text of the updates file followed by the
+  // errors file.  If fHouseholds is true, the candidate uses households to
+  // compare the adopters ...
+  //--
+  string sUpdates = MakeFileName("updates"), sErrors = MakeFileName("errors");
+  CBadDogs *pBadDogs = new CBadDogs(sErrors);
+  {
+    CDogs OldDogs, NewDogs;  CChips Chips;
+    if (fReference) {
+      RefReadDogs(OldDogs, vecOld, m_nCutoffYear, m_fOldFormat);
+      RefReadDogs(NewDogs, vecNew, m_nCutoffYear, m_fNewFormat);
+      RefCompareDogs(OldDogs, NewDogs);
+    } else {
+      string sOld = MakeFileName("old"), sNew = MakeFileName("new");
+      WriteLines(sOld, vecOld);  WriteLines(sNew, vecNew);
+      OldDogs.ReadFile(sOld, m_nCutoffYear, m_fOldFormat);
+      NewDogs.ReadFile(sNew, m_nCutoffYear, m_fNewFormat);
+      if (fHouseholds) {
+        CHouseholds Households(OldDogs, NewDogs);
+        CompareDogs(OldDogs, NewDogs, &Households);
+      } else
+        CompareDogs(OldDogs, NewDogs);
+      remove(sOld.c_str());  remove(sNew.c_str());
+    }
+    BuildUpdates(NewDogs, Chips);
+    Chips.WriteFile(sUpdates);
+  }
+  pBadDogs->WriteFile();  delete pBadDogs;
+  string sResult = ReadAll(sUpdates) + "\n----\n" + ReadAll(sErrors);
+  remove(sUpdates.c_str());  remove(sErrors.c_str());
+  return sResult;
+}
+
+
+string CDiffHarness::RunShards (const vector<string> &vecOld, const vector<string> &vecNew, bool fSharded)
+{
+  //++
+  //   Do a whole update run on a pair of DIRs, either all at once or split
+  // into SHARDS shards, run as a batch and merged, and return the updates
+  // file followed by the errors file, each one sorted.  The shard files all
+  // go in the scratch directory and are deleted afterwards ...
+  //--
+  string sOld = MakeFileName("old"), sNew = MakeFileName("new");
+  string sUpdates = MakeFileName("updates"), sErrors = MakeFileName("errors");
+  WriteLines(sOld, vecOld);  WriteLines(sNew, vecNew);
+  vector<string> vecScratch;
+  try {
+    if (!fSharded) {
+      RunUpdate(sOld, m_fOldFormat, sNew, m_fNewFormat, m_nCutoffYear, sUpdates, sErrors);
+    } else {
+      CShards shards;
+      shards.SetShards(SHARDS);  shards.SetCutoffYear(m_nCutoffYear);
+      shards.SetFormats(m_fOldFormat, m_fNewFormat);  shards.SetDirectory(m_sDirectory);
+      string sManifest = m_sDirectory + "/" + CShards::m_pszManifest;
+      vecScratch.push_back(sManifest);
+      vecScratch.push_back(m_sDirectory + "/" + CShards::m_pszChipErrors);
+      vecScratch.push_back(m_sDirectory + "/" + CShards::m_pszDomains);
+      shards.Split(sOld, sNew);
+      CBatch batch;
+      batch.SetCutoffYear(m_nCutoffYear);  batch.SetFormats(m_fOldFormat, m_fNewFormat);
+      batch.ReadManifest(sManifest);
+      for (vector<CBatch::JOB>::const_iterator it = batch.GetJobs().begin();  it != batch.GetJobs().end();  ++it) {
+        vecScratch.push_back(it->sOldFile);  vecScratch.push_back(it->sNewFile);
+        vecScratch.push_back(it->sUpdatesFile);  vecScratch.push_back(it->sErrorsFile);
+        vecScratch.push_back(ChangeExtension(it->sErrorsFile, METRICS_EXTENSION));
+        vecScratch.push_back(it->sHouseholdsFile);
+      }
+      batch.Run();
+      for (size_t i = 0;  i < batch.GetResults().size();  ++i)
+        if (!batch.GetResults()[i].sFailure.empty()) ERRS("shard " << i << " failed - " << batch.GetResults()[i].sFailure);
+      CShards::Merge(sManifest, sUpdates, sErrors);
+    }
+  } catch (std::exception &e) {
+    WriteLines(sErrors, vector<string>(1, string("FAILED - ") + e.what()));
+  }
+  string sResult = ReadSorted(sUpdates) + "\n----\n" + ReadSorted(sErrors);
+  vecScratch.push_back(sOld);  vecScratch.push_back(sNew);
+  vecScratch.push_back(sUpdates);  vecScratch.push_back(sErrors);
+  for (vector<string>::const_iterator it = vecScratch.begin();  it != vecScratch.end();  ++it)
+    remove(it->c_str());
+  return sResult;
+}
+
+
+string CDiffHarness::RunWhatIf (const vector<string> &vecOld, const vector<string> &vecNew, bool fWhatIf)
+{
+  //++
+  //   Count the updates and errors for WHATIF_YEARS cutoff years around the
+  // usual one, either all at once with CWhatIf or with a real RunUpdate() for
+  // each year, and return one line for each year.  The number of dogs isn't
+  // compared - a real run doesn't return it ...
+  //--
+  string sOld = MakeFileName("old"), sNew = MakeFileName("new");
+  string sUpdates = MakeFileName("updates"), sErrors = MakeFileName("errors");
+  WriteLines(sOld, vecOld);  WriteLines(sNew, vecNew);
+  vector<uint32_t> vecCutoffs;
+  for (uint32_t i = 0;  i < WHATIF_YEARS;  ++i) vecCutoffs.push_back(m_nCutoffYear - WHATIF_YEARS/2 + i);
+  std::ostringstream ss;
+  try {
+    if (fWhatIf) {
+      CWhatIf whatif;
+      whatif.SetCutoffs(vecCutoffs);
+      whatif.Run(sOld, m_fOldFormat, sNew, m_fNewFormat);
+      for (CWhatIf::RESULT_VECTOR::const_iterator it = whatif.GetResults().begin();  it != whatif.GetResults().end();  ++it)
+        ss << it->nCutoff << " " << it->nUpdates << " " << it->nErrors << "\n";
+    } else {
+      for (vector<uint32_t>::const_iterator it = vecCutoffs.begin();  it != vecCutoffs.end();  ++it) {
+        RunUpdate(sOld, m_fOldFormat, sNew, m_fNewFormat, *it, sUpdates, sErrors);
+        CCSVFile Updates, Errors;  Updates.Read(sUpdates);  Errors.Read(sErrors);
+        ss << *it << " " << (Updates.size()-1) << " " << (Errors.size()-1) << "\n";
+      }
+    }
+  } catch (std::exception &e) {
+    ss << "FAILED - " << e.what() << "\n";
+  }
+  remove(sOld.c_str());  remove(sNew.c_str());
+  remove(sUpdates.c_str());  remove(sErrors.c_str());
+  return ss.str();
+}
+
+
+void CDiffHarness::RunPipelineCheck (const string &sName, const vector<string> &vecOld, const vector<string> &vecNew, bool fHouseholds)
+{
+  //++
+  // Run the reference and candidate pipelines on a pair of DIRs ...
+  //--
+  RunPipelineCheck(sName, vecOld, vecNew,
+    [this](const vector<string> &o, const vector<string> &n) {return RunPipeline(o, n, true);},
+    [this, fHouseholds](const vector<string> &o, const vector<string> &n) {return RunPipeline(o, n, false, fHouseholds);});
+}
+
+
+void CDiffHarness::RunPipelineCheck (const string &sName, const vector<string> &vecOld, const vector<string> &vecNew,
+                                     PIPELINE_FUNCTION fnReference, PIPELINE_FUNCTION fnCandidate)
+{
+  //++
+  //   Run the reference and candidate pipelines on a pair of DIRs.  If the
+  // outputs differ, shrink the DIRs to the fewest rows that still show the
+  // difference.  The "units" for the shrinking are all the old DIR rows
+  // followed by all the new DIR rows (the headers are always kept).  The
+  // minimal DIR pair is saved in the scratch directory so that it can be
+  // run thru the debugger ...
+  //--
+  RESULT result;
+  result.sName = sName;  result.nInputs = (vecOld.size()-1) + (vecNew.size()-1);
+  result.nMismatches = result.nExempt = 0;
+  if (fnReference(vecOld, vecNew) != fnCandidate(vecOld, vecNew)) {
+    size_t nOld = vecOld.size()-1;
+    std::function<void(const vector<size_t> &, vector<string> &, vector<string> &)> fnBuild =
+      [&](const vector<size_t> &v, vector<string> &o, vector<string> &n) {
+        o.assign(1, vecOld[0]);  n.assign(1, vecNew[0]);
+        for (size_t i = 0;  i < v.size();  ++i) {
+          if (v[i] < nOld) o.push_back(vecOld[v[i]+1]);  else n.push_back(vecNew[v[i]-nOld+1]);
+        }
+      };
+    vector<size_t> vecUnits;
+    for (size_t i = 0;  i < result.nInputs;  ++i) vecUnits.push_back(i);
+    vector<size_t> vecMin = Shrink(vecUnits, [&](const vector<size_t> &v)
+      {vector<string> o, n;  fnBuild(v, o, n);  return fnReference(o, n) != fnCandidate(o, n);});
+    vector<string> vecMinOld, vecMinNew;
+    fnBuild(vecMin, vecMinOld, vecMinNew);
+    WriteLines(MakeFileName("fail-old"), vecMinOld);
+    WriteLines(MakeFileName("fail-new"), vecMinNew);
+    result.nMismatches = 1;
+    for (size_t i = 1;  i < vecMinOld.size();  ++i) result.sInput += "old: " + vecMinOld[i] + "\n";
+    for (size_t i = 1;  i < vecMinNew.size();  ++i) result.sInput += "new: " + vecMinNew[i] + "\n";
+    result.sReference = fnReference(vecMinOld, vecMinNew);
+    result.sCandidate = fnCandidate(vecMinOld, vecMinNew);
+  }
+  m_vecResults.push_back(result);
+}
+
+
+void CDiffHarness::Run()
+{
+  //++
+  //   Build the corpora and then run all the field checks, followed by the
+  // pipeline checks ...
+  //--
+  std::streambuf *pCout = std::cout.rdbuf(NULL);
+  m_vecResults.clear();  m_vecChecks.clear();
+
+  //   Building the corpora and the field checks need a CBadDogs to catch the
+  // messages from the real code.  Note that the pipeline checks create their
+  // own, so this one has to go away first ...
+  CBadDogs *pBadDogs = new CBadDogs("");
+  BuildCorpora();
+  AddStandardChecks();
+  for (vector<CHECK>::const_iterator it = m_vecChecks.begin();  it != m_vecChecks.end();  ++it)
+    RunFieldCheck(*it);
+  delete pBadDogs;
+
+  // And the pipeline checks ...
+  RunPipelineCheck("pipeline (generated)", m_vecGenOld, m_vecGenNew);
+  if (!m_vecRecOld.empty() && !m_vecRecNew.empty())
+    RunPipelineCheck("pipeline (recorded)", m_vecRecOld, m_vecRecNew);
+  if (!m_vecHouseOld.empty())
+    RunPipelineCheck("pipeline (households)", m_vecHouseOld, m_vecHouseNew, true);
+  RunPipelineCheck("shards (generated)", m_vecShardOld, m_vecShardNew,
+    [this](const vector<string> &o, const vector<string> &n) {return RunShards(o, n, false);},
+    [this](const vector<string> &o, const vector<string> &n) {return RunShards(o, n, true);});
+  RunPipelineCheck("whatif (generated)", m_vecShardOld, m_vecShardNew,
+    [this](const vector<string> &o, const vector<string> &n) {return RunWhatIf(o, n, false);},
+    [this](const vector<string> &o, const vector<string> &n) {return RunWhatIf(o, n, true);});
+  std::cout.rdbuf(pCout);  std::cout.clear();
+}
+
+
+void CDiffHarness::Report() const
+{
+  //++
+  //   Print the results.  For every check that failed, print the minimal
+  // input and both outputs ...
+  //--
+  MSGS(CBadDogs::Print("%-30s %10s %10s %10s", "Check", "Inputs", "Exempt", "Mismatches"));
+  for (RESULT_VECTOR::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it)
+    MSGS(CBadDogs::Print("%-30s %10zu %10zu %10zu", it->sName.c_str(), it->nInputs, it->nExempt, it->nMismatches));
+  for (RESULT_VECTOR::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it) {
+    if (it->nMismatches == 0) continue;
+    MSGS("");
+    MSGS(it->sName << " - minimal failing input:");
+    MSGS("  input:     " << Escape(it->sInput));
+    MSGS("  reference: " << Escape(it->sReference));
+    MSGS("  candidate: " << Escape(it->sCandidate));
+  }
+  MSGS("");
+  if (GetFailures() == 0)
+    MSGS("All " << m_vecResults.size() << " checks passed");
+  else
+    MSGS(GetFailures() << " of " << m_vecResults.size() << " checks FAILED");
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//////////////// REFERENCE CODE FOR NEW (NOT ORIGINAL) BEHAVIOR ///////////////
+///////////////////////////////////////////////////////////////////////////////
+
+
+/*static*/ bool CDiffHarness::IsNewAgeLayout (const string &sAge)
+{
+  //++
+  //   Return true if an age is in one of the layouts that CDog::ParseAge()
+  // accepts on purpose but the original code didn't.  These are the only ages
+  // where the frozen CDog::ComputeBirthday() check lets the candidate find a
+  // birthday when the reference doesn't.  Anything the reference does accept
+  // still has to match exactly, and anything that isn't in this list has to
+  // be rejected by both ...
+  //--
+  static const char *const apszLayouts[] = {
+    // "2 yrs 3 mos", "1 Year 0 Months", "2 years, 3 mos", "2years3months" ...
+    "^\\s*\\d+\\s*(years|year|yrs|yr)[\\s,]*\\d+\\s*(months|month|mos|mo)\\s*$",
+    // "3 Years", "2.5 yrs" ...
+    "^\\s*\\d+(\\.\\d+)?\\s*(years|year|yrs|yr)\\s*$",
+    // "6 months", "240 mos" ...
+    "^\\s*\\d+\\s*(months|month|mos|mo)\\s*$",
+  };
+  string sLower = CDog::tolower(sAge);
+  for (size_t i = 0;  i < sizeof(apszLayouts)/sizeof(apszLayouts[0]);  ++i)
+    if (std::tr1::regex_search(sLower, std::tr1::regex(apszLayouts[i]))) return true;
+  return false;
+}
+
+
+/*static*/ bool CDiffHarness::NewComputeBirthday (const string &sAge, const string &sDateAcquired, string &sDOB)
+{
+  //++
+  //   This is CDog::ComputeBirthday() as it's meant to work now, with the age
+  // parsed by a regex for the grammar described in CDog::ParseAge().  It was
+  // written along with ParseAge(), so it only checks that the tokenizer does
+  // what the comments say it does - RefComputeBirthday() is still the one
+  // that guards the original behavior ...
+  //--
+  sDOB.clear();
+  if (sDateAcquired.empty() || sAge.empty()) return false;
+  std::tr1::regex reAge("^\\s*(?:(\\d{1,6})\\s*(?:years|year|yrs|yr)[\\s,]*(\\d{1,6})\\s*(?:months|month|mos|mo)"
+                                "|(\\d{1,6})(?:\\.(\\d{1,4}))?\\s*(?:years|year|yrs|yr)"
+                                "|(\\d{1,6})\\s*(?:months|month|mos|mo))\\s*$");
+  std::tr1::smatch rmAge;
+  string sLower = CDog::tolower(sAge);
+  if (!std::tr1::regex_search(sLower, rmAge, reAge)) return false;
+  uint32_t nAgeYears = 0, nAgeMonths = 0;
+  if (rmAge[1].matched) {
+    nAgeYears = std::stoi(rmAge.str(1));  nAgeMonths = std::stoi(rmAge.str(2));
+    if (nAgeMonths > 12) return false;
+  } else if (rmAge[3].matched) {
+    nAgeYears = std::stoi(rmAge.str(3));
+    if (rmAge[4].matched) {
+      uint32_t nDenominator = 1;
+      for (size_t i = 0;  i < rmAge.str(4).length();  ++i) nDenominator *= 10;
+      nAgeMonths = (std::stoi(rmAge.str(4))*24 + nDenominator) / (2*nDenominator);
+      if (nAgeMonths == 12) {++nAgeYears;  nAgeMonths = 0;}
+    }
+  } else {
+    nAgeMonths = std::stoi(rmAge.str(5));
+    nAgeYears = nAgeMonths / 12;  nAgeMonths %= 12;
+  }
+  if (nAgeYears > 20) return false;
+  uint32_t nYearAcquired, nMonthAcquired, nDayAcquired;
+  if (!RefParseDate(sDateAcquired, nDayAcquired, nMonthAcquired, nYearAcquired)) return false;
+  int32_t nYear = nYearAcquired-nAgeYears;
+  int32_t nMonth = nMonthAcquired-nAgeMonths;
+  if (nMonth < 1) {--nYear;  nMonth += 12;}
+  sDOB = CDog::FormatDate(nDayAcquired, nMonth, nYear);
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//////////////////// FROZEN REFERENCE CODE - DO NOT CHANGE! ///////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+
+/*static*/ string CDiffHarness::RefTrimColumn (const string &src)
+{
+  // Reference copy of CCSVRow::TrimColumn() ...
+  size_t start = src.find_first_not_of(" \t");
+  size_t end = src.find_last_not_of(" \t");
+  if ((start == string::npos)  ||  (end == string::npos)) return "";
+  return src.substr(start, end+1);
+}
+
+
+/*static*/ string CDiffHarness::RefRemoveEquals (const string &src)
+{
+  // Reference copy of CCSVRow::RemoveEquals() ...
+  if ((src.length() == 0)  ||  (src[0] != '='))  return src;
+  string dst = src.substr(1);
+  if (dst.length() < 2) return dst;
+  if ((dst[0] != '"')  ||  (dst[dst.length()-1] != '"'))  return dst;
+  return dst.substr(1, dst.length()-2);
+}
+
+
+/*static*/ string CDiffHarness::RefParseField (const string &str, string::const_iterator &it)
+{
+  // Reference copy of CCSVRow::ParseField() ...
+  bool fInQuotes = false, fQuoteLast = false;  string sResult("");
+  for (;  it != str.end();  ++it) {
+    if ((*it == ',')  &&  !fInQuotes)  break;
+    if (*it == '"') {
+      if (!fInQuotes) {
+        if (fQuoteLast) sResult.push_back('"');
+        fQuoteLast = false;  fInQuotes = true;
+      } else {
+        fInQuotes = false;  fQuoteLast = true;
+      }
+    } else {
+      sResult.push_back(*it);  fQuoteLast = false;
+    }
+  }
+  return sResult;
+}
+
+
+/*static*/ CCSVRow::COLUMN_VECTOR CDiffHarness::RefParse (const string &str)
+{
+  // Reference copy of CCSVRow::Parse() ...
+  CCSVRow::COLUMN_VECTOR vecColumns;
+  if (str.length() != 0) {
+    for (string::const_iterator it = str.begin();; ++it) {
+      string sColumn = RefParseField(str, it);
+      vecColumns.push_back(RefTrimColumn(RefRemoveEquals(RefTrimColumn(sColumn))));
+      if (it == str.end()) break;
+    }
+  }
+  return vecColumns;
+}
+
+
+/*static*/ bool CDiffHarness::RefParseDate (const string &sDate, uint32_t &nDay, uint32_t &nMonth, uint32_t &nYear)
+{
+  // Reference copy of CDog::ParseDate() ...
+  std::tr1::regex reDate("^(\\d{4})\\-(\\d{2})\\-(\\d{2})$");
+  std::tr1::smatch rmDate;
+  if (!std::tr1::regex_search(sDate, rmDate, reDate)) return false;
+  nYear = std::stoi(rmDate.str(1));
+  nMonth = std::stoi(rmDate.str(2));
+  nDay = std::stoi(rmDate.str(3));
+  if ((nMonth == 0) || (nMonth > 12)) return false;
+  if ((nDay == 0) || (nDay > 31)) return false;
+  if ((nYear < 1990) || (nYear > 2099)) return false;
+  return true;
+}
+
+
+/*static*/ bool CDiffHarness::RefComputeBirthday (const string &sAge, const string &sDateAcquired, string &sDOB)
+{
+  // Reference copy of CDog::ComputeBirthday() ...
+  sDOB.clear();
+  if (sDateAcquired.empty() || sAge.empty()) return false;
+  std::tr1::regex reAge("^(\\d+)\\syears\\s(\\d+)\\smonths$");
+  std::tr1::smatch rmAge;
+  string sLower = CDog::tolower(sAge);
+  if (!std::tr1::regex_search(sLower, rmAge, reAge)) return false;
+  uint32_t nAgeYears = std::stoi(rmAge.str(1));
+  uint32_t nAgeMonths = std::stoi(rmAge.str(2));
+  if ((nAgeMonths > 12) || (nAgeYears > 20)) return false;
+  uint32_t nYearAcquired, nMonthAcquired, nDayAcquired;
+  if (!RefParseDate(sDateAcquired, nDayAcquired, nMonthAcquired, nYearAcquired)) return false;
+  int32_t nYear = nYearAcquired-nAgeYears;
+  int32_t nMonth = nMonthAcquired-nAgeMonths;
+  if (nMonth < 1) {--nYear;  nMonth += 12;}
+  sDOB = CDog::FormatDate(nDayAcquired, nMonth, nYear);
+  return true;
+}
+
+
+/*static*/ bool CDiffHarness::RefVerifyPhone (string &sPhone, string &sMessage)
+{
+  // Reference copy of CDog::VerifyPhone() (for the home phone) ...
+  if (sPhone.empty() || (sPhone == "none")) {
+    sPhone.clear();   return true;
+  }
+  std::tr1::regex rePhone("^\\+?1?\\s?\\(?(\\d\\d\\d)\\)?[\\s\\-/\\*,\\.]*(\\d\\d\\d)[\\s\\-=\\*,\\.]*(\\d\\d\\d\\d)$");
+  std::tr1::smatch rmPhone;
+  if (!std::tr1::regex_search(sPhone, rmPhone, rePhone)) {
+    sMessage = "invalid home phone \"" + sPhone + "\"";
+    sPhone.clear();  return false;
+  }
+  string sArea = rmPhone[1], sPrefix = rmPhone[2], sNumber = rmPhone[3];
+  sPhone = sArea + sPrefix + sNumber;
+  return true;
+}
+
+
+/*static*/ bool CDiffHarness::RefVerifyZip (string &sZip, string &sMessage)
+{
+  // Reference copy of CDog::VerifyZip() ...
+  if (sZip.empty())
+    {sMessage = "zip code cannot be blank";  return false;}
+  std::tr1::regex reZip("^\\d{5}(\\-\\d{4})?$");
+  if (std::tr1::regex_match(sZip, reZip)) return true;
+  sMessage = "invalid zip code \"" + sZip + "\"";
+  sZip.clear();  return false;
+}
+
+
+/*static*/ bool CDiffHarness::RefVerifyeMail (string &seMail, string &sMessage)
+{
+  // Reference copy of CDog::VerifyeMail() ...
+  if (seMail.empty())
+    {sMessage = "email address cannot be blank";  return false;}
+  std::tr1::regex reeMail("^[[:alnum:]_%\\+\\-\\.]+@[[:alnum:]\\.\\-]+\\.[[:alpha:]]{2,}$");
+  if (std::tr1::regex_match(seMail, reeMail)) return true;
+  sMessage = "invalid email address \"" + seMail + "\"";
+  seMail.clear();  return false;
+}
+
+
+/*static*/ bool CDiffHarness::RefVerifyState (string &sState, string &sMessage)
+{
+  // Reference copy of CDog::VerifyState() ...
+  if (sState.empty()) {
+    sState = "CA";  return true;
+  }
+  static string sStates = "|AL|AK|AS|AZ|AR|CA|CO|CT|DE|DC|FM|FL|GA|GU|HI|ID|IL|IN|IA|KS|KY|LA|ME|MH|MD|MA|MI|MN|MS|MO|MT|NE|NV|NH|NJ|NM|NY|NC|ND|MP|OH|OK|OR|PW|PA|PR|RI|SC|SD|TN|TX|UT|VT|VI|VA|WA|WV|WI|WY|";
+  if ((sState.length() == 2)  &&  (sStates.find(sState) != string::npos)) return true;
+  sMessage = "invalid state \"" + sState + "\"";
+  sState.clear();  return false;
+}
+
+
+/*static*/ bool CDiffHarness::RefVerifyMicrochip (string &sChip)
+{
+  // Reference copy of CChip::VerifyMicrochip() (with fMessage false) ...
+  if (sChip.empty()) return false;
+  std::tr1::regex reISO("^9\\d{14}$");
+  if (std::tr1::regex_match(sChip, reISO)) return true;
+  std::tr1::regex rePumpkin("^202\\d{12}$");
+  if (std::tr1::regex_match(sChip, rePumpkin)) return true;
+  std::tr1::regex reFDXA("^[[:xdigit:]]{10}$");
+  if (std::tr1::regex_match(sChip, reFDXA)) return true;
+  std::tr1::regex reOld("^(\\d{3})[ \\*]?(\\d{3})[ \\*]?(\\d{3})$");
+  std::tr1::smatch rmChip;
+  if (std::tr1::regex_search(sChip, rmChip, reOld)) {
+    sChip = rmChip.str(1) + rmChip.str(2) + rmChip.str(3);  return true;
+  }
+  return false;
+}
+
+
+/*static*/ void CDiffHarness::RefCompareDogs (const CDogs &OldDogs, CDogs &NewDogs)
+{
+  // Reference copy of the seven pass CompareDogs() ...
+  MSGS("Comparing " << OldDogs.DogCount() << " old dogs with " << NewDogs.DogCount() << " new dogs ...");
+
+  // Pass 1 - dogs that disappeared ...
+  for (CDogs::dog_number_const_iterator it = OldDogs.dog_begin(); it != OldDogs.dog_end(); ++it) {
+    const CDog *pOldDog = it->second;
+    if (NewDogs.Find(pOldDog->GetNumber()) == NULL) {
+      if (pOldDog->HasChip())
+        BADDOGS(pOldDog, "has microchip " + pOldDog->GetChip() + " but is not found in new dog report");
+    }
+  }
+
+  // Pass 2 - dogs acquired, chips added and chips changed ...
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+    CDog *pNewDog = it->second;
+    if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
+    const CDog *pOldDog = OldDogs.Find(pNewDog->GetNumber());
+    if (pOldDog == NULL) {
+      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " was acquired");
+      if (pNewDog->GetChip().empty()) {
+        BADDOGS(pNewDog, "no microchip number recorded");
+      } else {
+        pNewDog->SetUpdateRequired();
+      }
+    } else if (pOldDog->GetChip().empty() && !pNewDog->GetChip().empty()) {
+      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " microchip was added");
+      pNewDog->SetUpdateRequired();
+    } else if (pOldDog->GetChip() != pNewDog->GetChip()) {
+      BADDOGS(pNewDog, "microchip number changed - was \"" << pOldDog->GetChip() << "\" is \"" << pNewDog->GetChip() << "\"");
+    }
+  }
+
+  // Pass 3 - adopted but no adopter ...
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+    CDog *pNewDog = it->second;
+    if ((pNewDog->GetStatus() == "Adopted")) {
+      if (pNewDog->GetAdoptionFName().empty() && pNewDog->GetAdoptionLName().empty())
+        BADDOGS(pNewDog, pNewDog->GetStatus() + " but no adopting party is recorded");
+    }
+  }
+
+  // Pass 4 - adopter but not adopted ...
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+    CDog *pNewDog = it->second;
+    if (!pNewDog->GetAdoptionFName().empty() || !pNewDog->GetAdoptionLName().empty()) {
+      if ((pNewDog->GetStatus() != "Adopted") && (pNewDog->GetStatus() != "Adoption Pending")) {
+        if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
+        BADDOGS(pNewDog, " adopting party is recorded but status is " + pNewDog->GetStatus());
+      }
+    }
+  }
+
+  // Pass 5 - disposition date but still available ...
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+    CDog *pNewDog = it->second;
+    if (!pNewDog->GetDispositionDate().empty()) {
+      if (pNewDog->GetDispositionDate() == "0000-00-00") continue;
+      if ((pNewDog->GetStatus() == "Evaluation") || (pNewDog->GetStatus() == "Available"))
+        BADDOGS(pNewDog, "disposition date is " + pNewDog->GetDispositionDate() + " but status is " + pNewDog->GetStatus());
+    }
+  }
+
+  // Pass 6 - recently adopted, or adopting family changed ...
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+    CDog *pNewDog = it->second;
+    const CDog *pOldDog = OldDogs.Find(pNewDog->GetNumber());
+    if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
+    if (!pNewDog->IsAdopted()) continue;
+    if ((pOldDog != NULL) && pOldDog->IsAdopted()) {
+      if ((pOldDog->GetAdoptionFName() != pNewDog->GetAdoptionFName())
+          || (pOldDog->GetAdoptionLName() != pNewDog->GetAdoptionLName()))
+          BADDOGS(pOldDog, "adopting family changed");
+    } else {
+      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " was adopted by " << pNewDog->GetAdoptionFName() << " " << pNewDog->GetAdoptionLName());
+      pNewDog->SetUpdateRequired();
+    }
+  }
+
+  // Pass 7 - returned to NGRR ...
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+    CDog *pNewDog = it->second;
+    const CDog *pOldDog = OldDogs.Find(pNewDog->GetNumber());
+    if ((pOldDog == NULL) || !pOldDog->IsAdopted()) continue;
+    if (!pNewDog->IsAdopted()) {
+      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " was returned to NGRR");
+      pNewDog->SetUpdateRequired();
+    }
+  }
+}
@@ -0,0 +1,264 @@
+//++
+// DiffHarness.hpp -> differential testing of fast paths vs reference code
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The CDiffHarness class runs the "reference" implementations of the CSV
+// parser, the field validators and CompareDogs() side by side with the code
+// the program actually uses (the "candidate"), on the same inputs, and checks
+// that the outputs are identical byte for byte.  The reference versions are
+// frozen copies of the original (slow, regex based) code and live only in
+// DiffHarness.cpp - they should NEVER be changed, no matter how much faster
+// the real code gets.  That's the whole point!
+//
+//   Sometimes the real code is changed on purpose to accept more than the
+// original did (e.g. CDog::ParseAge() understands "2 yrs 3 mos", which the
+// old regex didn't).  The frozen reference still stays exactly as it was.
+// Instead the check gets an exemption - a function that picks out just the
+// inputs in the new layouts that the original code rejected - and everything
+// else still has to match byte for byte.  The new behavior gets a separate
+// check of its own, against a reference written for the new grammar, and
+// that reference lives outside the frozen section.  Code that's entirely new
+// (e.g. CDomainChecker::Suggest()) has no reference at all, so its check
+// compares it with a short list of hand picked inputs and their answers.
+//
+//   The inputs come from the synthetic DIR generator and, optionally, from a
+// pair of real ("recorded") DIR files.  When a difference is found, the input
+// is shrunk to the smallest one that still shows the difference - for a field
+// check that's the fewest characters, and for the whole pipeline that's the
+// fewest DIR rows - so that the problem is easy to see.
+//
+//   There's one more pipeline check that runs the candidate with households
+// (see Household.hpp) on a few hand made families - different families that
+// share a work phone, a placeholder phone or email, a crowded address, or are
+// only bridged by a similar sounding name.  None of those are the same
+// household, so the output must still match the reference, which doesn't know
+// about households at all.
+//
+//   And the last pipeline check is different - there's no reference code in
+// it at all.  It compares a single update run, RunUpdate(), with the same
+// DIRs split into shards, run as a batch and merged (see CShards).  The DIRs
+// are the generated pair plus a few dogs that were re-entered under a new
+// number, with misspelled email domains, and a few adopter changes that are
+// only the same household because of a dog in another shard.  Those are the
+// results that depend on seeing every dog at once.  The merged files are sorted by dog and the
+// single run's aren't, so the lines of each file are sorted before they're
+// compared.
+//
+//   The "whatif" check uses the same DIRs, and compares the number of updates
+// and errors that CWhatIf counts for a few cutoff years with what a real
+// RunUpdate() for each of those years writes.  CWhatIf only runs the one dog
+// rules once, and counts them by year (see WhatIf.hpp), so this is what
+// makes sure that the sums still come out the same.
+//
+//   New fast paths are added with AddFieldCheck(), which takes a name, an
+// input corpus, and the reference and candidate functions.  Each function
+// takes one input string and returns its output encoded as a string.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add exemptions and the new ComputeBirthday() check.
+// 17-OCT-26  AGT   Add the shards check.
+// 17-OCT-26  AGT   Add households that span shards to the shards check.
+// 17-OCT-26  AGT   Add the CDomainChecker::Suggest check.
+// 17-OCT-26  AGT   Add the whatif check.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <functional>           // std::function ...
+#include "Dog.hpp"              // CDog data and CDogs collection
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+class CDIRGenerator;            // ...
+
+
+class CDiffHarness {
+  //++
+  // Differential test harness ...
+  //--
+
+public:
+  enum {
+    DEFAULT_DOGS        = 2000,         // default size of the generated DIRs
+    MAX_SHRINK_TESTS    = 5000,         // give up shrinking after this many tries
+    SHARDS              = 4,            // shards for the shards check
+    REENTERED_DOGS      = 8,            // re-entered dogs  "   "     "
+    DOMAIN_DOGS         = 4,            // adopters at the uncommon domain
+    HOUSEHOLD_DOGS      = 4,            // pairs of dogs for the households
+    WHATIF_YEARS        = 5,            // cutoff years for the whatif check
+  };
+
+  // Reference or candidate function for a field check ...
+  typedef std::function<string(const string &)> FIELD_FUNCTION;
+  // Returns true for inputs where the candidate may differ on purpose ...
+  typedef std::function<bool(const string &)> FIELD_FILTER;
+  // Runs a whole pipeline on a pair of DIRs and returns all its output ...
+  typedef std::function<string(const vector<string> &, const vector<string> &)> PIPELINE_FUNCTION;
+  // One field level check ...
+  struct CHECK {
+    string          sName;              // name of the check (e.g. "VerifyZip")
+    const vector<string> *pCorpus;      // inputs for the check
+    FIELD_FUNCTION  fnReference;        // reference implementation
+    FIELD_FUNCTION  fnCandidate;        // candidate (i.e. fast) implementation
+    FIELD_FILTER    fnExempt;           // inputs that aren't compared (or empty)
+  };
+  // Results for one check ...
+  struct RESULT {
+    string    sName;                    // name of the check
+    size_t    nInputs;                  // number of inputs tried
+    size_t    nExempt;                  // number of inputs exempted
+    size_t    nMismatches;              // number of inputs that differed
+    string    sInput;                   // smallest input that differs
+    string    sReference;               // reference output for that input
+    string    sCandidate;               // candidate output  "    "    "
+  };
+  typedef vector<RESULT> RESULT_VECTOR;
+
+public:
+  // Constructor and destructor ...
+  CDiffHarness (CDIRGenerator &gen);
+  virtual ~CDiffHarness();
+  // Copy and assignment constructors ...
+  CDiffHarness (const CDiffHarness &h) = delete;
+  CDiffHarness& operator= (const CDiffHarness &h) = delete;
+
+  // CDiffHarness public properties ...
+public:
+  // Set the directory used for scratch files ...
+  void SetDirectory (const string &sDir) {m_sDirectory = sDir;}
+  // Set the cutoff year and DIR formats for the pipeline checks ...
+  void SetCutoffYear (uint32_t nYear) {m_nCutoffYear = nYear;}
+  void SetFormats (bool fOldNew, bool fNewNew) {m_fOldFormat = fOldNew;  m_fNewFormat = fNewNew;}
+  // Add a pair of recorded DIR files to the corpora ...
+  void SetRecorded (const string &sOldFile, const string &sNewFile)
+    {m_sRecordedOld = sOldFile;  m_sRecordedNew = sNewFile;}
+  // Return the results so far ...
+  const RESULT_VECTOR &GetResults() const {return m_vecResults;}
+  // Return the number of checks that failed ...
+  size_t GetFailures() const;
+
+  // CDiffHarness public methods ...
+public:
+  // Add a field level check ...
+  void AddFieldCheck (const string &sName, const vector<string> &vecCorpus,
+                      FIELD_FUNCTION fnReference, FIELD_FUNCTION fnCandidate,
+                      FIELD_FILTER fnExempt=nullptr);
+  // Build the corpora and run all the checks ...
+  void Run();
+  // Print the results ...
+  void Report() const;
+  //   Shrink a list of "units" (characters, rows, whatever) to a minimal list
+  // for which fnFails() is still true (this is Zeller's ddmin algorithm) ...
+  static vector<size_t> Shrink (const vector<size_t> &vecUnits,
+                                std::function<bool(const vector<size_t> &)> fnFails,
+                                size_t nMaxTests=MAX_SHRINK_TESTS);
+  // Make a string printable (escape control characters, etc) ...
+  static string Escape (const string &str);
+
+  // Private internal CDiffHarness methods ...
+protected:
+  // Build the input corpora ...
+  void BuildCorpora();
+  void AddDIR (const vector<string> &vecLines, bool fNew);
+  void BuildHouseholds();
+  void BuildShards();
+  // Add all the standard field checks ...
+  void AddStandardChecks();
+  // Run one field check ...
+  void RunFieldCheck (const CHECK &check);
+  // Run the whole pipeline check on one pair of DIRs ...
+  void RunPipelineCheck (const string &sName, const vector<string> &vecOld, const vector<string> &vecNew, bool fHouseholds=false);
+  void RunPipelineCheck (const string &sName, const vector<string> &vecOld, const vector<string> &vecNew,
+                         PIPELINE_FUNCTION fnReference, PIPELINE_FUNCTION fnCandidate);
+  // Run the pipeline (reference or candidate) and return all the output ...
+  string RunPipeline (const vector<string> &vecOld, const vector<string> &vecNew, bool fReference, bool fHouseholds=false);
+  // Run a whole update (single or sharded) and return all the output ...
+  string RunShards (const vector<string> &vecOld, const vector<string> &vecNew, bool fSharded);
+  // Count the updates and errors for several cutoffs (CWhatIf or real runs) ...
+  string RunWhatIf (const vector<string> &vecOld, const vector<string> &vecNew, bool fWhatIf);
+  // Read a DIR file into lines ...
+  static void ReadLines (const string &sFileName, vector<string> &vecLines);
+  // Write a DIR (header plus selected rows) to a file ...
+  static void WriteLines (const string &sFileName, const vector<string> &vecLines);
+  // Read a whole file into a string ...
+  static string ReadAll (const string &sFileName);
+  // Read a whole file and return its lines sorted (but the header first) ...
+  static string ReadSorted (const string &sFileName);
+  // Return the full path for a scratch file ...
+  string MakeFileName (const char *pszName) const {return m_sDirectory + "/diff-" + pszName + ".csv";}
+  // Capture the last bad dog message (if any) after a candidate call ...
+  static string LastError (size_t nBefore);
+  // Encode a validator result as a string ...
+  static string Encode (bool fOK, const string &sValue, const string &sMessage)
+    {return string(fOK ? "1" : "0") + "|" + sValue + "|" + sMessage;}
+
+  // Frozen reference implementations ...
+protected:
+  static string RefTrimColumn (const string &src);
+  static string RefRemoveEquals (const string &src);
+  static string RefParseField (const string &str, string::const_iterator &it);
+  static CCSVRow::COLUMN_VECTOR RefParse (const string &str);
+  static bool RefParseDate (const string &sDate, uint32_t &nDay, uint32_t &nMonth, uint32_t &nYear);
+  static bool RefComputeBirthday (const string &sAge, const string &sDateAcquired, string &sDOB);
+  static bool RefVerifyPhone (string &sPhone, string &sMessage);
+  static bool RefVerifyZip (string &sZip, string &sMessage);
+  static bool RefVerifyeMail (string &seMail, string &sMessage);
+  static bool RefVerifyState (string &sState, string &sMessage);
+  static bool RefVerifyMicrochip (string &sChip);
+  static void RefCompareDogs (const CDogs &OldDogs, CDogs &NewDogs);
+  static void RefReadDogs (CDogs &Dogs, const vector<string> &vecLines, uint32_t nYear, bool fNew);
+  // References for new behavior (not frozen) ...
+  static bool IsNewAgeLayout (const string &sAge);
+  static bool NewComputeBirthday (const string &sAge, const string &sDateAcquired, string &sDOB);
+
+  // Local CDiffHarness members ...
+protected:
+  CDIRGenerator  &m_Generator;          // generates the synthetic DIRs
+  string          m_sDirectory;         // directory for scratch files
+  uint32_t        m_nCutoffYear;        // cutoff year for the pipeline
+  bool            m_fOldFormat;         // old DIR is the new format
+  bool            m_fNewFormat;         // new  "   "  "   "    "
+  string          m_sRecordedOld;       // recorded old DIR (if any)
+  string          m_sRecordedNew;       //    "     new  "    "   "
+  CDog           *m_pScratch;           // scratch dog for the candidates
+  vector<CHECK>   m_vecChecks;          // all the field checks
+  RESULT_VECTOR   m_vecResults;         // results for every check
+  // Input corpora ...
+  vector<string>  m_vecGenOld;          // generated old DIR lines
+  vector<string>  m_vecGenNew;          //    "      new  "    "
+  vector<string>  m_vecRecOld;          // recorded old DIR lines
+  vector<string>  m_vecRecNew;          //    "     new  "    "
+  vector<string>  m_vecHouseOld;        // household check old DIR lines
+  vector<string>  m_vecHouseNew;        //     "       "   new  "    "
+  vector<string>  m_vecShardOld;        // shards check old DIR lines
+  vector<string>  m_vecShardNew;        //    "     "   new  "    "
+  vector<string>  m_vecLines;           // all DIR lines (less headers)
+  vector<string>  m_vecPhones;          // phone numbers
+  vector<string>  m_vecZips;            // zip codes
+  vector<string>  m_veceMails;          // email addresses
+  vector<string>  m_vecStates;          // state abbreviations
+  vector<string>  m_vecChips;           // microchip numbers
+  vector<string>  m_vecDates;           // dates
+  vector<string>  m_vecAges;            // "age<TAB>date acquired" pairs
+  vector<string>  m_vecDomains;         // "email<TAB>suggestion" pairs
+};
@@ -40,6 +40,18 @@
 // 19-Jan-21  RLA   Update for new DIR file format
 //  3-Apr-23  RLA   Update again for yet another DIR file format
 // 17-Dec-23  RLA   Allow "none" in the microchip field
+// 17-Oct-26  AGT   Add CMetrics counters
+// 17-Oct-26  AGT   Add CTracer events to ReadFile()
+// 17-Oct-26  AGT   Add FindSimilarChips()
+// 17-Oct-26  AGT   Cross check the adopter's zip, state and city
+// 17-Oct-26  AGT   Parse the age without a regex, and accept more layouts
+// 17-Oct-26  AGT   Allow organization prefixes and 32 bit dog numbers
+// 17-Oct-26  AGT   Lock the organization registry
+// 17-Oct-26  AGT   Split the search out of FindSimilarChips()
+// 17-Oct-26  AGT   Allocate CDog objects from a CArena
+// 17-Oct-26  AGT   One CDog arena per thread
+// 17-Oct-26  AGT   Parse dog IDs and look up prefixes in place
+// 17-Oct-26  AGT   FindSimilarChips() works on numbers, and copes with lots
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -51,12 +63,16 @@
 #include <regex>                // regular expression matching ...
 #include <chrono>               // date and time arithmetic
 #include <locale>               // std::locale, std::toupper
+#include <algorithm>            // std::min(), std::sort() ...
 #include <ctype.h>              // old fashioned toupper() and tolower()
 #include "Messages.hpp"         // ERRS() macro, et al ...
 #include "CSVRow.hpp"           // CSV file row object
 #include "CSVFile.hpp"          // a collection of spreadsheet rows
 #include "Dog.hpp"              // declarations for this module
 #include "Chip.hpp"             // needed for CChip::VerifyMicrochip() ...
+#include "ZipCodes.hpp"         // CZipCodes::GetState(), et al ...
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "Trace.hpp"            // TRACE_CHUNK() macro, et al ...
 
 // This is the expected header row for the dog information report ...
 //   Note that "Micropchip" is misspelled - that's the way it actually is in
@@ -106,14 +122,94 @@ const string CDog::m_sNewColumnHeaders("Dog Name, Dog Number, Micropchip number,
 }
 
 
+// Organization prefixes - code zero (no prefix at all) is always NGRR ...
+vector<string> CDog::m_vecOrgs(1, "");
+std::mutex     CDog::m_mtxOrgs;
+
+// Each thread's arena for its CDog objects ...
+thread_local CArena CDog::m_Arena(sizeof(CDog));
+
+
+/*static*/ uint32_t CDog::LookupOrg (const char *pszPrefix, size_t nLength)
+{
+  //++
+  //   Return the organization code for a dog number prefix (e.g. "ABC" for
+  // "ABC-12345").  Prefixes are case insensitive, and a new prefix gets the
+  // next code the first time we see it.  There are only ever a handful of
+  // partner organizations, so a linear search is fine.  The prefix doesn't
+  // have to be a string of its own, so --where can look up the prefix of a
+  // field in place ...
+  //--
+  std::lock_guard<std::mutex> lock(m_mtxOrgs);
+  for (size_t i = 0;  i < m_vecOrgs.size();  ++i) {
+    const string &sOrg = m_vecOrgs[i];
+    if (sOrg.length() != nLength) continue;
+    size_t j = 0;
+    while ((j < nLength) && (toupper((unsigned char) pszPrefix[j]) == sOrg[j]))  ++j;
+    if (j == nLength) return (uint32_t) i;
+  }
+  string sUpper(pszPrefix, nLength);
+  for (size_t i = 0;  i < sUpper.length();  ++i)  sUpper[i] = toupper(sUpper[i]);
+  m_vecOrgs.push_back(sUpper);
+  return (uint32_t) (m_vecOrgs.size()-1);
+}
+
+
+/*static*/ string CDog::GetOrgPrefix (uint32_t nOrg)
+{
+  //++
+  // Return the prefix for an organization code ("" for NGRR) ...
+  //--
+  std::lock_guard<std::mutex> lock(m_mtxOrgs);
+  assert(nOrg < m_vecOrgs.size());
+  return m_vecOrgs[nOrg];
+}
+
+
+/*static*/ bool CDog::ParseDogID (const char *pszID, size_t nLength, uint32_t &nOrg, uint32_t &nNumber)
+{
+  //++
+  //   Parse a dog ID from the DIR.  NGRR's own dogs have just a number, but
+  // partner rescues prefix theirs with a few letters and an optional dash
+  // (e.g. "ABC-12345" or "abc12345").  The number can be anything from 1 to
+  // 2^32-1.  Returns false, and doesn't change nOrg or nNumber, if the ID
+  // isn't valid.  The ID is parsed in place, so it needn't be a string ...
+  //--
+  size_t nPrefix = 0;
+  while ((nPrefix < nLength) && isalpha((unsigned char) pszID[nPrefix]))  ++nPrefix;
+  size_t nStart = nPrefix;
+  if ((nStart > 0) && (nStart < nLength) && (pszID[nStart] == '-'))  ++nStart;
+  if ((nStart >= nLength) || (nLength-nStart > 10)) return false;
+  uint64_t nValue = 0;
+  for (size_t i = nStart;  i < nLength;  ++i) {
+    if (!isdigit((unsigned char) pszID[i])) return false;
+    nValue = nValue*10 + (pszID[i] - '0');
+  }
+  if ((nValue == 0) || (nValue > UINT32_MAX)) return false;
+  nOrg = (nPrefix == 0) ? (uint32_t) NGRR_ORG : LookupOrg(pszID, nPrefix);
+  nNumber = (uint32_t) nValue;
+  return true;
+}
+
+
+string CDog::GetID() const
+{
+  //++
+  //   Return this dog's ID the way it appears in the DIR, which for an NGRR
+  // dog is just the number ...
+  //--
+  if (m_nOrg == NGRR_ORG) return std::to_string(m_nNumber);
+  return GetOrgPrefix(m_nOrg) + "-" + std::to_string(m_nNumber);
+}
+
+
 void CDog::Initialize (uint32_t nDog)
 {
   //++
   //   Initialize this CDog object ...  This sets every field to the null
   // string EXCEPT the dog number, which is always required ...
   //--
-  assert(nDog <= MAXDOG);
-  m_nNumber = nDog;  m_sName.clear();  m_sMicrochip.clear();  m_sAge.clear();
+  m_nNumber = nDog;  m_nOrg = NGRR_ORG;  m_sName.clear();  m_sMicrochip.clear();  m_sAge.clear();
   m_sSex.clear();  m_sNeuter.clear();  m_sStatus.clear();  m_sLocation.clear();
   m_sHowAcquired.clear();  m_sDateAcquired.clear();  m_sPrimaryContactFName.clear();
   m_sPrimaryContactLName.clear();  m_sSurrenderFName.clear();
@@ -184,12 +280,8 @@ bool CDog::FromRow (const CCSVRow &row, bool fNew)
   if (_stricmp(m_sMicrochip.c_str(), "none") == 0) m_sMicrochip.clear();
 
   // Parse the dog number and make sure it's legal ...
-  std::tr1::regex reNumber("\\d+");
-  if (!std::tr1::regex_match(sDogNumber, reNumber)) 
+  if (!ParseDogID(sDogNumber, m_nOrg, m_nNumber))
     {BADDOGS(this, "invalid dog number " << sDogNumber);  return false;}
-  m_nNumber = std::stoi(sDogNumber);
-  if ((m_nNumber == 0) || (m_nNumber > MAXDOG))
-    {BADDOGS(this, "invalid dog number " << m_nNumber);  return false;}
   return true;
 }
 
@@ -244,7 +336,7 @@ void CDog::Display() const
   //++
   // Dump all this dog's data on stdout ...
   //--
-  std::cout << ">>>>> Data for dog #" << m_nNumber << " <<<<<" << std::endl;
+  std::cout << ">>>>> Data for dog #" << GetID() << " <<<<<" << std::endl;
   std::cout << "\t Name               = \"" << m_sName << "\"" << std::endl;
   std::cout << "\t Microchip          = \"" << m_sMicrochip << "\"" << std::endl;
   std::cout << "\t Age                = \"" << m_sAge << "\"" << std::endl;
@@ -308,14 +400,113 @@ void CDog::Display() const
 }
 
 
+/*static*/ CDog::AGE_FORMAT CDog::ParseAge (const string &sAge, uint32_t &nYears, uint32_t &nMonths)
+{
+  //++
+  //   Parse the dog's age field.  The NGRR web page lets people type anything
+  // they like in there, and the ones we actually see are -
+  //
+  //      "2 Years 3 Months"  "1 Year 0 Months"  "2 yrs 3 mos"  "2 years, 3 mos"
+  //      "3 Years"           "6 months"         "2.5 years"
+  //
+  // Case never matters, and the space between the number and the unit is
+  // optional.  The unit may be "year", "years", "yr" or "yrs" and "month",
+  // "months", "mo" or "mos".  A fraction of a year is rounded to the nearest
+  // month, and months alone are converted to years and months.  Numbers are
+  // limited to MAXAGEDIGITS digits (and fractions to MAXFRACTION digits) and
+  // the result to MAXAGEYEARS years.  Also for compatibility with the old
+  // code the months may be up to and including 12 when there are years too.
+  //
+  //   This is a simple hand written tokenizer rather than a regex, partly
+  // because regexes are slow but mostly because it's a lot easier to see
+  // exactly what's accepted.  It makes one pass over the string and doesn't
+  // allocate anything.  Returns the layout it found, or AGE_INVALID ...
+  //--
+  enum {MAXAGEDIGITS = 6, MAXFRACTION = 4, MAXAGEYEARS = 20, MAXUNIT = 6};
+  static const struct {const char *pszUnit;  bool fYears, fAbbreviated;} aUnits[] = {
+    {"years", true, false}, {"year", true, false}, {"yrs", true, true}, {"yr", true, true},
+    {"months", false, false}, {"month", false, false}, {"mos", false, true}, {"mo", false, true},
+    {NULL, false, false}
+  };
+  nYears = nMonths = 0;
+  size_t i = 0, n = sAge.length();
+  uint32_t nComponents = 0;  bool fYears = false, fMonths = false;
+  bool fFraction = false, fAbbreviated = false;
+  while (true) {
+    // Skip spaces (and a comma between the years and months) ...
+    bool fComma = false;
+    while ((i < n) && (isspace((unsigned char) sAge[i]) || ((nComponents == 1) && (sAge[i] == ','))))
+      fComma |= (sAge[i++] == ',');
+    if (i >= n) {
+      if (fComma) return AGE_INVALID;
+      break;
+    }
+    if (nComponents >= 2) return AGE_INVALID;
+
+    // Parse the number, including any fraction ...
+    uint32_t nValue = 0, nDigits = 0, nNumerator = 0, nDenominator = 1;
+    for (;  (i < n) && isdigit((unsigned char) sAge[i]);  ++i, ++nDigits)
+      nValue = nValue*10 + (sAge[i]-'0');
+    if ((nDigits == 0) || (nDigits > MAXAGEDIGITS)) return AGE_INVALID;
+    if ((i < n) && (sAge[i] == '.')) {
+      for (++i, nDigits = 0;  (i < n) && isdigit((unsigned char) sAge[i]);  ++i, ++nDigits)
+        {nNumerator = nNumerator*10 + (sAge[i]-'0');  nDenominator *= 10;}
+      if ((nDigits == 0) || (nDigits > MAXFRACTION)) return AGE_INVALID;
+      fFraction = true;
+    }
+
+    // And then the units ...
+    while ((i < n) && isspace((unsigned char) sAge[i])) ++i;
+    char szUnit[MAXUNIT+1];  uint32_t nUnit = 0;
+    for (;  (i < n) && isalpha((unsigned char) sAge[i]);  ++i) {
+      if (nUnit >= MAXUNIT) return AGE_INVALID;
+      szUnit[nUnit++] = (char) ::tolower((unsigned char) sAge[i]);
+    }
+    szUnit[nUnit] = 0;
+    uint32_t u = 0;
+    while ((aUnits[u].pszUnit != NULL) && (strcmp(szUnit, aUnits[u].pszUnit) != 0)) ++u;
+    if (aUnits[u].pszUnit == NULL) return AGE_INVALID;
+    fAbbreviated |= aUnits[u].fAbbreviated;
+
+    //   Years must come first and months last, and only years can have a
+    // fraction.  The fraction is converted to months, rounding half up ...
+    if (aUnits[u].fYears) {
+      if (nComponents != 0) return AGE_INVALID;
+      nYears = nValue;  fYears = true;
+      nMonths = (nNumerator*12*2 + nDenominator) / (2*nDenominator);
+      if (nMonths == 12) {++nYears;  nMonths = 0;}
+    } else {
+      if (fMonths || fFraction) return AGE_INVALID;
+      nMonths = nValue;  fMonths = true;
+    }
+    ++nComponents;
+  }
+
+  // Figure out what we found ...
+  AGE_FORMAT nFormat;
+  if (fYears && fMonths) {
+    if (nMonths > 12) return AGE_INVALID;
+    nFormat = fAbbreviated ? AGE_ABBREVIATED : AGE_YEARS_MONTHS;
+  } else if (fYears) {
+    nFormat = fFraction ? AGE_FRACTION : AGE_YEARS;
+  } else if (fMonths) {
+    nYears = nMonths / 12;  nMonths %= 12;  nFormat = AGE_MONTHS;
+  } else
+    return AGE_INVALID;
+  if (nYears > MAXAGEYEARS) return AGE_INVALID;
+  return nFormat;
+}
+
+
 bool CDog::ComputeBirthday (string &sDOB) const
 {
   //++
   //   This method will attempt to compute the dog's date of birth.  This is
   // tricky because what the DIR actually gives us is the dog's age, and that's
   // relative to the date the dog was acquired.  Worse, the age is formatted
-  // oddly as a string "nn Years nn Months".  We'll have to parse that, parse
-  // the date acquired, and then do some math.
+  // as a string, usually "nn Years nn Months" but not always (see ParseAge()
+  // for all the gory details).  We'll have to parse that, parse the date
+  // acquired, and then do some math.
   //
   //   The answer will be returned as a string in the format "MM/DD/YYYY".
   // Note that the actual day will always be returned as "01" because the
@@ -328,15 +519,16 @@ bool CDog::ComputeBirthday (string &sDOB) const
   sDOB.clear();
   if (m_sDateAcquired.empty() || m_sAge.empty()) return false;
 
-  // Parse the age field ...
-  std::tr1::regex reAge("^(\\d+)\\syears\\s(\\d+)\\smonths$");
-  std::tr1::smatch rmAge;
-  string sAge = tolower(m_sAge);
-  if (!std::tr1::regex_search(sAge, rmAge, reAge)) return false;
-  assert(rmAge.size() == 3);
-  uint32_t nAgeYears = std::stoi(rmAge.str(1));
-  uint32_t nAgeMonths = std::stoi(rmAge.str(2));
-  if ((nAgeMonths > 12) || (nAgeYears > 20)) return false;
+  // Parse the age field, and keep score of the layouts we see ...
+  uint32_t nAgeYears, nAgeMonths;
+  switch (ParseAge(m_sAge, nAgeYears, nAgeMonths)) {
+    case AGE_YEARS_MONTHS:  METRIC(AGE_YEARS_MONTHS);  break;
+    case AGE_ABBREVIATED:   METRIC(AGE_ABBREVIATED);   break;
+    case AGE_YEARS:         METRIC(AGE_YEARS);         break;
+    case AGE_MONTHS:        METRIC(AGE_MONTHS);        break;
+    case AGE_FRACTION:      METRIC(AGE_FRACTION);      break;
+    default:                METRIC(AGE_INVALID);       return false;
+  }
 
   // Parse the date acquired ...
   uint32_t nYearAcquired, nMonthAcquired, nDayAcquired;
@@ -362,6 +554,7 @@ bool CDog::VerifyPhone (const string &sWhich, string &sPhone, bool fQuiet) const
   // decimal digits, e.g. "4085551212", with no punctuation or other special
   // characters.  Note that we don't currently allow international numbers!
   //--
+  METRIC(VALIDATIONS);
 
   //   Leave a totally blank phone number alone.  At the same time, handle a
   // few nonsense words that people like to enter ...
@@ -398,6 +591,7 @@ bool CDog::VerifyZip (string &sZip) const
   //
   //    BTW, in this case a null zip code is NOT acceptable!
   //--
+  METRIC(VALIDATIONS);
   if (sZip.empty()) 
     {BADDOGS(this, "zip code cannot be blank");  return false;}
   std::tr1::regex reZip("^\\d{5}(\\-\\d{4})?$");
@@ -416,6 +610,7 @@ bool CDog::VerifyeMail (string &seMail) const
   // and probably acccepts a few things that it shouldn't, but it's pretty
   // close.  Null email addresses are not allowed!
   //--
+  METRIC(VALIDATIONS);
   if (seMail.empty())
     {BADDOGS(this, "email address cannot be blank");  return false;}
   std::tr1::regex reeMail("^[[:alnum:]_%\\+\\-\\.]+@[[:alnum:]\\.\\-]+\\.[[:alpha:]]{2,}$");
@@ -430,6 +625,7 @@ bool CDog::VerifyState (string &sState) const
   //++
   // Verify a legal USPS 2 letter state name abbreviation ...
   //--
+  METRIC(VALIDATIONS);
   
   //   This is a huge kludge, but there are a fair number of people who omit
   // their state.  If it's blank, assume California!
@@ -446,11 +642,36 @@ bool CDog::VerifyState (string &sState) const
 }
 
 
+bool CDog::VerifyAddress (const string &sCity, const string &sState, const string &sZip) const
+{
+  //++
+  //   Cross check a zip code against the state and city.  This should be
+  // called AFTER VerifyZip() and VerifyState(), which will have cleared the
+  // zip or state if they were invalid - in that case there's nothing to
+  // check and we've already complained.  Remember that the city check only
+  // works for the cities that CZipCodes knows about; any other city is OK.
+  //--
+  if (sZip.empty() || sState.empty()) return true;
+  METRIC(VALIDATIONS);
+  if (!CZipCodes::IsInState(sZip, sState)) {
+    BADDOGS(this, "zip code " << sZip << " doesn't match state " << sState
+            << " (should be " << CZipCodes::GetState(sZip) << ")");
+    return false;
+  }
+  if (CZipCodes::CheckCity(sCity, sZip) == CZipCodes::CITY_MISMATCH) {
+    BADDOGS(this, "city \"" << sCity << "\" doesn't match zip code " << sZip);
+    return false;
+  }
+  return true;
+}
+
+
 bool CDog::VerifySex()
 {
   //++
   // Verify the sex (Male/Female) of a dog ...
   //--
+  METRIC(VALIDATIONS);
   string s = tolower(m_sSex);
   if ((s == "female")  ||  (s == "male")) return true;
   BADDOGS(this, "invalid sex \"" << m_sSex << "\"");
@@ -463,6 +684,7 @@ bool CDog::VerifySpayNeuter()
   //++
   // Verify the spay/neuter status (Yes/No) of a dog ...
   //--
+  METRIC(VALIDATIONS);
   string s = tolower(m_sNeuter);
   if ((s == "yes")  ||  (s == "no")) return true;
   BADDOGS(this, "invalid spay/neuter \"" << m_sNeuter << "\"");
@@ -514,7 +736,15 @@ bool CDog::VerifyAll()
     //}
     // Verify the adopter's mailing address ...
     fOK &= VerifyAdoptionZip();
+    //   If the state is blank, then take it from the zip code rather than
+    // letting VerifyState() assume California.  If the zip is invalid too,
+    // then California it is ...
+    if (m_sAdoptionState.empty()) {
+      const char *pszState = CZipCodes::GetState(m_sAdoptionZip);
+      if (pszState != NULL) m_sAdoptionState = pszState;
+    }
     fOK &= VerifyAdoptionState();
+    fOK &= VerifyAdoptionAddress();
   } else {
     bool fBlank = m_sAdoptioneMail.empty() & m_sAdoptionFName.empty() & m_sAdoptionLName.empty()
        & m_sAdoptionCellPhone.empty() & m_sAdoptionHomePhone.empty() & m_sAdoptionWorkPhone.empty()
@@ -573,7 +803,7 @@ void CDogs::DeleteAll()
   // contained in both.
   //--
   for (dog_number_iterator it = dog_begin(); it != dog_end(); ++it)  delete it->second;
-  m_mapNumber.clear();  m_mapChip.clear();
+  m_Index.clear();  m_mapChip.clear();
 }
 
 
@@ -586,11 +816,11 @@ bool CDogs::Add (CDog *pDog)
   // consequently can't be found by searching for a microchip).
   //--
   assert(pDog != NULL);
-  uint32_t nDog = pDog->GetNumber();
+  uint64_t nKey = pDog->GetKey();
   string sChip = pDog->GetChip();
 
-  // First, be sure that the NGRR dog number is unique ...
-  if (Find(nDog) != NULL) 
+  // First, be sure that the dog number is unique ...
+  if (Find(nKey) != NULL) 
     {BADDOGS(pDog, "already in collection");  return false;}
 
   //  Now we need to check and ensure that the microchip number, if any, is
@@ -600,13 +830,13 @@ bool CDogs::Add (CDog *pDog)
   if (!sChip.empty()) {
     const CDog *p = Find(sChip);
     if (p != NULL) {
-      BADDOGS(pDog,  "and " << p->GetName() << " #" << p->GetNumber() << " have the same microchip");
+      BADDOGS(pDog,  "and " << p->GetName() << " #" << p->GetID() << " have the same microchip");
       return false;
     }
   }
 
   // All's well - add this dog to both maps ...
-  m_mapNumber.insert({nDog, pDog});
+  m_Index.Insert(nKey, pDog);
   if (!sChip.empty()) m_mapChip.insert({sChip, pDog});
   return true;
 }
@@ -623,25 +853,189 @@ bool CDogs::Add (const CCSVRow &row)
 }
 
 
-CDog *CDogs::Find (uint32_t nDog) const
+CDog *CDogs::Find (string sChip) const
 {
   //++
-  //   Find a dog given it's NGRR dog number and return a pointer to the CDog
-  // object, or NULL if none exists.  Remember that just because a dog exists
-  // doesn't guarantee that it has a microchip too!
+  //   Find a dog given its microchip number and return a pointer to the CDog
+  // object, or NULL if none exists.  Finding a dog by number is done by the
+  // CDogIndex (see Dog.hpp) ...
   //--
-  dog_number_const_iterator it = m_mapNumber.find(nDog);
-  return (it != dog_end())  ?  it->second  :  NULL;
+  microchip_const_iterator it = m_mapChip.find(sChip);
+  return (it != chip_end())  ?  it->second  :  NULL;
 }
 
 
-CDog *CDogs::Find (string sChip) const
+/*static*/ bool CDogs::IsISOChip (const string &sChip)
 {
   //++
-  // Same as above, but this time search the microchip map ...
+  // Return true if the chip number is exactly 15 decimal digits ...
   //--
-  microchip_const_iterator it = m_mapChip.find(sChip);
-  return (it != chip_end())  ?  it->second  :  NULL;
+  if (sChip.length() != ISO_CHIP_LENGTH) return false;
+  for (size_t i = 0;  i < sChip.length();  ++i)
+    if (!isdigit((unsigned char) sChip[i])) return false;
+  return true;
+}
+
+
+/*static*/ uint64_t CDogs::PackChip (const string &sChip)
+{
+  //++
+  //   Convert an ISO chip to a number.  Fifteen decimal digits fit easily in
+  // 64 bits, and numbers are a lot cheaper to hash, sort and compare than
+  // strings.  The chip must already have passed IsISOChip() ...
+  //--
+  uint64_t nChip = 0;
+  for (size_t i = 0;  i < ISO_CHIP_LENGTH;  ++i)  nChip = nChip*10 + (sChip[i]-'0');
+  return nChip;
+}
+
+
+/*static*/ void CDogs::FindOneDigitPairs (const vector<uint64_t> &vecChips, unsigned nBlock, vector<SIMILAR_CHIPS> &vecSimilar)
+{
+  //++
+  //   Find all the pairs of chips that differ by exactly one digit, and that
+  // digit is in pigeonhole block nBlock (0 is the first CHIP_HIGH_DIGITS
+  // digits, and 1 is the rest).  A pair like that agrees on the other block,
+  // so sort the chips by the other block first and this one second - then the
+  // chips that share the other block form runs, and each run is sorted by
+  // this block.  Within a run, change each digit of this block to every
+  // larger digit and look for the result in the rest of the run.
+  //
+  //   Why not just hash each block and compare every pair in the bucket?
+  // Because shelters buy chips in lots, and a lot of chips only varies in the
+  // last few digits.  However the digits are split up, some block is the same
+  // for most of the lot, and that bucket is enormous.  This way the work per
+  // chip is bounded (at most nine tries per digit) no matter how the chips
+  // are distributed, and a run of one chip costs nothing at all ...
+  //--
+  static const uint64_t anPowers[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL
+  };
+  const uint64_t nSplit = anPowers[ISO_CHIP_LENGTH-CHIP_HIGH_DIGITS];
+  const unsigned nDigits = (nBlock == 0) ? CHIP_HIGH_DIGITS : ISO_CHIP_LENGTH-CHIP_HIGH_DIGITS;
+  struct BLOCKS {uint64_t nOther, nThis;  size_t nIndex;};
+  vector<BLOCKS> vecBlocks(vecChips.size());
+  for (size_t i = 0;  i < vecChips.size();  ++i) {
+    uint64_t nHigh = vecChips[i] / nSplit, nLow = vecChips[i] % nSplit;
+    if (nBlock == 0)
+      vecBlocks[i] = {nLow, nHigh, i};
+    else
+      vecBlocks[i] = {nHigh, nLow, i};
+  }
+  //   For block 1 the chips are already in the right order, since they're
+  // sorted by the whole number ...
+  if (nBlock == 0)
+    std::sort(vecBlocks.begin(), vecBlocks.end(), [](const BLOCKS &b1, const BLOCKS &b2)
+      {return (b1.nOther != b2.nOther) ? (b1.nOther < b2.nOther) : (b1.nThis < b2.nThis);});
+
+  for (size_t nFirst = 0, nLast;  nFirst < vecBlocks.size();  nFirst = nLast) {
+    for (nLast = nFirst+1;  (nLast < vecBlocks.size()) && (vecBlocks[nLast].nOther == vecBlocks[nFirst].nOther);  ++nLast) ;
+    const uint64_t nMaximum = vecBlocks[nLast-1].nThis;
+    for (size_t i = nFirst;  i+1 < nLast;  ++i) {
+      const uint64_t nValue = vecBlocks[i].nThis;
+      for (unsigned k = 0;  k < nDigits;  ++k) {
+        unsigned nDigit = (unsigned) ((nValue / anPowers[k]) % 10);
+        size_t nFrom = i+1;
+        for (uint64_t nTry = nValue+anPowers[k];  (++nDigit <= 9) && (nTry <= nMaximum);  nTry += anPowers[k]) {
+          //   The tries only get bigger, so gallop forward from where the last
+          // one left off and then do a binary search on the last step ...
+          size_t nLow = nFrom, nHigh = nFrom, nStep = 1;
+          while ((nHigh < nLast) && (vecBlocks[nHigh].nThis < nTry))
+            {nLow = nHigh+1;  nHigh += nStep;  nStep *= 2;}
+          if (nHigh > nLast) nHigh = nLast;
+          nFrom = std::lower_bound(vecBlocks.begin()+nLow, vecBlocks.begin()+nHigh, nTry,
+            [](const BLOCKS &b, uint64_t n) {return b.nThis < n;}) - vecBlocks.begin();
+          if ((nFrom == nLast) || (vecBlocks[nFrom].nThis != nTry)) continue;
+          size_t n1 = vecBlocks[i].nIndex, n2 = vecBlocks[nFrom].nIndex;
+          vecSimilar.push_back({std::min(n1, n2), std::max(n1, n2), "one digit different"});
+        }
+      }
+    }
+  }
+}
+
+
+size_t CDogs::FindSimilarChips() const
+{
+  //++
+  //   Exact duplicate microchip numbers are caught by Add(), but the more
+  // common problem is a typo - one digit wrong, or two adjacent digits swapped,
+  // so that the chip recorded for one dog is almost the same as another dog's.
+  // This method finds all such pairs of ISO chips and reports them as bad dogs.
+  // It returns the number of pairs found.  The search itself is done by the
+  // static version below, which CShards also uses ...
+  //--
+  TRACE_SCOPE("similar chips");
+
+  // Collect all the ISO chips, in order, so the report is repeatable ...
+  vector<const CDog *> vecDogs;
+  for (microchip_const_iterator it = chip_begin();  it != chip_end();  ++it)
+    if (IsISOChip(it->first)) vecDogs.push_back(it->second);
+  std::sort(vecDogs.begin(), vecDogs.end(),
+    [](const CDog *p1, const CDog *p2) {return p1->GetChip() < p2->GetChip();});
+  vector<string> vecChips;  vecChips.reserve(vecDogs.size());
+  for (vector<const CDog *>::const_iterator it = vecDogs.begin();  it != vecDogs.end();  ++it)
+    vecChips.push_back((*it)->GetChip());
+
+  // Find the pairs (they come back sorted by chip number) and report them ...
+  vector<SIMILAR_CHIPS> vecSimilar;
+  FindSimilarChips(vecChips, vecSimilar);
+  for (vector<SIMILAR_CHIPS>::const_iterator it = vecSimilar.begin();  it != vecSimilar.end();  ++it) {
+    const CDog *pDog1 = vecDogs[it->n1], *pDog2 = vecDogs[it->n2];
+    BADDOGS(pDog1, "microchip " << pDog1->GetChip() << " is similar to microchip " << pDog2->GetChip()
+            << " of " << pDog2->GetName() << " #" << pDog2->GetID() << " (" << it->pszWhy << ")");
+    METRIC(RULE_SIMILAR_CHIP);
+  }
+  return vecSimilar.size();
+}
+
+
+/*static*/ void CDogs::FindSimilarChips (const vector<string> &vecChips, vector<SIMILAR_CHIPS> &vecSimilar)
+{
+  //++
+  //   Find all the pairs of chips in vecChips, which must be sorted and must
+  // contain only ISO chips, that differ by one digit or by two adjacent digits
+  // swapped.  Each pair is returned as the indices of the two chips, lower
+  // one first, and the list is sorted by chip number.
+  //
+  //   Comparing every pair of chips would be O(n^2), so instead we use the
+  // pigeonhole principle.  Split the digits into CHIP_BLOCKS blocks - if two
+  // chips differ in only one digit, then they must be identical in all the
+  // other blocks.  FindOneDigitPairs() does the work for each block.  Swapped
+  // digits are easier still - there are only 14 ways to swap two adjacent
+  // digits, so just try all of them and look up the result in the (sorted)
+  // chip list.  Either way the chips are numbers rather than strings ...
+  //--
+  vecSimilar.clear();
+  vector<uint64_t> vecValues;  vecValues.reserve(vecChips.size());
+  for (vector<string>::const_iterator it = vecChips.begin();  it != vecChips.end();  ++it)
+    vecValues.push_back(PackChip(*it));
+
+  //   Find the chips that differ by one digit.  Note that a pair like that
+  // agrees on exactly CHIP_BLOCKS-1 blocks, so with two blocks every pair is
+  // found exactly once.  That wouldn't be true with more blocks ...
+  for (unsigned nBlock = 0;  nBlock < CHIP_BLOCKS;  ++nBlock)
+    FindOneDigitPairs(vecValues, nBlock, vecSimilar);
+
+  //   Now find the chips with two adjacent digits swapped.  Swapping digit a
+  // in the 10^(k+1) place with digit b in the 10^k place adds (b-a)*9*10^k to
+  // the chip, and we only look for the larger one of each pair ...
+  for (size_t i = 0;  i < vecValues.size();  ++i) {
+    uint64_t nChip = vecValues[i], nPower = 1;
+    for (size_t k = 0;  k < ISO_CHIP_LENGTH-1;  ++k, nPower *= 10) {
+      unsigned a = (unsigned) ((nChip / (nPower*10)) % 10), b = (unsigned) ((nChip / nPower) % 10);
+      if (b <= a) continue;
+      uint64_t nSwapped = nChip + (b-a)*9*nPower;
+      vector<uint64_t>::const_iterator itOther = std::lower_bound(vecValues.begin()+i+1, vecValues.end(), nSwapped);
+      if ((itOther != vecValues.end()) && (*itOther == nSwapped))
+        vecSimilar.push_back({i, (size_t) (itOther - vecValues.begin()), "adjacent digits swapped"});
+    }
+  }
+
+  //   Sort the pairs by chip number.  The chips are sorted already, so that's
+  // the same as sorting by index ...
+  std::sort(vecSimilar.begin(), vecSimilar.end(), [](const SIMILAR_CHIPS &s1, const SIMILAR_CHIPS &s2)
+    {return (s1.n1 != s2.n1) ? (s1.n1 < s2.n1) : (s1.n2 < s2.n2);});
 }
 
 
@@ -658,18 +1052,31 @@ void CDogs::ReadFile (const string &sFileName, uint32_t nYear, bool fNew)
   // data we need to store and process.
   //--
   CCSVFile csv;
+  CTracer::Begin("parse csv", CTracer::PASS);
   size_t nRows = csv.Read(sFileName, fNew ? CDog::m_sNewColumnHeaders : CDog::m_sOldColumnHeaders);
+  CTracer::End("parse csv", CTracer::PASS);
   MSGS("Read " << nRows << " rows from " << sFileName);
   if (csv.size() == 0) return;
-
-  for (CCSVFile::const_iterator it = csv.begin(); it != csv.end(); ++it) {
-    CDog *pDog = new CDog;
-    if (pDog->FromRow(**it, fNew)) {
-      if (pDog->WasAcquiredAfter(nYear)) Add(pDog);
-      //   Note that we don't verify the dog's data here - that's a fool's
-      // errand as the NGRR database is full of junk.  We only verify the dog
-      // data for dogs with microchips that need registering.
-      //pDog->VerifyAll();
+  m_Index.Reserve(DogCount() + csv.size());
+
+  //   The rows are converted to dogs in chunks of CHUNK_ROWS just so that
+  // each chunk shows up separately in the trace timeline ...
+  for (size_t nFirst = 0;  nFirst < csv.size();  nFirst += CHUNK_ROWS) {
+    TRACE_CHUNK("build dogs", nFirst/CHUNK_ROWS);
+    size_t nLast = std::min(csv.size(), nFirst+CHUNK_ROWS);
+    for (size_t i = nFirst;  i < nLast;  ++i) {
+      CDog *pDog = new CDog;
+      if (pDog->FromRow(*csv[i], fNew)) {
+        if (pDog->WasAcquiredAfter(nYear)) {
+          if (Add(pDog)) METRIC(DOGS_KEPT);  else METRIC(DOGS_REJECTED);
+        } else
+          METRIC(DOGS_CUTOFF);
+        //   Note that we don't verify the dog's data here - that's a fool's
+        // errand as the NGRR database is full of junk.  We only verify the dog
+        // data for dogs with microchips that need registering.
+        //pDog->VerifyAll();
+      } else
+        METRIC(DOGS_REJECTED);
     }
   }
   MSGS("CDogs created, " << DogCount() << " dogs, " << ChipCount() << " chips");
@@ -24,6 +24,21 @@
 //
 // REVISION HISTORY:
 //  8-JUL-19  RLA   New file.
+// 17-OCT-26  AGT   ReadFile() works in chunks for the trace timeline.
+// 17-OCT-26  AGT   Make CDiffHarness a friend.
+// 17-OCT-26  AGT   Add FindSimilarChips().
+// 17-OCT-26  AGT   Uncomment GetSurrenderFName() and GetSurrenderLName().
+// 17-OCT-26  AGT   Add VerifyAdoptionAddress().
+// 17-OCT-26  AGT   Add ParseAge().
+// 17-OCT-26  AGT   Make CDogTable a friend.
+// 17-OCT-26  AGT   Add the organization code and 64 bit dog keys.
+// 17-OCT-26  AGT   CDogs uses a CDogIndex instead of an unordered_map.
+// 17-OCT-26  AGT   Lock the organization registry for batch runs.
+// 17-OCT-26  AGT   Split the search out of FindSimilarChips() for CShards.
+// 17-OCT-26  AGT   Allocate CDog objects from a CArena.
+// 17-OCT-26  AGT   One CDog arena per thread.
+// 17-OCT-26  AGT   Parse dog IDs and look up prefixes in place.
+// 17-OCT-26  AGT   FindSimilarChips() works on numbers, and copes with lots.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -31,10 +46,15 @@
 #include <stdint.h>	        // uint8_t, uint32_t, etc ...
 #include <string>               // C++ std::string class, et al ...
 #include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include <vector>               // C++ vector collection ...
 #include <regex>                // regular expression matching ...
+#include <mutex>                // std::mutex, std::lock_guard ...
+#include "DogIndex.hpp"         // CDogIndex (dogs by number) ...
+#include "Arena.hpp"            // fixed size object arenas
 using std::size_t;              // ...
 using std::string;              // ...
 using std::unordered_map;       // ...
+using std::vector;              // ...
 class CCSVRow;                  // ...
 
 
@@ -42,11 +62,14 @@ class CDog {
   //++
   // A single dogs' data ...
   //--
+  friend class CDiffHarness;    // needs access to the raw fields
+  friend class CDogTable;       //   ... and so does this
 
 public:
   enum {
     // Magic number constants ...
-    MAXDOG                              = 99999,// largest possible NGRR dog number
+    MAXDOG                              = 99999,// largest NGRR dog number (partners' can be bigger)
+    NGRR_ORG                            = 0,    // organization code for NGRR dogs
     //   Having constants for the columns in the Dog Information Report used to be a good
     // idea, but now we've gone thru no less than three different iterations of the DIR
     // format.  It's just too complicated to have "old old", "old new" and "new new" 
@@ -100,6 +123,15 @@ public:
       TOTAL_OLD_COLUMNS			= 35,	// number of colums in the old dog data CSV
       TOTAL_NEW_COLUMNS			= 36	//   "    "    "     "  "  new dog  "    "
   };
+  // Age field layouts recognized by ParseAge() ...
+  enum AGE_FORMAT {
+    AGE_INVALID,                        // not any of these!
+    AGE_YEARS_MONTHS,                   // "2 Years 3 Months"
+    AGE_ABBREVIATED,                    // "2 yrs 3 mos"
+    AGE_YEARS,                          // "3 Years"
+    AGE_MONTHS,                         // "6 months"
+    AGE_FRACTION,                       // "2.5 years"
+  };
   // This is the expected header row for the dog information report ...
   static const string m_sOldColumnHeaders;      // Old style headers
   static const string m_sNewColumnHeaders;      // New style headers
@@ -109,13 +141,21 @@ public:
   CDog() {}
   // Destructor ...
   virtual ~CDog() {};
+  // CDog objects are allocated from this thread's m_Arena ...
+  static void *operator new (size_t nBytes) {return m_Arena.Allocate(nBytes);}
+  static void operator delete (void *pDog, size_t nBytes) {m_Arena.Free(pDog, nBytes);}
 
   // CDog public properties ...
 public:
   //   Get this dog's NGRR and/or microchip number.  Note that there are no
   // corresponding set functions for these - since these fields are used as
-  // keys for the CDogs collection, we don't allow them to be changed.
+  // keys for the CDogs collection, we don't allow them to be changed.  The
+  // organization code is zero for NGRR's own dogs (see LookupOrg()).
   uint32_t GetNumber() const {return m_nNumber;}
+  uint32_t GetOrg() const {return m_nOrg;}
+  uint64_t GetKey() const {return MakeKey(m_nOrg, m_nNumber);}
+  // Return the dog ID as it appears in the DIR ("12345" or "ABC-12345") ...
+  string GetID() const;
   string GetChip() const {return m_sMicrochip;}
   bool HasChip() const {return !m_sMicrochip.empty();}
   // Figure out which NGRR person is responsible for this dog ...
@@ -138,8 +178,8 @@ public:
     {return ParseDate(GetDispositionDate(), nDay, nMonth, nYear);}
 //const string GetPrimaryContactFName() const {return m_sPrimaryContactFName;}
 //const string GetPrimaryContactLName() const {return m_sPrimaryContactLName;}
-//const string GetSurrenderFName() const {return m_sSurrenderFName;}
-//const string GetSurrenderLName() const {return m_sSurrenderLName;}
+  const string GetSurrenderFName() const {return m_sSurrenderFName;}
+  const string GetSurrenderLName() const {return m_sSurrenderLName;}
 //const string GetSurrenderAddress() const {return m_sSurrenderAddress;}
 //const string GetSurrenderCity() const {return m_sSurrenderCity;}
 //const string GetSurrenderState() const {return m_sSurrenderState;}
@@ -212,6 +252,9 @@ public:
   // Verify (can't fix!) the adopter or surrender state names ...
   bool VerifyAdoptionState() {return VerifyState(m_sAdoptionState);}
   bool VerifySurrenderState() {return VerifyState(m_sSurrenderState);}
+  // Cross check the adopter's zip code against the state and city ...
+  bool VerifyAdoptionAddress() const
+    {return VerifyAddress(m_sAdoptionCity, m_sAdoptionState, m_sAdoptionZip);}
   // Verify the sex (Male/Female) of a dog ...
   bool VerifySex();
   // Verify the spay/neuter status (Yes/No) of a dog ...
@@ -220,7 +263,20 @@ public:
   bool VerifyAll();
   // Attempt to compute the dog's date of birth ...
   static string FormatDate (uint32_t nDay, uint32_t nMonth, uint32_t nYear);
+  static AGE_FORMAT ParseAge (const string &sAge, uint32_t &nYears, uint32_t &nMonths);
   bool ComputeBirthday (string &sDOB) const;
+  // Make the 64 bit key for an organization and dog number ...
+  static uint64_t MakeKey (uint32_t nOrg, uint32_t nNumber)
+    {return (((uint64_t) nOrg) << 32) | nNumber;}
+  // Parse a dog ID into the organization code and the dog number ...
+  static bool ParseDogID (const char *pszID, size_t nLength, uint32_t &nOrg, uint32_t &nNumber);
+  static bool ParseDogID (const string &sID, uint32_t &nOrg, uint32_t &nNumber)
+    {return ParseDogID(sID.data(), sID.length(), nOrg, nNumber);}
+  // Return the code for an organization prefix, or the prefix for a code ...
+  static uint32_t LookupOrg (const char *pszPrefix, size_t nLength);
+  static uint32_t LookupOrg (const string &sPrefix)
+    {return LookupOrg(sPrefix.data(), sPrefix.length());}
+  static string GetOrgPrefix (uint32_t nOrg);
 
   // Private internal CDog methods ...
 protected:
@@ -237,6 +293,8 @@ protected:
   bool VerifyeMail (string &seMail) const;
   // Verify a USPS two letter state abbreviation ...
   bool VerifyState (string &sState) const;
+  // Cross check a zip code, state and city ...
+  bool VerifyAddress (const string &sCity, const string &sState, const string &sZip) const;
 
 
   // Local CDog members ...
@@ -246,6 +304,7 @@ protected:
   // stored as a string and, depending on the quality of the data, may be valid
   // or may be total garbage...
   uint32_t  m_nNumber;			// COL_DOG_NUMBER
+  uint32_t  m_nOrg;			// organization prefix of the dog number
   string    m_sName;			// COL_DOG_NAME
   string    m_sMicrochip;		// COL_MICROCHIP_NUMBER
   string    m_sAge;			// COL_DOG_AGE
@@ -280,18 +339,25 @@ protected:
   string    m_sAdoptionStatus;		// COL_ADOPTION_STATUS
   string    m_sDispositionDate;		// COL_ADOPTION_OR_DISPOSITION_DATE
   bool      m_fUpdateRequired;          // TRUE if Found.org needs to be updated
+  //   Organization prefixes, indexed by the organization code.  The jobs in a
+  // batch run all share this list, so it has a lock ...
+  static vector<string> m_vecOrgs;
+  static std::mutex     m_mtxOrgs;
+  // All of this thread's CDog objects come from here ...
+  static thread_local CArena m_Arena;
 };
 
 
 class CDogs {
   //++
   //   Collection of CDog objects ...  There are a couple of thins worth knowing
-  // about this collection.  The first is that we actually keep TWO unordered
-  // maps of the CDog objects - one is hased by the NGRR dog number, and the
-  // second is hashed by the microchip number.  All dogs have a unique NGRR
-  // number and are entered in the first map, but not all dogs have a microchip
-  // number recorded.  Only those dogs with a non-blank chip number are contained
-  // in the second map.
+  // about this collection.  The first is that we actually keep TWO indices
+  // of the CDog objects - one is a CDogIndex by the dog's key (organization
+  // and dog number), and the second is hashed by the microchip number.  All
+  // dogs have a unique key and are entered in the first index, but not all
+  // dogs have a microchip number recorded.  Only those dogs with a non-blank
+  // chip number are contained in the second map.  Iterating over the dogs
+  // visits them in ascending key order.
   //
   //   The second important thing to know is that this object will delete all
   // the CDog objects when it is deleted.  The caller creates the CDog object
@@ -300,17 +366,27 @@ class CDogs {
   //--
 
 public:
+  enum {
+    CHUNK_ROWS          = 10000,        // rows per chunk in ReadFile()
+    ISO_CHIP_LENGTH     = 15,           // digits in an ISO (FDXB) microchip
+    CHIP_BLOCKS         = 2,            // pigeonhole blocks for FindSimilarChips()
+    CHIP_HIGH_DIGITS    = 8,            // digits in the first of those blocks
+  };
+  // One pair of similar microchips found by FindSimilarChips() ...
+  struct SIMILAR_CHIPS {
+    size_t      n1, n2;                 // indices of the chips (n1 is the lower)
+    const char *pszWhy;                 // and why they're similar
+  };
   // Define the dog collection hashes ...
-  typedef unordered_map<uint32_t, CDog *> DOG_NUMBER_HASH;
-  typedef DOG_NUMBER_HASH::iterator dog_number_iterator;
-  typedef DOG_NUMBER_HASH::const_iterator dog_number_const_iterator;
+  typedef CDogIndex::iterator dog_number_iterator;
+  typedef CDogIndex::const_iterator dog_number_const_iterator;
   typedef unordered_map<string, CDog *> MICROCHIP_HASH;
   typedef MICROCHIP_HASH::iterator microchip_iterator;
   typedef MICROCHIP_HASH::const_iterator microchip_const_iterator;
 
 public:
   // Constructors ...
-  CDogs()  {m_mapChip.clear();  m_mapNumber.clear();}
+  CDogs()  {m_mapChip.clear();  m_Index.clear();}
   // Copy and assignment constructors ...
   CDogs (const CDogs &dogs) = delete;
   CDogs& operator= (const CDogs &dogs) = delete;
@@ -320,22 +396,20 @@ public:
   // CDogs collection properties ...
 public:
   // Delegate the iterators for NGRR dog numbers and microchips ...
-  dog_number_iterator dog_begin() {return m_mapNumber.begin();}
-  const dog_number_const_iterator dog_begin() const {return m_mapNumber.begin();}
-  dog_number_iterator dog_end() {return m_mapNumber.end();}
-  const dog_number_const_iterator dog_end() const {return m_mapNumber.end();}
+  const dog_number_const_iterator dog_begin() const {return m_Index.begin();}
+  const dog_number_const_iterator dog_end() const {return m_Index.end();}
   microchip_iterator chip_begin() {return m_mapChip.begin();}
   const microchip_const_iterator chip_begin() const {return m_mapChip.begin();}
   microchip_iterator chip_end() {return m_mapChip.end();}
   const microchip_const_iterator chip_end() const {return m_mapChip.end();}
   // Return the number of dogs or dogs with microchips ...
-  size_t DogCount() const {return m_mapNumber.size();}
+  size_t DogCount() const {return m_Index.size();}
   size_t ChipCount() const {return m_mapChip.size();}
   // Delegate array form addressing for dog numbers and microchips ...
-  const CDog* operator[] (uint32_t nDog) const
-    {const CDog *p = Find(nDog);  assert(p != NULL);  return p;}
-  CDog* operator[] (uint32_t nDog) 
-    {CDog *p = Find(nDog);  assert(p != NULL);  return p;}
+  const CDog* operator[] (uint64_t nKey) const
+    {const CDog *p = Find(nKey);  assert(p != NULL);  return p;}
+  CDog* operator[] (uint64_t nKey) 
+    {CDog *p = Find(nKey);  assert(p != NULL);  return p;}
   const CDog* operator[] (string sChip) const
     {const CDog *p = Find(sChip);  assert(p != NULL);  return p;}
   CDog* operator[] (string sChip) 
@@ -348,21 +422,32 @@ public:
   // Add a dog to this collection ...
   bool Add (CDog *pDog);
   bool Add (const CCSVRow &row);
-  // Find dogs by number (integer) or microchip (string) ...
-  CDog *Find (uint32_t nDog) const;
+  //   Find dogs by key (integer) or microchip (string).  Note that the key
+  // for an NGRR dog is just its dog number ...
+  CDog *Find (uint64_t nKey) const {return m_Index.Find(nKey);}
   CDog *Find (string sChip) const;
   // Read or write this collection from/to a CSV file ...
   void ReadFile (const string &sFileName, uint32_t nYear=0, bool fNew=false);
   void WriteFile (const string &sFileName, bool fNew=false) const;
   // Verify that all new dogs have a microchip ...
   void VerifyNewMicrochips(uint32_t nYear=2019) const;
+  // Find (probable) typos in microchip numbers ...
+  size_t FindSimilarChips() const;
+  // Find the similar pairs in a sorted list of ISO microchips ...
+  static void FindSimilarChips (const vector<string> &vecChips, vector<SIMILAR_CHIPS> &vecSimilar);
+  // Return true if this is a 15 digit ISO microchip number ...
+  static bool IsISOChip (const string &sChip);
 
   // Private internal CDogs methods ...
 protected:
+  // Convert an ISO chip to a number ...
+  static uint64_t PackChip (const string &sChip);
+  // Find the chips that differ by one digit in one pigeonhole block ...
+  static void FindOneDigitPairs (const vector<uint64_t> &vecChips, unsigned nBlock, vector<SIMILAR_CHIPS> &vecSimilar);
 
   // Local CDogs members ...
 protected:
-  DOG_NUMBER_HASH m_mapNumber;  // NGRR dog # hash table
+  CDogIndex       m_Index;      // dog key (org and number) index
   MICROCHIP_HASH  m_mapChip;    // microchip number hash table
 };
 
@@ -0,0 +1,223 @@
+//++
+// DogIndex.cpp - implementation of the CDogIndex class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CDogIndex class, which finds CDog objects by
+// their 64 bit (organization, dog number) key.  See DogIndex.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <algorithm>            // std::sort(), std::max() ...
+#include "DogIndex.hpp"         // declarations for this module
+
+// The organization part of a key (i.e. the key of dog number zero) ...
+#define ORG_BASE(k)     ((k) & 0xFFFFFFFF00000000ULL)
+// Fibonacci hashing multiplier (2^64 / golden ratio) ...
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+
+void CDogIndex::clear()
+{
+  //++
+  //   Remove all the keys from the index and go back to an empty direct
+  // table.  Remember that the index doesn't own the dogs, so they're not
+  // deleted!
+  //--
+  m_nLayout = LAYOUT_DENSE;  m_nCount = m_nExpected = 0;
+  m_nBase = m_nMaxKey = 0;  m_fOneOrg = true;  m_fSorted = false;
+  m_vecTable.clear();  m_vecSlots.clear();  m_vecOrder.clear();
+}
+
+
+void CDogIndex::Reserve (size_t nDogs)
+{
+  //++
+  //   Tell the index how many dogs to expect.  This doesn't allocate anything
+  // (we don't know yet which layout we'll need!) but it lets the direct table
+  // cover a bigger range of dog numbers, and if we do switch to a hash table
+  // then it'll be big enough from the start ...
+  //--
+  m_nExpected = std::max(m_nExpected, nDogs);
+}
+
+
+bool CDogIndex::IsDense (uint64_t nBase, uint64_t nMaxKey, size_t nDogs) const
+{
+  //++
+  //   Return true if a direct table for nDogs with keys from nBase thru
+  // nMaxKey is dense enough to be worth it.  The caller has to check that all
+  // the keys have the same organization ...
+  //--
+  uint64_t nSlots = DENSITY * (uint64_t) std::max(nDogs, m_nExpected);
+  return (nMaxKey - nBase) < std::max(nSlots, (uint64_t) MIN_DENSE_SLOTS);
+}
+
+
+size_t CDogIndex::Probe (uint64_t nKey) const
+{
+  //++
+  //   Find the hash table slot that contains nKey, or the empty slot where it
+  // would go.  The table is never more than half full, so this always stops.
+  // The upper half of the Fibonacci hash has the best bits, and it's good
+  // enough to spread out dog numbers that are all multiples of 1000 (say) ...
+  //--
+  assert(!m_vecSlots.empty());
+  size_t nMask = m_vecSlots.size() - 1;
+  size_t i = ((size_t) ((nKey * HASH_MULTIPLIER) >> 32)) & nMask;
+  while ((m_vecSlots[i].second != NULL) && (m_vecSlots[i].first != nKey))  i = (i+1) & nMask;
+  return i;
+}
+
+
+void CDogIndex::Rebuild (LAYOUT nLayout, size_t nSlots)
+{
+  //++
+  //   Convert the index to the given layout, or just make the hash table
+  // bigger if it's already a hash table.  For a hash table, nSlots is the
+  // minimum number of slots (it's rounded up to a power of two) ...
+  //--
+  vector<ENTRY> vecEntries;  vecEntries.reserve(m_nCount);
+  for (size_t i = 0;  i < m_vecTable.size();  ++i)
+    if (m_vecTable[i] != NULL) vecEntries.push_back(ENTRY{m_nBase+i, m_vecTable[i]});
+  for (size_t i = 0;  i < m_vecSlots.size();  ++i)
+    if (m_vecSlots[i].second != NULL) vecEntries.push_back(m_vecSlots[i]);
+  m_vecTable.clear();  m_vecSlots.clear();  m_vecOrder.clear();  m_fSorted = false;
+  m_nLayout = nLayout;
+
+  if (nLayout == LAYOUT_DENSE) {
+    assert(m_fOneOrg);
+    m_vecTable.resize(vecEntries.empty() ? 0 : (size_t) (m_nMaxKey - m_nBase + 1), NULL);
+    for (vector<ENTRY>::const_iterator it = vecEntries.begin();  it != vecEntries.end();  ++it)
+      m_vecTable[(size_t) (it->first - m_nBase)] = it->second;
+  } else {
+    size_t nSize = MIN_HASH_SLOTS;
+    while ((nSize < nSlots) || (nSize < 2*vecEntries.size()))  nSize <<= 1;
+    m_vecSlots.resize(nSize, ENTRY{0, NULL});
+    for (vector<ENTRY>::const_iterator it = vecEntries.begin();  it != vecEntries.end();  ++it)
+      m_vecSlots[Probe(it->first)] = *it;
+  }
+}
+
+
+CDog *CDogIndex::Find (uint64_t nKey) const
+{
+  //++
+  //   Find a dog by key and return a pointer to it, or NULL if there's no
+  // such dog.  For the direct table a key from any other organization wraps
+  // around to a huge subscript, so one comparison covers everything ...
+  //--
+  if (m_nLayout == LAYOUT_DENSE) {
+    uint64_t nSlot = nKey - m_nBase;
+    return (nSlot < m_vecTable.size()) ? m_vecTable[(size_t) nSlot] : NULL;
+  }
+  return m_vecSlots[Probe(nKey)].second;
+}
+
+
+bool CDogIndex::Insert (uint64_t nKey, CDog *pDog)
+{
+  //++
+  //   Add a dog to the index and return true, or return false (and change
+  // nothing) if there's already a dog with the same key.  This is where we
+  // decide whether the direct table is still OK - if the new key is from a
+  // second organization or it would make the table too sparse, then we switch
+  // to a hash table.  And whenever the hash table fills up we check to see if
+  // the keys are dense enough to switch back ...
+  //--
+  assert(pDog != NULL);
+  if (m_nCount == 0) {
+    m_nBase = ORG_BASE(nKey);  m_nMaxKey = nKey;  m_fOneOrg = true;
+    if (m_nLayout == LAYOUT_DENSE) m_vecTable.clear();
+  } else if (ORG_BASE(nKey) != m_nBase)
+    m_fOneOrg = false;
+  uint64_t nMaxKey = std::max(m_nMaxKey, nKey);
+
+  if (m_nLayout == LAYOUT_DENSE) {
+    if (!m_fOneOrg || !IsDense(m_nBase, nMaxKey, m_nCount+1))
+      Rebuild(LAYOUT_HASH, 2*std::max(m_nCount+1, m_nExpected));
+  } else if (2*(m_nCount+1) > m_vecSlots.size()) {
+    bool fDense = m_fOneOrg && IsDense(m_nBase, nMaxKey, m_nCount+1);
+    Rebuild(fDense ? LAYOUT_DENSE : LAYOUT_HASH, 2*m_vecSlots.size());
+  }
+
+  if (m_nLayout == LAYOUT_DENSE) {
+    size_t nSlot = (size_t) (nKey - m_nBase);
+    if (nSlot >= m_vecTable.size())
+      m_vecTable.resize(std::max(nSlot+1, 2*m_vecTable.size()), NULL);
+    if (m_vecTable[nSlot] != NULL) return false;
+    m_vecTable[nSlot] = pDog;
+  } else {
+    ENTRY &slot = m_vecSlots[Probe(nKey)];
+    if (slot.second != NULL) return false;
+    slot.first = nKey;  slot.second = pDog;  m_fSorted = false;
+  }
+  ++m_nCount;  m_nMaxKey = nMaxKey;
+  return true;
+}
+
+
+void CDogIndex::SortHash() const
+{
+  //++
+  // Make a list of the used hash table slots in ascending key order ...
+  //--
+  m_vecOrder.clear();  m_vecOrder.reserve(m_nCount);
+  for (size_t i = 0;  i < m_vecSlots.size();  ++i)
+    if (m_vecSlots[i].second != NULL) m_vecOrder.push_back((uint32_t) i);
+  std::sort(m_vecOrder.begin(), m_vecOrder.end(),
+    [this](uint32_t n1, uint32_t n2) {return m_vecSlots[n1].first < m_vecSlots[n2].first;});
+  m_fSorted = true;
+}
+
+
+size_t CDogIndex::Next (size_t nPosition, ENTRY &entry) const
+{
+  //++
+  //   Find the first entry at or after nPosition (which is a direct table
+  // slot or a subscript in the sorted hash order) and return its position, or
+  // END if there aren't any more ...
+  //--
+  if (m_nLayout == LAYOUT_DENSE) {
+    while ((nPosition < m_vecTable.size()) && (m_vecTable[nPosition] == NULL))  ++nPosition;
+    if (nPosition >= m_vecTable.size()) return END;
+    entry.first = m_nBase + nPosition;  entry.second = m_vecTable[nPosition];
+  } else {
+    if (!m_fSorted) SortHash();
+    if (nPosition >= m_vecOrder.size()) return END;
+    entry = m_vecSlots[m_vecOrder[nPosition]];
+  }
+  return nPosition;
+}
+
+
+CDogIndex::iterator CDogIndex::begin() const
+{
+  //++
+  // Return an iterator for the dog with the smallest key ...
+  //--
+  iterator it;  it.m_pIndex = this;
+  it.m_nPosition = Next(0, it.m_Entry);
+  return it;
+}
@@ -0,0 +1,157 @@
+//++
+// DogIndex.hpp -> index of CDog objects by (organization, dog number) key
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   A dog's key is 64 bits - the organization code in the upper half (zero
+// for NGRR, see CDog::LookupOrg()) and the dog number in the lower half.
+// NGRR dog numbers are small and nearly every one is used, so the best index
+// is just a table of pointers with the dog number as the subscript.  Partner
+// rescues' numbers can be anything, though, and a table for those would be
+// mostly empty.  CDogIndex picks between the two layouts as it's built -
+//
+//   * LAYOUT_DENSE is a direct table.  It's used as long as all the keys
+//     belong to the same organization and the largest dog number is less
+//     than DENSITY times the number of dogs (or MIN_DENSE_SLOTS, whichever is
+//     bigger, so a few dogs with big numbers don't throw us out of it).
+//
+//   * LAYOUT_HASH is a flat, open addressing hash table with linear probing.
+//     Every key lives in one array, so a lookup is usually one cache miss.
+//     If the table has to grow and the keys have become dense enough in the
+//     meantime, it switches back to the direct table.
+//
+// Reserve() tells the index how many dogs to expect, which lets it make the
+// right choice before the first dog is added.
+//
+//   Either way, iterating over the index visits the dogs in ascending key
+// order.  For the direct table that's free, and for the hash table the order
+// is sorted the first time it's needed after a change.  The iterators look
+// just like the std::unordered_map ones that CDogs used to have (it->first is
+// the key and it->second is the CDog), so none of the loops over a CDogs
+// collection had to change.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stddef.h>             // NULL, size_t, etc ...
+#include <vector>               // C++ vector collection ...
+using std::size_t;              // ...
+using std::vector;              // ...
+class CDog;                     // ...
+
+
+class CDogIndex {
+  //++
+  // Direct table or flat hash table of CDog pointers by 64 bit key ...
+  //--
+
+public:
+  enum {
+    DENSITY             = 4,            // largest number/dogs for a direct table
+    MIN_DENSE_SLOTS     = 262144,       // a direct table can always be this big
+    MIN_HASH_SLOTS      = 1024,         // smallest hash table
+  };
+  // Index layouts ...
+  enum LAYOUT {
+    LAYOUT_DENSE,                       // direct table, subscript is the number
+    LAYOUT_HASH,                        // flat open addressing hash table
+  };
+  // One key and its dog (the same members as a std::pair) ...
+  struct ENTRY {
+    uint64_t  first;                    // key
+    CDog     *second;                   // dog (NULL for an empty hash slot)
+  };
+
+  // Iterator (in ascending key order) ...
+  class iterator {
+    friend class CDogIndex;
+  public:
+    iterator() {m_pIndex = NULL;  m_nPosition = END;  m_Entry.first = 0;  m_Entry.second = NULL;}
+    const ENTRY &operator* () const {return m_Entry;}
+    const ENTRY *operator-> () const {return &m_Entry;}
+    iterator &operator++ () {m_nPosition = m_pIndex->Next(m_nPosition+1, m_Entry);  return *this;}
+    bool operator== (const iterator &it) const {return m_nPosition == it.m_nPosition;}
+    bool operator!= (const iterator &it) const {return m_nPosition != it.m_nPosition;}
+  protected:
+    const CDogIndex *m_pIndex;          // index that we're iterating over
+    size_t           m_nPosition;       // table slot or hash order subscript
+    ENTRY            m_Entry;           // the current entry
+  };
+  typedef iterator const_iterator;
+
+public:
+  // Constructor and destructor ...
+  CDogIndex() {clear();}
+  virtual ~CDogIndex() {};
+  // Copy and assignment constructors ...
+  CDogIndex (const CDogIndex &x) = delete;
+  CDogIndex& operator= (const CDogIndex &x) = delete;
+
+  // CDogIndex properties ...
+public:
+  // Return the number of dogs ...
+  size_t size() const {return m_nCount;}
+  bool empty() const {return m_nCount == 0;}
+  // Return the current layout ...
+  LAYOUT GetLayout() const {return m_nLayout;}
+  // Iterators ...
+  iterator begin() const;
+  iterator end() const {iterator it;  it.m_pIndex = this;  return it;}
+
+  // CDogIndex public methods ...
+public:
+  // Remove everything (but don't delete the dogs!) ...
+  void clear();
+  // Expect this many dogs ...
+  void Reserve (size_t nDogs);
+  // Find a dog by key (NULL if it's not here) ...
+  CDog *Find (uint64_t nKey) const;
+  // Add a dog, unless there's already one with this key ...
+  bool Insert (uint64_t nKey, CDog *pDog);
+
+  // Private internal CDogIndex methods ...
+protected:
+  enum {END = SIZE_MAX};                // position of the end() iterator
+  // Return true if a direct table is OK for these keys ...
+  bool IsDense (uint64_t nBase, uint64_t nMaxKey, size_t nDogs) const;
+  // Find the hash slot for a key (either the key or an empty slot) ...
+  size_t Probe (uint64_t nKey) const;
+  // Rebuild in the given layout (with at least nSlots hash slots) ...
+  void Rebuild (LAYOUT nLayout, size_t nSlots=MIN_HASH_SLOTS);
+  // Return the next entry at or after a position ...
+  size_t Next (size_t nPosition, ENTRY &entry) const;
+  // Sort the hash slots by key for iteration ...
+  void SortHash() const;
+
+  // Local CDogIndex members ...
+protected:
+  LAYOUT          m_nLayout;            // LAYOUT_DENSE or LAYOUT_HASH
+  size_t          m_nCount;             // number of dogs
+  size_t          m_nExpected;          // number of dogs we expect (Reserve())
+  uint64_t        m_nBase;              // organization of the first key
+  uint64_t        m_nMaxKey;            // largest key so far
+  bool            m_fOneOrg;            // true if all keys have the same org
+  vector<CDog *>  m_vecTable;           // direct table
+  vector<ENTRY>   m_vecSlots;           // hash table
+  mutable vector<uint32_t> m_vecOrder;  // hash slots in key order
+  mutable bool    m_fSorted;            // true if m_vecOrder is up to date
+};
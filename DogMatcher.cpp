@@ -0,0 +1,212 @@
+//++
+// DogMatcher.cpp - implementation of the CDogMatcher class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CDogMatcher class, which looks for dogs in the
+// new DIR that are probably re-entries of dogs that disappeared from the old
+// one.  See DogMatcher.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Find dogs by their 64 bit key.
+// 17-Oct-26  AGT   Add GetKeys() for CPartitions.
+// 17-Oct-26  AGT   Score() can work on just the FIELDS, for CShards.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <ctype.h>              // isalnum(), tolower() ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <algorithm>            // std::sort() ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "DogMatcher.hpp"       // declarations for this module
+
+
+CDogMatcher::CDogMatcher (const CDogs &NewDogs) : m_NewDogs(NewDogs)
+{
+  //++
+  //   Build the name and surrender indexes for the new DIR.  We don't need to
+  // build a microchip index because CDogs already has one!
+  //--
+  TRACE_SCOPE("index new dogs");
+  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin();  it != NewDogs.dog_end();  ++it) {
+    AddKey(m_mapName, NameKey(it->second), it->second);
+    AddKey(m_mapSurrender, SurrenderKey(it->second), it->second);
+  }
+}
+
+
+/*static*/ string CDogMatcher::Normalize (const string &str)
+{
+  //++
+  //   Normalize a name by converting it to lower case and throwing away
+  // everything that isn't a letter or a digit.  That takes care of the usual
+  // differences in spacing, punctuation and capitalization ("Mac-Duff" vs
+  // "macduff ") ...
+  //--
+  string sResult;
+  for (string::const_iterator it = str.begin();  it != str.end();  ++it)
+    if (isalnum((unsigned char) *it)) sResult.push_back((char) ::tolower((unsigned char) *it));
+  return sResult;
+}
+
+
+/*static*/ string CDogMatcher::NameKey (const FIELDS &Fields)
+{
+  //++
+  //   Return the name index key, which is the normalized name plus the date
+  // acquired.  If either one is missing then the dog isn't indexed - there are
+  // way too many "Buddy"s to index by name alone!
+  //--
+  if (Fields.sName.empty() || Fields.sDate.empty() || (Fields.sDate == "0000-00-00")) return string("");
+  return Fields.sName + "|" + Fields.sDate;
+}
+
+
+/*static*/ string CDogMatcher::SurrenderKey (const CDog *pDog)
+{
+  //++
+  //   Return the surrender index key, which is the normalized last name and
+  // first name of the surrendering party.  We need both of them!
+  //--
+  string sFirst = Normalize(pDog->GetSurrenderFName());
+  string sLast = Normalize(pDog->GetSurrenderLName());
+  if (sFirst.empty() || sLast.empty()) return string("");
+  return sLast + "|" + sFirst;
+}
+
+
+/*static*/ void CDogMatcher::GetKeys (const CDog *pDog, vector<string> &vecKeys)
+{
+  //++
+  //   Return every key that FindMatches() would look up for this dog - the
+  // microchip plus the name and surrender keys - each tagged with the index
+  // it belongs to.  A new dog can only be a candidate for a missing dog if
+  // they have at least one of these in common.  CPartitions uses that to keep
+  // just the new dogs that matter ...
+  //--
+  vecKeys.clear();
+  if (pDog->HasChip()) vecKeys.push_back("c:" + pDog->GetChip());
+  string sKey = NameKey(pDog);
+  if (!sKey.empty()) vecKeys.push_back("n:" + sKey);
+  sKey = SurrenderKey(pDog);
+  if (!sKey.empty()) vecKeys.push_back("s:" + sKey);
+}
+
+
+/*static*/ CDogMatcher::FIELDS CDogMatcher::GetFields (const CDog *pDog)
+{
+  //++
+  //   Collect the fields that Score() compares, already normalized.  That's
+  // all CShards keeps for each dog ...
+  //--
+  FIELDS Fields;
+  Fields.sChip = pDog->GetChip();
+  Fields.sName = Normalize(pDog->GetName());
+  Fields.sDate = pDog->GetDateAcquired();
+  Fields.sSurrender = SurrenderKey(pDog);
+  return Fields;
+}
+
+
+/*static*/ uint32_t CDogMatcher::Score (const FIELDS &Fields1, const FIELDS &Fields2)
+{
+  //++
+  //   Score a possible match by adding up the points for all the fields that
+  // agree.  Blank fields never agree with anything ...
+  //--
+  uint32_t nScore = 0;
+  if (!Fields1.sChip.empty() && (Fields1.sChip == Fields2.sChip))
+    nScore += SCORE_CHIP;
+  if (!Fields1.sName.empty() && (Fields1.sName == Fields2.sName))
+    nScore += SCORE_NAME;
+  if (!Fields1.sDate.empty() && (Fields1.sDate != "0000-00-00") && (Fields1.sDate == Fields2.sDate))
+    nScore += SCORE_DATE;
+  if (!Fields1.sSurrender.empty() && (Fields1.sSurrender == Fields2.sSurrender))
+    nScore += SCORE_SURRENDER;
+  return nScore;
+}
+
+
+CDogMatcher::MATCH_VECTOR CDogMatcher::FindMatches (const CDog *pDog, const CDogs *pExclude) const
+{
+  //++
+  //   Collect all the new dogs that share a key with this one, score each one,
+  // and return the best MAX_MATCHES of them that score at least MIN_SCORE ...
+  //--
+  vector<const CDog *> vecCandidates;
+  const CDog *pChip = pDog->GetChip().empty() ? NULL : m_NewDogs.Find(pDog->GetChip());
+  if (pChip != NULL) vecCandidates.push_back(pChip);
+  string sKey = NameKey(pDog);
+  BLOCK_INDEX::const_iterator it = sKey.empty() ? m_mapName.end() : m_mapName.find(sKey);
+  if (it != m_mapName.end())
+    vecCandidates.insert(vecCandidates.end(), it->second.begin(), it->second.end());
+  sKey = SurrenderKey(pDog);
+  it = sKey.empty() ? m_mapSurrender.end() : m_mapSurrender.find(sKey);
+  if (it != m_mapSurrender.end())
+    vecCandidates.insert(vecCandidates.end(), it->second.begin(), it->second.end());
+
+  // The same dog might be in more than one block, so remove the duplicates ...
+  std::sort(vecCandidates.begin(), vecCandidates.end());
+  vecCandidates.erase(std::unique(vecCandidates.begin(), vecCandidates.end()), vecCandidates.end());
+
+  // Score them all ...
+  MATCH_VECTOR vecMatches;
+  for (vector<const CDog *>::const_iterator itc = vecCandidates.begin();  itc != vecCandidates.end();  ++itc) {
+    if (*itc == pDog) continue;
+    if ((pExclude != NULL) && (pExclude->Find((*itc)->GetKey()) != NULL)) continue;
+    uint32_t nScore = Score(pDog, *itc);
+    if (nScore >= MIN_SCORE) vecMatches.push_back({*itc, nScore});
+  }
+
+  // Best first (and lowest dog number first for a tie) ...
+  std::sort(vecMatches.begin(), vecMatches.end(), [](const MATCH &m1, const MATCH &m2)
+    {return (m1.nScore != m2.nScore) ? (m1.nScore > m2.nScore) : (m1.pDog->GetKey() < m2.pDog->GetKey());});
+  if (vecMatches.size() > MAX_MATCHES) vecMatches.resize(MAX_MATCHES);
+  return vecMatches;
+}
+
+
+size_t CDogMatcher::ReportMissingDogs (const CDogs &OldDogs) const
+{
+  //++
+  //   Look for all the dogs in the old DIR that aren't in the new one, and
+  // report any likely re-entries as bad dogs.  Dogs that are in both DIRs
+  // can't be re-entries, so they're excluded.  Returns the number of missing
+  // dogs that had at least one match ...
+  //--
+  TRACE_SCOPE("re-entered dogs");
+  size_t nFound = 0;
+  for (CDogs::dog_number_const_iterator it = OldDogs.dog_begin();  it != OldDogs.dog_end();  ++it) {
+    const CDog *pOldDog = it->second;
+    if (m_NewDogs.Find(pOldDog->GetKey()) != NULL) continue;
+    MATCH_VECTOR vecMatches = FindMatches(pOldDog, &OldDogs);
+    if (vecMatches.empty()) continue;
+    ++nFound;  METRIC(RULE_REENTERED);
+    for (MATCH_VECTOR::const_iterator itm = vecMatches.begin();  itm != vecMatches.end();  ++itm)
+      BADDOGS(pOldDog, "may have been re-entered as " << itm->pDog->GetName() << " #" << itm->pDog->GetID()
+              << " (score " << itm->nScore << ")");
+  }
+  return nFound;
+}
@@ -0,0 +1,124 @@
+//++
+// DogMatcher.hpp -> find dogs that were re-entered under a new number
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   Dogs "disappear" from the DIR more often than you'd think, and a lot of
+// the time it's because somebody deleted the record and entered the dog again
+// under a new NGRR number.  The CDogMatcher class tries to find the new record
+// for a dog that vanished.
+//
+//   Comparing every missing dog with every new dog would be way too slow, so
+// the constructor builds three "blocking" indexes on the new DIR - by microchip
+// number, by normalized name plus acquisition date, and by normalized surrender
+// name.  Only the dogs that share at least one key with the missing dog are
+// scored, and the score is just a weighted sum of the fields that agree.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add GetKeys() for CPartitions.
+// 17-OCT-26  AGT   Score() can work on just the FIELDS, for CShards.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include "Dog.hpp"              // CDog data and CDogs collection
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::unordered_map;       // ...
+
+
+class CDogMatcher {
+  //++
+  // Find likely re-entries of dogs in a new DIR ...
+  //--
+
+public:
+  enum {
+    // Points for each field that agrees (100 is a sure thing) ...
+    SCORE_CHIP          = 50,           // same microchip number
+    SCORE_NAME          = 20,           // same (normalized) dog name
+    SCORE_DATE          = 15,           // same acquisition date
+    SCORE_SURRENDER     = 15,           // same (normalized) surrendering party
+    MIN_SCORE           = 35,           // ignore anything less than this
+    MAX_MATCHES         = 3,            // maximum matches reported per dog
+  };
+  // One possible re-entry of a dog ...
+  struct MATCH {
+    const CDog *pDog;                   // the dog in the new DIR
+    uint32_t    nScore;                 // and how good a match it is
+  };
+  typedef vector<MATCH> MATCH_VECTOR;
+  //   The fields that Score() compares, for callers (e.g. CShards) that can't
+  // keep the whole CDog around ...
+  struct FIELDS {
+    string      sChip;                  // microchip number
+    string      sName;                  // normalized dog name
+    string      sDate;                  // acquisition date
+    string      sSurrender;             // surrender key (see SurrenderKey())
+  };
+  // The blocking indexes ...
+  typedef unordered_map<string, vector<const CDog *> > BLOCK_INDEX;
+
+public:
+  // Constructor and destructor ...
+  CDogMatcher (const CDogs &NewDogs);
+  virtual ~CDogMatcher() {};
+  // Copy and assignment constructors ...
+  CDogMatcher (const CDogMatcher &m) = delete;
+  CDogMatcher& operator= (const CDogMatcher &m) = delete;
+
+  // CDogMatcher public methods ...
+public:
+  //   Return the likely re-entries for one dog, best first, ignoring any that
+  // are also in pExclude (e.g. the old DIR - those can't be re-entries!) ...
+  MATCH_VECTOR FindMatches (const CDog *pDog, const CDogs *pExclude=NULL) const;
+  // Score how well two dogs match ...
+  static uint32_t Score (const CDog *pDog1, const CDog *pDog2)
+    {return Score(GetFields(pDog1), GetFields(pDog2));}
+  static uint32_t Score (const FIELDS &Fields1, const FIELDS &Fields2);
+  // Return the fields that Score() compares, and the name key for them ...
+  static FIELDS GetFields (const CDog *pDog);
+  static string NameKey (const FIELDS &Fields);
+  // Report the likely re-entries for every dog that disappeared ...
+  size_t ReportMissingDogs (const CDogs &OldDogs) const;
+  // Normalize a name for matching (lower case letters and digits only) ...
+  static string Normalize (const string &str);
+  // Return all the blocking keys for a dog, in any order ...
+  static void GetKeys (const CDog *pDog, vector<string> &vecKeys);
+
+  // Private internal CDogMatcher methods ...
+protected:
+  // Return the keys for each index (or an empty string for none) ...
+  static string NameKey (const CDog *pDog) {return NameKey(GetFields(pDog));}
+  static string SurrenderKey (const CDog *pDog);
+  // Add a dog to one index ...
+  static void AddKey (BLOCK_INDEX &map, const string &sKey, const CDog *pDog)
+    {if (!sKey.empty()) map[sKey].push_back(pDog);}
+
+  // Local CDogMatcher members ...
+protected:
+  const CDogs    &m_NewDogs;            // the new DIR (also the chip index!)
+  BLOCK_INDEX     m_mapName;            // name + acquisition date index
+  BLOCK_INDEX     m_mapSurrender;       // surrender name index
+};
@@ -0,0 +1,260 @@
+//++
+// DogTable.cpp - implementation of the CDogTable class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CDogTable class, a column store view of a CDogs
+// collection.  See DogTable.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <algorithm>            // std::min() ...
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define USE_SSE2
+#include <emmintrin.h>          // _mm_cmpeq_epi16(), _mm_movemask_epi8() ...
+#endif
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "DogTable.hpp"         // declarations for this module
+
+//   The status code for a status that isn't in the dictionary.  It's never
+// assigned to a row, so a filter containing it never matches anything ...
+#define NOSTATUS  0xFFFF
+
+
+uint32_t CDogTable::DICTIONARY::Encode (const string &sValue)
+{
+  //++
+  // Return the code for this value, adding it to the dictionary if it's new ...
+  //--
+  unordered_map<string, uint32_t>::const_iterator it = mapCodes.find(sValue);
+  if (it != mapCodes.end()) return it->second;
+  uint32_t nCode = (uint32_t) vecValues.size();
+  vecValues.push_back(sValue);  mapCodes[sValue] = nCode;
+  return nCode;
+}
+
+
+/*static*/ uint32_t CDogTable::PackDate (const string &sDate)
+{
+  //++
+  //   Convert a date to a single number, YYYYMMDD, that sorts (and compares)
+  // the right way.  Blank or bogus dates are zero ...
+  //--
+  uint32_t nDay, nMonth, nYear;
+  if (sDate.empty() || !CDog::ParseDate(sDate, nDay, nMonth, nYear)) return 0;
+  return nYear*10000 + nMonth*100 + nDay;
+}
+
+
+/*static*/ uint8_t CDogTable::GetFlags (const CDog *pDog)
+{
+  //++
+  // Compute the FLAG_xyz bits for one dog ...
+  //--
+  uint8_t bFlags = 0;
+  if (pDog->IsDead()) bFlags |= FLAG_DEAD;
+  if (pDog->IsReturned()) bFlags |= FLAG_RETURNED;
+  if (pDog->IsAdopted()) bFlags |= FLAG_ADOPTED;
+  if (pDog->HasChip()) bFlags |= FLAG_CHIP;
+  //   Don't know why, but a lot of dogs have a disposition date that looks
+  // like "0000-00-00" - that doesn't count ...
+  if (!pDog->m_sDispositionDate.empty() && (pDog->m_sDispositionDate != "0000-00-00"))
+    bFlags |= FLAG_DISPOSITION;
+  return bFlags;
+}
+
+
+void CDogTable::Build (const CDogs &Dogs)
+{
+  //++
+  //   Fill in all the columns, one row per dog, in the same order as the
+  // CDogs hash table iterates ...
+  //--
+  TRACE_SCOPE("dog table");
+  size_t nDogs = Dogs.DogCount();
+  m_vecDog.reserve(nDogs);  m_vecNumber.reserve(nDogs);  m_vecStatus.reserve(nDogs);
+  m_vecFlags.reserve(nDogs);  m_vecAcquired.reserve(nDogs);  m_vecDisposition.reserve(nDogs);
+  for (unsigned i = 0;  i < STRING_COLUMNS;  ++i) m_aColumns[i].vecCodes.reserve(nDogs);
+
+  for (CDogs::dog_number_const_iterator it = Dogs.dog_begin();  it != Dogs.dog_end();  ++it) {
+    CDog *pDog = it->second;
+    m_vecDog.push_back(pDog);
+    m_vecNumber.push_back(pDog->GetNumber());
+    unordered_map<string, uint32_t>::const_iterator itStatus = m_mapStatus.find(pDog->m_sStatus);
+    if (itStatus == m_mapStatus.end()) {
+      if (m_vecStatusValues.size() >= NOSTATUS)
+        ERRS("CDogTable::Build() too many different dog statuses");
+      itStatus = m_mapStatus.insert({pDog->m_sStatus, (uint32_t) m_vecStatusValues.size()}).first;
+      m_vecStatusValues.push_back(pDog->m_sStatus);
+    }
+    m_vecStatus.push_back((uint16_t) itStatus->second);
+    m_vecFlags.push_back(GetFlags(pDog));
+    m_vecAcquired.push_back(PackDate(pDog->m_sDateAcquired));
+    m_vecDisposition.push_back(PackDate(pDog->m_sDispositionDate));
+    m_aColumns[COL_SEX].vecCodes.push_back(m_aColumns[COL_SEX].Encode(pDog->m_sSex));
+    m_aColumns[COL_AREA].vecCodes.push_back(m_aColumns[COL_AREA].Encode(pDog->m_sOriginatingArea));
+    m_aColumns[COL_LOCATION].vecCodes.push_back(m_aColumns[COL_LOCATION].Encode(pDog->m_sLocation));
+    m_aColumns[COL_HOW_ACQUIRED].vecCodes.push_back(m_aColumns[COL_HOW_ACQUIRED].Encode(pDog->m_sHowAcquired));
+    m_aColumns[COL_ADOPTION_CITY].vecCodes.push_back(m_aColumns[COL_ADOPTION_CITY].Encode(pDog->m_sAdoptionCity));
+    m_aColumns[COL_ADOPTION_STATE].vecCodes.push_back(m_aColumns[COL_ADOPTION_STATE].Encode(pDog->m_sAdoptionState));
+  }
+}
+
+
+bool CDogTable::AddStatus (FILTER &filter, const string &sStatus) const
+{
+  //++
+  //   Add a status to a filter.  If no dog has this status, then it gets a
+  // code that no row has, which is just what we want (e.g. "status is not X"
+  // is true for every dog).  Returns false if the filter is full ...
+  //--
+  if (filter.nStatus >= MAXSTATUS) return false;
+  uint32_t nCode = GetStatusCode(sStatus);
+  filter.anStatus[filter.nStatus++] = (nCode == NOCODE) ? NOSTATUS : (uint16_t) nCode;
+  return true;
+}
+
+
+bool CDogTable::Match (const FILTER &filter, uint32_t nRow) const
+{
+  //++
+  //   Return true if this row matches the filter.  This is the reference
+  // version of Select(), and it's also used for the last few rows that don't
+  // fill a whole block ...
+  //--
+  if ((m_vecFlags[nRow] & filter.nMask) != filter.nFlags) return false;
+  if ((m_vecAcquired[nRow] < filter.nFirstAcquired) || (m_vecAcquired[nRow] > filter.nLastAcquired)) return false;
+  if (filter.nStatus == 0) return true;
+  bool fFound = false;
+  for (uint32_t i = 0;  (i < filter.nStatus) && !fFound;  ++i)
+    fFound = (m_vecStatus[nRow] == filter.anStatus[i]);
+  return fFound != filter.fNot;
+}
+
+
+size_t CDogTable::Select (const FILTER &filter, SELECTION &sel) const
+{
+  //++
+  //   Select all the rows that match the filter and return the number found.
+  // With SSE2 each block of BLOCK_ROWS rows is done all at once - the flag
+  // bytes are masked and compared sixteen at a time, the status codes eight
+  // at a time, and the dates four at a time, and each test is squeezed down
+  // to one bit per row with movemask.  AND those together and the one bits
+  // are the matching rows (and if a block runs out of ones early, the rest
+  // of the tests are skipped) ...
+  //--
+  sel.clear();
+  uint32_t nRows = (uint32_t) size(), nRow = 0;
+#ifdef USE_SSE2
+  const __m128i vMask = _mm_set1_epi8((char) filter.nMask);
+  const __m128i vFlags = _mm_set1_epi8((char) filter.nFlags);
+  //   The dates are all less than 2^31, so the signed compare is fine as long
+  // as the limits are clamped to that too ...
+  bool fDates = (filter.nFirstAcquired > 0) || (filter.nLastAcquired < INT32_MAX);
+  const __m128i vFirst = _mm_set1_epi32((int32_t) std::min(filter.nFirstAcquired, (uint32_t) INT32_MAX));
+  const __m128i vLast = _mm_set1_epi32((int32_t) std::min(filter.nLastAcquired, (uint32_t) INT32_MAX));
+  __m128i avStatus[MAXSTATUS];
+  for (uint32_t i = 0;  i < filter.nStatus;  ++i) avStatus[i] = _mm_set1_epi16((short) filter.anStatus[i]);
+
+  for (;  nRow+BLOCK_ROWS <= nRows;  nRow += BLOCK_ROWS) {
+    // Flags first ...
+    __m128i v = _mm_loadu_si128((const __m128i *) &m_vecFlags[nRow]);
+    uint32_t nBits = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, vMask), vFlags));
+    // Then the status codes ...
+    if ((filter.nStatus > 0) && (nBits != 0)) {
+      __m128i v0 = _mm_loadu_si128((const __m128i *) &m_vecStatus[nRow]);
+      __m128i v1 = _mm_loadu_si128((const __m128i *) &m_vecStatus[nRow+8]);
+      __m128i vHit0 = _mm_setzero_si128(), vHit1 = _mm_setzero_si128();
+      for (uint32_t i = 0;  i < filter.nStatus;  ++i) {
+        vHit0 = _mm_or_si128(vHit0, _mm_cmpeq_epi16(v0, avStatus[i]));
+        vHit1 = _mm_or_si128(vHit1, _mm_cmpeq_epi16(v1, avStatus[i]));
+      }
+      uint32_t nStatus = (uint32_t) _mm_movemask_epi8(_mm_packs_epi16(vHit0, vHit1));
+      nBits &= filter.fNot ? ~nStatus : nStatus;
+    }
+    // And the date acquired ...
+    if (fDates && (nBits != 0)) {
+      __m128i avOut[4];
+      for (uint32_t i = 0;  i < 4;  ++i) {
+        __m128i vDate = _mm_loadu_si128((const __m128i *) &m_vecAcquired[nRow+i*4]);
+        avOut[i] = _mm_or_si128(_mm_cmpgt_epi32(vFirst, vDate), _mm_cmpgt_epi32(vDate, vLast));
+      }
+      __m128i vOut = _mm_packs_epi16(_mm_packs_epi32(avOut[0], avOut[1]), _mm_packs_epi32(avOut[2], avOut[3]));
+      nBits &= ~(uint32_t) _mm_movemask_epi8(vOut);
+    }
+    // Whatever's left are the matches ...
+    nBits &= 0xFFFF;
+    for (uint32_t i = 0;  nBits != 0;  ++i, nBits >>= 1)
+      if ((nBits & 1) != 0) sel.push_back(nRow+i);
+  }
+#endif
+  for (;  nRow < nRows;  ++nRow)
+    if (Match(filter, nRow)) sel.push_back(nRow);
+  return sel.size();
+}
+
+
+size_t CDogTable::SelectString (STRING_COLUMN nColumn, const string &sValue, SELECTION &sel) const
+{
+  //++
+  //   Select all the rows where a dictionary encoded column is equal to this
+  // value.  Once the value is turned into a code this is just a search for a
+  // 32 bit number, four at a time with SSE2 ...
+  //--
+  sel.clear();
+  uint32_t nCode = GetStringCode(nColumn, sValue);
+  if (nCode == NOCODE) return 0;
+  const vector<uint32_t> &vecCodes = m_aColumns[nColumn].vecCodes;
+  uint32_t nRows = (uint32_t) vecCodes.size(), nRow = 0;
+#ifdef USE_SSE2
+  const __m128i vCode = _mm_set1_epi32((int32_t) nCode);
+  for (;  nRow+4 <= nRows;  nRow += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *) &vecCodes[nRow]);
+    uint32_t nBits = (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, vCode)));
+    for (uint32_t i = 0;  nBits != 0;  ++i, nBits >>= 1)
+      if ((nBits & 1) != 0) sel.push_back(nRow+i);
+  }
+#endif
+  for (;  nRow < nRows;  ++nRow)
+    if (vecCodes[nRow] == nCode) sel.push_back(nRow);
+  return sel.size();
+}
+
+
+/*static*/ void CDogTable::Intersect (SELECTION &sel, const SELECTION &sel2)
+{
+  //++
+  // Keep only the rows that are in both selections (both are sorted) ...
+  //--
+  size_t nOut = 0;
+  SELECTION::const_iterator it2 = sel2.begin();
+  for (SELECTION::const_iterator it = sel.begin();  it != sel.end();  ++it) {
+    while ((it2 != sel2.end()) && (*it2 < *it)) ++it2;
+    if (it2 == sel2.end()) break;
+    if (*it2 == *it) sel[nOut++] = *it;
+  }
+  sel.resize(nOut);
+}
@@ -0,0 +1,178 @@
+//++
+// DogTable.hpp -> column store view of a CDogs collection
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   A CDogs collection is a hash table of pointers to CDog objects, each one
+// with 34 strings in it.  That's fine for looking up one dog, but the rules in
+// CompareDogs() look at one or two fields of every dog, and chasing all those
+// pointers and comparing all those strings is slow.  A CDogTable is a column
+// store snapshot of a CDogs collection - the dog number, a status code, some
+// flag bits and the dates are each kept in their own contiguous array, and a
+// few other string fields are dictionary encoded (each distinct value gets a
+// number, and the column is an array of those numbers).
+//
+//   The filters work a block of rows at a time using SSE2 (when we have it)
+// and produce a SELECTION, which is just a list of the matching row numbers
+// in ascending order.  The rows are in the same order as the CDogs hash table
+// iteration, so a loop over a selection visits the dogs in exactly the same
+// order that a loop over the CDogs collection would have.
+//
+//   The table is a snapshot - if the dogs change (other than the update
+// required flag, which isn't in here) it has to be built again.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <unordered_map>        // C++ std::unordered_map (aka hash table)
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::unordered_map;       // ...
+class CDog;                     // ...
+class CDogs;                    // ...
+
+
+class CDogTable {
+  //++
+  // Column store snapshot of a CDogs collection ...
+  //--
+
+public:
+  enum {
+    BLOCK_ROWS          = 16,           // rows tested at a time by Select()
+    MAXSTATUS           = 8,            // most status codes in one FILTER
+    NOCODE              = 0xFFFFFFFF,   // string isn't in the dictionary
+  };
+  //   Flag bits, one byte per dog.  These are exactly the CDog tests that
+  // CompareDogs() uses, computed once ...
+  enum {
+    FLAG_DEAD           = 0x01,         // IsDead()
+    FLAG_RETURNED       = 0x02,         // IsReturned()
+    FLAG_ADOPTED        = 0x04,         // IsAdopted() (an adopter is recorded)
+    FLAG_CHIP           = 0x08,         // HasChip()
+    FLAG_DISPOSITION    = 0x10,         // a real disposition date is recorded
+  };
+  // Dictionary encoded string columns ...
+  enum STRING_COLUMN {
+    COL_SEX,                            // Male/Female
+    COL_AREA,                           // originating NGRR area
+    COL_LOCATION,                       // city where the dog is
+    COL_HOW_ACQUIRED,                   // Surrender/Shelter/etc
+    COL_ADOPTION_CITY,                  // adopter's city
+    COL_ADOPTION_STATE,                 // adopter's state
+    STRING_COLUMNS                      // number of string columns
+  };
+  // A list of row numbers, in ascending order ...
+  typedef vector<uint32_t> SELECTION;
+
+  //   A filter for Select().  A row matches if its status is (or, if fNot is
+  // set, is not) one of the codes, AND its flags masked with nMask equal
+  // nFlags, AND the date acquired is between nFirstAcquired and nLastAcquired
+  // (inclusive).  The constructor makes a filter that matches everything ...
+  struct FILTER {
+    uint32_t  nStatus;                  // number of status codes (zero for any)
+    uint16_t  anStatus[MAXSTATUS];      // the status codes
+    bool      fNot;                     // true to match status NOT in the list
+    uint8_t   nMask;                    // flag bits that we care about
+    uint8_t   nFlags;                   // and what they have to be
+    uint32_t  nFirstAcquired;           // earliest date acquired (YYYYMMDD)
+    uint32_t  nLastAcquired;            // latest     "     "        "
+    FILTER() {nStatus = 0;  fNot = false;  nMask = nFlags = 0;  nFirstAcquired = 0;  nLastAcquired = UINT32_MAX;}
+  };
+
+public:
+  // Constructor and destructor ...
+  CDogTable (const CDogs &Dogs) {Build(Dogs);}
+  virtual ~CDogTable() {};
+  // Copy and assignment constructors ...
+  CDogTable (const CDogTable &t) = delete;
+  CDogTable& operator= (const CDogTable &t) = delete;
+
+  // CDogTable properties ...
+public:
+  // Return the number of rows (dogs) ...
+  size_t size() const {return m_vecNumber.size();}
+  // Return the columns for one row ...
+  CDog *GetDog (uint32_t nRow) const {return m_vecDog[nRow];}
+  uint32_t GetNumber (uint32_t nRow) const {return m_vecNumber[nRow];}
+  uint16_t GetStatus (uint32_t nRow) const {return m_vecStatus[nRow];}
+  uint8_t GetFlags (uint32_t nRow) const {return m_vecFlags[nRow];}
+  uint32_t GetDateAcquired (uint32_t nRow) const {return m_vecAcquired[nRow];}
+  uint32_t GetDispositionDate (uint32_t nRow) const {return m_vecDisposition[nRow];}
+  const string &GetString (STRING_COLUMN nColumn, uint32_t nRow) const
+    {return m_aColumns[nColumn].vecValues[m_aColumns[nColumn].vecCodes[nRow]];}
+  // Return the code for a status or string value (or NOCODE) ...
+  uint32_t GetStatusCode (const string &sStatus) const {return Lookup(m_mapStatus, sStatus);}
+  uint32_t GetStringCode (STRING_COLUMN nColumn, const string &sValue) const
+    {return Lookup(m_aColumns[nColumn].mapCodes, sValue);}
+  // Return the number of distinct values in a column ...
+  size_t GetStatusCount() const {return m_vecStatusValues.size();}
+  size_t GetStringCount (STRING_COLUMN nColumn) const {return m_aColumns[nColumn].vecValues.size();}
+
+  // CDogTable public methods ...
+public:
+  // Add a status (by name) to a filter ...
+  bool AddStatus (FILTER &filter, const string &sStatus) const;
+  // Select the rows that match a filter ...
+  size_t Select (const FILTER &filter, SELECTION &sel) const;
+  // Select the rows where a string column has this value ...
+  size_t SelectString (STRING_COLUMN nColumn, const string &sValue, SELECTION &sel) const;
+  // Keep only the rows that are in both selections ...
+  static void Intersect (SELECTION &sel, const SELECTION &sel2);
+  // Pack a date into YYYYMMDD form (zero if it's not a valid date) ...
+  static uint32_t PackDate (const string &sDate);
+
+  // Private internal CDogTable methods ...
+protected:
+  // Fill in all the columns from a CDogs collection ...
+  void Build (const CDogs &Dogs);
+  // Look up a dictionary code ...
+  static uint32_t Lookup (const unordered_map<string, uint32_t> &map, const string &sValue)
+    {unordered_map<string, uint32_t>::const_iterator it = map.find(sValue);  return (it == map.end()) ? NOCODE : it->second;}
+  // Return the flag bits for a dog ...
+  static uint8_t GetFlags (const CDog *pDog);
+  // Test one row against a filter (the scalar version of Select()) ...
+  bool Match (const FILTER &filter, uint32_t nRow) const;
+
+  // One dictionary encoded column ...
+  struct DICTIONARY {
+    vector<uint32_t>  vecCodes;                 // one code per row
+    vector<string>    vecValues;                // the value for each code
+    unordered_map<string, uint32_t> mapCodes;   // and the code for each value
+    uint32_t Encode (const string &sValue);
+  };
+
+  // Local CDogTable members ...
+protected:
+  vector<CDog *>    m_vecDog;           // the dog for each row
+  vector<uint32_t>  m_vecNumber;        // NGRR dog number
+  vector<uint16_t>  m_vecStatus;        // status code
+  vector<uint8_t>   m_vecFlags;         // FLAG_xyz bits
+  vector<uint32_t>  m_vecAcquired;      // date acquired (YYYYMMDD)
+  vector<uint32_t>  m_vecDisposition;   // disposition date (YYYYMMDD)
+  vector<string>    m_vecStatusValues;  // status string for each code
+  unordered_map<string, uint32_t> m_mapStatus;  // and the code for each status
+  DICTIONARY        m_aColumns[STRING_COLUMNS]; // dictionary encoded strings
+};
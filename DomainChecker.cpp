@@ -0,0 +1,327 @@
+//++
+// DomainChecker.cpp - implementation of the CDomainChecker class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CDomainChecker class, which looks for misspelled
+// email domains.  See DomainChecker.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Split Learn() out of Add().
+// 17-Oct-26  AGT   Use a real metric for the BK-tree, and don't let the
+//                  built in domains block other top level domains.
+// 17-Oct-26  AGT   Add WriteCounts() and ReadCounts() for CShards.
+// 17-Oct-26  AGT   Suggest() doesn't flag other top level domains either.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <ctype.h>              // isspace(), tolower() ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <algorithm>            // std::min(), std::sort() ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "DomainChecker.hpp"    // declarations for this module
+
+//   The email domains that most of our adopters use.  These are always known
+// to be good, no matter what's in the old DIR ...
+static const char *const g_apszCommonDomains[] = {
+  "gmail.com",    "yahoo.com",      "hotmail.com",    "outlook.com",  "aol.com",
+  "icloud.com",   "me.com",         "mac.com",        "msn.com",      "live.com",
+  "comcast.net",  "sbcglobal.net",  "att.net",        "verizon.net",  "earthlink.net",
+  "cox.net",      "charter.net",    "pacbell.net",    "ymail.com",    "rocketmail.com",
+  "mail.com",     "gmx.com",        "protonmail.com", "proton.me",    "juno.com",
+  NULL
+};
+
+// The header row for a file of domain counts ...
+const string CDomainChecker::m_sColumnHeaders("Domain, Dogs");
+
+
+CDomainChecker::CDomainChecker()
+{
+  //++
+  //   Start with just the common domains.  They haven't been seen yet, so
+  // their counts are zero until Learn() finds them in a DIR ...
+  //--
+  for (uint32_t i = 0;  g_apszCommonDomains[i] != NULL;  ++i)
+    Add(g_apszCommonDomains[i], 0);
+}
+
+
+/*static*/ string CDomainChecker::GetDomain (const string &seMail)
+{
+  //++
+  //   Return everything after the last "@" in an email address, in lower
+  // case and with any leading or trailing spaces removed.  If there's no "@"
+  // or the domain doesn't contain at least one dot, then return nothing ...
+  //--
+  size_t nAt = seMail.rfind('@');
+  if (nAt == string::npos) return string("");
+  string sDomain;
+  for (size_t i = nAt+1;  i < seMail.length();  ++i)
+    if (!isspace((unsigned char) seMail[i])) sDomain.push_back((char) ::tolower((unsigned char) seMail[i]));
+  if (sDomain.find('.') == string::npos) return string("");
+  return sDomain;
+}
+
+
+/*static*/ uint32_t CDomainChecker::Distance (const string &s1, const string &s2)
+{
+  //++
+  //   Return the Damerau-Levenshtein distance between two strings.  That's
+  // the number of single character insertions, deletions, substitutions and
+  // transpositions of adjacent characters needed to turn one into the other,
+  // and unlike the optimal string alignment distance it allows a substring to
+  // be edited more than once, so it obeys the triangle inequality that the
+  // BK-tree needs.  This is the Lowrance-Wagner algorithm - d[][] is offset
+  // by one so that row and column zero can hold the "infinite" border, and
+  // anLast[] remembers the last row where each character appeared in s1.
+  // The matrix is on the stack, so strings longer than MAXDOMAIN just return
+  // MAXDOMAIN ...
+  //--
+  size_t n1 = s1.length(), n2 = s2.length();
+  if ((n1 > MAXDOMAIN) || (n2 > MAXDOMAIN)) return MAXDOMAIN;
+  uint8_t d[MAXDOMAIN+2][MAXDOMAIN+2];  size_t anLast[256] = {0};
+  uint8_t nInfinity = (uint8_t) (n1 + n2);
+  d[0][0] = nInfinity;
+  for (size_t i = 0;  i <= n1;  ++i) {d[i+1][0] = nInfinity;  d[i+1][1] = (uint8_t) i;}
+  for (size_t j = 0;  j <= n2;  ++j) {d[0][j+1] = nInfinity;  d[1][j+1] = (uint8_t) j;}
+  for (size_t i = 1;  i <= n1;  ++i) {
+    size_t nLastColumn = 0;
+    for (size_t j = 1;  j <= n2;  ++j) {
+      size_t k = anLast[(uint8_t) s2[j-1]], l = nLastColumn;
+      uint8_t nCost = 1;
+      if (s1[i-1] == s2[j-1]) {nCost = 0;  nLastColumn = j;}
+      uint8_t n = std::min(std::min(d[i][j+1]+1, d[i+1][j]+1), d[i][j]+nCost);
+      d[i+1][j+1] = std::min((size_t) n, d[k][l] + (i-k-1) + 1 + (j-l-1));
+    }
+    anLast[(uint8_t) s1[i-1]] = i;
+  }
+  return d[n1+1][n2+1];
+}
+
+
+/*static*/ bool CDomainChecker::IsOtherTLD (const string &sDomain1, const string &sDomain2)
+{
+  //++
+  //   Return true if two domains are identical except for the top level
+  // domain, and the top level domains are more than one edit apart.  So
+  // "yahoo.ca" and "yahoo.com" are two different domains, but "yahoo.con" is
+  // just a typo ...
+  //--
+  size_t nDot1 = sDomain1.rfind('.'), nDot2 = sDomain2.rfind('.');
+  if ((nDot1 == string::npos) || (nDot2 == string::npos)) return false;
+  if (sDomain1.compare(0, nDot1, sDomain2, 0, nDot2) != 0) return false;
+  return Distance(sDomain1.substr(nDot1+1), sDomain2.substr(nDot2+1)) > 1;
+}
+
+
+void CDomainChecker::Add (const string &sDomain, uint32_t nCount)
+{
+  //++
+  //   Add a known good domain to the BK-tree.  If it's already known then
+  // just add to its count.  Otherwise walk down the tree, following the child
+  // whose distance from each node is the same as ours, until we find a node
+  // without one.  The new domain becomes that child ...
+  //--
+  if (sDomain.empty() || (sDomain.length() > MAXDOMAIN)) return;
+  m_mapChecked.clear();
+  unordered_map<string, uint32_t>::const_iterator it = m_mapKnown.find(sDomain);
+  if (it != m_mapKnown.end()) {m_vecNodes[it->second].nCount += nCount;  return;}
+
+  uint32_t nNew = (uint32_t) m_vecNodes.size(), nDistance = 0;
+  if (nNew > 0) {
+    uint32_t nNode = 0;
+    for (;;) {
+      nDistance = Distance(sDomain, m_vecNodes[nNode].sDomain);
+      assert(nDistance > 0);
+      uint32_t nChild = m_vecNodes[nNode].nChild;
+      while ((nChild != NONODE) && (m_vecNodes[nChild].nDistance != nDistance))
+        nChild = m_vecNodes[nChild].nSibling;
+      if (nChild == NONODE) {
+        m_vecNodes.push_back({sDomain, nCount, nDistance, NONODE, m_vecNodes[nNode].nChild});
+        m_vecNodes[nNode].nChild = nNew;  break;
+      }
+      nNode = nChild;
+    }
+  } else
+    m_vecNodes.push_back({sDomain, nCount, 0, NONODE, NONODE});
+  m_mapKnown[sDomain] = nNew;
+}
+
+
+void CDomainChecker::Add (const CDogs &Dogs)
+{
+  //++
+  //   Count all the adopter email domains in a previous DIR, and then learn
+  // the ones that were seen at least MIN_SEEN times, most common first.  Any
+  // domain that's close to a known domain which is DOMINANCE times as common
+  // is assumed to be a typo and isn't learned (see Learn()) ...
+  //--
+  TRACE_SCOPE("email domains");
+  unordered_map<string, uint32_t> mapSeen;
+  for (CDogs::dog_number_const_iterator it = Dogs.dog_begin();  it != Dogs.dog_end();  ++it) {
+    string sDomain = GetDomain(it->second->GetAdoptioneMail());
+    if (!sDomain.empty()) ++mapSeen[sDomain];
+  }
+  Learn(mapSeen);
+}
+
+
+void CDomainChecker::Learn (const unordered_map<string, uint32_t> &mapSeen)
+{
+  //++
+  //   Learn the domains from a list of how many times each one was seen.
+  // This is the second half of Add(), for callers (e.g. CPartitions) that do
+  // the counting themselves.  The built in domains get their real counts
+  // here too, and since they're learned in order they're always counted
+  // before any less common domain is compared with them ...
+  //--
+  vector<std::pair<string, uint32_t> > vecSeen(mapSeen.begin(), mapSeen.end());
+  std::sort(vecSeen.begin(), vecSeen.end(), [](const std::pair<string, uint32_t> &p1, const std::pair<string, uint32_t> &p2)
+    {return (p1.second != p2.second) ? (p1.second > p2.second) : (p1.first < p2.first);});
+  for (vector<std::pair<string, uint32_t> >::const_iterator it = vecSeen.begin();  it != vecSeen.end();  ++it) {
+    if (it->second < MIN_SEEN) break;
+    if (!IsKnown(it->first)) {
+      uint32_t nNearest = Nearest(it->first, Radius(it->first));
+      if ((nNearest != NONODE) && (m_vecNodes[nNearest].nCount/DOMINANCE >= it->second)) continue;
+    }
+    Add(it->first, it->second);
+  }
+}
+
+
+/*static*/ void CDomainChecker::WriteCounts (const string &sFileName, const unordered_map<string, uint32_t> &mapSeen)
+{
+  //++
+  //   Write the domain counts, one per row and sorted by domain, so that
+  // ReadCounts() can learn exactly what Learn() would have.  CShards uses
+  // this to give every shard the domains from the whole old DIR ...
+  //--
+  vector<std::pair<string, uint32_t> > vecSeen(mapSeen.begin(), mapSeen.end());
+  std::sort(vecSeen.begin(), vecSeen.end());
+  CCSVFile csv;
+  for (vector<std::pair<string, uint32_t> >::const_iterator it = vecSeen.begin();  it != vecSeen.end();  ++it) {
+    CCSVRow row(2);
+    row[0] = it->first;  row[1] = std::to_string(it->second);
+    csv.AddRow(row);
+  }
+  csv.Write(sFileName, m_sColumnHeaders);
+}
+
+
+void CDomainChecker::ReadCounts (const string &sFileName)
+{
+  //++
+  //   Read a file of domain counts written by WriteCounts() and learn them,
+  // exactly as if we'd counted them ourselves ...
+  //--
+  CCSVFile csv;  unordered_map<string, uint32_t> mapSeen;
+  csv.Read(sFileName, m_sColumnHeaders);
+  for (size_t i = 0;  i < csv.size();  ++i) {
+    const CCSVRow &row = *csv[i];
+    if ((row.size() != 2) || row[0].empty() || row[1].empty() || (row[1].find_first_not_of("0123456789") != string::npos))
+      ERRS("CDomainChecker::ReadCounts() bad count in row " << (i+2) << " of " << sFileName);
+    mapSeen[row[0]] += (uint32_t) strtoul(row[1].c_str(), NULL, 10);
+  }
+  Learn(mapSeen);
+}
+
+
+uint32_t CDomainChecker::Nearest (const string &sDomain, uint32_t nRadius) const
+{
+  //++
+  //   Search the BK-tree for the known domain closest to this one, but not
+  // more than nRadius edits away, and return its node (or NONODE).  The
+  // triangle inequality says that only the children whose distance from
+  // their parent is within nRadius of our distance from the parent can
+  // possibly be close enough, so those are the only subtrees we visit.  A
+  // known domain that only has a different TLD (see IsOtherTLD()) can't be
+  // the answer, since this one isn't a misspelling of it, but its children
+  // are still searched.  That goes for both Learn() and Suggest() ...
+  //--
+  uint32_t nBest = NONODE, nBestDistance = nRadius+1;
+  if (m_vecNodes.empty()) return NONODE;
+  vector<uint32_t> vecStack(1, 0);
+  while (!vecStack.empty()) {
+    uint32_t nNode = vecStack.back();  vecStack.pop_back();
+    const NODE &node = m_vecNodes[nNode];
+    uint32_t nDistance = Distance(sDomain, node.sDomain);
+    if (((nDistance < nBestDistance)
+      || ((nDistance == nBestDistance) && (nBest != NONODE) && (node.nCount > m_vecNodes[nBest].nCount)))
+     && !IsOtherTLD(sDomain, node.sDomain)) {
+      nBest = nNode;  nBestDistance = nDistance;
+    }
+    for (uint32_t nChild = node.nChild;  nChild != NONODE;  nChild = m_vecNodes[nChild].nSibling) {
+      uint32_t nChildDistance = m_vecNodes[nChild].nDistance;
+      if ((nChildDistance + nRadius >= nDistance) && (nChildDistance <= nDistance + nRadius))
+        vecStack.push_back(nChild);
+    }
+  }
+  return nBest;
+}
+
+
+string CDomainChecker::Suggest (const string &sDomain)
+{
+  //++
+  //   Return the known domain that this one is probably a misspelling of, or
+  // an empty string if it's known to be good (or isn't close to anything we
+  // know, in which case we have to give it the benefit of the doubt).  The
+  // answer is remembered, since we'll see the same domains over and over ...
+  //--
+  if (sDomain.empty() || IsKnown(sDomain)) return string("");
+  unordered_map<string, string>::const_iterator it = m_mapChecked.find(sDomain);
+  if (it != m_mapChecked.end()) return it->second;
+  uint32_t nNearest = Nearest(sDomain, Radius(sDomain));
+  string sSuggestion = (nNearest != NONODE) ? m_vecNodes[nNearest].sDomain : string("");
+  m_mapChecked[sDomain] = sSuggestion;
+  return sSuggestion;
+}
+
+
+size_t CDomainChecker::CheckDogs (const CDogs &Dogs)
+{
+  //++
+  //   Check the adopter email address for every dog that's going to be sent
+  // to the microchip registry, and report the ones that look misspelled.
+  // This should be called after BuildUpdates(), which will have verified the
+  // email syntax (and cleared any that are invalid).  Returns the number of
+  // misspelled addresses found ...
+  //--
+  TRACE_SCOPE("email domains");
+  size_t nFound = 0;
+  for (CDogs::dog_number_const_iterator it = Dogs.dog_begin();  it != Dogs.dog_end();  ++it) {
+    const CDog *pDog = it->second;
+    if (!pDog->IsUpdateRequired() || pDog->GetAdoptioneMail().empty()) continue;
+    string sSuggestion = Suggest(GetDomain(pDog->GetAdoptioneMail()));
+    if (sSuggestion.empty()) continue;
+    ++nFound;  METRIC(RULE_EMAIL_DOMAIN);
+    BADDOGS(pDog, "email address \"" << pDog->GetAdoptioneMail() << "\" may be misspelled (did you mean "
+            << sSuggestion << "?)");
+  }
+  return nFound;
+}
@@ -0,0 +1,156 @@
+//++
+// DomainChecker.hpp -> find misspelled email domains
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   CDog::VerifyeMail() only checks the syntax of an email address, and
+// "someone@gmial.com" is perfectly good syntax.  The trouble is that the
+// microchip registry's email never gets to the adopter.  The CDomainChecker
+// class keeps a list of known good domains - a built in list of the common
+// ones, plus any domain that shows up often enough in a previous DIR - and
+// flags any domain that's not on the list but is within an edit or two of
+// one that is.
+//
+//   Alas, typos repeat - the same adopter adopts more than one dog, and lots
+// of people type "gmial".  So a domain from a previous DIR is only learned if
+// no known domain within an edit or two of it is DOMINANCE times as common.
+// The domains are learned most common first, so that the real ones are
+// already known by the time we get to their misspellings.  The built in
+// domains only count the times they're actually seen, so they don't crowd
+// out everything near them, and a domain that's the same as a known one
+// except for a really different top level domain ("yahoo.ca" vs "yahoo.com",
+// but not "yahoo.con") is never considered a typo of it - not when learning,
+// and not when checking an adopter's email either.
+//
+//   The known domains are kept in a BK-tree keyed by the (unrestricted)
+// Damerau-Levenshtein distance, so "gmial" vs "gmail" counts as only one
+// edit.  A BK-tree only has to look at the subtrees whose distance from
+// each node is within the search radius of the query, so a lookup touches a
+// handful of nodes rather than every domain.  That depends on the triangle
+// inequality, which is why it can't be the simpler optimal string alignment
+// distance - OSA("ca","abc") is 3, but "ca" -> "ac" -> "abc" is only 2.
+// And since most adopters use the same dozen domains, the answer for each
+// domain is remembered too.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Split Learn() out of Add().
+// 17-OCT-26  AGT   Use a real metric for the BK-tree, and don't let the
+//                  built in domains block other top level domains.
+// 17-OCT-26  AGT   Add WriteCounts() and ReadCounts() for CShards.
+// 17-OCT-26  AGT   Suggest() doesn't flag other top level domains either.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include "Dog.hpp"              // CDog data and CDogs collection
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::unordered_map;       // ...
+
+
+class CDomainChecker {
+  //++
+  // Email domain spelling checker ...
+  //--
+
+public:
+  enum {
+    MAXDOMAIN           = 64,           // longest domain we'll bother with
+    MIN_SEEN            = 3,            // times seen before it's "known"
+    SHORT_DOMAIN        = 8,            // domains shorter than this ...
+    SHORT_DISTANCE      = 1,            //  ... may be off by only one edit
+    MAX_DISTANCE        = 2,            // everything else by up to two
+    DOMINANCE           = 10,           // a typo is this much less common
+    NONODE              = 0xFFFFFFFF,   // end of a BK-tree child list
+  };
+  // The header row for a file of domain counts (see WriteCounts()) ...
+  static const string m_sColumnHeaders;
+
+public:
+  // Constructor and destructor ...
+  CDomainChecker();
+  CDomainChecker (const CDogs &OldDogs) : CDomainChecker() {Add(OldDogs);}
+  virtual ~CDomainChecker() {};
+  // Copy and assignment constructors ...
+  CDomainChecker (const CDomainChecker &d) = delete;
+  CDomainChecker& operator= (const CDomainChecker &d) = delete;
+
+  // CDomainChecker public properties ...
+public:
+  // Return the number of known domains ...
+  size_t DomainCount() const {return m_vecNodes.size();}
+  // Return true if this domain is known to be good ...
+  bool IsKnown (const string &sDomain) const
+    {return m_mapKnown.find(sDomain) != m_mapKnown.end();}
+
+  // CDomainChecker public methods ...
+public:
+  // Learn all the adopter domains from a previous DIR ...
+  void Add (const CDogs &Dogs);
+  // Learn the domains from a count of how many times each was seen ...
+  void Learn (const unordered_map<string, uint32_t> &mapSeen);
+  //   Save the counts for somebody else to learn, or learn the counts that
+  // somebody else saved ...
+  static void WriteCounts (const string &sFileName, const unordered_map<string, uint32_t> &mapSeen);
+  void ReadCounts (const string &sFileName);
+  // Add one domain that's known to be good ...
+  void Add (const string &sDomain, uint32_t nCount);
+  //   Return the suggested correction for a domain, or an empty string if
+  // it's known to be good or isn't close to anything ...
+  string Suggest (const string &sDomain);
+  // Check the email of every dog that needs a registry update ...
+  size_t CheckDogs (const CDogs &Dogs);
+  // Return the domain (in lower case) of an email address ...
+  static string GetDomain (const string &seMail);
+  // Return the Damerau-Levenshtein distance between two strings ...
+  static uint32_t Distance (const string &s1, const string &s2);
+  // Return true if two domains differ only in a (not misspelled) TLD ...
+  static bool IsOtherTLD (const string &sDomain1, const string &sDomain2);
+
+  // Private internal CDomainChecker methods ...
+protected:
+  //   Find the known domain nearest to this one, but not more than nRadius
+  // edits away and not just a different TLD.  Ties go to the more common
+  // domain ...
+  uint32_t Nearest (const string &sDomain, uint32_t nRadius) const;
+  // Return the search radius for a domain ...
+  static uint32_t Radius (const string &sDomain)
+    {return (sDomain.length() < SHORT_DOMAIN) ? SHORT_DISTANCE : MAX_DISTANCE;}
+
+  // One node in the BK-tree ...
+protected:
+  struct NODE {
+    string   sDomain;                   // the known domain
+    uint32_t nCount;                    // number of times it was seen
+    uint32_t nDistance;                 // distance from our parent
+    uint32_t nChild;                    // first child of this node
+    uint32_t nSibling;                  // next child of our parent
+  };
+
+  // Local CDomainChecker members ...
+protected:
+  vector<NODE>                       m_vecNodes;    // BK-tree (root is [0])
+  unordered_map<string, uint32_t>    m_mapKnown;    // known domain -> node
+  unordered_map<string, string>      m_mapChecked;  // domain -> suggestion
+};
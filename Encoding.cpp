@@ -0,0 +1,196 @@
+//++
+// Encoding.cpp - implementation of the CEncoding class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CEncoding class, which converts CSV input to
+// UTF-8.  See Encoding.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string.h>             // memcpy() ...
+#include <assert.h>             // assert() (what else??)
+#include <algorithm>            // std::min() ...
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define USE_SSE2
+#include <emmintrin.h>          // _mm_loadu_si128(), _mm_movemask_epi8() ...
+#endif
+#include "Encoding.hpp"         // declarations for this module
+
+//   Windows-1252 is the same as ISO-8859-1 (and thus Unicode) except for the
+// characters 0x80..0x9F.  These are the Unicode code points for those.  The
+// five unassigned ones map to the C1 control with the same value, the same
+// as every web browser does ...
+static const uint16_t g_anWindows1252[32] = {
+  0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,   // 80..87
+  0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,   // 88..8F
+  0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,   // 90..97
+  0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178    // 98..9F
+};
+
+
+/*static*/ bool CEncoding::StripBOM (string &sData)
+{
+  //++
+  // Remove the UTF-8 byte order mark (EF BB BF) from the start, if any ...
+  //--
+  if ((sData.length() < 3) || ((uint8_t) sData[0] != 0xEF)
+   || ((uint8_t) sData[1] != 0xBB) || ((uint8_t) sData[2] != 0xBF)) return false;
+  sData.erase(0, 3);
+  return true;
+}
+
+
+/*static*/ size_t CEncoding::FindNonASCII (const char *pData, size_t nLength)
+{
+  //++
+  //   Return the offset of the first byte with the high bit set, or nLength
+  // if there isn't one.  With SSE2 the movemask instruction collects the high
+  // bits of 16 bytes at a time, and we only look at the individual bytes in
+  // the block where one of them is set ...
+  //--
+  size_t i = 0;
+#ifdef USE_SSE2
+  for (;  i+BLOCK_SIZE <= nLength;  i += BLOCK_SIZE) {
+    int nMask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (pData+i)));
+    if (nMask != 0) {
+      while ((nMask & 1) == 0) {nMask >>= 1;  ++i;}
+      return i;
+    }
+  }
+#endif
+  for (;  i < nLength;  ++i)
+    if (((uint8_t) pData[i] & 0x80) != 0) return i;
+  return nLength;
+}
+
+
+/*static*/ size_t CEncoding::SequenceLength (const uint8_t *pData, size_t nLength)
+{
+  //++
+  //   Return the length of the UTF-8 sequence that starts at pData, or zero
+  // if it isn't a valid one.  Valid means the shortest possible encoding (no
+  // "overlong" forms), no UTF-16 surrogates, and nothing past U+10FFFF.  The
+  // second byte ranges are from the table in section 3.9 of the Unicode spec.
+  //--
+  uint8_t ch = pData[0];
+  if (ch < 0x80) return 1;
+  size_t nBytes;  uint8_t bLow = 0x80, bHigh = 0xBF;
+  if ((ch >= 0xC2) && (ch <= 0xDF)) {
+    nBytes = 2;
+  } else if ((ch >= 0xE0) && (ch <= 0xEF)) {
+    nBytes = 3;
+    if (ch == 0xE0) bLow = 0xA0;
+    if (ch == 0xED) bHigh = 0x9F;
+  } else if ((ch >= 0xF0) && (ch <= 0xF4)) {
+    nBytes = 4;
+    if (ch == 0xF0) bLow = 0x90;
+    if (ch == 0xF4) bHigh = 0x8F;
+  } else
+    return 0;
+  if (nLength < nBytes) return 0;
+  if ((pData[1] < bLow) || (pData[1] > bHigh)) return 0;
+  for (size_t i = 2;  i < nBytes;  ++i)
+    if ((pData[i] & 0xC0) != 0x80) return 0;
+  return nBytes;
+}
+
+
+/*static*/ size_t CEncoding::FindInvalidUTF8 (const char *pData, size_t nLength)
+{
+  //++
+  //   Return the offset of the first byte that isn't part of a valid UTF-8
+  // sequence, or nLength if it's all valid.  The runs of ASCII in between
+  // are skipped by FindNonASCII() ...
+  //--
+  size_t i = 0;
+  while (i < nLength) {
+    i += FindNonASCII(pData+i, nLength-i);
+    if (i >= nLength) break;
+    size_t n = SequenceLength((const uint8_t *) (pData+i), nLength-i);
+    if (n == 0) return i;
+    i += n;
+  }
+  return nLength;
+}
+
+
+/*static*/ void CEncoding::Append1252 (string &sResult, uint8_t ch)
+{
+  //++
+  // Convert one Windows-1252 character to UTF-8 ...
+  //--
+  uint32_t nCode = ((ch >= 0x80) && (ch <= 0x9F)) ? g_anWindows1252[ch-0x80] : ch;
+  if (nCode < 0x80) {
+    sResult.push_back((char) nCode);
+  } else if (nCode < 0x800) {
+    sResult.push_back((char) (0xC0 | (nCode >> 6)));
+    sResult.push_back((char) (0x80 | (nCode & 0x3F)));
+  } else {
+    sResult.push_back((char) (0xE0 | (nCode >> 12)));
+    sResult.push_back((char) (0x80 | ((nCode >> 6) & 0x3F)));
+    sResult.push_back((char) (0x80 | (nCode & 0x3F)));
+  }
+}
+
+
+/*static*/ CEncoding::CHARSET CEncoding::Normalize (string &sData, size_t &nConverted)
+{
+  //++
+  //   Strip any byte order mark and then make sure the data is valid UTF-8.
+  // If it already is, then the buffer isn't touched.  Otherwise everything
+  // up to the first invalid byte is copied as is, and after that each block
+  // of BLOCK_SIZE bytes is either copied (if it's all ASCII) or converted a
+  // character at a time.  Valid UTF-8 sequences are always kept - a file can
+  // have both if somebody pasted a name in from somewhere else - and any other
+  // byte is taken to be Windows-1252.
+  //--
+  nConverted = 0;
+  StripBOM(sData);
+  const char *pData = sData.data();  size_t nLength = sData.length();
+  size_t nFirst = FindNonASCII(pData, nLength);
+  if (nFirst == nLength) return ASCII;
+  size_t nInvalid = nFirst + FindInvalidUTF8(pData+nFirst, nLength-nFirst);
+  if (nInvalid == nLength) return UTF8;
+
+  // Oh well - we have to convert it ...
+  string sResult;  sResult.reserve(nLength + nLength/8);
+  sResult.append(pData, nInvalid);
+  size_t i = nInvalid;
+  while (i < nLength) {
+    if ((i+BLOCK_SIZE <= nLength) && (FindNonASCII(pData+i, BLOCK_SIZE) == BLOCK_SIZE)) {
+      sResult.append(pData+i, BLOCK_SIZE);  i += BLOCK_SIZE;  continue;
+    }
+    // This block has at least one high byte - do it one character at a time ...
+    for (size_t nEnd = std::min(i+BLOCK_SIZE, nLength);  i < nEnd;  ) {
+      size_t n = SequenceLength((const uint8_t *) (pData+i), nLength-i);
+      if (n != 0) {
+        sResult.append(pData+i, n);  i += n;
+      } else {
+        Append1252(sResult, (uint8_t) pData[i]);  ++i;  ++nConverted;
+      }
+    }
+  }
+  sData.swap(sResult);
+  return WINDOWS1252;
+}
@@ -0,0 +1,94 @@
+//++
+// Encoding.hpp -> normalize CSV input to UTF-8
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The NGRR web page exports CSV files in whatever character set it feels
+// like that day.  Usually it's plain ASCII, but sometimes it's UTF-8 with a
+// byte order mark (which ends up in the first header field!) and sometimes
+// it's Windows-1252, so "Jose" with an accent arrives as a single 0xE9 byte
+// that Found.org chokes on.  The CEncoding class cleans all that up before
+// CCSVFile ever sees the data -
+//
+//      * a UTF-8 byte order mark at the start is removed
+//      * the data is checked for valid UTF-8, and if it is then we're done
+//      * otherwise any byte that isn't part of a valid UTF-8 sequence is
+//        assumed to be Windows-1252 and converted to UTF-8
+//
+//   Nearly every file is pure ASCII, so the check for bytes with the high
+// bit set is done 16 bytes at a time using SSE2 (on machines that have it).
+// An ASCII file costs one pass of that and nothing else.  When we do have to
+// convert, the ASCII blocks are still copied 16 bytes at a time and only the
+// blocks that contain high bytes are converted a byte at a time.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+using std::size_t;              // ...
+using std::string;              // ...
+
+
+class CEncoding {
+  //++
+  // Character set detection and conversion ...
+  //--
+
+public:
+  enum {
+    BLOCK_SIZE          = 16,           // bytes checked at a time
+  };
+  // Character sets we recognize ...
+  enum CHARSET {
+    ASCII,                              // plain 7 bit ASCII
+    UTF8,                               // valid UTF-8 (with some non-ASCII)
+    WINDOWS1252,                        // at least some Windows-1252
+  };
+
+  // The constructor and destructor are private - everything here is static!
+private:
+  CEncoding() {};
+  virtual ~CEncoding() {};
+  // Copy and assignment constructors ...
+  CEncoding (const CEncoding &e) = delete;
+  CEncoding& operator= (const CEncoding &e) = delete;
+
+  // CEncoding public methods ...
+public:
+  //   Normalize a buffer to UTF-8 in place and return what it was.  The
+  // number of Windows-1252 characters converted is returned too ...
+  static CHARSET Normalize (string &sData, size_t &nConverted);
+  // Remove a UTF-8 byte order mark, if there is one ...
+  static bool StripBOM (string &sData);
+  // Return the offset of the first non-ASCII byte (or the length) ...
+  static size_t FindNonASCII (const char *pData, size_t nLength);
+  // Return the offset of the first invalid UTF-8 byte (or the length) ...
+  static size_t FindInvalidUTF8 (const char *pData, size_t nLength);
+
+  // Private internal CEncoding methods ...
+private:
+  //   Return the length of the UTF-8 sequence starting here, or zero if it's
+  // not a valid one ...
+  static size_t SequenceLength (const uint8_t *pData, size_t nLength);
+  // Append a Windows-1252 character to a string as UTF-8 ...
+  static void Append1252 (string &sResult, uint8_t ch);
+};
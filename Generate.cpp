@@ -0,0 +1,502 @@
+//++
+// Generate.cpp - implementation of the synthetic DIR generator
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This module makes up dogs.  Lots of dogs.  The plan is simple - first we
+// invent the "old" population of dogs, numbered sequentially in order of their
+// acquisition date, and then we make a copy of that population and apply some
+// churn to it to get the "new" population.  Some dogs get adopted, some get
+// returned, some die, some finally get their microchip entered and some brand
+// new dogs get acquired.  Both populations are then written out as DIRs.
+//
+//   The garbage (bad phone numbers, bad zip codes, duplicate chips, etc) is
+// decided once per dog, when the dog is invented, and is carried along in the
+// DOG structure.  That way a dog with a bad zip code has the SAME bad zip code
+// in both reports, which is what happens in real life, and we don't generate
+// spurious "changes" between the two reports.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Work and cell phones don't collide with other adopters.
+// 17-Oct-26  AGT   Reno is in Nevada, not California!
+// 17-Oct-26  AGT   Work phones are shared company switchboards.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stdio.h>              // snprintf() ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::filebuf
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "Dog.hpp"              // CDog column headers, et al ...
+#include "Generate.hpp"         // declarations for this module
+
+// Number of elements in a static table ...
+#define COUNTOF(a)  (sizeof(a)/sizeof(a[0]))
+
+//   Dog status values, in the order we use them.  These are the strings the
+// NGRR web page actually uses, and the CDog::IsXYZ() methods depend on them.
+enum {
+  STATUS_EVALUATION, STATUS_AVAILABLE, STATUS_PENDING, STATUS_ADOPTED,
+  STATUS_DIED, STATUS_EUTHANIZED, STATUS_RETURNED
+};
+static const char *const g_apszStatus[] = {
+  "Evaluation", "Available", "Adoption Pending", "Adopted",
+  "Died", "Euthanized", "Returned to Owner"
+};
+
+// Lots and lots of golden retriever names ...
+static const char *const g_apszDogNames[] = {
+  "Goldie", "Bear", "Max", "Buddy", "Sunny", "Honey", "Cooper", "Riley", "Bailey",
+  "Charlie", "Lucy", "Daisy", "Murphy", "Rusty", "Maggie", "Tucker", "Sadie",
+  "Duke", "Molly", "Jake", "Ginger", "Brady", "Penny", "Finn", "Rosie", "Toby",
+  "Nova", "Gogo", "Pumpkin", "Sam", "Lady", "Gus", "Hazel", "Cody", "Belle",
+  "Jos\xc3\xa9", "Oso", "Scout", "Willow", "Winston"
+};
+
+// And adopter (and A/C) names ...
+static const char *const g_apszFirstNames[] = {
+  "Robert", "Bob", "Anne", "Mary", "John", "Linda", "James", "Susan", "David",
+  "Karen", "William", "Will", "Nancy", "Richard", "Lisa", "Thomas", "Sharon",
+  "Mark", "Carol", "Steven", "Laura", "Paul", "Donna", "Kevin", "Jennifer"
+};
+static const char *const g_apszLastNames[] = {
+  "Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller", "Davis",
+  "Rodriguez", "Martinez", "Hernandez", "Lopez", "Wilson", "Anderson", "Thomas",
+  "Taylor", "Moore", "Jackson", "Martin", "Lee", "Nguyen", "Chen", "O'Brien"
+};
+static const char *const g_apszStreets[] = {
+  "Main St", "Oak Ave", "Elm St", "El Camino Real", "Hillview Dr", "Park Blvd",
+  "Alameda de las Pulgas", "Stevens Creek Blvd", "Lincoln Ave", "2nd St"
+};
+
+// Some real Northern California (and Nevada) cities and zip codes ...
+static const struct {const char *pszCity, *pszState, *pszZip;} g_aCities[] = {
+  {"San Jose", "CA", "95123"}, {"Palo Alto", "CA", "94301"}, {"Oakland", "CA", "94607"},
+  {"San Mateo", "CA", "94401"}, {"Santa Rosa", "CA", "95404"}, {"Sacramento", "CA", "95814"},
+  {"Fremont", "CA", "94536"}, {"Walnut Creek", "CA", "94596"}, {"Salinas", "CA", "93901"},
+  {"Redding", "CA", "96001"}, {"Fresno", "CA", "93721"}, {"Reno", "NV", "89501"}
+};
+
+// Email domains, and some of the ways people misspell them ...
+static const char *const g_apszDomains[] = {
+  "gmail.com", "yahoo.com", "comcast.net", "sbcglobal.net", "aol.com",
+  "hotmail.com", "icloud.com", "att.net"
+};
+static const char *const g_apszBadDomains[] = {
+  "gmial.com", "yahoo.con", "comcast.ent", "sbcgloabl.net", "aol.co",
+  "hotmail.cm", "gmail", "att@net"
+};
+
+// NGRR areas ...
+static const char *const g_apszAreas[] = {
+  "South Bay", "Peninsula", "East Bay", "North Bay", "Sacramento",
+  "Central Valley", "Monterey Bay", "Sierra Foothills"
+};
+
+
+CDIRGenerator::CDIRGenerator()
+{
+  //++
+  //   The defaults are more or less what a real pair of DIRs, a month or so
+  // apart, looks like ...
+  //--
+  m_nDogs = DEFAULT_DOGS;  m_nCutoffYear = 2019;  m_nRecentPct = 30;
+  m_nAcquirePct = 2;  m_nAdoptPct = 40;  m_nReturnPct = 2;  m_nDeathPct = 1;
+  m_nDirtyPct = 5;  m_nSeed = DEFAULT_SEED;
+  m_fOldFormat = m_fNewFormat = true;
+}
+
+
+/*static*/ string CDIRGenerator::MakeDate (uint32_t nYear, uint32_t nMonth, uint32_t nDay)
+{
+  //++
+  // Format a date the way the DIR does - YYYY-MM-DD ...
+  //--
+  char sz[32];
+  snprintf(sz, sizeof(sz), "%04u-%02u-%02u", nYear, nMonth, nDay);
+  return string(sz);
+}
+
+
+/*static*/ string CDIRGenerator::MakeAge (const DOG &dog)
+{
+  //++
+  //   Normally the age is "N Years M Months", but if this dog is dirty then
+  // use one of the other formats that turn up in the DIR ...
+  //--
+  char sz[64];
+  if ((dog.nDirty & DIRTY_AGE) == 0) {
+    snprintf(sz, sizeof(sz), "%u Years %u Months", dog.nAgeYears, dog.nAgeMonths);
+  } else {
+    switch (dog.nNumber % 5) {
+      case 0:  snprintf(sz, sizeof(sz), "%u Years", dog.nAgeYears);  break;
+      case 1:  snprintf(sz, sizeof(sz), "%u months", dog.nAgeYears*12 + dog.nAgeMonths);  break;
+      case 2:  snprintf(sz, sizeof(sz), "%u yrs %u mos", dog.nAgeYears, dog.nAgeMonths);  break;
+      case 3:  snprintf(sz, sizeof(sz), "%u.5 years", dog.nAgeYears);  break;
+      default: snprintf(sz, sizeof(sz), "%u Year %u Months", dog.nAgeYears, dog.nAgeMonths);  break;
+    }
+  }
+  return string(sz);
+}
+
+
+/*static*/ string CDIRGenerator::MakePhone (uint32_t nAdopter, uint32_t nDirty)
+{
+  //++
+  //   Make up a phone number for an adopter.  The "good" format is the one the
+  // web page suggests, and the dirty ones are all things we've actually seen.
+  // Note that the last one isn't even a valid phone number ...
+  //--
+  char sz[64];
+  uint32_t nArea = 408 + (nAdopter % 7)*100, nPrefix = 200 + (nAdopter % 800);
+  uint32_t nLine = (nAdopter * 7919) % 10000;
+  if ((nDirty & DIRTY_PHONE) == 0) {
+    snprintf(sz, sizeof(sz), "%03u-%03u-%04u", nArea, nPrefix, nLine);
+  } else {
+    switch (nAdopter % 7) {
+      case 0:  snprintf(sz, sizeof(sz), "(%03u) %03u-%04u", nArea, nPrefix, nLine);  break;
+      case 1:  snprintf(sz, sizeof(sz), "%03u.%03u.%04u", nArea, nPrefix, nLine);  break;
+      case 2:  snprintf(sz, sizeof(sz), "+1 %03u %03u %04u", nArea, nPrefix, nLine);  break;
+      case 3:  snprintf(sz, sizeof(sz), "%03u*%03u*%04u", nArea, nPrefix, nLine);  break;
+      case 4:  snprintf(sz, sizeof(sz), "%03u%03u%04u", nArea, nPrefix, nLine);  break;
+      case 5:  snprintf(sz, sizeof(sz), "none");  break;
+      default: snprintf(sz, sizeof(sz), "%03u-%04u", nPrefix, nLine);  break;
+    }
+  }
+  return string(sz);
+}
+
+
+/*static*/ string CDIRGenerator::MakeZip (uint32_t nAdopter, uint32_t nDirty)
+{
+  //++
+  // Return the zip code for an adopter, possibly mangled ...
+  //--
+  string sZip = g_aCities[nAdopter % COUNTOF(g_aCities)].pszZip;
+  if ((nDirty & DIRTY_ZIP) == 0) {
+    if ((nAdopter % 4) == 0) sZip += "-" + std::to_string(1000 + nAdopter % 9000);
+    return sZip;
+  }
+  switch (nAdopter % 4) {
+    case 0:  return sZip.substr(0, 4);
+    case 1:  sZip[2] = 'l';  return sZip;
+    case 2:  return sZip + "-12";
+    default: return "CA " + sZip;
+  }
+}
+
+
+/*static*/ string CDIRGenerator::MakeeMail (uint32_t nAdopter, uint32_t nDirty)
+{
+  //++
+  // Make up an email address, possibly with a misspelled domain ...
+  //--
+  string sUser = string(g_apszFirstNames[nAdopter % COUNTOF(g_apszFirstNames)])
+               + "." + std::to_string(nAdopter);
+  if ((nDirty & DIRTY_EMAIL) == 0)
+    return sUser + "@" + g_apszDomains[(nAdopter/3) % COUNTOF(g_apszDomains)];
+  return sUser + "@" + g_apszBadDomains[(nAdopter/3) % COUNTOF(g_apszBadDomains)];
+}
+
+
+uint32_t CDIRGenerator::MakeDirt()
+{
+  //++
+  // Decide which kinds of garbage this dog is going to have ...
+  //--
+  uint32_t nDirty = 0;
+  for (uint32_t nBit = DIRTY_PHONE;  nBit <= DIRTY_STATE;  nBit <<= 1)
+    if (Dirty()) nDirty |= nBit;
+  return nDirty;
+}
+
+
+string CDIRGenerator::MakeChip (uint32_t nDirty)
+{
+  //++
+  //   Make up a microchip number.  Almost all NGRR chips are 98102xxxxxxxxxx,
+  // but we also see the occasional legacy 9 digit chip and (worse) the same
+  // chip entered for two different dogs ...
+  //--
+  char sz[64];
+  if (((nDirty & DIRTY_DUP_CHIP) != 0) && !m_vecChips.empty())
+    return m_vecChips[Random((uint32_t) m_vecChips.size())];
+  if ((nDirty & DIRTY_OLD_CHIP) != 0) {
+    snprintf(sz, sizeof(sz), "%03u*%03u*%03u", Random(1000), Random(1000), Random(1000));
+  } else {
+    snprintf(sz, sizeof(sz), "98102%05u%05u", Random(100000), Random(100000));
+  }
+  m_vecChips.push_back(sz);
+  return string(sz);
+}
+
+
+void CDIRGenerator::NewDog (DOG &dog, uint32_t nNumber, uint32_t nYear)
+{
+  //++
+  //   Invent one brand new dog, acquired sometime during nYear.  The dog
+  // starts out in evaluation, and the caller decides what happens next.
+  //--
+  dog.nNumber = nNumber;  dog.nDirty = MakeDirt();
+  dog.sName = Pick(g_apszDogNames, COUNTOF(g_apszDogNames));
+  //   About 10% of dogs don't have their chip recorded when the first get
+  // to NGRR, and a few of them came with the word "none" ...
+  if (Chance(10))
+    dog.sChip = Chance(20) ? "None" : "";
+  else
+    dog.sChip = MakeChip(dog.nDirty);
+  dog.nYear = nYear;  dog.nMonth = 1 + Random(12);  dog.nDay = 1 + Random(28);
+  dog.nAgeYears = Random(14);  dog.nAgeMonths = Random(12);
+  dog.fMale = Chance(50);  dog.nStatus = STATUS_EVALUATION;
+  dog.nAdopter = 0;  dog.sDisposition.clear();
+  if ((dog.nDirty & DIRTY_NULL_DATE) != 0) dog.sDisposition = "0000-00-00";
+  dog.nArea = Random(COUNTOF(g_apszAreas));
+}
+
+
+void CDIRGenerator::Adopt (DOG &dog, uint32_t nYear)
+{
+  //++
+  // Find this dog a forever home ...
+  //--
+  dog.nStatus = STATUS_ADOPTED;
+  //   Adopters are drawn from a pool that's a bit smaller than the number of
+  // dogs, so some households adopt more than one dog ...
+  dog.nAdopter = 1 + Random((uint32_t) (m_nDogs*3/4 + 1));
+  dog.sDisposition = MakeDate(nYear, 1 + Random(12), 1 + Random(28));
+}
+
+
+void CDIRGenerator::GenerateDogs (vector<DOG> &vecOld, vector<DOG> &vecNew)
+{
+  //++
+  //   Invent the old population of dogs, and then apply the churn to get the
+  // new population.  Dogs are numbered sequentially starting from 1 in order
+  // of acquisition, just like the NGRR database (more or less!) ...
+  //--
+  m_rng.seed(m_nSeed);  m_vecChips.clear();
+  size_t nNew = m_nDogs;
+  size_t nAcquired = (nNew * m_nAcquirePct) / 100;
+  size_t nOld = nNew - nAcquired;
+  size_t nRecent = (nOld * m_nRecentPct) / 100;
+  uint32_t nThisYear = m_nCutoffYear + 5;
+  vecOld.clear();  vecOld.resize(nOld);
+
+  // Generate the old dogs first ...
+  for (size_t i = 0;  i < nOld;  ++i) {
+    DOG &dog = vecOld[i];
+    uint32_t nYear;
+    if (i < (nOld-nRecent))
+      nYear = FIRST_YEAR + (uint32_t) ((i * (m_nCutoffYear-FIRST_YEAR)) / (nOld-nRecent));
+    else
+      nYear = m_nCutoffYear + (uint32_t) (((i-(nOld-nRecent)) * 5) / (nRecent+1));
+    NewDog(dog, (uint32_t) (i+1), nYear);
+    //   Old dogs have mostly been adopted (or have passed on), and the recent
+    // ones are spread out all over the place ...
+    uint32_t n = Random(100);
+    if (nYear < m_nCutoffYear) {
+      if (n < 80) Adopt(dog, nYear);
+      else if (n < 95) dog.nStatus = STATUS_DIED;
+      else dog.nStatus = STATUS_RETURNED;
+    } else {
+      if (n < 60) Adopt(dog, nYear);
+      else if (n < 70) dog.nStatus = STATUS_AVAILABLE;
+      else if (n < 75) dog.nStatus = STATUS_PENDING;
+      else if (n < 80) dog.nStatus = STATUS_DIED;
+      else if (n < 82) dog.nStatus = STATUS_EUTHANIZED;
+      else if (n < 84) dog.nStatus = STATUS_RETURNED;
+      //   The rest stay in evaluation.  Note that in real life some dogs that
+      // have died still have a disposition date, and a few that are still
+      // available do too (which is an error!) ...
+    }
+    if ((dog.nStatus == STATUS_DIED) || (dog.nStatus == STATUS_EUTHANIZED))
+      dog.sDisposition = MakeDate(nYear, 1 + Random(12), 1 + Random(28));
+  }
+
+  // Now the new dogs are the old dogs plus some churn ...
+  vecNew = vecOld;
+  for (size_t i = 0;  i < nOld;  ++i) {
+    DOG &dog = vecNew[i];
+    if ((dog.nStatus == STATUS_DIED) || (dog.nStatus == STATUS_EUTHANIZED)) continue;
+    if ((dog.nStatus == STATUS_RETURNED)) continue;
+    if (dog.nAdopter != 0) {
+      // Adopted dogs may be returned to NGRR, or may die ...
+      if (Chance(m_nReturnPct)) {
+        dog.nAdopter = 0;  dog.nStatus = STATUS_AVAILABLE;  dog.sDisposition.clear();
+      } else if (Chance(m_nDeathPct)) {
+        dog.nStatus = STATUS_DIED;
+      }
+    } else {
+      // Unadopted dogs may be adopted, or die ...
+      if (Chance(m_nAdoptPct)) Adopt(dog, nThisYear);
+      else if (Chance(m_nDeathPct)) dog.nStatus = STATUS_DIED;
+    }
+    // And some of the dogs without chips finally get them entered ...
+    if ((dog.sChip.empty() || (dog.sChip == "None")) && Chance(50))
+      dog.sChip = MakeChip(dog.nDirty & ~DIRTY_DUP_CHIP);
+  }
+
+  // Lastly, add the newly acquired dogs ...
+  vecNew.resize(nNew);
+  for (size_t i = nOld;  i < nNew;  ++i) {
+    DOG &dog = vecNew[i];
+    NewDog(dog, (uint32_t) (i+1), nThisYear);
+    if (Chance(20)) dog.nStatus = STATUS_AVAILABLE;
+  }
+}
+
+
+void CDIRGenerator::ToRow (const DOG &dog, CCSVRow &row, bool fNew)
+{
+  //++
+  //   Convert one synthetic dog into a DIR row, in either the 35 column (fNew
+  // is false) or 36 column (fNew is true) layout ...
+  //--
+  bool fEquals = (dog.nDirty & DIRTY_EQUALS) != 0;
+  const char *pszACF = g_apszFirstNames[(dog.nArea*3) % COUNTOF(g_apszFirstNames)];
+  const char *pszACL = g_apszLastNames[(dog.nArea*5) % COUNTOF(g_apszLastNames)];
+  const char *pszArea = g_apszAreas[dog.nArea];
+  uint32_t nSurrender = dog.nNumber * 31;
+  size_t nCol = 0;
+  row = CCSVRow(fNew ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS);
+
+  row[nCol++] = dog.sName;                                              // dog name
+  row[nCol++] = fEquals ? Equals(std::to_string(dog.nNumber))           // dog number
+                        : std::to_string(dog.nNumber);
+  row[nCol++] = (fEquals && !dog.sChip.empty()) ? Equals(dog.sChip) : dog.sChip;
+  row[nCol++] = MakeAge(dog);                                           // age
+  row[nCol++] = dog.fMale ? "Male" : "Female";                          // sex
+  row[nCol++] = "Golden Retriever";                                     // breed
+  row[nCol++] = "Yes";                                                  // neuter
+  row[nCol++] = g_apszStatus[dog.nStatus];                              // status
+  row[nCol++] = pszArea;                                                // location
+  row[nCol++] = (dog.nNumber % 3) ? "Surrender" : "Shelter";            // how acquired
+  row[nCol++] = ((dog.nDirty & DIRTY_NULL_DATE) && ((dog.nNumber % 4) == 0))
+              ? "0000-00-00" : MakeDate(dog.nYear, dog.nMonth, dog.nDay);
+  row[nCol++] = pszACF;                                                 // primary contact
+  row[nCol++] = pszACL;                                                 // ...
+  row[nCol++] = g_apszFirstNames[nSurrender % COUNTOF(g_apszFirstNames)];
+  row[nCol++] = g_apszLastNames[nSurrender % COUNTOF(g_apszLastNames)];
+  row[nCol++] = std::to_string(100 + nSurrender % 9000) + " " + g_apszStreets[nSurrender % COUNTOF(g_apszStreets)];
+  row[nCol++] = g_aCities[nSurrender % COUNTOF(g_aCities)].pszCity;
+  row[nCol++] = g_aCities[nSurrender % COUNTOF(g_aCities)].pszState;
+  row[nCol++] = MakeZip(nSurrender, dog.nDirty);
+  row[nCol++] = pszArea;                                                // originating area
+  if (fNew) row[nCol++] = "";                                           // county
+
+  // Adopter data, if any ...
+  if (dog.nAdopter != 0) {
+    uint32_t n = dog.nAdopter;
+    row[nCol++] = g_apszFirstNames[n % COUNTOF(g_apszFirstNames)];
+    row[nCol++] = g_apszLastNames[(n/COUNTOF(g_apszFirstNames)) % COUNTOF(g_apszLastNames)];
+    row[nCol++] = pszACF;  row[nCol++] = pszACL;
+    row[nCol++] = std::to_string(100 + n % 9000) + " " + g_apszStreets[n % COUNTOF(g_apszStreets)];
+    row[nCol++] = g_aCities[n % COUNTOF(g_aCities)].pszCity;
+    row[nCol++] = (dog.nDirty & DIRTY_STATE) ? (((n % 2) == 0) ? "" : "ca") : g_aCities[n % COUNTOF(g_aCities)].pszState;
+    row[nCol++] = fEquals ? Equals(MakeZip(n, dog.nDirty)) : MakeZip(n, dog.nDirty);
+    row[nCol++] = pszArea;
+    row[nCol++] = MakeeMail(n, dog.nDirty);
+    row[nCol++] = MakePhone(n, dog.nDirty);
+    row[nCol++] = ((n % 3) == 0) ? MakePhone(WORK_PHONE_OFFSET + n%WORK_SWITCHBOARDS, 0) : "";
+    row[nCol++] = ((n % 2) == 0) ? MakePhone(n+CELL_PHONE_OFFSET, dog.nDirty) : "";
+    row[nCol++] = "Completed";
+  } else {
+    nCol += 2;  row[nCol++] = pszACF;  row[nCol++] = pszACL;  nCol += 10;
+  }
+  row[nCol++] = dog.sDisposition;                                       // disposition date
+  assert(nCol == row.size());
+}
+
+
+/*static*/ string CDIRGenerator::FormatRow (const CCSVRow &row)
+{
+  //++
+  //   Format a DIR row the way the NGRR web page does.  This is the same as
+  // CCSVRow::Format() except that Excel style ="..." fields are written out
+  // verbatim rather than being quoted.
+  //--
+  string sResult("");
+  for (CCSVRow::const_iterator it = row.begin();  it != row.end();  ++it) {
+    if (it != row.begin()) sResult.push_back(CCSVRow::COMMA);
+    const string &s = *it;
+    if ((s.length() >= 3) && (s[0] == '=') && (s[1] == CCSVRow::QUOTE) && (s.back() == CCSVRow::QUOTE)) {
+      sResult.append(s);
+    } else if ((s.find(CCSVRow::COMMA) != string::npos) || (s.find(CCSVRow::QUOTE) != string::npos)) {
+      sResult.push_back(CCSVRow::QUOTE);
+      for (string::const_iterator jt = s.begin();  jt != s.end();  ++jt) {
+        sResult.push_back(*jt);
+        if (*jt == CCSVRow::QUOTE) sResult.push_back(CCSVRow::QUOTE);
+      }
+      sResult.push_back(CCSVRow::QUOTE);
+    } else
+      sResult.append(s);
+  }
+  return sResult;
+}
+
+
+size_t CDIRGenerator::Write (ostream &stm, const vector<DOG> &vecDogs, bool fNew)
+{
+  //++
+  //   Write a collection of synthetic dogs to a stream as a DIR, header row
+  // and all.  Returns the number of dogs written.
+  //--
+  CCSVRow hdr(fNew ? CDog::m_sNewColumnHeaders : CDog::m_sOldColumnHeaders);
+  stm << hdr;
+  CCSVRow row;
+  for (vector<DOG>::const_iterator it = vecDogs.begin();  it != vecDogs.end();  ++it) {
+    ToRow(*it, row, fNew);
+    stm << FormatRow(row) << '\n';
+  }
+  return vecDogs.size();
+}
+
+
+uint64_t CDIRGenerator::WriteFile (const string &sFileName, const vector<DOG> &vecDogs, bool fNew)
+{
+  //++
+  //   Same as the above, but handle opening and closing the file too.  Returns
+  // the size of the file, in bytes ...
+  //--
+  std::filebuf fb;
+  if (!fb.open(sFileName, std::ios::out|std::ios::binary))
+    ERRS("CDIRGenerator::WriteFile() unable to create " << sFileName);
+  std::ostream os(&fb);
+  size_t nDogs = Write(os, vecDogs, fNew);
+  uint64_t nBytes = (uint64_t) os.tellp();
+  fb.close();
+  MSGS("Wrote " << nDogs << " synthetic dogs to " << sFileName);
+  return nBytes;
+}
+
+
+void CDIRGenerator::Generate (const string &sOldFile, const string &sNewFile)
+{
+  //++
+  // Generate a complete pair of old and new DIR files ...
+  //--
+  vector<DOG> vecOld, vecNew;
+  GenerateDogs(vecOld, vecNew);
+  WriteFile(sOldFile, vecOld, m_fOldFormat);
+  WriteFile(sNewFile, vecNew, m_fNewFormat);
+}
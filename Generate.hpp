@@ -0,0 +1,175 @@
+//++
+// Generate.hpp -> synthetic Dog Information Report generator
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The CDIRGenerator class writes a pair of completely made up Dog Information
+// Reports - an "old" one and a "new" one - that look and feel like the real
+// thing.  That includes all the churn between two reports (dogs acquired,
+// adopted, returned and died) and, more importantly, all the garbage that the
+// A/Cs like to type into the NGRR web page.  It's used for benchmarking and
+// testing when we don't want to (or can't!) use real adopter data.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Work and cell phones don't collide with other adopters.
+// 17-OCT-26  AGT   Work phones are shared company switchboards.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <random>               // std::mt19937_64, et al ...
+#include <iostream>             // C++ style output ...
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::ostream;             // ...
+class CCSVRow;                  // ...
+
+
+class CDIRGenerator {
+  //++
+  //   Generate a synthetic pair of DIR files.  All the knobs are expressed
+  // as percentages (0..100) and are applied independently to each dog ...
+  //--
+
+public:
+  enum {
+    DEFAULT_DOGS        = 10000,        // default number of dogs to generate
+    DEFAULT_SEED        = 1234,         // default random number seed
+    FIRST_YEAR          = 2000,         // oldest acquisition date we generate
+    //   Work phones are the main number of one of a few companies, so lots
+    // of unrelated adopters share them (just like the real DIR).  The offsets
+    // keep the work and cell phones from matching some adopter's home phone,
+    // at least for the first few tens of thousands of adopters ...
+    WORK_SWITCHBOARDS   = 50,           // number of different work phones
+    WORK_PHONE_OFFSET   = 46667,        // adopter offset for work phones
+    CELL_PHONE_OFFSET   = 93333,        //   "      "     "  cell   "
+  };
+
+  // This is everything we know about one synthetic dog ...
+  struct DOG {
+    uint32_t  nNumber;                  // NGRR dog number
+    string    sName;                    // dog's name
+    string    sChip;                    // microchip (may be blank or bogus)
+    uint32_t  nYear, nMonth, nDay;      // date acquired
+    uint32_t  nAgeYears, nAgeMonths;    // age when acquired
+    bool      fMale;                    // sex
+    uint32_t  nStatus;                  // index into the status table
+    uint32_t  nAdopter;                 // adopter index (0 -> not adopted)
+    string    sDisposition;             // disposition date, if any
+    uint32_t  nArea;                    // NGRR area index
+    uint32_t  nDirty;                   // DIRTY_xxx bits for this dog
+  };
+  // Kinds of garbage we know how to inject ...
+  enum {
+    DIRTY_PHONE         = 0x0001,       // odd phone number formats
+    DIRTY_EQUALS        = 0x0002,       // Excel ="..." fields
+    DIRTY_ZIP           = 0x0004,       // bad zip codes
+    DIRTY_DUP_CHIP      = 0x0008,       // same chip as some other dog
+    DIRTY_OLD_CHIP      = 0x0010,       // legacy nnn*nnn*nnn chips
+    DIRTY_NULL_DATE     = 0x0020,       // "0000-00-00" dates
+    DIRTY_EMAIL         = 0x0040,       // misspelled email domains
+    DIRTY_AGE           = 0x0080,       // ages not in "N Years M Months"
+    DIRTY_STATE         = 0x0100,       // blank or lower case states
+  };
+
+public:
+  // Constructor and destructor ...
+  CDIRGenerator();
+  virtual ~CDIRGenerator() {};
+  // Copy and assignment constructors ...
+  CDIRGenerator (const CDIRGenerator &gen) = delete;
+  CDIRGenerator& operator= (const CDIRGenerator &gen) = delete;
+
+  // CDIRGenerator public properties ...
+public:
+  // Set the number of dogs in the NEW report ...
+  void SetDogCount (size_t nDogs) {m_nDogs = nDogs;}
+  size_t GetDogCount() const {return m_nDogs;}
+  // Set the cutoff year and the percentage of dogs acquired on or after it ...
+  void SetCutoffYear (uint32_t nYear) {m_nCutoffYear = nYear;}
+  void SetRecentPercent (uint32_t nPct) {m_nRecentPct = nPct;}
+  // Set the churn between the old and new reports ...
+  void SetAcquirePercent (uint32_t nPct) {m_nAcquirePct = nPct;}
+  void SetAdoptPercent (uint32_t nPct) {m_nAdoptPct = nPct;}
+  void SetReturnPercent (uint32_t nPct) {m_nReturnPct = nPct;}
+  void SetDeathPercent (uint32_t nPct) {m_nDeathPct = nPct;}
+  // Set the percentage of fields that get dirty data injected ...
+  void SetDirtyPercent (uint32_t nPct) {m_nDirtyPct = nPct;}
+  // Set the random number seed (same seed -> same files) ...
+  void SetSeed (uint64_t nSeed) {m_nSeed = nSeed;}
+  // Select the DIR layout (true -> 36 column, false -> 35 column) ...
+  void SetFormats (bool fOldNew, bool fNewNew) {m_fOldFormat = fOldNew;  m_fNewFormat = fNewNew;}
+
+  // CDIRGenerator public methods ...
+public:
+  // Generate both the old and new DIR files ...
+  void Generate (const string &sOldFile, const string &sNewFile);
+  // Generate only the dogs (but don't write anything) ...
+  void GenerateDogs (vector<DOG> &vecOld, vector<DOG> &vecNew);
+  // Write a collection of dogs to a DIR file ...
+  uint64_t WriteFile (const string &sFileName, const vector<DOG> &vecDogs, bool fNew);
+  size_t Write (ostream &stm, const vector<DOG> &vecDogs, bool fNew);
+  // Convert one synthetic dog to a DIR row ...
+  void ToRow (const DOG &dog, CCSVRow &row, bool fNew);
+
+  // Private internal CDIRGenerator methods ...
+protected:
+  // Return true nPct percent of the time ...
+  bool Chance (uint32_t nPct) {return (m_rng() % 10000) < (nPct*100);}
+  // Return true if this field should be dirty ...
+  bool Dirty() {return Chance(m_nDirtyPct);}
+  // Return a random integer 0..n-1 ...
+  uint32_t Random (uint32_t n) {return (uint32_t) (m_rng() % n);}
+  // Pick a random string from a table ...
+  const char *Pick (const char *const *ppsz, size_t n) {return ppsz[Random((uint32_t) n)];}
+  // Make up all the various fields ...
+  void NewDog (DOG &dog, uint32_t nNumber, uint32_t nYear);
+  void Adopt (DOG &dog, uint32_t nYear);
+  uint32_t MakeDirt();
+  string MakeChip (uint32_t nDirty);
+  static string MakePhone (uint32_t nAdopter, uint32_t nDirty);
+  static string MakeZip (uint32_t nAdopter, uint32_t nDirty);
+  static string MakeeMail (uint32_t nAdopter, uint32_t nDirty);
+  static string MakeAge (const DOG &dog);
+  static string MakeDate (uint32_t nYear, uint32_t nMonth, uint32_t nDay);
+  // Excel's ="..." convention ...
+  static string Equals (const string &str) {return "=\"" + str + "\"";}
+  // Format one row exactly the way the NGRR web page does ...
+  static string FormatRow (const CCSVRow &row);
+
+  // Local CDIRGenerator members ...
+protected:
+  size_t          m_nDogs;              // number of dogs in the new report
+  uint32_t        m_nCutoffYear;        // cutoff year for "recent" dogs
+  uint32_t        m_nRecentPct;         // percent acquired after the cutoff
+  uint32_t        m_nAcquirePct;        // percent of new dogs not in the old DIR
+  uint32_t        m_nAdoptPct;          // percent adopted since the old DIR
+  uint32_t        m_nReturnPct;         // percent returned since the old DIR
+  uint32_t        m_nDeathPct;          // percent died since the old DIR
+  uint32_t        m_nDirtyPct;          // percent of dirty fields
+  uint64_t        m_nSeed;              // random number seed
+  bool            m_fOldFormat;         // true if the old DIR is 36 columns
+  bool            m_fNewFormat;         //   "   "  "  new  "   "  "    "
+  std::mt19937_64 m_rng;                // random number generator
+  vector<string>  m_vecChips;           // chips handed out so far (for dups)
+};
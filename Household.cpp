@@ -0,0 +1,415 @@
+//++
+// Household.cpp - implementation of the CHouseholds class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CHouseholds class, which groups adopters into
+// households.  See Household.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Add AddAdopter() and SetAdopter() for CPartitions.
+// 17-Oct-26  AGT   Don't let weak keys chain households together.
+// 17-Oct-26  AGT   Add ReadFile() for the households that CShards finds.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <ctype.h>              // isalpha(), toupper() ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <algorithm>            // std::min(), std::max() ...
+#include <functional>           // std::hash ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "Household.hpp"        // declarations for this module
+
+// The header row for a file of households (see CShards) ...
+const string CHouseholds::m_sColumnHeaders("DIR, Number, Household");
+
+//   Common street address words and their USPS abbreviations.  It's not the
+// whole USPS list by a long shot, but it covers most of what we see ...
+static const struct {
+  const char *pszWord;          // the word as people type it
+  const char *pszAbbreviation;  // and the standard abbreviation
+} g_aAddressWords[] = {
+  {"street", "st"},     {"avenue", "ave"},    {"av", "ave"},        {"road", "rd"},
+  {"drive", "dr"},      {"lane", "ln"},       {"court", "ct"},      {"place", "pl"},
+  {"boulevard", "blvd"},{"circle", "cir"},    {"way", "wy"},        {"terrace", "ter"},
+  {"highway", "hwy"},   {"parkway", "pkwy"},  {"apartment", "apt"}, {"suite", "ste"},
+  {"north", "n"},       {"south", "s"},       {"east", "e"},        {"west", "w"},
+  {NULL, NULL}
+};
+
+//   Email addresses that people type when they don't want to give us one.
+// The first list is the part before the "@" and the second is the domain ...
+static const char *g_apszPlaceholderUsers[] = {
+  "none", "noemail", "no", "na", "n/a", "nobody", "unknown", "test",
+  "noreply", "no-reply", "donotreply", "x", "xx", "xxx", NULL
+};
+static const char *g_apszPlaceholderDomains[] = {
+  "none.com", "noemail.com", "example.com", "test.com", "na.com", NULL
+};
+
+
+/*static*/ string CHouseholds::AddressKey (const CDog *pDog)
+{
+  //++
+  //   Return the address key for an adopter, which is the street address
+  // broken into words, with punctuation removed and the common words like
+  // "Street" abbreviated, plus the 5 digit zip code.  If either the address
+  // or the zip is missing then there's no key ...
+  //--
+  string sZip = pDog->GetAdoptionZip().substr(0, 5);
+  if (sZip.length() != 5) return string("");
+  string sAddress = pDog->GetAdoptionAddress(), sKey, sWord;
+  for (size_t i = 0;  i <= sAddress.length();  ++i) {
+    if ((i < sAddress.length()) && isalnum((unsigned char) sAddress[i])) {
+      sWord.push_back((char) ::tolower((unsigned char) sAddress[i]));  continue;
+    }
+    if (sWord.empty()) continue;
+    for (size_t j = 0;  g_aAddressWords[j].pszWord != NULL;  ++j)
+      if (sWord == g_aAddressWords[j].pszWord) {sWord = g_aAddressWords[j].pszAbbreviation;  break;}
+    sKey += sWord + " ";  sWord.clear();
+  }
+  if (sKey.empty()) return string("");
+  return "a:" + sKey + sZip;
+}
+
+
+/*static*/ string CHouseholds::PhoneKey (const string &sPhone)
+{
+  //++
+  //   Return the key for a phone number, which is just the last ten digits.
+  // Anything with fewer than ten digits isn't a usable phone number ...
+  //--
+  string sDigits;
+  for (string::const_iterator it = sPhone.begin();  it != sPhone.end();  ++it)
+    if (isdigit((unsigned char) *it)) sDigits.push_back(*it);
+  if (sDigits.length() < 10) return string("");
+  sDigits = sDigits.substr(sDigits.length()-10);
+  if (IsPlaceholderPhone(sDigits)) return string("");
+  return "p:" + sDigits;
+}
+
+
+/*static*/ bool CHouseholds::IsPlaceholderPhone (const string &sDigits)
+{
+  //++
+  //   Return true if a ten digit phone number is obviously fake - all the
+  // same digit ("000-000-0000"), a run ("123-456-7890") or one of the 555
+  // numbers that the movies use ...
+  //--
+  if (sDigits.length() != 10) return true;
+  if (sDigits.find_first_not_of(sDigits[0]) == string::npos) return true;
+  if ((sDigits == "1234567890") || (sDigits == "0123456789") || (sDigits == "9876543210")) return true;
+  if (sDigits.compare(3, 3, "555") == 0) return true;
+  return false;
+}
+
+
+/*static*/ bool CHouseholds::IsPlaceholdereMail (const string &seMail)
+{
+  //++
+  //   Return true if a (lower case) email address is one of the usual "I
+  // don't have one" addresses ...
+  //--
+  size_t nAt = seMail.find('@');
+  string sUser = seMail.substr(0, nAt), sDomain = seMail.substr(nAt+1);
+  for (size_t i = 0;  g_apszPlaceholderUsers[i] != NULL;  ++i)
+    if (sUser == g_apszPlaceholderUsers[i]) return true;
+  for (size_t i = 0;  g_apszPlaceholderDomains[i] != NULL;  ++i)
+    if (sDomain == g_apszPlaceholderDomains[i]) return true;
+  return false;
+}
+
+
+/*static*/ string CHouseholds::eMailKey (const CDog *pDog)
+{
+  //++
+  // Return the key for an email address, which is the address in lower case ...
+  //--
+  string sRaw = pDog->GetAdoptioneMail(), seMail;
+  for (string::const_iterator it = sRaw.begin();  it != sRaw.end();  ++it)
+    seMail.push_back((char) ::tolower((unsigned char) *it));
+  size_t nFirst = seMail.find_first_not_of(" \t"), nLast = seMail.find_last_not_of(" \t");
+  if (nFirst == string::npos) return string("");
+  seMail = seMail.substr(nFirst, nLast-nFirst+1);
+  if (seMail.find('@') == string::npos) return string("");
+  if (IsPlaceholdereMail(seMail)) return string("");
+  return "e:" + seMail;
+}
+
+
+/*static*/ string CHouseholds::Soundex (const string &sName)
+{
+  //++
+  //   Return the classic American Soundex code (e.g. "R163" for "Robert") for
+  // a name.  Non-letters are ignored.  Remember the two odd rules - letters
+  // with the same code separated by "H" or "W" are coded once, but vowels in
+  // between DO separate them.  And the first letter is kept as is ...
+  //--
+  //                               ABCDEFGHIJKLMNOPQRSTUVWXYZ
+  static const char *pszCodes   = "01230120022455012623010202";
+  string sCode;  char chLast = 0;
+  for (string::const_iterator it = sName.begin();  (it != sName.end()) && (sCode.length() < 4);  ++it) {
+    if (!isalpha((unsigned char) *it)) continue;
+    char ch = (char) ::toupper((unsigned char) *it);
+    char chCode = pszCodes[ch-'A'];
+    if (sCode.empty()) {
+      sCode.push_back(ch);
+    } else if ((chCode != '0') && (chCode != chLast)) {
+      sCode.push_back(chCode);
+    }
+    if ((ch != 'H') && (ch != 'W')) chLast = chCode;
+  }
+  if (sCode.empty()) return sCode;
+  while (sCode.length() < 4) sCode.push_back('0');
+  return sCode;
+}
+
+
+/*static*/ string CHouseholds::NameKey (const CDog *pDog)
+{
+  //++
+  //   Return the phonetic name key, which is the Soundex code for the last
+  // and first names plus the 5 digit zip code.  This catches typos that were
+  // fixed ("Jon Smyth" vs "John Smith") but not nicknames - "Bob" and "Robert"
+  // don't sound anything alike!  Those have to match on one of the other keys.
+  // This key is too loose to merge households with (see SameHousehold()) ...
+  //--
+  string sZip = pDog->GetAdoptionZip().substr(0, 5);
+  string sLast = Soundex(pDog->GetAdoptionLName());
+  string sFirst = Soundex(pDog->GetAdoptionFName());
+  if (sLast.empty() || sFirst.empty() || (sZip.length() != 5)) return string("");
+  return "n:" + sLast + sFirst + "|" + sZip;
+}
+
+
+/*static*/ uint64_t CHouseholds::NameKeyHash (const CDog *pDog)
+{
+  //++
+  //   Return a hash of the phonetic name key, which is all SameHousehold()
+  // needs.  Zero means there isn't one, so a real key never hashes to that ...
+  //--
+  string sNameKey = NameKey(pDog);
+  if (sNameKey.empty()) return 0;
+  uint64_t nNameKey = (uint64_t) std::hash<string>()(sNameKey);
+  return (nNameKey == 0) ? 1 : nNameKey;
+}
+
+
+uint32_t CHouseholds::FindRoot (uint32_t nAdopter)
+{
+  //++
+  // Find the root of an adopter's set, with path halving along the way ...
+  //--
+  while (m_vecParent[nAdopter] != nAdopter) {
+    m_vecParent[nAdopter] = m_vecParent[m_vecParent[nAdopter]];
+    nAdopter = m_vecParent[nAdopter];
+  }
+  return nAdopter;
+}
+
+
+void CHouseholds::AddKey (uint32_t nAdopter, uint64_t nName, const string &sKey)
+{
+  //++
+  //   If this key has been seen before, then remember to merge this adopter
+  // with the first one that had it, and count this adopter's name if it's a
+  // new one.  Otherwise this adopter is the first one with the key.  Once a
+  // key has more than MAX_KEY_NAMES names we stop counting - it's no good ...
+  //--
+  if (sKey.empty()) return;
+  unordered_map<string, uint32_t>::const_iterator it = m_mapKeys.find(sKey);
+  if (it == m_mapKeys.end()) {
+    KEY key;  key.nFirst = nAdopter;  key.nNames = 1;  key.anNames[0] = nName;
+    m_mapKeys[sKey] = (uint32_t) m_vecKeys.size();  m_vecKeys.push_back(key);
+    return;
+  }
+  KEY &key = m_vecKeys[it->second];
+  if (key.nNames <= MAX_KEY_NAMES) {
+    uint32_t i = 0;
+    while ((i < key.nNames) && (key.anNames[i] != nName)) ++i;
+    if (i == key.nNames) {
+      if (key.nNames < MAX_KEY_NAMES) key.anNames[key.nNames] = nName;
+      ++key.nNames;
+    }
+  }
+  m_vecLinks.push_back(std::make_pair(nAdopter, it->second));
+}
+
+
+void CHouseholds::Add (const CDog *pDog)
+{
+  //++
+  //   Add one dog's adopter to the index.  Dogs with no adopter name are
+  // ignored, and so is a dog that's already been added ...
+  //--
+  if (m_mapAdopter.find(pDog) != m_mapAdopter.end()) return;
+  uint32_t nAdopter = AddAdopter(pDog);
+  if (nAdopter != NOHOUSEHOLD) m_mapAdopter[pDog] = nAdopter;
+}
+
+
+uint32_t CHouseholds::AddAdopter (const CDog *pDog)
+{
+  //++
+  //   Add one dog's adopter and return its adopter number, but don't remember
+  // which dog it came from.  CPartitions uses this for dogs that are only in
+  // memory for a moment, and tells us later with SetAdopter().  Returns
+  // NOHOUSEHOLD if the dog has no adopter name ...
+  //--
+  if (pDog->GetAdoptionFName().empty() && pDog->GetAdoptionLName().empty()) return NOHOUSEHOLD;
+  uint32_t nAdopter = (uint32_t) m_vecParent.size();
+  m_vecParent.push_back(nAdopter);
+  //   The name that's counted for each key is the whole name, in lower case.
+  // The Soundex key is only kept as a hash - zero means there isn't one ...
+  string sName = pDog->GetAdoptionLName() + "|" + pDog->GetAdoptionFName();
+  for (size_t i = 0;  i < sName.length();  ++i) sName[i] = (char) ::tolower((unsigned char) sName[i]);
+  uint64_t nName = (uint64_t) std::hash<string>()(sName);
+  AddKey(nAdopter, nName, AddressKey(pDog));
+  AddKey(nAdopter, nName, PhoneKey(pDog->GetAdoptionHomePhone()));
+  AddKey(nAdopter, nName, PhoneKey(pDog->GetAdoptionCellPhone()));
+  AddKey(nAdopter, nName, eMailKey(pDog));
+  m_vecNameKey.push_back(NameKeyHash(pDog));
+  return nAdopter;
+}
+
+
+void CHouseholds::Add (const CDogs &Dogs)
+{
+  //++
+  // Add all the adopters from a DIR ...
+  //--
+  TRACE_SCOPE("households");
+  for (CDogs::dog_number_const_iterator it = Dogs.dog_begin();  it != Dogs.dog_end();  ++it)
+    Add(it->second);
+}
+
+
+void CHouseholds::Build()
+{
+  //++
+  //   Merge the adopters that share a good key, then flatten the union-find
+  // sets and number the households consecutively.  After this GetHousehold()
+  // doesn't need to chase any pointers.  The keys aren't needed any more, so
+  // free them too ...
+  //--
+  size_t nIgnored = 0;
+  for (vector<KEY>::const_iterator it = m_vecKeys.begin();  it != m_vecKeys.end();  ++it)
+    if (it->nNames > MAX_KEY_NAMES) ++nIgnored;
+  for (size_t i = 0;  i < m_vecLinks.size();  ++i) {
+    const KEY &key = m_vecKeys[m_vecLinks[i].second];
+    if (key.nNames > MAX_KEY_NAMES) continue;
+    uint32_t nRoot1 = FindRoot(m_vecLinks[i].first), nRoot2 = FindRoot(key.nFirst);
+    if (nRoot1 != nRoot2) m_vecParent[std::max(nRoot1, nRoot2)] = std::min(nRoot1, nRoot2);
+  }
+  vector<uint32_t> vecNumber(m_vecParent.size(), NOHOUSEHOLD);
+  m_vecHousehold.assign(m_vecParent.size(), NOHOUSEHOLD);
+  m_vecSize.clear();
+  for (uint32_t i = 0;  i < m_vecParent.size();  ++i) {
+    uint32_t nRoot = FindRoot(i);
+    if (vecNumber[nRoot] == NOHOUSEHOLD) {
+      vecNumber[nRoot] = (uint32_t) m_vecSize.size();  m_vecSize.push_back(0);
+    }
+    m_vecHousehold[i] = vecNumber[nRoot];  ++m_vecSize[vecNumber[nRoot]];
+  }
+  m_nHouseholds = m_vecSize.size();
+  m_mapKeys.clear();  m_vecKeys.clear();  m_vecLinks.clear();
+  MSGS("Found " << AdopterCount() << " adopters in " << HouseholdCount() << " households");
+  if (nIgnored > 0) MSGS("Ignored " << nIgnored << " addresses, phones and emails shared by too many adopters");
+}
+
+
+uint32_t CHouseholds::GetAdopter (const CDog *pDog) const
+{
+  //++
+  //   Return the adopter number for this dog, or NOHOUSEHOLD if the dog has
+  // no adopter (or wasn't added, or Build() hasn't been called) ...
+  //--
+  unordered_map<const CDog *, uint32_t>::const_iterator it = m_mapAdopter.find(pDog);
+  if ((it == m_mapAdopter.end()) || (it->second >= m_vecHousehold.size())) return NOHOUSEHOLD;
+  return it->second;
+}
+
+
+uint32_t CHouseholds::GetHousehold (const CDog *pDog) const
+{
+  //++
+  //   Return the household number for this dog's adopter, or NOHOUSEHOLD if
+  // the dog doesn't have one ...
+  //--
+  uint32_t nAdopter = GetAdopter(pDog);
+  return (nAdopter != NOHOUSEHOLD) ? m_vecHousehold[nAdopter] : NOHOUSEHOLD;
+}
+
+
+bool CHouseholds::SameHousehold (const CDog *pDog1, const CDog *pDog2) const
+{
+  //++
+  //   Return true if both dogs were adopted by the same household - either
+  // the two adopters were merged by Build(), or they have the same Soundex
+  // name key.  The latter is just between these two - it doesn't say anything
+  // about the rest of either household ...
+  //--
+  uint32_t n1 = GetAdopter(pDog1), n2 = GetAdopter(pDog2);
+  if ((n1 == NOHOUSEHOLD) || (n2 == NOHOUSEHOLD)) return false;
+  if (m_vecHousehold[n1] == m_vecHousehold[n2]) return true;
+  return (m_vecNameKey[n1] != 0) && (m_vecNameKey[n1] == m_vecNameKey[n2]);
+}
+
+
+void CHouseholds::ReadFile (const string &sFileName, const CDogs &OldDogs, const CDogs &NewDogs)
+{
+  //++
+  //   Read the households for one shard, as written by CShards::Split().  The
+  // household numbers are the ones for the whole DIR pair, so two adopters
+  // are the same household here exactly when they would have been in a
+  // single run, even if whatever tied them together went to another shard.
+  // The Soundex name keys only ever compare a dog with itself, so those are
+  // still computed from our own dogs.  A dog that isn't in this shard (or
+  // was rejected by CDogs) is just ignored.  Note that the household sizes
+  // only count the adopters in this shard ...
+  //--
+  CCSVFile csv;
+  csv.Read(sFileName, m_sColumnHeaders);
+  m_mapAdopter.clear();  m_vecParent.clear();  m_vecHousehold.clear();
+  m_vecNameKey.clear();  m_vecSize.clear();  m_nHouseholds = 0;
+  for (size_t i = 0;  i < csv.size();  ++i) {
+    const CCSVRow &row = *csv[i];  uint32_t nOrg, nNumber;
+    if ((row.size() != 3) || ((row[0] != "old") && (row[0] != "new"))
+        || !CDog::ParseDogID(row[1], nOrg, nNumber)
+        || row[2].empty() || (row[2].find_first_not_of("0123456789") != string::npos))
+      ERRS("CHouseholds::ReadFile() bad household in row " << (i+2) << " of " << sFileName);
+    const CDog *pDog = ((row[0] == "old") ? OldDogs : NewDogs).Find(CDog::MakeKey(nOrg, nNumber));
+    if ((pDog == NULL) || (m_mapAdopter.find(pDog) != m_mapAdopter.end())) continue;
+    uint32_t nHousehold = (uint32_t) strtoul(row[2].c_str(), NULL, 10);
+    uint32_t nAdopter = (uint32_t) m_vecParent.size();
+    m_vecParent.push_back(nAdopter);  m_vecHousehold.push_back(nHousehold);
+    m_vecNameKey.push_back(NameKeyHash(pDog));  m_mapAdopter[pDog] = nAdopter;
+    if (nHousehold >= m_vecSize.size()) m_vecSize.resize(nHousehold+1, 0);
+    ++m_vecSize[nHousehold];
+  }
+  m_nHouseholds = m_vecSize.size();
+  MSGS("Read " << AdopterCount() << " adopters in " << HouseholdCount() << " households from " << sFileName);
+}
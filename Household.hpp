@@ -0,0 +1,177 @@
+//++
+// Household.hpp -> group adopters into households
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The CHouseholds class groups the adopters recorded in one or more DIRs
+// into households.  Two adopter records belong to the same household if they
+// share ANY of these keys -
+//
+//      * the normalized street address plus the 5 digit zip code
+//      * the home or cell phone number (just the ten digits)
+//      * the email address (ignoring case)
+//
+// and households are transitive - if A shares a phone with B and B shares an
+// address with C, then A, B and C are all one household.  That takes care of
+// "Bob" vs "Robert", a new cell phone, and so on.
+//
+//   Because it's transitive, one bad key can chain a whole lot of unrelated
+// adopters together, and then the "adopting family changed" rule goes quiet
+// for all of them.  So -
+//
+//      * work phones aren't keys at all.  Everybody at the same employer can
+//        have the same switchboard number.
+//
+//      * placeholder phone numbers and email addresses (e.g. "000-000-0000"
+//        or "none@none.com") aren't keys either.
+//
+//      * a key that's shared by more than MAX_KEY_NAMES different adopter
+//        names is ignored.  A real household has a couple of people in it
+//        (plus the odd nickname), not a dozen.
+//
+//      * the Soundex codes of the last and first names plus the 5 digit zip
+//        code don't merge anything.  They only make the two adopters that
+//        have them the same household (so that a typo that got fixed, "Jon
+//        Smyth" vs "John Smith", isn't a family change), but that doesn't
+//        carry over to anybody else in either household.
+//
+//   CShards finds the households for the whole DIR pair when it splits it,
+// since no one shard has every adopter.  It writes each shard's dogs and
+// their households to a file (see m_sColumnHeaders), and the update run for
+// that shard reads it with ReadFile() instead of building its own.
+//
+//   Everything is collected in one pass over the dogs.  Each key is hashed,
+// and the first adopter with a given key becomes the representative for it.
+// The merges have to wait for Build(), when we know how many names share
+// every key, and then they're done with a union-find (aka disjoint set)
+// structure.  At the end the sets are flattened, so asking whether two dogs'
+// adopters are the same household is just a couple of lookups.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add AddAdopter() and SetAdopter() for CPartitions.
+// 17-OCT-26  AGT   Don't let weak keys chain households together.
+// 17-OCT-26  AGT   Add ReadFile() for the households that CShards finds.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include "Dog.hpp"              // CDog data and CDogs collection
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::unordered_map;       // ...
+
+
+class CHouseholds {
+  //++
+  // Adopter household index ...
+  //--
+
+public:
+  enum {
+    NOHOUSEHOLD         = 0xFFFFFFFF,   // dog has no adopter recorded
+    MAX_KEY_NAMES       = 4,            // most different names that can share a key
+  };
+  //   The header row for a file of households, which has the DIR ("old" or
+  // "new"), the dog number and the household for every dog with an adopter ...
+  static const string m_sColumnHeaders;
+
+public:
+  // Constructor and destructor ...
+  CHouseholds() {m_nHouseholds = 0;}
+  CHouseholds (const CDogs &OldDogs, const CDogs &NewDogs)
+    {m_nHouseholds = 0;  Add(OldDogs);  Add(NewDogs);  Build();}
+  virtual ~CHouseholds() {};
+  // Copy and assignment constructors ...
+  CHouseholds (const CHouseholds &h) = delete;
+  CHouseholds& operator= (const CHouseholds &h) = delete;
+
+  // CHouseholds public properties ...
+public:
+  // Return the number of adopters and households ...
+  size_t AdopterCount() const {return m_vecParent.size();}
+  size_t HouseholdCount() const {return m_nHouseholds;}
+  // Return the household for a dog's adopter (or NOHOUSEHOLD) ...
+  uint32_t GetHousehold (const CDog *pDog) const;
+  // Return the number of adopter records in a household ...
+  size_t GetHouseholdSize (uint32_t nHousehold) const
+    {return (nHousehold < m_vecSize.size()) ? m_vecSize[nHousehold] : 0;}
+  // Return true if both dogs were adopted by the same household ...
+  bool SameHousehold (const CDog *pDog1, const CDog *pDog2) const;
+  // Return the household for an adopter number (after Build()) ...
+  uint32_t GetAdopterHousehold (uint32_t nAdopter) const
+    {return (nAdopter < m_vecHousehold.size()) ? m_vecHousehold[nAdopter] : NOHOUSEHOLD;}
+
+  // CHouseholds public methods ...
+public:
+  // Add all the adopters from a DIR ...
+  void Add (const CDogs &Dogs);
+  // Add one adopter ...
+  void Add (const CDog *pDog);
+  // Add one adopter without remembering the dog, and return its number ...
+  uint32_t AddAdopter (const CDog *pDog);
+  // Say which adopter a dog has, or forget all the dogs (see CPartitions) ...
+  void SetAdopter (const CDog *pDog, uint32_t nAdopter) {m_mapAdopter[pDog] = nAdopter;}
+  void ForgetDogs() {m_mapAdopter.clear();}
+  // Assign the final household numbers (call after the last Add()!) ...
+  void Build();
+  // Use the households from a file instead of Add() and Build() ...
+  void ReadFile (const string &sFileName, const CDogs &OldDogs, const CDogs &NewDogs);
+  // Return the keys for one adopter ...
+  static string AddressKey (const CDog *pDog);
+  static string PhoneKey (const string &sPhone);
+  static bool IsPlaceholderPhone (const string &sDigits);
+  static bool IsPlaceholdereMail (const string &seMail);
+  static string eMailKey (const CDog *pDog);
+  static string NameKey (const CDog *pDog);
+  static uint64_t NameKeyHash (const CDog *pDog);
+  // Return the American Soundex code for a name ...
+  static string Soundex (const string &sName);
+
+  // Private internal CHouseholds methods ...
+protected:
+  // Everything we know about one key until Build() ...
+  struct KEY {
+    uint32_t  nFirst;                   // first adopter with this key
+    uint32_t  nNames;                   // number of different names with it
+    uint64_t  anNames[MAX_KEY_NAMES];   // hashes of the first few names
+  };
+  // Remember that an adopter has a key ...
+  void AddKey (uint32_t nAdopter, uint64_t nName, const string &sKey);
+  // Find the root of an adopter's set ...
+  uint32_t FindRoot (uint32_t nAdopter);
+  // Return the adopter number for a dog (or NOHOUSEHOLD) ...
+  uint32_t GetAdopter (const CDog *pDog) const;
+
+  // Local CHouseholds members ...
+protected:
+  unordered_map<const CDog *, uint32_t> m_mapAdopter; // dog -> adopter number
+  unordered_map<string, uint32_t> m_mapKeys;          // key -> index in m_vecKeys
+  vector<KEY>       m_vecKeys;          // all the keys seen so far
+  vector<std::pair<uint32_t, uint32_t> > m_vecLinks;  // (adopter, key) to merge
+  vector<uint64_t>  m_vecNameKey;       // hash of every adopter's Soundex key
+  vector<uint32_t>  m_vecParent;        // union-find parent of every adopter
+  vector<uint32_t>  m_vecHousehold;     // household of every adopter
+  vector<uint32_t>  m_vecSize;          // adopters in every household
+  size_t            m_nHouseholds;      // number of households
+};
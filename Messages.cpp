@@ -24,6 +24,20 @@
 //
 // REVISION HISTORY:
 // 15-Jul-19  RLA   New file.
+// 17-Oct-26  AGT   Really forget the instance in the destructor so that a
+//                  new CBadDogs can be created (e.g. by the benchmark).
+//                  Count bad dogs for CMetrics.
+//                  Classify bad dogs by error code for the metrics.
+//                  Add the similar_chip and reentered error codes.
+//                  Add the zip_state_mismatch and zip_city_mismatch codes.
+//                  Add the email_domain_typo code.
+//                  Add AddRawRows().
+//                  An empty file name means just collect the errors.
+//                  Use the dog ID, which may have an organization prefix.
+//                  Keep one instance per thread for batch runs.
+//                  Add an AddError() that doesn't need a CDog.
+//                  AddRawRows() looks up prefixed dog IDs too.
+//                  The destructor no longer writes the file.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -32,41 +46,91 @@
 #include <stdarg.h>             // va_start(), va_end(), et al ...
 #include <assert.h>             // assert() (what else??)
 #include <iostream>             // std::ios, std::istream, std::cout
+#include <algorithm>            // std::find() ...
 #include "Messages.hpp"         // declarations for this module ...
 #include "CSVRow.hpp"           // CSV file row object
 #include "CSVFile.hpp"          // a collection of spreadsheet rows
 #include "Dog.hpp"              // dog data definitions
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "RowIndex.hpp"         // sidecar row offset index
+#include "Encoding.hpp"         // UTF-8 normalization
 
 
 // Initialize all the static members of CBadDogs ...
-CBadDogs *CBadDogs::m_pBadDogs = NULL;
-string    CBadDogs::m_sFileName("");
+thread_local CBadDogs *CBadDogs::m_pBadDogs = NULL;
 const string CBadDogs::m_sColumnHeaders("Name,Number,Contact Member,Error");
+const string CBadDogs::m_sRawColumnHeaders("Name,Number,Contact Member,Error,Raw Row");
+
+//   This table is used to classify bad dog messages into error codes for the
+// metrics (e.g. "errors by code" on the dashboards).  Each message is checked
+// against the table from the top down and the first entry whose text appears
+// anywhere in the message wins.  The messages that contain dog data (names,
+// phone numbers, etc) are listed first, so that the data can't confuse us.
+// Anything that doesn't match is an "other" error - if that number starts to
+// get big, somebody added a new BADDOGS() and forgot to update this table!
+static const struct {
+  const char *pszText;          // text that appears in the message
+  const char *pszCode;          // and the corresponding error code
+} g_aErrorCodes[] = {
+  {"doesn't match dog data",                    "chip_data_mismatch"},
+  {"invalid dog number",                        "invalid_dog_number"},
+  {"duplicate microchip",                       "duplicate_chip"},
+  {"have the same microchip",                   "duplicate_chip"},
+  {"is similar to microchip",                   "similar_chip"},
+  {"already in collection",                     "duplicate_dog"},
+  {"microchip number changed",                  "chip_changed"},
+  {"but is not found in new dog report",        "missing_dog"},
+  {"may have been re-entered as",               "reentered"},
+  {"but no adopting party is recorded",         "no_adopter"},
+  {"adopting party is recorded but status is",  "adopter_not_adopted"},
+  {"disposition date is",                       "disposition_status"},
+  {"adopting family changed",                   "family_changed"},
+  {"no microchip number recorded",              "no_chip"},
+  {"should have a microchip",                   "no_chip"},
+  {"requires update but has no microchip",      "no_chip"},
+  {"zip code cannot be blank",                  "blank_zip"},
+  {"invalid zip code",                          "invalid_zip"},
+  {"email address cannot be blank",             "blank_email"},
+  {"invalid email address",                     "invalid_email"},
+  {"may be misspelled",                         "email_domain_typo"},
+  {"invalid state",                             "invalid_state"},
+  {"doesn't match state",                       "zip_state_mismatch"},
+  {"doesn't match zip code",                    "zip_city_mismatch"},
+  {"invalid sex",                               "invalid_sex"},
+  {"invalid spay/neuter",                       "invalid_spay_neuter"},
+  {"has no valid DOB",                          "invalid_dob"},
+  {"adoption information should be blank",      "unexpected_adoption"},
+  {"no acquisition date recorded",              "no_acquisition_date"},
+  {" phone \"",                                 "invalid_phone"},
+  {NULL,                                        "other"}
+};
 
 
 CBadDogs::CBadDogs(const string sFileName) : CCSVFile()
 {
   //++
-  //   CBadDogs is a singleton class, so only one instance is ever allowed to
-  // exist.  We save a pointer to this instance in the static member m_pBadDogs
-  // so that the AddError() procedure can use it to find that instance.  We 
-  // also save the log file name, which will be used by the destructor to write
-  // out all the stored errors.
+  //   CBadDogs is a singleton class, so only one instance per thread is ever
+  // allowed to exist.  We save a pointer to this instance in the thread local
+  // static member m_pBadDogs so that the AddError() procedure can use it to
+  // find that instance.  We also save the log file name, which WriteFile()
+  // uses when it's not given one.  If the file name is empty then the errors
+  // are only collected (e.g. so that CWhatIf can count them) ...
   //--
   assert(m_pBadDogs == NULL);
-  assert(!sFileName.empty());
-  m_pBadDogs = this;  m_sFileName = sFileName;
+  m_pBadDogs = this;  m_sFileName = sFileName;  m_fRawRows = false;
 }
 
 
 CBadDogs::~CBadDogs()
 {
   //++
-  //   The destructor writes the log to the file name saved by the constructor
-  // and then forgets about this instance ..
+  //   The destructor just forgets about this instance.  It doesn't write the
+  // log - that can fail, and a destructor mustn't throw (especially not while
+  // the stack is being unwound by some other exception!).  Call WriteFile()
+  // first if the errors are wanted ...
   //--
   assert(m_pBadDogs != NULL);
-  WriteFile();
+  m_pBadDogs = NULL;
 }
 
 
@@ -92,13 +156,77 @@ void CBadDogs::AddError (const CDog *pDog, const string sMsg)
   // Add a new bad dog error to this collection ...
   //--
   assert(pDog != NULL);
-  MSGS("dog " << pDog->GetName() << " #" << pDog->GetNumber() << " contact " << pDog->GetResponsiblePerson() << " - " << sMsg);
+  AddError(pDog->GetName(), pDog->GetID(), pDog->GetResponsiblePerson(), sMsg);
+}
+
+
+void CBadDogs::AddError (const string &sName, const string &sID, const string &sContact, const string sMsg)
+{
+  //++
+  //   Same as above, but for when we don't have a CDog object - just the
+  // parts of one that go in the report (CShards keeps only those) ...
+  //--
+  MSGS("dog " << sName << " #" << sID << " contact " << sContact << " - " << sMsg);
   CCSVRow row(TOTAL_COLUMNS);
-  row[COL_DOG_NAME-1]        = pDog->GetName();
-  row[COL_DOG_NUMBER-1]      = std::to_string(pDog->GetNumber());
-  row[COL_CONTACT_MEMBER-1]  = pDog->GetResponsiblePerson();
+  row[COL_DOG_NAME-1]        = sName;
+  row[COL_DOG_NUMBER-1]      = sID;
+  row[COL_CONTACT_MEMBER-1]  = sContact;
   row[COL_MESSAGE-1]         = sMsg;
-  CCSVFile::AddRow(row);
+  CCSVFile::AddRow(row);  METRIC(BAD_DOGS);
+  CMetrics::CountError(Classify(sMsg));
+}
+
+
+/*static*/ const char *CBadDogs::Classify (const string &sMsg)
+{
+  //++
+  //   Return the error code for a bad dog message (e.g. "invalid_zip").  See
+  // the comments for g_aErrorCodes[] ...
+  //--
+  size_t i;
+  for (i = 0;  g_aErrorCodes[i].pszText != NULL;  ++i)
+    if (sMsg.find(g_aErrorCodes[i].pszText) != string::npos) break;
+  return g_aErrorCodes[i].pszCode;
+}
+
+
+/*static*/ vector<string> CBadDogs::GetErrorCodes()
+{
+  //++
+  //   Return a list of all the possible error codes (without duplicates),
+  // including "other".  The exporters use this to report a zero for codes
+  // that didn't happen, so that the time series don't come and go ...
+  //--
+  vector<string> vecCodes;
+  for (size_t i = 0;  ;  ++i) {
+    if (std::find(vecCodes.begin(), vecCodes.end(), g_aErrorCodes[i].pszCode) == vecCodes.end())
+      vecCodes.push_back(g_aErrorCodes[i].pszCode);
+    if (g_aErrorCodes[i].pszText == NULL) break;
+  }
+  return vecCodes;
+}
+
+
+void CBadDogs::AddRawRows (CRowIndex &NewIndex, CRowIndex &OldIndex)
+{
+  //++
+  //   Add a column to every error with the dog's record, exactly as it is in
+  // the new DIR (or the old DIR, if the dog isn't in the new one any more)
+  // but converted to UTF-8 like everything else.  This saves whoever reads
+  // the errors file from having to dig through the DIR to see what's really
+  // there.  It's one seek per error, so it costs next to nothing ...
+  //--
+  for (iterator it = begin();  it != end();  ++it) {
+    CCSVRow *pRow = *it;  string sRaw;
+    uint64_t nKey;
+    if (CRowIndex::ParseKey((*pRow)[COL_DOG_NUMBER-1], nKey) && !NewIndex.ReadRaw(nKey, sRaw))
+      OldIndex.ReadRaw(nKey, sRaw);
+    size_t nConverted;  CEncoding::Normalize(sRaw, nConverted);
+    CCSVRow::COLUMN_VECTOR vecColumns(pRow->begin(), pRow->end());
+    vecColumns.resize(COL_RAW_ROW-1);  vecColumns.push_back(sRaw);
+    *pRow = CCSVRow(vecColumns);
+  }
+  m_fRawRows = true;
 }
 
 
@@ -109,6 +237,6 @@ void CBadDogs::WriteFile (const string &sFileName) const
   // specified, then use the one passed to the constructor ...
   //--
   string sFN = sFileName.empty() ? m_sFileName : sFileName;
-  size_t nDogs = CCSVFile::Write(sFN, m_sColumnHeaders);
+  size_t nDogs = CCSVFile::Write(sFN, m_fRawRows ? m_sRawColumnHeaders : m_sColumnHeaders);
   MSGS("Wrote " << nDogs << " bad dogs to " << sFN);
 }
@@ -36,17 +36,26 @@
 //
 // REVISION HISTORY:
 //  5-JUL-19  RLA   New file.
+// 17-OCT-26  AGT   Add Classify() ...
+// 17-OCT-26  AGT   Add AddRawRows() ...
+// 17-OCT-26  AGT   Allow a CBadDogs with no file ...
+// 17-OCT-26  AGT   One CBadDogs per thread ...
+// 17-OCT-26  AGT   AddError() without a CDog ...
+// 17-OCT-26  AGT   The destructor doesn't write the file ...
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
 #include <string>               // C++ std::string class, et al ...
 #include <iostream>             // C++ style output for LOGS() ...
 #include <sstream>              // C++ std::stringstream, et al ...
+#include <vector>               // C++ std::vector ...
 #include "CSVRow.hpp"           // we need the CSVRow ...
 #include "CSVFile.hpp"          //  ... and CSVFile classes here
 using std::string;              // ...
 using std::ostream;             // ...
+class CRowIndex;                // ...
 using std::ostringstream;       // ...
+using std::vector;              // ...
 class CDog;                     // ...
 
 // Write simple messages to stderr ...
@@ -80,11 +89,14 @@ class CBadDogs : public CCSVFile {
   // is more than enough ...
   //
   //   Moreover, notice that CBadDogs is a singleton class.  There is exactly
-  // one instance of this object in the entire program, and it's used to log
-  // all bad dog errors.  This single instance is created by a call to the
-  // constructor; a pointer to that instance is saved in the static data, and
+  // one instance of this object per thread, and it's used to log all bad dog
+  // errors.  This single instance is created by a call to the constructor; a
+  // pointer to that instance is saved in the (thread local) static data, and
   // instance is deleted by the destructor.  A call to the member AddError()
-  // method implicitly uses this instance.
+  // method implicitly uses this instance.  Normally only the main thread has
+  // one, but each job in a batch run (see CBatch) has its own.  The errors
+  // are saved only by an explicit call to WriteFile() - the destructor never
+  // writes anything.
   //--
 
   // Column numbers for the bad dog report ...
@@ -94,10 +106,12 @@ public:
     COL_DOG_NUMBER			=  2,	// NGRR dog number (guaranteed to be unique!)
     COL_CONTACT_MEMBER		        =  3,	// NGRR member (A/C?) to contact about this dog
     COL_MESSAGE				=  4,	// error message
+    COL_RAW_ROW				=  5,	// DIR row for this dog (optional)
     TOTAL_COLUMNS 			=  4	// number of colums in a bad dog CSV
   };
   // This is the expected header row for the dog information report ...
   static const string m_sColumnHeaders;         // Header row for CSV file
+  static const string m_sRawColumnHeaders;      // ... with the raw DIR rows
 
 public:
   // Constructor and destructor ...
@@ -110,7 +124,7 @@ public:
 
   // CBadDogs collection properties ...
 public:
-  // Return a pointer to the one and only CBadDogs collection ...
+  // Return a pointer to this thread's CBadDogs collection ...
   static CBadDogs *Get() {assert(m_pBadDogs != NULL);  return m_pBadDogs;}
 
   // CBadDogs public methods ...
@@ -119,14 +133,21 @@ public:
   static string Print (const char *pszFormat, ...);
   // Add an error message to this collection ...
   void AddError (const CDog *pDog, const string sMsg);
+  void AddError (const string &sName, const string &sID, const string &sContact, const string sMsg);
   static void AddErrorS (const CDog *pDog, const string sMsg) {Get()->AddError(pDog, sMsg);}
+  // Return the error code (e.g. "invalid_zip") for a bad dog message ...
+  static const char *Classify (const string &sMsg);
+  // Return a list of all the possible error codes ...
+  static vector<string> GetErrorCodes();
+  // Add the raw DIR row for each dog as an extra column ...
+  void AddRawRows (CRowIndex &NewIndex, CRowIndex &OldIndex);
   // Write the error messages to a CSV file ...
   void WriteFile (const string &sFileName="") const;
 
   // Local CBadDogs members ...
 protected:
-  // Note that these members are all STATIC!
-  static CBadDogs *m_pBadDogs;  // the one and only instance of this collection
-  static string    m_sFileName; // CSV file to save the errors 
+  static thread_local CBadDogs *m_pBadDogs;  // this thread's instance
+  string    m_sFileName;        // CSV file to save the errors 
+  bool      m_fRawRows;         // true if AddRawRows() was called
 };
 
@@ -0,0 +1,417 @@
+//++
+// Metrics.cpp - implementation of the CMetrics class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CMetrics class, which collects per phase timing
+// and assorted counters for one run and writes them to a JSON file.  Nothing
+// in here is expensive - bumping a counter is one add and timing a phase is
+// two reads of the clock - so it's always enabled.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Add per phase heap allocation accounting.
+// 17-Oct-26  AGT   Phases are also recorded by CTracer, if it's enabled.
+// 17-Oct-26  AGT   Add errors by code and WritePrometheus().
+// 17-Oct-26  AGT   Add rule_similar_chip.
+// 17-Oct-26  AGT   Add rule_reentered.
+// 17-Oct-26  AGT   Add rule_email_domain.
+// 17-Oct-26  AGT   Add the age_* counters.
+// 17-Oct-26  AGT   Add rows_filtered.
+// 17-Oct-26  AGT   Keep one instance per thread for batch runs.
+// 17-Oct-26  AGT   Don't rename a partly written Prometheus file.
+// 17-Oct-26  AGT   Add GetCurrentRSS().
+// 17-Oct-26  AGT   Record the current RSS and its change for each phase.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <stdio.h>              // snprintf(), rename(), remove() ...
+#include <string.h>             // memset() ...
+#include <assert.h>             // assert() (what else??)
+#include <ctime>                // time(), strftime(), et al ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::filebuf
+#ifdef _WIN32
+#include <windows.h>            // HANDLE, GetCurrentProcess(), etc ...
+#include <psapi.h>              // GetProcessMemoryInfo()
+#else
+#include <sys/resource.h>       // getrusage()
+#include <unistd.h>             // sysconf() ...
+#endif
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "Allocations.hpp"      // heap allocation accounting
+#include "Trace.hpp"            // trace event timeline
+#include "Metrics.hpp"          // declarations for this module
+
+// Initialize all the static members of CMetrics ...
+thread_local CMetrics *CMetrics::m_pMetrics = NULL;
+
+// Names for all the phases and counters (these appear in the JSON file) ...
+static const char *const g_apszPhases[CMetrics::MAXPHASE] = {
+  "read_old", "read_new", "compare", "build_updates", "write_updates", "write_errors"
+};
+static const char *const g_apszCounters[CMetrics::MAXCOUNTER] = {
+  "rows_read", "bytes_read", "bytes_written", "dogs_kept", "dogs_cutoff",
+  "dogs_rejected", "rows_filtered", "old_dogs", "new_dogs", "validations", "bad_dogs", "updates",
+  "age_years_months", "age_abbreviated", "age_years", "age_months", "age_fraction",
+  "age_invalid",
+  "rule_missing", "rule_acquired", "rule_acquired_no_chip", "rule_chip_added",
+  "rule_chip_changed", "rule_adopted_no_adopter", "rule_adopter_not_adopted",
+  "rule_disposition", "rule_family_changed", "rule_adopted", "rule_returned",
+  "rule_similar_chip", "rule_reentered", "rule_email_domain"
+};
+
+
+CMetrics::CMetrics()
+{
+  //++
+  //   Like CBadDogs, this is a singleton class (one instance per thread, at
+  // most).  The constructor remembers the instance and zeros all the
+  // counters ...
+  //--
+  assert(m_pMetrics == NULL);
+  m_pMetrics = this;  m_tCreated = CLOCK::now();
+  for (unsigned i = 0;  i < MAXPHASE;  ++i) {
+    m_adSeconds[i] = 0.0;  m_anPeakRSS[i] = 0;  m_atStart[i] = m_tCreated;
+    m_anStartAllocs[i] = m_anStartBytes[i] = 0;
+    m_anAllocs[i] = m_anAllocBytes[i] = m_anPeakHeap[i] = 0;
+    m_anStartRSS[i] = m_anRSS[i] = 0;  m_anRSSChange[i] = 0;
+  }
+  for (unsigned i = 0;  i < MAXCOUNTER;  ++i) m_anCounters[i] = 0;
+}
+
+
+CMetrics::~CMetrics()
+{
+  //++
+  // Forget about this thread's instance ...
+  //--
+  assert(m_pMetrics == this);
+  m_pMetrics = NULL;
+}
+
+
+/*static*/ const char *CMetrics::PhaseName (PHASE nPhase)
+{
+  assert(nPhase < MAXPHASE);
+  return g_apszPhases[nPhase];
+}
+
+
+/*static*/ const char *CMetrics::CounterName (COUNTER nCounter)
+{
+  assert(nCounter < MAXCOUNTER);
+  return g_apszCounters[nCounter];
+}
+
+
+/*static*/ uint64_t CMetrics::GetPeakRSS()
+{
+  //++
+  //   Return the peak resident set size (aka the "peak working set" in
+  // Windows speak) of this process, in bytes.  Returns zero if we can't
+  // figure it out ...
+  //--
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+  return (uint64_t) pmc.PeakWorkingSetSize;
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+  return ((uint64_t) ru.ru_maxrss) * 1024ULL;
+#endif
+}
+
+
+/*static*/ uint64_t CMetrics::GetCurrentRSS()
+{
+  //++
+  //   Return the current resident set size (the "working set") of this
+  // process, in bytes.  Unlike GetPeakRSS() this can go down as well as up,
+  // so the difference between two calls means something.  On Linux it comes
+  // from /proc/self/statm, and anywhere else that doesn't have it we just
+  // return zero ...
+  //--
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+  return (uint64_t) pmc.WorkingSetSize;
+#else
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (f == NULL) return 0;
+  unsigned long lSize = 0, lResident = 0;
+  int nFields = fscanf(f, "%lu %lu", &lSize, &lResident);
+  fclose(f);
+  if (nFields != 2) return 0;
+  return ((uint64_t) lResident) * ((uint64_t) sysconf(_SC_PAGESIZE));
+#endif
+}
+
+
+double CMetrics::GetTotalSeconds() const
+{
+  //++
+  // Return the elapsed time since this run started ...
+  //--
+  return std::chrono::duration<double>(CLOCK::now() - m_tCreated).count();
+}
+
+
+uint64_t CMetrics::GetErrorCount (const string &sCode) const
+{
+  //++
+  // Return the number of bad dogs with this error code ...
+  //--
+  std::map<string, uint64_t>::const_iterator it = m_mapErrors.find(sCode);
+  return (it == m_mapErrors.end()) ? 0 : it->second;
+}
+
+
+void CMetrics::SetLabel (const string &sName, const string &sValue)
+{
+  //++
+  //   Labels are just name/value strings that are copied to the JSON file
+  // so that we can tell which run it was ...
+  //--
+  m_vecLabels.push_back(LABEL(sName, sValue));
+}
+
+
+/*static*/ void CMetrics::BeginPhase (PHASE nPhase)
+{
+  //++
+  //   Start timing a phase.  If allocations are being counted, then remember
+  // the current counts and start a new high-water mark too.  The current RSS
+  // is remembered so that EndPhase() can tell how much this phase changed
+  // it.  And if we're tracing, the phase goes into the timeline as well ...
+  //--
+  CTracer::Begin(PhaseName(nPhase), CTracer::STAGE);
+  if (m_pMetrics == NULL) return;
+  m_pMetrics->m_anStartAllocs[nPhase] = CAllocations::GetCount();
+  m_pMetrics->m_anStartBytes[nPhase] = CAllocations::GetBytes();
+  m_pMetrics->m_anStartRSS[nPhase] = GetCurrentRSS();
+  CAllocations::ResetPeak();
+  m_pMetrics->m_atStart[nPhase] = CLOCK::now();
+}
+
+
+/*static*/ void CMetrics::EndPhase (PHASE nPhase)
+{
+  //++
+  //   Stop timing a phase.  Note that the time is added to any previous time
+  // for the same phase, just in case somebody runs a phase more than once.
+  //--
+  CTracer::End(PhaseName(nPhase), CTracer::STAGE);
+  if (m_pMetrics == NULL) return;
+  std::chrono::duration<double> dt = CLOCK::now() - m_pMetrics->m_atStart[nPhase];
+  m_pMetrics->m_adSeconds[nPhase] += dt.count();
+  m_pMetrics->m_anPeakRSS[nPhase] = GetPeakRSS();
+  m_pMetrics->m_anRSS[nPhase] = GetCurrentRSS();
+  m_pMetrics->m_anRSSChange[nPhase] += (int64_t) m_pMetrics->m_anRSS[nPhase] - (int64_t) m_pMetrics->m_anStartRSS[nPhase];
+  m_pMetrics->m_anAllocs[nPhase] += CAllocations::GetCount() - m_pMetrics->m_anStartAllocs[nPhase];
+  m_pMetrics->m_anAllocBytes[nPhase] += CAllocations::GetBytes() - m_pMetrics->m_anStartBytes[nPhase];
+  uint64_t nPeak = CAllocations::GetPeakBytes();
+  if (nPeak > m_pMetrics->m_anPeakHeap[nPhase]) m_pMetrics->m_anPeakHeap[nPhase] = nPeak;
+}
+
+
+/*static*/ string CMetrics::JSONString (const string &str)
+{
+  //++
+  //   Quote a string for JSON.  That means escaping quotes, backslashes and
+  // any control characters ...
+  //--
+  string sResult("\"");
+  for (string::const_iterator it = str.begin();  it != str.end();  ++it) {
+    unsigned char ch = (unsigned char) *it;
+    if ((ch == '"') || (ch == '\\')) {
+      sResult.push_back('\\');  sResult.push_back(ch);
+    } else if (ch < ' ') {
+      char sz[8];  snprintf(sz, sizeof(sz), "\\u%04x", ch);  sResult.append(sz);
+    } else
+      sResult.push_back(ch);
+  }
+  sResult.push_back('"');
+  return sResult;
+}
+
+
+void CMetrics::WriteJSON (ostream &stm) const
+{
+  //++
+  //   Write all the metrics to a stream in JSON format.  The layout is flat
+  // and boring on purpose, so that it's easy to pick apart with jq or any
+  // spreadsheet ...
+  //--
+  time_t now;  struct tm tmnow;  char sz[64];
+  time(&now);  localtime_s(&tmnow, &now);
+  strftime(sz, sizeof(sz), "%Y-%m-%dT%H:%M:%S", &tmnow);
+
+  stm << "{\n";
+  stm << "  \"finished\": " << JSONString(sz) << ",\n";
+  for (vector<LABEL>::const_iterator it = m_vecLabels.begin();  it != m_vecLabels.end();  ++it)
+    stm << "  " << JSONString(it->first) << ": " << JSONString(it->second) << ",\n";
+  stm << "  \"total_seconds\": " << GetTotalSeconds() << ",\n";
+  stm << "  \"peak_rss_bytes\": " << GetPeakRSS() << ",\n";
+  stm << "  \"count_allocations\": " << (CAllocations::IsEnabled() ? "true" : "false") << ",\n";
+  stm << "  \"phases\": {\n";
+  for (unsigned i = 0;  i < MAXPHASE;  ++i) {
+    stm << "    " << JSONString(g_apszPhases[i]) << ": {\"seconds\": " << m_adSeconds[i]
+        << ", \"peak_rss_bytes\": " << m_anPeakRSS[i];
+    if (CAllocations::IsEnabled())
+      stm << ", \"allocations\": " << m_anAllocs[i] << ", \"allocated_bytes\": " << m_anAllocBytes[i]
+          << ", \"peak_heap_bytes\": " << m_anPeakHeap[i];
+    stm << "}" << (((i+1) < MAXPHASE) ? ",\n" : "\n");
+  }
+  stm << "  },\n";
+  stm << "  \"counters\": {\n";
+  for (unsigned i = 0;  i < MAXCOUNTER;  ++i) {
+    stm << "    " << JSONString(g_apszCounters[i]) << ": " << m_anCounters[i]
+        << (((i+1) < MAXCOUNTER) ? ",\n" : "\n");
+  }
+  stm << "  },\n";
+  stm << "  \"errors\": {\n";
+  vector<string> vecCodes = CBadDogs::GetErrorCodes();
+  for (vector<string>::const_iterator it = vecCodes.begin();  it != vecCodes.end();  ++it) {
+    stm << "    " << JSONString(*it) << ": " << GetErrorCount(*it)
+        << (((it+1) != vecCodes.end()) ? ",\n" : "\n");
+  }
+  stm << "  }\n";
+  stm << "}\n";
+}
+
+
+void CMetrics::WriteJSON (const string &sFileName) const
+{
+  //++
+  // Same as the above, but handle opening and closing the file too ...
+  //--
+  std::filebuf fb;
+  if (!fb.open(sFileName, std::ios::out))
+    ERRS("CMetrics::WriteJSON() unable to create " << sFileName);
+  std::ostream os(&fb);
+  WriteJSON(os);
+  fb.close();
+  MSGS("Wrote metrics to " << sFileName);
+}
+
+
+
+void CMetrics::WritePrometheus (ostream &stm) const
+{
+  //++
+  //   Write the metrics in the Prometheus text exposition format.  Everything
+  // is a gauge, since each file describes just the one (i.e. the last) run.
+  // Error codes that didn't happen are written with a zero so that the time
+  // series on the dashboards don't come and go from one night to the next.
+  //--
+  double dRead = m_adSeconds[PHASE_READ_OLD] + m_adSeconds[PHASE_READ_NEW];
+  double dBytesPerSecond = (dRead > 0.0) ? (m_anCounters[BYTES_READ] / dRead) : 0.0;
+
+  stm << "# HELP microchipupdate_last_run_timestamp_seconds Time the last run finished.\n";
+  stm << "# TYPE microchipupdate_last_run_timestamp_seconds gauge\n";
+  stm << "microchipupdate_last_run_timestamp_seconds " << (uint64_t) time(NULL) << "\n";
+  stm << "# HELP microchipupdate_duration_seconds Total wall time of the last run.\n";
+  stm << "# TYPE microchipupdate_duration_seconds gauge\n";
+  stm << "microchipupdate_duration_seconds " << GetTotalSeconds() << "\n";
+  stm << "# HELP microchipupdate_phase_duration_seconds Wall time of each phase of the last run.\n";
+  stm << "# TYPE microchipupdate_phase_duration_seconds gauge\n";
+  for (unsigned i = 0;  i < MAXPHASE;  ++i)
+    stm << "microchipupdate_phase_duration_seconds{phase=\"" << g_apszPhases[i] << "\"} " << m_adSeconds[i] << "\n";
+  stm << "# HELP microchipupdate_dogs Dogs in each DIR snapshot after the cutoff year.\n";
+  stm << "# TYPE microchipupdate_dogs gauge\n";
+  stm << "microchipupdate_dogs{snapshot=\"old\"} " << m_anCounters[OLD_DOGS] << "\n";
+  stm << "microchipupdate_dogs{snapshot=\"new\"} " << m_anCounters[NEW_DOGS] << "\n";
+  stm << "# HELP microchipupdate_updates Updates written for Found.org.\n";
+  stm << "# TYPE microchipupdate_updates gauge\n";
+  stm << "microchipupdate_updates " << m_anCounters[UPDATES] << "\n";
+  stm << "# HELP microchipupdate_errors Bad dog errors by error code.\n";
+  stm << "# TYPE microchipupdate_errors gauge\n";
+  vector<string> vecCodes = CBadDogs::GetErrorCodes();
+  for (vector<string>::const_iterator it = vecCodes.begin();  it != vecCodes.end();  ++it)
+    stm << "microchipupdate_errors{code=\"" << *it << "\"} " << GetErrorCount(*it) << "\n";
+  stm << "# HELP microchipupdate_input_bytes_per_second DIR bytes read per second of reading.\n";
+  stm << "# TYPE microchipupdate_input_bytes_per_second gauge\n";
+  stm << "microchipupdate_input_bytes_per_second " << dBytesPerSecond << "\n";
+  stm << "# HELP microchipupdate_peak_rss_bytes Peak resident set size of the last run.\n";
+  stm << "# TYPE microchipupdate_peak_rss_bytes gauge\n";
+  stm << "microchipupdate_peak_rss_bytes " << GetPeakRSS() << "\n";
+  stm << "# HELP microchipupdate_count Assorted counters from the last run.\n";
+  stm << "# TYPE microchipupdate_count gauge\n";
+  for (unsigned i = 0;  i < MAXCOUNTER;  ++i)
+    stm << "microchipupdate_count{counter=\"" << g_apszCounters[i] << "\"} " << m_anCounters[i] << "\n";
+}
+
+
+void CMetrics::WritePrometheus (const string &sFileName) const
+{
+  //++
+  //   Write the Prometheus metrics to a file.  The node_exporter textfile
+  // collector might read the file at any moment, so we write a temporary file
+  // first and then rename it on top of the real one.  The collector only
+  // looks at "*.prom" files, so it'll never see the temporary one.  And if
+  // writing the temporary file fails (e.g. the disk is full) then we delete
+  // it and leave the old metrics alone rather than rename a truncated file
+  // on top of them ...
+  //--
+  string sTemp = sFileName + ".tmp";
+  std::filebuf fb;
+  if (!fb.open(sTemp, std::ios::out))
+    ERRS("CMetrics::WritePrometheus() unable to create " << sTemp);
+  std::ostream os(&fb);
+  WritePrometheus(os);
+  bool fOK = os.good();
+  if (fb.close() == NULL) fOK = false;
+  if (!fOK) {
+    remove(sTemp.c_str());
+    ERRS("CMetrics::WritePrometheus() error writing " << sTemp);
+  }
+#ifdef _WIN32
+  if (!MoveFileExA(sTemp.c_str(), sFileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+  if (rename(sTemp.c_str(), sFileName.c_str()) != 0)
+#endif
+    ERRS("CMetrics::WritePrometheus() unable to rename " << sTemp << " to " << sFileName);
+  MSGS("Wrote Prometheus metrics to " << sFileName);
+}
+
+
+void CMetrics::Report() const
+{
+  //++
+  //   Print a table with the time and (if they're being counted) the heap
+  // allocations for every phase on the console ...
+  //--
+  if (CAllocations::IsEnabled()) {
+    MSGS(CBadDogs::Print("%-14s %10s %12s %12s %14s %12s",
+         "Phase", "Seconds", "Peak RSS MB", "Allocations", "Alloc MB", "Peak heap MB"));
+    for (unsigned i = 0;  i < MAXPHASE;  ++i)
+      MSGS(CBadDogs::Print("%-14s %10.3f %12.1f %12llu %14.1f %12.1f",
+           g_apszPhases[i], m_adSeconds[i], m_anPeakRSS[i]/(1024.0*1024.0),
+           (unsigned long long) m_anAllocs[i], m_anAllocBytes[i]/(1024.0*1024.0),
+           m_anPeakHeap[i]/(1024.0*1024.0)));
+  } else {
+    MSGS(CBadDogs::Print("%-14s %10s %12s", "Phase", "Seconds", "Peak RSS MB"));
+    for (unsigned i = 0;  i < MAXPHASE;  ++i)
+      MSGS(CBadDogs::Print("%-14s %10.3f %12.1f",
+           g_apszPhases[i], m_adSeconds[i], m_anPeakRSS[i]/(1024.0*1024.0)));
+  }
+}
@@ -0,0 +1,211 @@
+//++
+// Metrics.hpp -> run time performance metrics
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The CMetrics class collects timing and counters for one run of the
+// program, so that when a nightly run is slow we can tell why.  The run is
+// divided into phases (read old DIR, read new DIR, compare, etc) and we
+// record the wall time and peak memory for each one.  There are also a bunch
+// of counters (rows read, dogs kept, rules that fired, etc) that are bumped
+// by the METRIC() macro wherever something interesting happens.  At the end
+// of the run all of it is written to a JSON file and, optionally, to a file in
+// the Prometheus text exposition format for the node_exporter textfile
+// collector.
+//
+//   Like CBadDogs, CMetrics is a singleton.  The one and only instance is
+// created by main() and a pointer to it is kept in the static data.  If no
+// instance exists then METRIC() and the phase methods quietly do nothing,
+// which is handy for things like the micro benchmarks.  The pointer is thread
+// local, so each job in a batch run (see CBatch) counts into its own.  The
+// heap allocation counts are for the whole process, though, so in a batch
+// they include whatever the other jobs were doing at the same time.
+//
+//   If the program was built with COUNT_ALLOCATIONS (see Allocations.hpp) then
+// each phase also records the number of heap allocations, the bytes allocated
+// and the high-water mark of heap bytes in use during that phase.  These go
+// into the JSON file too, and Report() prints them on the console.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Add per phase heap allocation accounting.
+// 17-OCT-26  AGT   Add errors by code and the Prometheus exporter.
+// 17-OCT-26  AGT   Add RULE_SIMILAR_CHIP.
+// 17-OCT-26  AGT   Add RULE_REENTERED.
+// 17-OCT-26  AGT   Add RULE_EMAIL_DOMAIN.
+// 17-OCT-26  AGT   Add the AGE_* counters.
+// 17-OCT-26  AGT   Add ROWS_FILTERED.
+// 17-OCT-26  AGT   Keep one instance per thread for batch runs.
+// 17-OCT-26  AGT   Add GetCurrentRSS().
+// 17-OCT-26  AGT   Record the current RSS and its change for each phase.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <map>                  // C++ std::map (sorted!) ...
+#include <chrono>               // std::chrono::steady_clock, et al ...
+#include <iostream>             // C++ style output ...
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::ostream;             // ...
+
+// Bump one of the CMetrics counters (e.g. METRIC(ROWS_READ)) ...
+#define METRIC(c)       CMetrics::Count(CMetrics::c)
+#define METRICN(c, n)   CMetrics::Count(CMetrics::c, n)
+
+
+class CMetrics {
+  //++
+  // Performance metrics for one run ...
+  //--
+
+public:
+  // Phases of a run, in the order they normally happen ...
+  enum PHASE {
+    PHASE_READ_OLD,             // read the old DIR
+    PHASE_READ_NEW,             // read the new DIR
+    PHASE_COMPARE,              // CompareDogs()
+    PHASE_BUILD_UPDATES,        // BuildUpdates()
+    PHASE_WRITE_UPDATES,        // write the Found.org updates file
+    PHASE_WRITE_ERRORS,         // write the bad dogs file
+    MAXPHASE                    // number of phases
+  };
+  // Counters ...
+  enum COUNTER {
+    ROWS_READ,                  // CSV rows read (all files)
+    BYTES_READ,                 // CSV bytes read (all files)
+    BYTES_WRITTEN,              // CSV bytes written (all files)
+    DOGS_KEPT,                  // dogs added to a CDogs collection
+    DOGS_CUTOFF,                // dogs discarded by the cutoff year
+    DOGS_REJECTED,              // rows that couldn't be made into a dog
+    ROWS_FILTERED,              // CSV rows dropped by a --where expression
+    OLD_DOGS,                   // dogs in the old DIR (after the cutoff)
+    NEW_DOGS,                   //  "   "   " new   "     "     "     "
+    VALIDATIONS,                // field validations run
+    BAD_DOGS,                   // errors logged by CBadDogs
+    UPDATES,                    // updates written for Found.org
+    // CDog::ParseAge() age layouts (see CDog::AGE_FORMAT) ...
+    AGE_YEARS_MONTHS,           // "2 Years 3 Months"
+    AGE_ABBREVIATED,            // "2 yrs 3 mos"
+    AGE_YEARS,                  // "3 Years"
+    AGE_MONTHS,                 // "6 months"
+    AGE_FRACTION,               // "2.5 years"
+    AGE_INVALID,                // none of the above
+    // CompareDogs() rule hits ...
+    RULE_MISSING,               // dog with a chip disappeared
+    RULE_ACQUIRED,              // dog was recently acquired
+    RULE_ACQUIRED_NO_CHIP,      //  ... but has no microchip
+    RULE_CHIP_ADDED,            // microchip was added
+    RULE_CHIP_CHANGED,          // microchip was changed
+    RULE_ADOPTED_NO_ADOPTER,    // status adopted but no adopter
+    RULE_ADOPTER_NOT_ADOPTED,   // adopter but status not adopted
+    RULE_DISPOSITION,           // disposition date but still available
+    RULE_FAMILY_CHANGED,        // adopting family changed
+    RULE_ADOPTED,               // dog was recently adopted
+    RULE_RETURNED,              // dog was returned to NGRR
+    RULE_SIMILAR_CHIP,          // microchips that differ by a typo
+    RULE_REENTERED,             // missing dog was probably re-entered
+    RULE_EMAIL_DOMAIN,          // email domain is probably misspelled
+    MAXCOUNTER                  // number of counters
+  };
+
+public:
+  // Constructor and destructor ...
+  CMetrics();
+  virtual ~CMetrics();
+  // Copy and assignment constructors ...
+  CMetrics (const CMetrics &m) = delete;
+  CMetrics& operator= (const CMetrics &m) = delete;
+
+  // CMetrics properties ...
+public:
+  // Return a pointer to this thread's CMetrics object (or NULL) ...
+  static CMetrics *Get() {return m_pMetrics;}
+  // Return the name of a phase or counter ...
+  static const char *PhaseName (PHASE nPhase);
+  static const char *CounterName (COUNTER nCounter);
+  // Return the elapsed time or peak memory for a phase ...
+  double GetSeconds (PHASE nPhase) const {return m_adSeconds[nPhase];}
+  uint64_t GetPeakRSS (PHASE nPhase) const {return m_anPeakRSS[nPhase];}
+  // Return the RSS at the end of a phase, and how much the phase changed it ...
+  uint64_t GetRSS (PHASE nPhase) const {return m_anRSS[nPhase];}
+  int64_t GetRSSChange (PHASE nPhase) const {return m_anRSSChange[nPhase];}
+  // Return the heap allocations, bytes and high-water mark for a phase ...
+  uint64_t GetAllocations (PHASE nPhase) const {return m_anAllocs[nPhase];}
+  uint64_t GetAllocatedBytes (PHASE nPhase) const {return m_anAllocBytes[nPhase];}
+  uint64_t GetPeakHeap (PHASE nPhase) const {return m_anPeakHeap[nPhase];}
+  // Return the value of a counter ...
+  uint64_t GetCount (COUNTER nCounter) const {return m_anCounters[nCounter];}
+  // Return the total elapsed time since this object was created ...
+  double GetTotalSeconds() const;
+  // Return the number of bad dogs with a given error code ...
+  uint64_t GetErrorCount (const string &sCode) const;
+  // Add a descriptive label (e.g. the input file names) to the output ...
+  void SetLabel (const string &sName, const string &sValue);
+
+  // CMetrics public methods ...
+public:
+  // Bump a counter ...
+  static void Count (COUNTER nCounter, uint64_t n=1)
+    {if (m_pMetrics != NULL) m_pMetrics->m_anCounters[nCounter] += n;}
+  // Count one bad dog error by its code (see CBadDogs::Classify()) ...
+  static void CountError (const char *pszCode)
+    {if (m_pMetrics != NULL) ++m_pMetrics->m_mapErrors[pszCode];}
+  // Start and end a phase ...
+  static void BeginPhase (PHASE nPhase);
+  static void EndPhase (PHASE nPhase);
+  // Write everything to a JSON file ...
+  void WriteJSON (ostream &stm) const;
+  void WriteJSON (const string &sFileName) const;
+  // Write everything in the Prometheus text format ...
+  void WritePrometheus (ostream &stm) const;
+  void WritePrometheus (const string &sFileName) const;
+  // Print a per phase summary on the console ...
+  void Report() const;
+  // Return the peak resident set size of this process, in bytes ...
+  static uint64_t GetPeakRSS();
+  // Return the current resident set size of this process, in bytes ...
+  static uint64_t GetCurrentRSS();
+  // Quote a string for JSON ...
+  static string JSONString (const string &str);
+
+  // Local CMetrics members ...
+protected:
+  typedef std::chrono::steady_clock CLOCK;
+  typedef std::pair<string, string> LABEL;
+  static thread_local CMetrics *m_pMetrics;     // this thread's instance
+  CLOCK::time_point m_tCreated;                 // time this object was created
+  CLOCK::time_point m_atStart[MAXPHASE];        // start time for each phase
+  double            m_adSeconds[MAXPHASE];      // elapsed time for each phase
+  uint64_t          m_anPeakRSS[MAXPHASE];      // peak memory after each phase
+  uint64_t          m_anStartRSS[MAXPHASE];     // current memory at the start of each phase
+  uint64_t          m_anRSS[MAXPHASE];          //    "      "    "  "  end   "   "     "
+  int64_t           m_anRSSChange[MAXPHASE];    // change in memory during each phase
+  uint64_t          m_anStartAllocs[MAXPHASE];  // allocations at the start of each phase
+  uint64_t          m_anStartBytes[MAXPHASE];   // bytes allocated   "   "    "   "    "
+  uint64_t          m_anAllocs[MAXPHASE];       // heap allocations during each phase
+  uint64_t          m_anAllocBytes[MAXPHASE];   // bytes allocated during each phase
+  uint64_t          m_anPeakHeap[MAXPHASE];     // heap high-water mark for each phase
+  uint64_t          m_anCounters[MAXCOUNTER];   // counters
+  vector<LABEL>     m_vecLabels;                // descriptive labels
+  std::map<string, uint64_t> m_mapErrors;       // bad dogs by error code
+};
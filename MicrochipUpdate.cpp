@@ -39,16 +39,93 @@
 // generating a summary report of all the bad dog records that need fixing.
 //
 // USAGE:
-//      MicrochipUpdate [-cnnnn] [-on] <old DIR> <new DIR> [[<updates>] [<errors>]]
+//      MicrochipUpdate [-cnnnn] [-on] [--trace=file] [--prometheus=file] [--raw] [--memory=mb] [--partitions=n] [--spill=path] <old DIR> <new DIR> [[<updates>] [<errors>]]
+//      MicrochipUpdate generate [-cnnnn] [-on] [<generator options>] <old DIR> <new DIR>
+//      MicrochipUpdate benchmark [-cnnnn] [-on] [<generator options>] [--max=n] [--dir=path] [--keep]
+//      MicrochipUpdate microbench [--seconds=n]
+//      MicrochipUpdate diff [-cnnnn] [-on] [<generator options>] [--dir=path] [<old DIR> <new DIR>]
+//      MicrochipUpdate row <DIR> <dog ID> ...
+//      MicrochipUpdate extract [-o] --where=expression <DIR> [<output>]
+//      MicrochipUpdate whatif [-on] --cutoffs=years <old DIR> <new DIR>
+//      MicrochipUpdate batch [-cnnnn] [-on] [--jobs=n] [--profiles=file] [--trace=file] <manifest>
+//      MicrochipUpdate shard [-cnnnn] [-on] [--shards=n] <old DIR> <new DIR> [<directory>]
+//      MicrochipUpdate merge <manifest> [<updates> [<errors>]]
 //
 //      -cnnnn    - set cutoff year to nnnn
 //      -o or -o1 - old DIR is in the old format
 //      -o2       - BOTH DIRs are in the old format
+//      --trace=file - write a Chrome/Perfetto trace event timeline to file
+//      --prometheus=file - write run metrics for the node_exporter textfile
+//                     collector (e.g. .../textfile/microchipupdate.prom)
+//      --raw     - add each dog's raw DIR row to the error report
+//      --memory=mb - compare the DIRs out of core in about this much memory
+//      --partitions=n - number of out of core partitions (default from --memory)
+//      --spill=path - directory for the out of core partition files (default ".")
+//      --where=expression - select the DIR rows to extract (see Where.hpp)
+//      --cutoffs=years - list of cutoff years to try, e.g. 2015,2017-2020
+//      --jobs=n  - number of batch jobs to run at once (default one per CPU)
+//      --profiles=file - organization profiles for the batch (see OrgProfile.hpp)
+//      --shards=n - number of shards to split the DIRs into (default 4)
 //      <old DIR> - the previous Dog Information Report .csv file
 //      <new DIR> - the current  Dog Information Report .csv file
 //      <updates> - microchip update .csv file ready to send to Found.org
 //      <errors>  - error report .csv file
 //
+//   Every update run also writes a metrics file next to the error report (e.g.
+// "errors.metrics.json" for "errors.csv") with the time spent in each phase and
+// counts of rows read, dogs kept, rules that fired, and so on.  If the program
+// was built with COUNT_ALLOCATIONS, the heap allocations, bytes allocated and
+// heap high-water mark for each phase are included and printed at the end.
+//
+//   The "generate" command writes a synthetic pair of DIRs, and "benchmark"
+// generates DIR pairs from 10,000 dogs up to --max (default 10,000,000) and
+// times the whole pipeline on each.  "microbench" times the individual parsing
+// and validation functions (at least --seconds, default 1, for each one).
+// "diff" runs the frozen reference copies of the parser, validators and
+// CompareDogs() against the current code on a generated DIR pair (default
+// 2,000 dogs) plus the recorded DIRs if given, and shrinks any difference to
+// a minimal failing input (scratch files go in --dir).  "row" prints the raw
+// records for some dogs, exactly as they are in a DIR, using a sidecar index
+// ("<DIR>.idx") that's built the first time and rebuilt whenever the DIR
+// changes.  The --raw option uses the same index to add each dog's raw
+// record to the error report.  "extract" copies the rows of a DIR that
+// match the --where expression to another CSV file (extract.csv by default)
+// with the same header, e.g.
+//
+//      MicrochipUpdate extract --where="status = Available and acquired >= 2023" dogs.csv
+//
+// (for "extract", -o means the DIR is in the old format).  "whatif" reads
+// both DIRs once and then prints the number of updates and errors that each
+// of the --cutoffs years would produce.  The rules that look at only one dog
+// are run once and counted by the year each dog was acquired - only the ones
+// that look at more than one dog (households, duplicate and similar chips,
+// re-entered dogs and email domains) are run again for each year (see
+// CWhatIf).  "batch" runs all the
+// update jobs in a manifest - one row per job with the organization, both
+// DIRs, and the updates and errors files - on a pool of --jobs threads, with
+// each organization's registration details from the --profiles file, and
+// prints one line of results for each job (see CBatch).  "shard" splits both
+// DIRs into --shards pairs of smaller DIRs by dog number, in <directory>
+// (default "."), and writes a batch manifest for them.  Each pair can be run
+// separately, on any machine, and then "merge" combines all their updates
+// and errors files, plus the errors for duplicate and similar microchips and
+// re-entered dogs that "shard" found, into one of each (see CShards).
+//
+//   An update run with --memory or --partitions doesn't keep both DIRs in
+// memory at once.  Instead it splits them into partition files by dog number,
+// in the --spill directory, compares one pair of partitions at a time, and
+// then merges the results.  The updates and errors files are exactly the same
+// as a normal run's (see CPartitions).  The generator options are
+//
+//      --dogs=n      - number of dogs in the new DIR
+//      --recent=p    - percent of dogs acquired after the cutoff year
+//      --acquire=p   - percent of new dogs that weren't in the old DIR
+//      --adopt=p     - percent of unadopted dogs adopted since the old DIR
+//      --return=p    - percent of adopted dogs returned since the old DIR
+//      --death=p     - percent of dogs that died since the old DIR
+//      --dirty=p     - percent chance of each kind of garbage in each dog
+//      --seed=n      - random number seed
+//
 //                                          Bob Armstrong [4-Jul-2019]
 //
 // REVISION HISTORY:
@@ -66,6 +143,35 @@
 //                   check for that combination in CompareDogs()..
 //  3-Apr-23  RLA    Update for yet another DIR file format.  Add the -o and -c
 //                   command line options ('cause I'm sure this will happen again!).
+// 17-Oct-26  AGT    Add the "generate", "benchmark" and "microbench" commands.
+// 17-Oct-26  AGT    Time each phase and write a metrics file next to the errors.
+// 17-Oct-26  AGT    Report heap allocations by phase in COUNT_ALLOCATIONS builds.
+// 17-Oct-26  AGT    Add the --trace option.
+// 17-Oct-26  AGT    Add the --prometheus option.
+// 17-Oct-26  AGT    Add the "diff" command.
+// 17-Oct-26  AGT    Report microchip typos (see CDogs::FindSimilarChips()).
+// 17-Oct-26  AGT    Report likely re-entries of missing dogs (see CDogMatcher).
+// 17-Oct-26  AGT    Don't report a family change within the same household.
+// 17-Oct-26  AGT    Report misspelled email domains (see CDomainChecker).
+// 17-Oct-26  AGT    Add the "row" command and the --raw option (see CRowIndex).
+// 17-Oct-26  AGT    Use CDogTable filters for three of the CompareDogs() rules.
+// 17-Oct-26  AGT    Add the "extract" command and --where expressions.
+// 17-Oct-26  AGT    Add the "whatif" command.
+// 17-Oct-26  AGT    Find dogs by their (organization, number) key.
+// 17-Oct-26  AGT    Add the "batch" command and organization profiles.
+// 17-Oct-26  AGT    Add the "shard" and "merge" commands.
+// 17-Oct-26  AGT    Add the --memory out of core mode (see CPartitions).
+// 17-Oct-26  AGT    Exit without deleting the dogs and rows (see FastExit()).
+// 17-Oct-26  AGT    "row" takes dog IDs with an organization prefix too.
+// 17-Oct-26  AGT    Say that "whatif" runs the rules once per cutoff year.
+// 17-Oct-26  AGT    Shard runs leave re-entered dogs and domain counts to "shard".
+// 17-Oct-26  AGT    RunUpdate() writes the errors file itself, inside its try.
+// 17-Oct-26  AGT    Shard runs read their households from a file.
+// 17-Oct-26  AGT    Add COMPARE_FAMILY so "whatif" runs the one dog rules once.
+// 17-Oct-26  AGT    "diff" reports its errors instead of aborting.
+// 17-Oct-26  AGT    Write the --trace file explicitly (see WriteTrace()).
+// 17-Oct-26  AGT    "extract" reports its errors instead of aborting.
+// 17-Oct-26  AGT    "row" reports its errors instead of aborting.
 //--
 //000000001111111111222222222233333333334444444444555555555566666666667777777777
 //234567890123456789012345678901234567890123456789012345678901234567890123456789
@@ -80,13 +186,46 @@
 #include "CSVFile.hpp"          // a collection of spreadsheet rows
 #include "Dog.hpp"              // CDog data and CDogs collection
 #include "Chip.hpp"             // CChip data and CChips collection
+#include "Generate.hpp"         // synthetic DIR generator
+#include "Benchmark.hpp"        // end to end benchmark
+#include "DiffHarness.hpp"      // differential testing harness
+#include "DogMatcher.hpp"       // find re-entered dogs
+#include "Household.hpp"        // adopter household index
+#include "DomainChecker.hpp"    // misspelled email domains
+#include "RowIndex.hpp"         // sidecar row offset index
+#include "DogTable.hpp"         // column store view of the dogs
+#include "Where.hpp"            // "--where" record filters
+#include "WhatIf.hpp"           // try several cutoff years at once
+#include "Batch.hpp"            // concurrent update jobs from a manifest
+#include "Shard.hpp"            // split DIRs into shards and merge the results
+#include "Partition.hpp"        // out of core update runs
+#include "Metrics.hpp"          // run time performance metrics
+#include "Allocations.hpp"      // heap allocation accounting
+#include "Trace.hpp"            // trace event timeline
+#include "MicrochipUpdate.hpp"  // declarations for this module
 
 // Useful definitions ...
 #define STREQL(a,b)     (strcmp(a,b) == 0)
 #define STRNEQL(a,b,l)  (strncmp(a,b,l) == 0)
 
+// Commands (the optional first argument) ...
+enum {
+  CMD_UPDATE,                         // compare DIRs and generate updates
+  CMD_GENERATE,                       // generate synthetic DIRs
+  CMD_BENCHMARK,                      // run the end to end benchmark
+  CMD_MICROBENCH,                     // run the micro benchmarks
+  CMD_DIFF,                           // run the differential tests
+  CMD_ROW,                            // print raw DIR rows by dog number
+  CMD_EXTRACT,                        // copy the DIR rows matching --where
+  CMD_WHATIF,                         // try a list of cutoff years
+  CMD_BATCH,                          // run the jobs in a manifest
+  CMD_SHARD,                          // split the DIRs into shards
+  CMD_MERGE                           // merge the results from the shards
+};
+
 // Globals ...
 #define DEFAULT_EXTENSION ".csv"      // default file type for all csv files
+int    g_nCommand(CMD_UPDATE);        // what we're supposed to do
 string g_sOldDogsFile("");            // old DIR report csv file
 string g_sNewDogsFile("");            // new  "     "    "   "
 bool   g_fOldDogsFormat(true);        // true if the old dogs file is the new format
@@ -94,9 +233,29 @@ bool   g_fNewDogsFormat(true);        //   "  "   "  new   "   "   "   "   "
 int    g_nCutoffYear(2019);           // dogs before 1-JAN-year are ignored
 string g_sUpdatesFile("updates.csv"); // output file for Found.org
 string g_sErrorsFile("errors.csv");   // error listing file
+CDIRGenerator g_Generator;            // synthetic DIR generator settings
+size_t g_nBenchmarkDogs(CBenchmark::MAX_DOGS); // largest benchmark size
+string g_sBenchmarkDir(".");          // directory for benchmark (or diff) files
+bool   g_fBenchmarkKeep(false);       // keep benchmark files when done
+uint32_t g_nMicroSeconds(1);          // minimum seconds per micro benchmark
+string g_sTraceFile("");              // trace event timeline file (if any)
+string g_sPrometheusFile("");         // Prometheus textfile (if any)
+bool   g_fRawRows(false);             // add raw DIR rows to the errors
+vector<string> g_vecRowIDs;          // dog IDs for the "row" command
+string g_sWhere("");                  // --where expression for "extract"
+string g_sExtractFile("extract.csv"); // output file for "extract"
+vector<uint32_t> g_vecCutoffs;        // cutoff years for "whatif"
+string g_sManifestFile("");           // job manifest for "batch"
+string g_sProfilesFile("");           // organization profiles for "batch"
+unsigned g_nJobs(0);                  // number of batch workers (0 = one per CPU)
+unsigned g_nShards(CShards::DEFAULT_SHARDS); // number of shards for "shard"
+string g_sShardDir(".");              // directory for the shard files
+uint64_t g_nMemory(0);                // out of core memory budget in MB (0 = in memory)
+unsigned g_nPartitions(0);            // number of out of core partitions (0 = from g_nMemory)
+string g_sSpillDir(".");              // directory for the partition files
 
 
-void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs)
+void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs, const CHouseholds *pHouseholds, uint32_t nPasses)
 {
   //++
   //   Compare a new dog database, after the csv file has been read into a 
@@ -105,8 +264,12 @@ void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs)
   // dogs in the new database need to be uploaded to Found.org and marks
   // them with SetUpdateRequired().  It doesn't actually generate an output
   // file for Found.org though - that's another job...
+  //
+  //   nPasses selects which of the passes below (COMPARE_MISSING, etc) are
+  // run.  The ones that are run still go in the usual order ...
   //--
-  MSGS("Comparing " << OldDogs.DogCount() << " old dogs with " << NewDogs.DogCount() << " new dogs ...");
+  if (nPasses == COMPARE_ALL)
+    MSGS("Comparing " << OldDogs.DogCount() << " old dogs with " << NewDogs.DogCount() << " new dogs ...");
 
   //   Part 0 - Sanitize all the new dog data ...  We should probably verify
   // all the old dog data too, but that never ends up in the update file ...
@@ -123,15 +286,21 @@ void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs)
   //   Part 1 - we never delete a dog record, so all the dogs in the OldDogs
   // collection should exist in the NewDogs.  Warn about any that don't follow
   // this rule.
-  for (CDogs::dog_number_const_iterator it = OldDogs.dog_begin(); it != OldDogs.dog_end(); ++it) {
-    const CDog *pOldDog = it->second;
-    if (NewDogs.Find(pOldDog->GetNumber()) == NULL) {
-      //   Turns out that dogs disappear from the database more often than you
-      // might think.  Don't ask me to explain why, but only report a problem
-      // if the dog had a microchip registered.  Otherwise I guess we don't care.
-      if (pOldDog->HasChip())
-        BADDOGS(pOldDog, "has microchip " + pOldDog->GetChip() + " but is not found in new dog report");
+  if ((nPasses & COMPARE_MISSING) != 0) {
+    CTracer::Begin("missing dogs", CTracer::PASS);
+    for (CDogs::dog_number_const_iterator it = OldDogs.dog_begin(); it != OldDogs.dog_end(); ++it) {
+      const CDog *pOldDog = it->second;
+      if (NewDogs.Find(pOldDog->GetKey()) == NULL) {
+        //   Turns out that dogs disappear from the database more often than you
+        // might think.  Don't ask me to explain why, but only report a problem
+        // if the dog had a microchip registered.  Otherwise I guess we don't care.
+        if (pOldDog->HasChip()) {
+          BADDOGS(pOldDog, "has microchip " + pOldDog->GetChip() + " but is not found in new dog report");
+          METRIC(RULE_MISSING);
+        }
+      }
     }
+    CTracer::End("missing dogs", CTracer::PASS);
   }
 
   //   Conversely, any dog which is in the new dogs but not in the old dogs
@@ -143,68 +312,107 @@ void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs)
   // number recorded for a dog, or an A/C might forget to enter the chip number
   // now but then go back and re-enter it later.  We need to detect both of
   // those cases too and update Found.org as well.
-  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
-    CDog *pNewDog = it->second;
-    if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
-    const CDog *pOldDog = OldDogs.Find(pNewDog->GetNumber());
-    if (pOldDog == NULL) {
-      // Dog was recently acquired.  As long as it has a microchip, register it!
-      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " was acquired");
-      if (pNewDog->GetChip().empty()) {
-        BADDOGS(pNewDog, "no microchip number recorded");
-      } else {
-        pNewDog->SetUpdateRequired();
+  if ((nPasses & COMPARE_ACQUIRED) != 0) {
+    CTracer::Begin("acquired dogs", CTracer::PASS);
+    for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+      CDog *pNewDog = it->second;
+      if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
+      const CDog *pOldDog = OldDogs.Find(pNewDog->GetKey());
+      if (pOldDog == NULL) {
+        // Dog was recently acquired.  As long as it has a microchip, register it!
+        MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetID() << " was acquired");
+        METRIC(RULE_ACQUIRED);
+        if (pNewDog->GetChip().empty()) {
+          BADDOGS(pNewDog, "no microchip number recorded");  METRIC(RULE_ACQUIRED_NO_CHIP);
+        } else {
+          pNewDog->SetUpdateRequired();
+        }
+      } else if (pOldDog->GetChip().empty() && !pNewDog->GetChip().empty()) {
+        // The dog didn't have a chip number before but does now - register it!
+        MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetID() << " microchip was added");
+        pNewDog->SetUpdateRequired();  METRIC(RULE_CHIP_ADDED);
+      } else if (pOldDog->GetChip() != pNewDog->GetChip()) {
+        //  The dog's microchip number was changed.  Note that we can't fix this
+        // by updating Found.org, so you're on your own!
+        BADDOGS(pNewDog, "microchip number changed - was \"" << pOldDog->GetChip() << "\" is \"" << pNewDog->GetChip() << "\"");
+        METRIC(RULE_CHIP_CHANGED);
       }
-    } else if (pOldDog->GetChip().empty() && !pNewDog->GetChip().empty()) {
-      // The dog didn't have a chip number before but does now - register it!
-      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " microchip was added");
-      pNewDog->SetUpdateRequired();
-    } else if (pOldDog->GetChip() != pNewDog->GetChip()) {
-      //  The dog's microchip number was changed.  Note that we can't fix this
-      // by updating Found.org, so you're on your own!
-      BADDOGS(pNewDog, "microchip number changed - was \"" << pOldDog->GetChip() << "\" is \"" << pNewDog->GetChip() << "\"");
     }
+    CTracer::End("acquired dogs", CTracer::PASS);
   }
 
-  //   If the dog's status says it's adopted but there's no adopter name or
-  // address recorded, then issue a warning.  It was likely a dog that was
-  // adopted by an NGRR member - there's a bug in the web page that prevents
-  // the adopter information from being recorded on these dogs...
-  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
-    CDog *pNewDog = it->second;
-    if ((pNewDog->GetStatus() == "Adopted") /*|| (pNewDog->GetStatus() == "Adoption Pending")*/) {
-      if (pNewDog->GetAdoptionFName().empty() && pNewDog->GetAdoptionLName().empty())
+  //   The next three rules each look at just a few fields of every new dog,
+  // so they're done with filters on a column store snapshot of the new dogs
+  // instead (see CDogTable).  The rows come out in the same order as the
+  // loops over NewDogs used to visit them.  The table isn't built unless at
+  // least one of them is going to run ...
+  if ((nPasses & (COMPARE_NO_ADOPTER | COMPARE_NOT_ADOPTED | COMPARE_DISPOSITION)) != 0) {
+    CDogTable NewTable(NewDogs);  CDogTable::SELECTION sel;
+
+    //   If the dog's status says it's adopted but there's no adopter name or
+    // address recorded, then issue a warning.  It was likely a dog that was
+    // adopted by an NGRR member - there's a bug in the web page that prevents
+    // the adopter information from being recorded on these dogs...
+    if ((nPasses & COMPARE_NO_ADOPTER) != 0) {
+      CTracer::Begin("adopted without adopter", CTracer::PASS);
+      {
+        CDogTable::FILTER filter;
+        NewTable.AddStatus(filter, "Adopted");  //NewTable.AddStatus(filter, "Adoption Pending");
+        filter.nMask = CDogTable::FLAG_ADOPTED;  filter.nFlags = 0;
+        NewTable.Select(filter, sel);
+      }
+      for (CDogTable::SELECTION::const_iterator it = sel.begin(); it != sel.end(); ++it) {
+        CDog *pNewDog = NewTable.GetDog(*it);
         //BADDOGS(pNewDog, "status is ADOPTED but no adopter name is recorded");
         BADDOGS(pNewDog, pNewDog->GetStatus() + " but no adopting party is recorded");
+        METRIC(RULE_ADOPTED_NO_ADOPTER);
+      }
+      CTracer::End("adopted without adopter", CTracer::PASS);
     }
-  }
 
-  //   Conversely, if there's an adopter name recorded and the dog's status is
-  // NOT adopted, then complain about that too...
-  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
-    CDog *pNewDog = it->second;
-    if (!pNewDog->GetAdoptionFName().empty() || !pNewDog->GetAdoptionLName().empty()) {
-      if ((pNewDog->GetStatus() != "Adopted") && (pNewDog->GetStatus() != "Adoption Pending")) {
-        //   There are dogs in the database that are recorded as died or euthanized
-        // but are still shown as adopted.  Not sure how that happened (why would
-        // we record a dog's death AFTER it was adopted??) but we'll ignore those.
-        if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
+    //   Conversely, if there's an adopter name recorded and the dog's status is
+    // NOT adopted, then complain about that too...
+    //
+    //   There are dogs in the database that are recorded as died or euthanized
+    // but are still shown as adopted.  Not sure how that happened (why would
+    // we record a dog's death AFTER it was adopted??) but we'll ignore those.
+    if ((nPasses & COMPARE_NOT_ADOPTED) != 0) {
+      CTracer::Begin("adopter not adopted", CTracer::PASS);
+      {
+        CDogTable::FILTER filter;
+        NewTable.AddStatus(filter, "Adopted");  NewTable.AddStatus(filter, "Adoption Pending");
+        filter.fNot = true;
+        filter.nMask = CDogTable::FLAG_ADOPTED | CDogTable::FLAG_DEAD | CDogTable::FLAG_RETURNED;
+        filter.nFlags = CDogTable::FLAG_ADOPTED;
+        NewTable.Select(filter, sel);
+      }
+      for (CDogTable::SELECTION::const_iterator it = sel.begin(); it != sel.end(); ++it) {
+        CDog *pNewDog = NewTable.GetDog(*it);
         BADDOGS(pNewDog, " adopting party is recorded but status is " + pNewDog->GetStatus());
+        METRIC(RULE_ADOPTER_NOT_ADOPTED);
       }
+      CTracer::End("adopter not adopted", CTracer::PASS);
     }
-  }
 
-  //   If the dog has a disposition date (which normally means that the dog was
-  // adopted, returned, died, or otherwise "disposed of") BUT the status is still
-  // Evaluation or Available, then complain...
-  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
-    CDog *pNewDog = it->second;
-    if (!pNewDog->GetDispositionDate().empty()) {
-      //   Don't know why, but a lot of dogs have a disposition date that looks
-      // like "0000-00-00" ...  Just ignore those.
-      if (pNewDog->GetDispositionDate() == "0000-00-00") continue;
-      if ((pNewDog->GetStatus() == "Evaluation") || (pNewDog->GetStatus() == "Available"))
+    //   If the dog has a disposition date (which normally means that the dog was
+    // adopted, returned, died, or otherwise "disposed of") BUT the status is still
+    // Evaluation or Available, then complain...  Don't know why, but a lot of
+    // dogs have a disposition date that looks like "0000-00-00" and those don't
+    // count (FLAG_DISPOSITION takes care of that).
+    if ((nPasses & COMPARE_DISPOSITION) != 0) {
+      CTracer::Begin("disposition date", CTracer::PASS);
+      {
+        CDogTable::FILTER filter;
+        NewTable.AddStatus(filter, "Evaluation");  NewTable.AddStatus(filter, "Available");
+        filter.nMask = filter.nFlags = CDogTable::FLAG_DISPOSITION;
+        NewTable.Select(filter, sel);
+      }
+      for (CDogTable::SELECTION::const_iterator it = sel.begin(); it != sel.end(); ++it) {
+        CDog *pNewDog = NewTable.GetDog(*it);
         BADDOGS(pNewDog, "disposition date is " + pNewDog->GetDispositionDate() + " but status is " + pNewDog->GetStatus());
+        METRIC(RULE_DISPOSITION);
+      }
+      CTracer::End("disposition date", CTracer::PASS);
     }
   }
 
@@ -212,35 +420,52 @@ void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs)
   // weren't adopted last time around.  These dogs were recently adopted, and
   // also need registering with Found.org.  And just to be safe, if the dog
   // both was and is adopted, see if the adopting family has changed.
-  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
-    CDog *pNewDog = it->second;
-    const CDog *pOldDog = OldDogs.Find(pNewDog->GetNumber());
-    if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
-    if (!pNewDog->IsAdopted()) continue;
-    if ((pOldDog != NULL) && pOldDog->IsAdopted()) {
-      // Was adopted before and is adopted now ...
-      if ((pOldDog->GetAdoptionFName() != pNewDog->GetAdoptionFName())
-          || (pOldDog->GetAdoptionLName() != pNewDog->GetAdoptionLName()))
-          BADDOGS(pOldDog, "adopting family changed");
-          // Should an update be required here??!!  Probably...
-    } else {
-      // Was recently adopted ...
-      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " was adopted by " << pNewDog->GetAdoptionFName() << " " << pNewDog->GetAdoptionLName());
-      pNewDog->SetUpdateRequired();
+  //
+  //   The family check is the only rule in CompareDogs() that looks at more
+  // than one dog (the households depend on every other adopter), so it's a
+  // pass of its own - CWhatIf runs it separately from the rest ...
+  if ((nPasses & (COMPARE_ADOPTED | COMPARE_FAMILY)) != 0) {
+    CTracer::Begin("recently adopted", CTracer::PASS);
+    for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+      CDog *pNewDog = it->second;
+      const CDog *pOldDog = OldDogs.Find(pNewDog->GetKey());
+      if (pNewDog->IsDead() || pNewDog->IsReturned()) continue;
+      if (!pNewDog->IsAdopted()) continue;
+      if ((pOldDog != NULL) && pOldDog->IsAdopted()) {
+        // Was adopted before and is adopted now ...
+        if ((nPasses & COMPARE_FAMILY) == 0) continue;
+        //   Don't complain if the name changed but it's still the same household
+        // ("Bob" vs "Robert", a typo that got fixed, or the spouse's name ...).
+        if ((pHouseholds != NULL) && pHouseholds->SameHousehold(pOldDog, pNewDog)) continue;
+        if ((pOldDog->GetAdoptionFName() != pNewDog->GetAdoptionFName())
+            || (pOldDog->GetAdoptionLName() != pNewDog->GetAdoptionLName())) {
+            BADDOGS(pOldDog, "adopting family changed");  METRIC(RULE_FAMILY_CHANGED);
+            // Should an update be required here??!!  Probably...
+        }
+      } else if ((nPasses & COMPARE_ADOPTED) != 0) {
+        // Was recently adopted ...
+        MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetID() << " was adopted by " << pNewDog->GetAdoptionFName() << " " << pNewDog->GetAdoptionLName());
+        pNewDog->SetUpdateRequired();  METRIC(RULE_ADOPTED);
+      }
     }
+    CTracer::End("recently adopted", CTracer::PASS);
   }
 
   //   Lastly, look for dogs that were returned to NGRR.  These dogs would have
   // been adopted last time around but are not adopted now.
-  for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
-    CDog *pNewDog = it->second;
-    const CDog *pOldDog = OldDogs.Find(pNewDog->GetNumber());
-    if ((pOldDog == NULL) || !pOldDog->IsAdopted()) continue;
-    if (!pNewDog->IsAdopted()) {
-      // Was adopted before and is NOT adopted now ...
-      MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetNumber() << " was returned to NGRR");
-      pNewDog->SetUpdateRequired();
+  if ((nPasses & COMPARE_RETURNED) != 0) {
+    CTracer::Begin("returned dogs", CTracer::PASS);
+    for (CDogs::dog_number_const_iterator it = NewDogs.dog_begin(); it != NewDogs.dog_end(); ++it) {
+      CDog *pNewDog = it->second;
+      const CDog *pOldDog = OldDogs.Find(pNewDog->GetKey());
+      if ((pOldDog == NULL) || !pOldDog->IsAdopted()) continue;
+      if (!pNewDog->IsAdopted()) {
+        // Was adopted before and is NOT adopted now ...
+        MSGS("dog " << pNewDog->GetName() << " #" << pNewDog->GetID() << " was returned to NGRR");
+        pNewDog->SetUpdateRequired();  METRIC(RULE_RETURNED);
+      }
     }
+    CTracer::End("returned dogs", CTracer::PASS);
   }
 }
 
@@ -267,6 +492,127 @@ void BuildUpdates (CDogs &Dogs, CChips &Chips)
 }
 
 
+void RunUpdate (const string &sOldFile, bool fOldFormat, const string &sNewFile, bool fNewFormat,
+                uint32_t nCutoff, const string &sUpdatesFile, const string &sErrorsFile, bool fRawRows,
+                bool fFastExit, const string &sDomainsFile, const string &sHouseholdsFile)
+{
+  //++
+  //   Do one complete update run - read both DIRs, compare them, and write
+  // the updates and errors files.  The phases are timed by the caller's
+  // CMetrics, if there is one.  Note that CBadDogs doesn't write the errors
+  // file when it's deleted, so we write it here, inside the try, where a
+  // failure is just another exception for the caller.  If anything else
+  // throws, the errors found so far are still written ...
+  //
+  //   If fFastExit is true then the caller promises to call FastExit() as
+  // soon as it's done with the results.  In that case the dogs, the chips and
+  // the errors are never deleted - everything is left for the operating system
+  // to throw away all at once.  Deleting a big DIR one dog at a time takes a
+  // noticeable fraction of the whole run, just to free memory that's about to
+  // go away anyway ...
+  //
+  //   If sDomainsFile is given then these DIRs are just one shard of a bigger
+  // pair (see CShards).  The email domains are learned from that file, which
+  // has the counts for the whole old DIR, and the re-entered dogs have
+  // already been found by CShards::Split(), which saw every dog in both DIRs.
+  // Doing either one here would only see this shard's dogs.  The same goes
+  // for the adopter households, which come from sHouseholdsFile if it's
+  // given ...
+  //--
+  CBadDogs *pBadDogs = new CBadDogs(sErrorsFile);
+  CDogs *pOldDogs = new CDogs, *pNewDogs = new CDogs;  CChips *pChips = new CChips;
+  CDogs &OldDogs = *pOldDogs, &NewDogs = *pNewDogs;  CChips &Chips = *pChips;
+  bool fWritingErrors = false;
+  try {
+    CMetrics::BeginPhase(CMetrics::PHASE_READ_OLD);
+    OldDogs.ReadFile(sOldFile, nCutoff, fOldFormat);
+    METRICN(OLD_DOGS, OldDogs.DogCount());
+    CMetrics::EndPhase(CMetrics::PHASE_READ_OLD);
+    CMetrics::BeginPhase(CMetrics::PHASE_READ_NEW);
+    NewDogs.ReadFile(sNewFile, nCutoff, fNewFormat);
+    METRICN(NEW_DOGS, NewDogs.DogCount());
+    CMetrics::EndPhase(CMetrics::PHASE_READ_NEW);
+    CMetrics::BeginPhase(CMetrics::PHASE_COMPARE);
+    CHouseholds Households;
+    if (sHouseholdsFile.empty()) {
+      Households.Add(OldDogs);  Households.Add(NewDogs);  Households.Build();
+    } else
+      Households.ReadFile(sHouseholdsFile, OldDogs, NewDogs);
+    CompareDogs(OldDogs, NewDogs, &Households);
+    NewDogs.FindSimilarChips();
+    if (sDomainsFile.empty()) CDogMatcher(NewDogs).ReportMissingDogs(OldDogs);
+    CMetrics::EndPhase(CMetrics::PHASE_COMPARE);
+    CMetrics::BeginPhase(CMetrics::PHASE_BUILD_UPDATES);
+    BuildUpdates(NewDogs, Chips);
+    CDomainChecker Domains;
+    if (sDomainsFile.empty()) Domains.Add(OldDogs);  else Domains.ReadCounts(sDomainsFile);
+    Domains.CheckDogs(NewDogs);
+    CMetrics::EndPhase(CMetrics::PHASE_BUILD_UPDATES);
+    CMetrics::BeginPhase(CMetrics::PHASE_WRITE_UPDATES);
+    Chips.WriteFile(sUpdatesFile);  METRICN(UPDATES, Chips.size());
+    CMetrics::EndPhase(CMetrics::PHASE_WRITE_UPDATES);
+    //   The chips point to the new dogs, so they have to go first.  With
+    // fFastExit none of them go at all ...
+    if (!fFastExit) {
+      delete pChips;  delete pNewDogs;  delete pOldDogs;
+      pChips = NULL;  pNewDogs = pOldDogs = NULL;
+    }
+    CMetrics::BeginPhase(CMetrics::PHASE_WRITE_ERRORS);
+    fWritingErrors = true;
+    if (fRawRows) {
+      CRowIndex NewIndex(sNewFile), OldIndex(sOldFile);
+      NewIndex.Open();  OldIndex.Open();
+      pBadDogs->AddRawRows(NewIndex, OldIndex);
+    }
+    pBadDogs->WriteFile();
+  } catch (...) {
+    //   Save whatever errors we found, unless writing them is what failed.
+    // Either way it's the original exception that goes to the caller ...
+    if (!fWritingErrors) {
+      try {pBadDogs->WriteFile();} catch (std::exception &) {}
+    }
+    delete pChips;  delete pNewDogs;  delete pOldDogs;  delete pBadDogs;  throw;
+  }
+  if (!fFastExit) delete pBadDogs;
+  CMetrics::EndPhase(CMetrics::PHASE_WRITE_ERRORS);
+}
+
+
+void FastExit (int nStatus)
+{
+  //++
+  //   Exit right now, without running any destructors at all - not even the
+  // static ones.  By the time main() calls this every output file has been
+  // written and closed (the updates and errors files, the metrics, the trace
+  // timeline, etc), so all that's left to flush is the console.  Whatever is
+  // still allocated (e.g. the dogs that RunUpdate() left behind, and the CArena
+  // chunks they're in) goes back to the operating system in one piece ...
+  //--
+  std::cout.flush();  std::cerr.flush();  fflush(NULL);
+  _Exit(nStatus);
+}
+
+
+void WriteTrace (CTracer *pTracer, const char *pszCommand)
+{
+  //++
+  //   Write the --trace file, if there is one, and then delete the CTracer.
+  // Everything else is done by now, so if the file can't be written then just
+  // say so and exit with the same status as any other failure.  This can't be
+  // left to the CTracer destructor - an exception from there would terminate
+  // the program ...
+  //--
+  if (pTracer == NULL) return;
+  try {
+    pTracer->WriteFile();
+  } catch (std::exception &e) {
+    MSGF("%s failed - %s\n", pszCommand, e.what());
+    FastExit(2);
+  }
+  delete pTracer;
+}
+
+
 void PrintUsage(void)
 {
   //++
@@ -275,14 +621,49 @@ void PrintUsage(void)
   // bogus...
   //--
   fprintf(stderr, "USAGE:\n");
-  fprintf(stderr, "\tMicrochipUpdate [-cnnnn] [-on] <old DIR> <new DIR> [[<updates>] [<errors>]]\n\n");
+  fprintf(stderr, "\tMicrochipUpdate [-cnnnn] [-on] [--trace=file] [--prometheus=file] [--raw] [--memory=mb] [--partitions=n] [--spill=path] <old DIR> <new DIR> [[<updates>] [<errors>]]\n");
+  fprintf(stderr, "\tMicrochipUpdate generate [-cnnnn] [-on] [<generator options>] <old DIR> <new DIR>\n");
+  fprintf(stderr, "\tMicrochipUpdate benchmark [-cnnnn] [-on] [<generator options>] [--max=n] [--dir=path] [--keep]\n");
+  fprintf(stderr, "\tMicrochipUpdate microbench [--seconds=n]\n");
+  fprintf(stderr, "\tMicrochipUpdate diff [-cnnnn] [-on] [<generator options>] [--dir=path] [<old DIR> <new DIR>]\n");
+  fprintf(stderr, "\tMicrochipUpdate row <DIR> <dog ID> ...\n");
+  fprintf(stderr, "\tMicrochipUpdate extract [-o] --where=expression <DIR> [<output>]\n");
+  fprintf(stderr, "\tMicrochipUpdate whatif [-on] --cutoffs=years <old DIR> <new DIR>\n");
+  fprintf(stderr, "\tMicrochipUpdate batch [-cnnnn] [-on] [--jobs=n] [--profiles=file] [--trace=file] <manifest>\n");
+  fprintf(stderr, "\tMicrochipUpdate shard [-cnnnn] [-on] [--shards=n] <old DIR> <new DIR> [<directory>]\n");
+  fprintf(stderr, "\tMicrochipUpdate merge <manifest> [<updates> [<errors>]]\n\n");
   fprintf(stderr, "\t-cnnnn    - set cutoff year to nnnn\n");
   fprintf(stderr, "\t-o or -o1 - old DIR is in the old format\n");
   fprintf(stderr, "\t-o2       - BOTH DIRs are in the old format\n");
+  fprintf(stderr, "\t--trace=file - write a Chrome/Perfetto trace event timeline to file\n");
+  fprintf(stderr, "\t--prometheus=file - write run metrics for the node_exporter textfile collector\n");
+  fprintf(stderr, "\t--raw     - add each dog's raw DIR row to the error report\n");
+  fprintf(stderr, "\t--memory=mb - compare the DIRs out of core in about this much memory\n");
+  fprintf(stderr, "\t--partitions=n - number of out of core partitions\n");
+  fprintf(stderr, "\t--spill=path - directory for the out of core partition files\n");
+  fprintf(stderr, "\t--where=expression - select the DIR rows to extract\n");
+  fprintf(stderr, "\t--cutoffs=years - cutoff years to try, e.g. 2015,2017-2020\n");
+  fprintf(stderr, "\t                  (the DIRs are read once, and only the rules\n");
+  fprintf(stderr, "\t                  that look at more than one dog run for each year)\n");
+  fprintf(stderr, "\t--jobs=n  - number of batch jobs to run at once\n");
+  fprintf(stderr, "\t--profiles=file - organization profiles for the batch\n");
+  fprintf(stderr, "\t--shards=n - number of shards to split the DIRs into\n");
+  fprintf(stderr, "\t<manifest> - batch jobs (Org, Old DIR, New DIR, Updates, Errors)\n");
+  fprintf(stderr, "\t<directory> - where to put the shards (default \".\")\n");
   fprintf(stderr, "\t<old DIR> - the previous Dog Information Report .csv file\n");
   fprintf(stderr, "\t<new DIR> - the current  Dog Information Report .csv file\n");
   fprintf(stderr, "\t<updates> - microchip update .csv file ready to send to Found.org\n");
-  fprintf(stderr, "\t<errors>  - error report .csv file\n");
+  fprintf(stderr, "\t<errors>  - error report .csv file (metrics go to <errors>.metrics.json)\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "\tgenerator options:\n");
+  fprintf(stderr, "\t--dogs=n    - number of dogs in the new DIR\n");
+  fprintf(stderr, "\t--recent=p  - percent of dogs acquired after the cutoff year\n");
+  fprintf(stderr, "\t--acquire=p - percent of new dogs that weren't in the old DIR\n");
+  fprintf(stderr, "\t--adopt=p   - percent of unadopted dogs adopted since the old DIR\n");
+  fprintf(stderr, "\t--return=p  - percent of adopted dogs returned since the old DIR\n");
+  fprintf(stderr, "\t--death=p   - percent of dogs that died since the old DIR\n");
+  fprintf(stderr, "\t--dirty=p   - percent chance of each kind of garbage in each dog\n");
+  fprintf(stderr, "\t--seed=n    - random number seed\n");
   fprintf(stderr, "\n");
 }
 
@@ -311,6 +692,84 @@ string ApplyDefaultExtension (const string sFileName, const char *pszType)
 }
 
 
+string ChangeExtension (const string sFileName, const char *pszType)
+{
+  //++
+  //   Replace the extension of the file name with a different one, keeping
+  // the drive and directory.  This is how we make up the name of the metrics
+  // file from the name of the errors file (e.g. "errors.csv" becomes
+  // "errors.metrics.json")...
+  //--
+  char szDrive[_MAX_DRIVE+1], szDirectory[_MAX_DIR+1];
+  char szFileName[_MAX_FNAME+1], szExtension[_MAX_EXT+1];
+  errno_t err = _splitpath_s(sFileName.c_str(), szDrive, sizeof(szDrive),
+                             szDirectory, sizeof(szDirectory), szFileName, sizeof(szFileName),
+                             szExtension, sizeof(szExtension));
+  if (err != 0) return sFileName + pszType;
+  return string(szDrive) + string(szDirectory) + string(szFileName) + string(pszType);
+}
+
+
+bool ParseNumber (const char *pszArg, const char *pszOption, uint64_t nMax, uint64_t &nValue)
+{
+  //++
+  //   If pszArg is the long option pszOption (e.g. "--dogs=") then parse the
+  // decimal value that follows and return true.  If it's some other option,
+  // or if the value is bogus or larger than nMax, return false ...
+  //--
+  size_t nLen = strlen(pszOption);  char *psz;
+  if (!STRNEQL(pszArg, pszOption, nLen) || (pszArg[nLen] == '\0')) return false;
+  nValue = strtoull(&pszArg[nLen], &psz, 10);
+  return (*psz == '\0') && (nValue <= nMax);
+}
+
+
+bool ParseCutoffs (const char *pszList)
+{
+  //++
+  //   Parse a list of cutoff years for "whatif", e.g. "2015,2017-2020".  Each
+  // year has to be in the same range that -c allows ...
+  //--
+  for (const char *psz = pszList;;) {
+    char *pszEnd;
+    uint32_t nFirst = (uint32_t) strtoul(psz, &pszEnd, 10), nLast = nFirst;
+    if (pszEnd == psz) return false;
+    if (*pszEnd == '-') {
+      psz = pszEnd+1;  nLast = (uint32_t) strtoul(psz, &pszEnd, 10);
+      if (pszEnd == psz) return false;
+    }
+    if ((nFirst < 2010) || (nLast > 2050) || (nFirst > nLast)) return false;
+    for (uint32_t nYear = nFirst;  nYear <= nLast;  ++nYear) g_vecCutoffs.push_back(nYear);
+    if (*pszEnd == '\0') return true;
+    if (*pszEnd != ',') return false;
+    psz = pszEnd+1;
+  }
+}
+
+
+bool ParseGeneratorOption (const char *pszArg)
+{
+  //++
+  //   Parse one of the synthetic DIR generator options (or one of the benchmark
+  // options).  Returns false if the option isn't recognized ...
+  //--
+  uint64_t n;
+  if (ParseNumber(pszArg, "--dogs=", CBenchmark::MAX_DOGS*10ULL, n)) g_Generator.SetDogCount((size_t) n);
+  else if (ParseNumber(pszArg, "--recent=",  100, n)) g_Generator.SetRecentPercent((uint32_t) n);
+  else if (ParseNumber(pszArg, "--acquire=", 100, n)) g_Generator.SetAcquirePercent((uint32_t) n);
+  else if (ParseNumber(pszArg, "--adopt=",   100, n)) g_Generator.SetAdoptPercent((uint32_t) n);
+  else if (ParseNumber(pszArg, "--return=",  100, n)) g_Generator.SetReturnPercent((uint32_t) n);
+  else if (ParseNumber(pszArg, "--death=",   100, n)) g_Generator.SetDeathPercent((uint32_t) n);
+  else if (ParseNumber(pszArg, "--dirty=",   100, n)) g_Generator.SetDirtyPercent((uint32_t) n);
+  else if (ParseNumber(pszArg, "--seed=", UINT64_MAX, n)) g_Generator.SetSeed(n);
+  else if ((g_nCommand == CMD_BENCHMARK) && ParseNumber(pszArg, "--max=", CBenchmark::MAX_DOGS*10ULL, n)) g_nBenchmarkDogs = (size_t) n;
+  else if (((g_nCommand == CMD_BENCHMARK) || (g_nCommand == CMD_DIFF)) && STRNEQL(pszArg, "--dir=", 6) && (pszArg[6] != '\0')) g_sBenchmarkDir = &pszArg[6];
+  else if ((g_nCommand == CMD_BENCHMARK) && STREQL(pszArg, "--keep")) g_fBenchmarkKeep = true;
+  else return false;
+  return true;
+}
+
+
 bool ParseArguments (int argc, char *argv[])
 {
   //++
@@ -318,6 +777,53 @@ bool ParseArguments (int argc, char *argv[])
   //--
   int nArg = 1;  --argc;
 
+  // See if there's a command first ...
+  if ((argc > 0) && STREQL(argv[nArg], "generate")) {
+    g_nCommand = CMD_GENERATE;  ++nArg;  --argc;
+  } else if ((argc > 0) && STREQL(argv[nArg], "benchmark")) {
+    g_nCommand = CMD_BENCHMARK;  ++nArg;  --argc;
+  } else if ((argc > 0) && STREQL(argv[nArg], "diff")) {
+    g_nCommand = CMD_DIFF;  ++nArg;  --argc;
+    g_Generator.SetDogCount(CDiffHarness::DEFAULT_DOGS);
+  } else if ((argc > 0) && STREQL(argv[nArg], "microbench")) {
+    g_nCommand = CMD_MICROBENCH;  ++nArg;  --argc;
+    uint64_t n;
+    for (;  argc > 0;  ++nArg, --argc) {
+      if (!ParseNumber(argv[nArg], "--seconds=", 3600, n) || (n == 0)) return false;
+      g_nMicroSeconds = (uint32_t) n;
+    }
+    return true;
+  } else if ((argc > 0) && STREQL(argv[nArg], "row")) {
+    //   The "row" command takes a DIR file name and one or more dog IDs (e.g.
+    // "12345" or "ABC-123"), and nothing else ...
+    g_nCommand = CMD_ROW;  ++nArg;  --argc;
+    if (argc < 2) return false;
+    g_sNewDogsFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);  --argc;
+    uint64_t nKey;
+    for (;  argc > 0;  ++nArg, --argc) {
+      if (!CRowIndex::ParseKey(argv[nArg], nKey)) return false;
+      g_vecRowIDs.push_back(argv[nArg]);
+    }
+    return true;
+  } else if ((argc > 0) && STREQL(argv[nArg], "extract")) {
+    g_nCommand = CMD_EXTRACT;  ++nArg;  --argc;
+  } else if ((argc > 0) && STREQL(argv[nArg], "whatif")) {
+    g_nCommand = CMD_WHATIF;  ++nArg;  --argc;
+  } else if ((argc > 0) && STREQL(argv[nArg], "batch")) {
+    g_nCommand = CMD_BATCH;  ++nArg;  --argc;
+  } else if ((argc > 0) && STREQL(argv[nArg], "shard")) {
+    g_nCommand = CMD_SHARD;  ++nArg;  --argc;
+  } else if ((argc > 0) && STREQL(argv[nArg], "merge")) {
+    //   Merge takes the manifest written by "shard" and, optionally, the
+    // names of the merged files, and no options ...
+    g_nCommand = CMD_MERGE;  ++nArg;  --argc;
+    if ((argc < 1) || (argc > 3)) return false;
+    g_sManifestFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);  --argc;
+    if (argc > 0) {g_sUpdatesFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);  --argc;}
+    if (argc > 0) {g_sErrorsFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);  --argc;}
+    return true;
+  }
+
   //   Check for -o and -c options first ...  If present, these have to be
   // at the beginning of the command line.  Actually there's no reason why
   // they "have" to be, but this parser is pretty simple minded...
@@ -332,16 +838,79 @@ bool ParseArguments (int argc, char *argv[])
       g_nCutoffYear = (int) strtoul(&argv[nArg][2], &psz, 10);
       if (*psz != '\0') return false;
       if ((g_nCutoffYear < 2010) || (g_nCutoffYear > 2050)) return false;
+    } else if (((g_nCommand == CMD_UPDATE) || (g_nCommand == CMD_BATCH)) && STRNEQL(argv[nArg], "--trace=", 8) && (argv[nArg][8] != '\0')) {
+      g_sTraceFile = &argv[nArg][8];
+    } else if (((g_nCommand == CMD_UPDATE) || (g_nCommand == CMD_BATCH)) && STREQL(argv[nArg], "--trace") && (argc > 1)) {
+      g_sTraceFile = argv[++nArg];  --argc;
+    } else if ((g_nCommand == CMD_UPDATE) && STRNEQL(argv[nArg], "--prometheus=", 13) && (argv[nArg][13] != '\0')) {
+      g_sPrometheusFile = &argv[nArg][13];
+    } else if ((g_nCommand == CMD_UPDATE) && STREQL(argv[nArg], "--raw")) {
+      g_fRawRows = true;
+    } else if ((g_nCommand == CMD_UPDATE) && STRNEQL(argv[nArg], "--memory=", 9)) {
+      uint64_t n;
+      if (!ParseNumber(argv[nArg], "--memory=", UINT32_MAX, n) || (n == 0)) return false;
+      g_nMemory = n;
+    } else if ((g_nCommand == CMD_UPDATE) && STRNEQL(argv[nArg], "--partitions=", 13)) {
+      uint64_t n;
+      if (!ParseNumber(argv[nArg], "--partitions=", CPartitions::MAX_PARTITIONS, n) || (n == 0)) return false;
+      g_nPartitions = (unsigned) n;
+    } else if ((g_nCommand == CMD_UPDATE) && STRNEQL(argv[nArg], "--spill=", 8) && (argv[nArg][8] != '\0')) {
+      g_sSpillDir = &argv[nArg][8];
+    } else if ((g_nCommand == CMD_EXTRACT) && STRNEQL(argv[nArg], "--where=", 8) && (argv[nArg][8] != '\0')) {
+      g_sWhere = &argv[nArg][8];
+    } else if ((g_nCommand == CMD_EXTRACT) && STREQL(argv[nArg], "--where") && (argc > 1)) {
+      g_sWhere = argv[++nArg];  --argc;
+    } else if ((g_nCommand == CMD_WHATIF) && STRNEQL(argv[nArg], "--cutoffs=", 10)) {
+      if (!ParseCutoffs(&argv[nArg][10])) return false;
+    } else if ((g_nCommand == CMD_BATCH) && STRNEQL(argv[nArg], "--jobs=", 7)) {
+      uint64_t n;
+      if (!ParseNumber(argv[nArg], "--jobs=", 256, n) || (n == 0)) return false;
+      g_nJobs = (unsigned) n;
+    } else if ((g_nCommand == CMD_BATCH) && STRNEQL(argv[nArg], "--profiles=", 11) && (argv[nArg][11] != '\0')) {
+      g_sProfilesFile = ApplyDefaultExtension(&argv[nArg][11], DEFAULT_EXTENSION);
+    } else if ((g_nCommand == CMD_SHARD) && STRNEQL(argv[nArg], "--shards=", 9)) {
+      uint64_t n;
+      if (!ParseNumber(argv[nArg], "--shards=", CShards::MAX_SHARDS, n) || (n == 0)) return false;
+      g_nShards = (unsigned) n;
+    } else if ((g_nCommand != CMD_UPDATE) && (g_nCommand != CMD_EXTRACT) && (g_nCommand != CMD_WHATIF) && (g_nCommand != CMD_BATCH) && (g_nCommand != CMD_SHARD) && ParseGeneratorOption(argv[nArg])) {
+      ;
     } else
       return false;
     ++nArg;  --argc;
   }
 
+  //   The benchmark doesn't need any file names at all, and for diff the
+  // recorded DIRs are optional ...
+  if (g_nCommand == CMD_BENCHMARK) return (argc == 0);
+  if ((g_nCommand == CMD_DIFF) && (argc == 0)) return true;
+
+  // Extract needs a --where, one DIR, and optionally the output file ...
+  if (g_nCommand == CMD_EXTRACT) {
+    if (g_sWhere.empty() || (argc < 1) || (argc > 2)) return false;
+    g_sNewDogsFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);
+    if (argc > 1) g_sExtractFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);
+    return true;
+  }
+
+  // Batch needs just the manifest - everything else is in there ...
+  if (g_nCommand == CMD_BATCH) {
+    if (argc != 1) return false;
+    g_sManifestFile = ApplyDefaultExtension(argv[nArg], DEFAULT_EXTENSION);
+    return true;
+  }
+
   // The OLD DIR and NEW DIR file names are required ...
   if (argc < 2) return false;
   g_sOldDogsFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);
   g_sNewDogsFile = ApplyDefaultExtension(argv[nArg++], DEFAULT_EXTENSION);
   argc -= 2;
+  if ((g_nCommand == CMD_GENERATE) || (g_nCommand == CMD_DIFF)) return (argc == 0);
+  if (g_nCommand == CMD_WHATIF) return (argc == 0) && !g_vecCutoffs.empty();
+  if (g_nCommand == CMD_SHARD) {
+    if (argc > 1) return false;
+    if (argc > 0) g_sShardDir = argv[nArg];
+    return true;
+  }
 
   // Now parse the optional file names ...
   if (argc > 0) {
@@ -360,15 +929,122 @@ int main (int argc, char *argv[])
   //   Parse the command line, read the input files, compare the two reports,
   // and generate an update file for Found.org.  Easy!
   //--
-  if (ParseArguments(argc, argv)) {
-    CBadDogs baddogs(g_sErrorsFile);  CDogs OldDogs, NewDogs;
-    OldDogs.ReadFile(g_sOldDogsFile, g_nCutoffYear, g_fOldDogsFormat);
-    NewDogs.ReadFile(g_sNewDogsFile, g_nCutoffYear, g_fNewDogsFormat);
-    CompareDogs(OldDogs, NewDogs);
-    CChips Chips;
-    BuildUpdates(NewDogs, Chips);
-    Chips.WriteFile(g_sUpdatesFile);
-  } else
+  if (!ParseArguments(argc, argv)) {
     PrintUsage();
-  exit(1);
+  } else if (g_nCommand == CMD_GENERATE) {
+    g_Generator.SetCutoffYear(g_nCutoffYear);
+    g_Generator.SetFormats(g_fOldDogsFormat, g_fNewDogsFormat);
+    g_Generator.Generate(g_sOldDogsFile, g_sNewDogsFile);
+  } else if (g_nCommand == CMD_BENCHMARK) {
+    CBenchmark bench(g_Generator);
+    bench.SetMaxDogs(g_nBenchmarkDogs);
+    bench.SetDirectory(g_sBenchmarkDir);
+    bench.SetKeepFiles(g_fBenchmarkKeep);
+    bench.Run(g_nCutoffYear, g_fOldDogsFormat, g_fNewDogsFormat);
+    bench.Report();
+  } else if (g_nCommand == CMD_MICROBENCH) {
+    CMicroBenchmark bench;
+    bench.SetMinSeconds(g_nMicroSeconds);
+    bench.Run();
+    bench.Report();
+  } else if (g_nCommand == CMD_DIFF) {
+    //   The harness is usually run unattended, so if it can't even start (e.g.
+    // the --dir doesn't exist or can't be written) say so plainly and exit
+    // with a status that's different from the usual one, rather than letting
+    // the exception abort the program ...
+    try {
+      CDiffHarness harness(g_Generator);
+      harness.SetDirectory(g_sBenchmarkDir);
+      harness.SetCutoffYear(g_nCutoffYear);
+      harness.SetFormats(g_fOldDogsFormat, g_fNewDogsFormat);
+      if (!g_sOldDogsFile.empty()) harness.SetRecorded(g_sOldDogsFile, g_sNewDogsFile);
+      harness.Run();
+      harness.Report();
+    } catch (std::exception &e) {
+      MSGF("MicrochipUpdate diff failed - %s\n", e.what());
+      FastExit(2);
+    }
+  } else if (g_nCommand == CMD_ROW) {
+    //   A DIR that's missing or can't be read is reported the same way "diff"
+    // does, rather than aborting the program ...
+    try {
+      CRowIndex index(g_sNewDogsFile);
+      if (!index.Open()) ERRS("unable to open " << g_sNewDogsFile);
+      for (vector<string>::const_iterator it = g_vecRowIDs.begin();  it != g_vecRowIDs.end();  ++it) {
+        string sRecord;  uint64_t nKey;
+        if (CRowIndex::ParseKey(*it, nKey) && index.ReadRaw(nKey, sRecord))
+          std::cout << sRecord << std::endl;
+        else
+          MSGS("dog #" << *it << " not found in " << g_sNewDogsFile);
+      }
+    } catch (std::exception &e) {
+      MSGF("MicrochipUpdate row failed - %s\n", e.what());
+      FastExit(2);
+    }
+  } else if (g_nCommand == CMD_EXTRACT) {
+    //   The expression is compiled for the DIR's format (-o and -o2 both
+    // clear g_fOldDogsFormat) and then applied to each record as it's read,
+    // so only the matching rows are ever parsed.  A mistyped expression or a
+    // DIR that can't be read is a user error, so it's reported like "diff"
+    // does rather than aborting the program ...
+    try {
+      CWhere where;  CCSVFile csv;
+      const string &sHeader = g_fOldDogsFormat ? CDog::m_sNewColumnHeaders : CDog::m_sOldColumnHeaders;
+      if (!where.Compile(g_sWhere, g_fOldDogsFormat))
+        ERRS("--where " << where.GetError());
+      csv.Read(g_sNewDogsFile, sHeader, &where);
+      MSGS("Selected " << csv.size() << " rows from " << g_sNewDogsFile);
+      size_t nRows = csv.Write(g_sExtractFile, sHeader);
+      MSGS("Wrote " << nRows << " rows to " << g_sExtractFile);
+    } catch (std::exception &e) {
+      MSGF("MicrochipUpdate extract failed - %s\n", e.what());
+      FastExit(2);
+    }
+  } else if (g_nCommand == CMD_WHATIF) {
+    CWhatIf whatif;
+    whatif.SetCutoffs(g_vecCutoffs);
+    whatif.Run(g_sOldDogsFile, g_fOldDogsFormat, g_sNewDogsFile, g_fNewDogsFormat);
+    whatif.Report();
+  } else if (g_nCommand == CMD_BATCH) {
+    CTracer *pTracer = g_sTraceFile.empty() ? NULL : new CTracer(g_sTraceFile);
+    CBatch batch;
+    batch.SetWorkers(g_nJobs);
+    batch.SetCutoffYear(g_nCutoffYear);
+    batch.SetFormats(g_fOldDogsFormat, g_fNewDogsFormat);
+    if (!g_sProfilesFile.empty()) batch.ReadProfiles(g_sProfilesFile);
+    batch.ReadManifest(g_sManifestFile);
+    batch.Run();
+    batch.Report();
+    WriteTrace(pTracer, "MicrochipUpdate batch");
+  } else if (g_nCommand == CMD_SHARD) {
+    CShards shards;
+    shards.SetShards(g_nShards);
+    shards.SetCutoffYear(g_nCutoffYear);
+    shards.SetFormats(g_fOldDogsFormat, g_fNewDogsFormat);
+    shards.SetDirectory(g_sShardDir);
+    shards.Split(g_sOldDogsFile, g_sNewDogsFile);
+  } else if (g_nCommand == CMD_MERGE) {
+    CShards::Merge(g_sManifestFile, g_sUpdatesFile, g_sErrorsFile);
+  } else {
+    CTracer *pTracer = g_sTraceFile.empty() ? NULL : new CTracer(g_sTraceFile);
+    CMetrics metrics;
+    metrics.SetLabel("old_dir", g_sOldDogsFile);
+    metrics.SetLabel("new_dir", g_sNewDogsFile);
+    metrics.SetLabel("cutoff_year", std::to_string(g_nCutoffYear));
+    if ((g_nMemory != 0) || (g_nPartitions != 0)) {
+      CPartitions partitions;
+      if (g_nMemory != 0) partitions.SetMemory(g_nMemory);
+      partitions.SetPartitions(g_nPartitions);
+      partitions.SetDirectory(g_sSpillDir);
+      partitions.Run(g_sOldDogsFile, g_fOldDogsFormat, g_sNewDogsFile, g_fNewDogsFormat,
+                     g_nCutoffYear, g_sUpdatesFile, g_sErrorsFile, g_fRawRows);
+    } else
+      RunUpdate(g_sOldDogsFile, g_fOldDogsFormat, g_sNewDogsFile, g_fNewDogsFormat,
+                g_nCutoffYear, g_sUpdatesFile, g_sErrorsFile, g_fRawRows, true);
+    metrics.WriteJSON(ChangeExtension(g_sErrorsFile, METRICS_EXTENSION));
+    if (!g_sPrometheusFile.empty()) metrics.WritePrometheus(g_sPrometheusFile);
+    if (CAllocations::IsEnabled()) metrics.Report();
+    WriteTrace(pTracer, "MicrochipUpdate");
+  }
+  FastExit(1);
 }
@@ -0,0 +1,72 @@
+//++
+// MicrochipUpdate.hpp -> main program processing steps
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This header declares the processing steps implemented by the main program
+// module, MicrochipUpdate.cpp, so that other modules (e.g. the benchmark) can
+// run the same pipeline that main() does.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   CompareDogs() takes an optional CHouseholds.
+// 17-OCT-26  AGT   Add RunUpdate() and ChangeExtension() for CBatch.
+// 17-OCT-26  AGT   CompareDogs() can run just some of its passes.
+// 17-OCT-26  AGT   RunUpdate() can leave its objects for FastExit().
+// 17-OCT-26  AGT   RunUpdate() can learn its email domains from a file.
+// 17-OCT-26  AGT   Split the family changed check into COMPARE_FAMILY.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+using std::string;              // ...
+class CDogs;                    // ...
+class CChips;                   // ...
+class CHouseholds;              // ...
+
+// The passes of CompareDogs(), in the order they run ...
+enum {
+  COMPARE_MISSING     = 0x01,         // old dogs missing from the new DIR
+  COMPARE_ACQUIRED    = 0x02,         // new dogs and microchip changes
+  COMPARE_NO_ADOPTER  = 0x04,         // adopted with no adopter recorded
+  COMPARE_NOT_ADOPTED = 0x08,         // adopter recorded but not adopted
+  COMPARE_DISPOSITION = 0x10,         // disposition date but still available
+  COMPARE_ADOPTED     = 0x20,         // recently adopted
+  COMPARE_RETURNED    = 0x40,         // returned to NGRR
+  COMPARE_FAMILY      = 0x80,         // adopting family changed
+  COMPARE_ALL         = 0xFF          // all of the above
+};
+//   Compare the old and new DIRs and flag the dogs that need updates.  If an
+// adopter household index is given, then a change of adopter within the same
+// household isn't reported.  Normally all the passes are run, but CPartitions
+// runs them one at a time.  COMPARE_FAMILY is checked in the same loop as
+// COMPARE_ADOPTED, so it comes out in that order ...
+extern void CompareDogs (const CDogs &OldDogs, CDogs &NewDogs, const CHouseholds *pHouseholds=NULL, uint32_t nPasses=COMPARE_ALL);
+// Build the Found.org updates for all flagged dogs ...
+extern void BuildUpdates (CDogs &Dogs, CChips &Chips);
+//   Do one whole update run (everything but the metrics file) on the current
+// thread.  The errors file is written even if something throws.  A run with
+// a domains or households file is one shard of a bigger run (see CShards) ...
+extern void RunUpdate (const string &sOldFile, bool fOldFormat, const string &sNewFile, bool fNewFormat,
+                       uint32_t nCutoff, const string &sUpdatesFile, const string &sErrorsFile, bool fRawRows=false,
+                       bool fFastExit=false, const string &sDomainsFile="", const string &sHouseholdsFile="");
+// Replace the extension of a file name (e.g. to make the metrics file name) ...
+extern string ChangeExtension (const string sFileName, const char *pszType);
+#define METRICS_EXTENSION ".metrics.json" // file type for the metrics file
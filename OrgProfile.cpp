@@ -0,0 +1,140 @@
+//++
+// OrgProfile.cpp - implementation of the COrgProfile and COrgProfiles classes
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the COrgProfile class, which holds the registration
+// details for one rescue organization, and the COrgProfiles collection.  See
+// OrgProfile.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <ctype.h>              // toupper() ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Chip.hpp"             // NGRR_xyz constants
+#include "OrgProfile.hpp"       // declarations for this module
+
+// This is the expected header row for the profiles file ...
+const string COrgProfile::m_sColumnHeaders("Org, Name, First Name, Last Name, Email, Phone, Species, Breed");
+
+// The built in NGRR profile, and the current profile for each thread ...
+const COrgProfile COrgProfile::m_NGRR;
+thread_local const COrgProfile *COrgProfile::m_pCurrent = NULL;
+
+
+COrgProfile::COrgProfile()
+{
+  //++
+  //   Every profile starts out as a copy of the NGRR defaults, so a profile
+  // file only has to fill in the columns that are different ...
+  //--
+  m_sOrg       = "NGRR";
+  m_sName      = "NGRR";
+  m_sFirstName = NGRR_FIRST_NAME;
+  m_sLastName  = NGRR_LAST_NAME;
+  m_seMail     = NGRR_EMAIL_ADDRESS;
+  m_sPhone     = NGRR_PHONE_NUMBER;
+  m_sSpecies   = NGRR_SPECIES;
+  m_sBreed     = NGRR_PRIMARY_BREED;
+}
+
+
+bool COrgProfile::FromRow (const CCSVRow &row)
+{
+  //++
+  //   Extract the profile from one row of the profiles file.  The code and
+  // the name are required, but any other empty column keeps the NGRR value.
+  // Returns false if the row is bogus ...
+  //--
+  if (row.size() != TOTAL_COLUMNS) return false;
+  if (row[COL_ORG-1].empty() || row[COL_NAME-1].empty()) return false;
+  m_sOrg = row[COL_ORG-1];
+  for (size_t i = 0;  i < m_sOrg.length();  ++i)  m_sOrg[i] = toupper(m_sOrg[i]);
+  m_sName = row[COL_NAME-1];
+  if (!row[COL_FIRST_NAME-1].empty()) m_sFirstName = row[COL_FIRST_NAME-1];
+  if (!row[COL_LAST_NAME-1].empty())  m_sLastName  = row[COL_LAST_NAME-1];
+  if (!row[COL_EMAIL-1].empty())      m_seMail     = row[COL_EMAIL-1];
+  if (!row[COL_PHONE-1].empty())      m_sPhone     = row[COL_PHONE-1];
+  if (!row[COL_SPECIES-1].empty())    m_sSpecies   = row[COL_SPECIES-1];
+  if (!row[COL_BREED-1].empty())      m_sBreed     = row[COL_BREED-1];
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+
+void COrgProfiles::DeleteAll()
+{
+  //++
+  // Delete all the COrgProfile objects in this collection ...
+  //--
+  for (vector<COrgProfile *>::iterator it = m_vecProfiles.begin();  it != m_vecProfiles.end();  ++it)
+    delete *it;
+  m_vecProfiles.clear();
+}
+
+
+void COrgProfiles::ReadFile (const string &sFileName)
+{
+  //++
+  //   Read the profiles file.  A bad row or a duplicate organization is an
+  // error - it's better to stop now than to register somebody's dogs with
+  // the wrong rescue ...
+  //--
+  CCSVFile csv;
+  size_t nRows = csv.Read(sFileName, COrgProfile::m_sColumnHeaders);
+  for (size_t i = 0;  i < csv.size();  ++i) {
+    COrgProfile *pProfile = new COrgProfile;
+    if (!pProfile->FromRow(*csv[i])) {
+      delete pProfile;  ERRS("invalid profile in row " << (i+2) << " of " << sFileName);
+    }
+    const COrgProfile *pOld = Find(pProfile->GetOrg());
+    if ((pOld != NULL) && (pOld != COrgProfile::GetNGRR())) {
+      string sOrg = pProfile->GetOrg();  delete pProfile;
+      ERRS("duplicate profile for " << sOrg << " in " << sFileName);
+    }
+    m_vecProfiles.push_back(pProfile);
+  }
+  MSGS("Read " << nRows << " organization profiles from " << sFileName);
+}
+
+
+const COrgProfile *COrgProfiles::Find (const string &sOrg) const
+{
+  //++
+  //   Find a profile by its organization code.  If the file didn't have one
+  // for NGRR then the built in profile is used ...
+  //--
+  string sUpper(sOrg);
+  for (size_t i = 0;  i < sUpper.length();  ++i)  sUpper[i] = toupper(sUpper[i]);
+  for (vector<COrgProfile *>::const_iterator it = m_vecProfiles.begin();  it != m_vecProfiles.end();  ++it)
+    if ((*it)->GetOrg() == sUpper) return *it;
+  const COrgProfile *pNGRR = COrgProfile::GetNGRR();
+  return (pNGRR->GetOrg() == sUpper) ? pNGRR : NULL;
+}
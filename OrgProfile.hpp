@@ -0,0 +1,155 @@
+//++
+// OrgProfile.hpp -> registration details for each rescue organization
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   When a dog hasn't been adopted the Found.org registration is in the name
+// of the rescue, and every update carries the rescue's email address, the
+// species and breed, and a note with the rescue's dog number.  Those used to
+// be the NGRR_xyz #defines in Chip.hpp, which was fine as long as there was
+// only one rescue.  Now we process DIRs for partner groups too, so a
+// COrgProfile holds those details for one organization and CChip::ToRow()
+// asks for the current one.
+//
+//   The current profile is kept per thread, so that several jobs for several
+// organizations can run at the same time (see CBatch).  If a thread never
+// sets one then it gets the built in NGRR profile, made from the old
+// #defines, and a plain update run works exactly the same as it always did.
+//
+//   A COrgProfiles collection is read from a CSV file with one row per
+// organization -
+//
+//      Org, Name, First Name, Last Name, Email, Phone, Species, Breed
+//
+// "Org" is the short code that the batch manifest uses (e.g. "GRRA"), and
+// "Name" goes in the notes field (e.g. "GRRA #1234").  The file can redefine
+// NGRR too, but it doesn't have to - the built in profile is always there.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+class CCSVRow;                  // ...
+
+
+class COrgProfile {
+  //++
+  // Registration details for one rescue organization ...
+  //--
+
+public:
+  // Column numbers in the profiles file ...
+  enum {
+    COL_ORG             = 1,    // short organization code
+    COL_NAME            = 2,    // name for the notes field
+    COL_FIRST_NAME      = 3,    // "first name" for registration
+    COL_LAST_NAME       = 4,    // "last name"   "     "     "
+    COL_EMAIL           = 5,    // rescue email address
+    COL_PHONE           = 6,    //   "    phone number
+    COL_SPECIES         = 7,    // species (e.g. "Dog")
+    COL_BREED           = 8,    // primary breed
+    TOTAL_COLUMNS       = 8     // number of columns in the profiles file
+  };
+  // This is the expected header row for the profiles file ...
+  static const string m_sColumnHeaders;
+
+public:
+  // Constructor and destructor (a new profile is a copy of NGRR's) ...
+  COrgProfile();
+  virtual ~COrgProfile() {};
+  // Copy and assignment constructors ...
+  COrgProfile (const COrgProfile &p) = delete;
+  COrgProfile& operator= (const COrgProfile &p) = delete;
+
+  // COrgProfile properties ...
+public:
+  string GetOrg() const {return m_sOrg;}
+  string GetName() const {return m_sName;}
+  string GetFirstName() const {return m_sFirstName;}
+  string GetLastName() const {return m_sLastName;}
+  string GeteMail() const {return m_seMail;}
+  string GetPhone() const {return m_sPhone;}
+  string GetSpecies() const {return m_sSpecies;}
+  string GetBreed() const {return m_sBreed;}
+  // Return the current thread's profile (NGRR if none was set) ...
+  static const COrgProfile *Get() {return (m_pCurrent != NULL) ? m_pCurrent : &m_NGRR;}
+  // Set (or, with NULL, clear) the current thread's profile ...
+  static void SetCurrent (const COrgProfile *pProfile) {m_pCurrent = pProfile;}
+  // Return the built in NGRR profile ...
+  static const COrgProfile *GetNGRR() {return &m_NGRR;}
+
+  // COrgProfile public methods ...
+public:
+  // Extract the profile from a row of the profiles file ...
+  bool FromRow (const CCSVRow &row);
+
+  // Local COrgProfile members ...
+protected:
+  string    m_sOrg;             // COL_ORG (always upper case)
+  string    m_sName;            // COL_NAME
+  string    m_sFirstName;       // COL_FIRST_NAME
+  string    m_sLastName;        // COL_LAST_NAME
+  string    m_seMail;           // COL_EMAIL
+  string    m_sPhone;           // COL_PHONE
+  string    m_sSpecies;         // COL_SPECIES
+  string    m_sBreed;           // COL_BREED
+  // The built in profile and this thread's current one ...
+  static const COrgProfile m_NGRR;
+  static thread_local const COrgProfile *m_pCurrent;
+};
+
+
+class COrgProfiles {
+  //++
+  // Collection of COrgProfile objects, by organization code ...
+  //--
+
+public:
+  // Constructor and destructor ...
+  COrgProfiles() {};
+  virtual ~COrgProfiles() {DeleteAll();}
+  // Copy and assignment constructors ...
+  COrgProfiles (const COrgProfiles &p) = delete;
+  COrgProfiles& operator= (const COrgProfiles &p) = delete;
+
+  // COrgProfiles properties ...
+public:
+  // Return the number of profiles read from the file ...
+  size_t size() const {return m_vecProfiles.size();}
+
+  // COrgProfiles public methods ...
+public:
+  // Delete all the profiles ...
+  void DeleteAll();
+  // Read the profiles file ...
+  void ReadFile (const string &sFileName);
+  // Find a profile by code (case insensitive), or NULL if there's none ...
+  const COrgProfile *Find (const string &sOrg) const;
+
+  // Local COrgProfiles members ...
+protected:
+  vector<COrgProfile *> m_vecProfiles;  // profiles, in file order
+};
@@ -0,0 +1,476 @@
+//++
+// Partition.cpp - implementation of the CPartitions class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CPartitions class, which does an update run
+// one partition of the dogs at a time.  See Partition.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Run COMPARE_FAMILY in the same pass as COMPARE_ADOPTED.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdio.h>              // remove() ...
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::ifstream, std::ofstream ...
+#include <algorithm>            // std::min(), std::stable_sort() ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVDialect.hpp"       // CSV file format conventions
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Encoding.hpp"         // UTF-8 normalization
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Chip.hpp"             // CChip data and CChips collection
+#include "DogMatcher.hpp"       // find re-entered dogs
+#include "RowIndex.hpp"         // sidecar row offset index
+#include "Shard.hpp"            // CShards::GetShard()
+#include "Metrics.hpp"          // METRIC() macro, et al ...
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "MicrochipUpdate.hpp"  // CompareDogs(), BuildUpdates(), etc
+#include "Partition.hpp"        // declarations for this module
+
+// File names in the spill directory ...
+const char *CPartitions::m_pszPrefix = "part";
+
+
+CPartitions::CPartitions()
+{
+  //++
+  // The default budget is a gigabyte ...
+  //--
+  m_nMemory = 1ULL << 30;  m_nPartitions = m_nUsed = 0;  m_sDirectory = ".";
+}
+
+
+string CPartitions::GetFileName (const string &sName) const
+{
+  //++
+  // Return the full name of a file in the spill directory ...
+  //--
+  string sFile = string(m_pszPrefix) + "." + sName;
+  return m_sDirectory.empty() ? sFile : (m_sDirectory + "/" + sFile);
+}
+
+
+string CPartitions::GetPartitionName (const char *pszWhich, unsigned nPartition) const
+{
+  //++
+  // Return the name of one partition file, e.g. "part.old.003.csv" ...
+  //--
+  return GetFileName(CBadDogs::Print("%s.%03u.csv", pszWhich, nPartition));
+}
+
+
+unsigned CPartitions::ChoosePartitions (const string &sOldFile, const string &sNewFile) const
+{
+  //++
+  //   Pick the number of partitions so that one pair of them, once it's been
+  // made into CDogs, fits in the memory budget.  All we have to go on is the
+  // size of the DIRs, and the dogs before the cutoff don't count, so this
+  // is on the generous side ...
+  //--
+  if (m_nPartitions != 0) return m_nPartitions;
+  uint64_t nBytes = 0;
+  const string *apsFiles[2] = {&sOldFile, &sNewFile};
+  for (unsigned i = 0;  i < 2;  ++i) {
+    std::ifstream stm(*apsFiles[i], std::ios::in | std::ios::binary | std::ios::ate);
+    if (!stm.is_open()) ERRS("CPartitions::Run() unable to open " << *apsFiles[i]);
+    nBytes += (uint64_t) stm.tellg();
+  }
+  uint64_t nPartitions = (nBytes*MEMORY_FACTOR + m_nMemory-1) / m_nMemory;
+  return (unsigned) std::min(std::max(nPartitions, (uint64_t) 1), (uint64_t) MAX_PARTITIONS);
+}
+
+
+void CPartitions::SplitFile (const string &sFileName, bool fNew, bool fOld, uint32_t nCutoff, DIR_SUMMARY &dir)
+{
+  //++
+  //   Stream one DIR into its partition files.  This reads the records the
+  // same way CShards::SplitFile() does, and each dog goes thru the same tests,
+  // in the same order, as in CDogs::ReadFile() and CDogs::Add().  The errors
+  // from those tests are reported here, in file order, exactly like a normal
+  // run would, and only the dogs that are kept go to a partition.  Along the
+  // way we collect everything about the DIR that the later steps need.
+  //
+  //   fNew is the format of the DIR and fOld says which DIR it is.  Note
+  // that the old DIR has to be done first - the new DIR needs its keys ...
+  //--
+  TRACE_SCOPE("split dir");
+  const string &sHeader = fNew ? CDog::m_sNewColumnHeaders : CDog::m_sOldColumnHeaders;
+  std::ifstream stm(sFileName, std::ios::in | std::ios::binary);
+  if (!stm.is_open()) ERRS("CPartitions::Run() unable to open " << sFileName);
+  stm.seekg(0, std::ios::end);
+  uint64_t nBytes = (uint64_t) stm.tellg();
+  if (nBytes > 0) METRICN(BYTES_READ, nBytes);
+  stm.seekg(0);
+
+  // Figure out the dialect and skip any byte order mark ...
+  string sSample(CCSVDialect::SNIFF_BYTES, '\0');
+  stm.read(&sSample[0], sSample.length());  sSample.resize((size_t) stm.gcount());
+  bool fBOM = CEncoding::StripBOM(sSample);
+  CCSVDialect dialect = CCSVDialect::Sniff(sSample);
+  stm.clear();  stm.seekg(fBOM ? 3 : 0);
+
+  // Check the header and write it to all the partitions ...
+  const char *pszWhich = fOld ? "old" : "new";
+  CCSVRow row;  uint32_t nLine = 0;  string sRecord;  size_t nConverted;
+  if (!CCSVRow::ReadRecord(stm, dialect, nLine, sRecord))
+    ERRS("CPartitions::Run() " << sFileName << " is empty");
+  CEncoding::Normalize(sRecord, nConverted);  row.Parse(sRecord, dialect);
+  if (!row.Verify(sHeader)) MSGS("CPartitions::Run() header does not match in " << sFileName);
+  size_t nColumns = fNew ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS;
+  vector<std::ofstream> vecFiles(m_nUsed+1);
+  for (unsigned i = 0;  i <= m_nUsed;  ++i) {
+    //   The last file is for the candidate re-entries, which are only in the
+    // new DIR, but it's simpler to just make an empty one for the old DIR ...
+    string sFile = (i < m_nUsed) ? GetPartitionName(pszWhich, i) : GetFileName(string(pszWhich) + ".candidates.csv");
+    vecFiles[i].open(sFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!vecFiles[i].is_open()) ERRS("CPartitions::Run() unable to create " << sFile);
+    vecFiles[i] << CCSVRow(sHeader).Format() << '\n';
+  }
+
+  //   Now split the records.  Everything from here on has to happen in the
+  // same order as CDogs::ReadFile() does it, so that the errors come out in
+  // the same order too ...
+  size_t nRecords = 0, nDogs = 0;
+  while (CCSVRow::ReadRecord(stm, dialect, nLine, sRecord)) {
+    if (sRecord.empty()) continue;
+    CEncoding::Normalize(sRecord, nConverted);  row.Parse(sRecord, dialect);
+    ++nRecords;  METRIC(ROWS_READ);
+    if (row.size() != nColumns) {
+      //   CDog::FromRow() can't cope with this at all (it asserts!), so we
+      // just skip the record ...
+      MSGS("CPartitions::Run() wrong number of columns in line " << nLine << " of " << sFileName);
+      METRIC(DOGS_REJECTED);  continue;
+    }
+    CDog dog;
+    if (!dog.FromRow(row, fNew)) {METRIC(DOGS_REJECTED);  continue;}
+    if (!dog.WasAcquiredAfter(nCutoff)) {METRIC(DOGS_CUTOFF);  continue;}
+
+    // This is CDogs::Add() ...
+    uint64_t nKey = dog.GetKey();  string sChip = dog.GetChip();
+    if (dir.setKeys.count(nKey) != 0) {
+      BADDOGS(&dog, "already in collection");  METRIC(DOGS_REJECTED);  continue;
+    }
+    if (!sChip.empty()) {
+      CHIP_MAP::const_iterator it = dir.mapChips.find(sChip);
+      if (it != dir.mapChips.end()) {
+        BADDOGS(&dog,  "and " << it->second.sName << " #" << it->second.sID << " have the same microchip");
+        METRIC(DOGS_REJECTED);  continue;
+      }
+      dir.mapChips.insert({sChip, {dog.GetName(), dog.GetID(), dog.GetResponsiblePerson()}});
+    }
+    dir.setKeys.insert(nKey);  ++nDogs;  METRIC(DOGS_KEPT);
+
+    // Remember the things that need to see every dog ...
+    uint32_t nAdopter = m_Households.AddAdopter(&dog);
+    if (nAdopter != CHouseholds::NOHOUSEHOLD) dir.mapAdopters[nKey] = nAdopter;
+    if (fOld) {
+      string sDomain = CDomainChecker::GetDomain(dog.GetAdoptioneMail());
+      if (!sDomain.empty()) ++m_mapDomains[sDomain];
+    } else if (m_Old.setKeys.count(nKey) == 0) {
+      vecFiles[m_nUsed] << row.Format() << '\n';
+    }
+    vecFiles[CShards::GetShard(dog.GetID(), m_nUsed)] << row.Format() << '\n';
+  }
+
+  for (unsigned i = 0;  i <= m_nUsed;  ++i) {
+    vecFiles[i].close();
+    if (vecFiles[i].fail()) ERRS("CPartitions::Run() error writing partition " << i << " of " << sFileName);
+  }
+  MSGS("Read " << nRecords << " rows from " << sFileName);
+  MSGS("Split " << nDogs << " dogs, " << dir.mapChips.size() << " chips into " << m_nUsed << " partitions");
+}
+
+
+void CPartitions::ReadPartition (const string &sFileName, bool fNew, CDogs &Dogs, const unordered_set<string> *pKeys) const
+{
+  //++
+  //   Read one partition file back into a CDogs collection.  The file is in
+  // the plain NGRR dialect and every dog in it has already passed all the
+  // tests in SplitFile(), so there's nothing to check here.  If pKeys is
+  // given then only the dogs with at least one CDogMatcher key in that set
+  // are kept (that's for the candidate re-entries) ...
+  //--
+  std::ifstream stm(sFileName, std::ios::in | std::ios::binary);
+  if (!stm.is_open()) ERRS("CPartitions::Run() unable to open " << sFileName);
+  CCSVDialect dialect;  CCSVRow row;  uint32_t nLine = 0;  string sRecord;
+  vector<string> vecKeys;
+  CCSVRow::ReadRecord(stm, dialect, nLine, sRecord);
+  while (CCSVRow::ReadRecord(stm, dialect, nLine, sRecord)) {
+    if (sRecord.empty()) continue;
+    row.Parse(sRecord, dialect);
+    CDog *pDog = new CDog;
+    if (!pDog->FromRow(row, fNew)) {delete pDog;  continue;}
+    if (pKeys != NULL) {
+      CDogMatcher::GetKeys(pDog, vecKeys);  bool fFound = false;
+      for (vector<string>::const_iterator it = vecKeys.begin();  (it != vecKeys.end()) && !fFound;  ++it)
+        fFound = pKeys->count(*it) != 0;
+      if (!fFound) {delete pDog;  continue;}
+    }
+    if (!Dogs.Add(pDog)) delete pDog;
+  }
+}
+
+
+void CPartitions::TakeErrors (uint32_t nStage, bool fByKey)
+{
+  //++
+  //   Move all the errors collected so far to m_vecErrors, tagged with the
+  // stage they came from, and start a new (empty) CBadDogs for this thread.
+  // If fByKey is true then each error is also tagged with its dog's key,
+  // which is how a normal run would have ordered them.  Otherwise the
+  // errors are already in the right order and are just numbered ...
+  //--
+  CBadDogs *pErrors = CBadDogs::Get();
+  for (CCSVFile::const_iterator it = pErrors->begin();  it != pErrors->end();  ++it) {
+    ERROR_ROW error;  uint32_t nOrg, nNumber;
+    error.nStage = nStage;  error.nKey = m_vecErrors.size();  error.row = **it;
+    if (fByKey && CDog::ParseDogID(error.row[CBadDogs::COL_DOG_NUMBER-1], nOrg, nNumber))
+      error.nKey = CDog::MakeKey(nOrg, nNumber);
+    m_vecErrors.push_back(error);
+  }
+  //   The CBadDogs is a per thread singleton, so there's no need to keep a
+  // pointer to the new one - CBadDogs::Get() will find it ...
+  delete pErrors;  new CBadDogs("");
+}
+
+
+void CPartitions::ComparePartition (unsigned nPartition, bool fOldFormat, bool fNewFormat)
+{
+  //++
+  //   Read one pair of partitions and do everything to them that a normal
+  // run does to the whole DIRs.  The CompareDogs() passes are run one at a
+  // time, so that we know which errors came from which pass ...
+  //--
+  static const uint32_t anPasses[] = {
+    COMPARE_MISSING, COMPARE_ACQUIRED, COMPARE_NO_ADOPTER, COMPARE_NOT_ADOPTED,
+    COMPARE_DISPOSITION, COMPARE_ADOPTED | COMPARE_FAMILY, COMPARE_RETURNED
+  };
+  TRACE_CHUNK("partition", (int64_t) nPartition);
+  CMetrics::BeginPhase(CMetrics::PHASE_COMPARE);
+  CDogs OldDogs, NewDogs;
+  ReadPartition(GetPartitionName("old", nPartition), fOldFormat, OldDogs);
+  ReadPartition(GetPartitionName("new", nPartition), fNewFormat, NewDogs);
+  MSGS("Comparing partition " << nPartition << ", " << OldDogs.DogCount() << " old dogs with " << NewDogs.DogCount() << " new dogs ...");
+
+  // Tell the household index which adopter each of these dogs has ...
+  const CDogs *apDogs[2] = {&OldDogs, &NewDogs};
+  const DIR_SUMMARY *apDIRs[2] = {&m_Old, &m_New};
+  for (unsigned i = 0;  i < 2;  ++i) {
+    for (CDogs::dog_number_const_iterator it = apDogs[i]->dog_begin();  it != apDogs[i]->dog_end();  ++it) {
+      unordered_map<uint64_t, uint32_t>::const_iterator ita = apDIRs[i]->mapAdopters.find(it->first);
+      if (ita != apDIRs[i]->mapAdopters.end()) m_Households.SetAdopter(it->second, ita->second);
+    }
+  }
+
+  for (uint32_t i = 0;  i < sizeof(anPasses)/sizeof(anPasses[0]);  ++i) {
+    CompareDogs(OldDogs, NewDogs, &m_Households, anPasses[i]);
+    TakeErrors(STAGE_COMPARE+i, true);
+  }
+  m_Households.ForgetDogs();
+
+  //   Save a copy of the old dogs that went missing.  We can't look for their
+  // re-entries until we've seen every partition ...
+  for (CDogs::dog_number_const_iterator it = OldDogs.dog_begin();  it != OldDogs.dog_end();  ++it)
+    if (NewDogs.Find(it->first) == NULL) m_MissingDogs.Add(new CDog(*it->second));
+  CMetrics::EndPhase(CMetrics::PHASE_COMPARE);
+
+  //   Build the updates and check the email domains, and then save the
+  // finished update rows.  CChip::ToRow() needs the CDog, so this has to be
+  // done now - the dogs are about to go away ...
+  CMetrics::BeginPhase(CMetrics::PHASE_BUILD_UPDATES);
+  CChips Chips;
+  BuildUpdates(NewDogs, Chips);
+  TakeErrors(STAGE_UPDATES, true);
+  m_Domains.CheckDogs(NewDogs);
+  TakeErrors(STAGE_DOMAINS, true);
+  for (CChips::const_iterator it = Chips.begin();  it != Chips.end();  ++it) {
+    UPDATE_ROW update;
+    update.nKey = it->second->GetDog()->GetKey();  update.sChip = it->first;
+    update.row = CCSVRow(CChip::TOTAL_FOUND_COLUMNS);  it->second->ToRow(update.row);
+    m_vecUpdates.push_back(update);
+  }
+  CMetrics::EndPhase(CMetrics::PHASE_BUILD_UPDATES);
+}
+
+
+void CPartitions::FindSimilarChips()
+{
+  //++
+  //   Find the similar microchips in the whole new DIR, exactly the way that
+  // CDogs::FindSimilarChips() does, from the microchips that SplitFile()
+  // saved.  The report is the same too ...
+  //--
+  TRACE_SCOPE("similar chips");
+  vector<const CHIP_MAP::value_type *> vecDogs;
+  for (CHIP_MAP::const_iterator it = m_New.mapChips.begin();  it != m_New.mapChips.end();  ++it)
+    if (CDogs::IsISOChip(it->first)) vecDogs.push_back(&*it);
+  std::sort(vecDogs.begin(), vecDogs.end(),
+    [](const CHIP_MAP::value_type *p1, const CHIP_MAP::value_type *p2) {return p1->first < p2->first;});
+  vector<string> vecChips;  vecChips.reserve(vecDogs.size());
+  for (size_t i = 0;  i < vecDogs.size();  ++i) vecChips.push_back(vecDogs[i]->first);
+
+  vector<CDogs::SIMILAR_CHIPS> vecSimilar;
+  CDogs::FindSimilarChips(vecChips, vecSimilar);
+  for (vector<CDogs::SIMILAR_CHIPS>::const_iterator it = vecSimilar.begin();  it != vecSimilar.end();  ++it) {
+    const CHIP_DOG &Dog1 = vecDogs[it->n1]->second, &Dog2 = vecDogs[it->n2]->second;
+    CBadDogs::Get()->AddError(Dog1.sName, Dog1.sID, Dog1.sContact, "microchip " + vecChips[it->n1]
+      + " is similar to microchip " + vecChips[it->n2] + " of " + Dog2.sName + " #" + Dog2.sID + " (" + it->pszWhy + ")");
+    METRIC(RULE_SIMILAR_CHIP);
+  }
+  TakeErrors(STAGE_SIMILAR_CHIPS, false);
+}
+
+
+void CPartitions::FindReentered (bool fNewFormat)
+{
+  //++
+  //   Look for re-entries of the old dogs that went missing.  A re-entry has
+  // to be a new dog that wasn't in the old DIR (SplitFile() saved all of
+  // those) and it has to share at least one blocking key with a missing dog,
+  // so those are the only ones we need to read back.  CDogMatcher gives
+  // exactly the same answers for them as it would for the whole new DIR ...
+  //--
+  if (m_MissingDogs.DogCount() == 0) return;
+  unordered_set<string> setKeys;  vector<string> vecKeys;
+  for (CDogs::dog_number_const_iterator it = m_MissingDogs.dog_begin();  it != m_MissingDogs.dog_end();  ++it) {
+    CDogMatcher::GetKeys(it->second, vecKeys);
+    setKeys.insert(vecKeys.begin(), vecKeys.end());
+  }
+  CDogs Candidates;
+  ReadPartition(GetFileName("new.candidates.csv"), fNewFormat, Candidates, &setKeys);
+  MSGS("Matching " << m_MissingDogs.DogCount() << " missing dogs with " << Candidates.DogCount() << " candidates ...");
+  CDogMatcher(Candidates).ReportMissingDogs(m_MissingDogs);
+  TakeErrors(STAGE_REENTERED, false);
+}
+
+
+void CPartitions::WriteUpdates (const string &sFileName)
+{
+  //++
+  //   Write the updates file.  CChips::WriteFile() writes the chips in hash
+  // table order, and BuildUpdates() adds them in key order.  Adding the same
+  // microchips, in the same order, to the same kind of hash table gives the
+  // same order, so that's what we do ...
+  //--
+  std::sort(m_vecUpdates.begin(), m_vecUpdates.end(),
+    [](const UPDATE_ROW &u1, const UPDATE_ROW &u2) {return u1.nKey < u2.nKey;});
+  unordered_map<string, const CCSVRow *> mapChips;
+  for (vector<UPDATE_ROW>::const_iterator it = m_vecUpdates.begin();  it != m_vecUpdates.end();  ++it)
+    mapChips.insert({it->sChip, &it->row});
+  CCSVFile csv;
+  for (unordered_map<string, const CCSVRow *>::const_iterator it = mapChips.begin();  it != mapChips.end();  ++it)
+    csv.AddRow(*it->second);
+  size_t nChips = csv.Write(sFileName, CChip::m_sFoundHeaders);
+  MSGS("Wrote " << nChips << " rows to " << sFileName);
+  METRICN(UPDATES, nChips);
+  m_vecUpdates.clear();
+}
+
+
+void CPartitions::WriteErrors (const string &sFileName, const string &sOldFile, const string &sNewFile, bool fRawRows)
+{
+  //++
+  //   Put all the errors back in the order that a normal run would have found
+  // them (see Partition.hpp) and write them out.  They were all counted when
+  // they were found, so they're added to the final CBadDogs as plain rows ...
+  //--
+  std::stable_sort(m_vecErrors.begin(), m_vecErrors.end(), [](const ERROR_ROW &e1, const ERROR_ROW &e2)
+    {return (e1.nStage != e2.nStage) ? (e1.nStage < e2.nStage) : (e1.nKey < e2.nKey);});
+  CBadDogs BadDogs(sFileName);
+  for (vector<ERROR_ROW>::const_iterator it = m_vecErrors.begin();  it != m_vecErrors.end();  ++it)
+    BadDogs.AddRow(it->row);
+  m_vecErrors.clear();
+  if (fRawRows) {
+    CRowIndex NewIndex(sNewFile), OldIndex(sOldFile);
+    NewIndex.Open();  OldIndex.Open();
+    BadDogs.AddRawRows(NewIndex, OldIndex);
+  }
+  BadDogs.WriteFile();
+}
+
+
+void CPartitions::RemoveFiles() const
+{
+  //++
+  // Delete all the partition files (the ones that exist, anyway) ...
+  //--
+  for (unsigned i = 0;  i < m_nUsed;  ++i) {
+    remove(GetPartitionName("old", i).c_str());
+    remove(GetPartitionName("new", i).c_str());
+  }
+  remove(GetFileName("old.candidates.csv").c_str());
+  remove(GetFileName("new.candidates.csv").c_str());
+}
+
+
+void CPartitions::Run (const string &sOldFile, bool fOldFormat, const string &sNewFile, bool fNewFormat,
+                       uint32_t nCutoff, const string &sUpdatesFile, const string &sErrorsFile, bool fRawRows)
+{
+  //++
+  //   Do a complete update run, one partition at a time.  The errors are
+  // collected by a CBadDogs with no file name and moved to m_vecErrors after
+  // every step (see TakeErrors()) - the real errors file isn't created until
+  // the end.  If anything throws, the partition files are cleaned up and
+  // the errors found so far are lost ...
+  //--
+  m_nUsed = ChoosePartitions(sOldFile, sNewFile);
+  assert((m_nUsed > 0) && (m_nUsed <= MAX_PARTITIONS));
+  MSGS("Using " << m_nUsed << " partitions for a budget of " << (m_nMemory >> 20) << "MB");
+  m_vecErrors.clear();  m_vecUpdates.clear();
+  new CBadDogs("");
+  try {
+    CMetrics::BeginPhase(CMetrics::PHASE_READ_OLD);
+    SplitFile(sOldFile, fOldFormat, true, nCutoff, m_Old);
+    METRICN(OLD_DOGS, m_Old.setKeys.size());  m_Old.mapChips.clear();
+    CMetrics::EndPhase(CMetrics::PHASE_READ_OLD);
+    CMetrics::BeginPhase(CMetrics::PHASE_READ_NEW);
+    SplitFile(sNewFile, fNewFormat, false, nCutoff, m_New);
+    METRICN(NEW_DOGS, m_New.setKeys.size());
+    CMetrics::EndPhase(CMetrics::PHASE_READ_NEW);
+    TakeErrors(STAGE_READ, false);
+
+    // These need every dog, and we've seen them all now ...
+    m_Households.Build();
+    m_Domains.Learn(m_mapDomains);  m_mapDomains.clear();
+    m_Old.setKeys.clear();  m_New.setKeys.clear();
+
+    for (unsigned i = 0;  i < m_nUsed;  ++i) ComparePartition(i, fOldFormat, fNewFormat);
+    CMetrics::BeginPhase(CMetrics::PHASE_COMPARE);
+    FindSimilarChips();
+    FindReentered(fNewFormat);
+    CMetrics::EndPhase(CMetrics::PHASE_COMPARE);
+  } catch (...) {
+    delete CBadDogs::Get();  RemoveFiles();  throw;
+  }
+  delete CBadDogs::Get();
+  RemoveFiles();
+
+  CMetrics::BeginPhase(CMetrics::PHASE_WRITE_UPDATES);
+  WriteUpdates(sUpdatesFile);
+  CMetrics::EndPhase(CMetrics::PHASE_WRITE_UPDATES);
+  CMetrics::BeginPhase(CMetrics::PHASE_WRITE_ERRORS);
+  WriteErrors(sErrorsFile, sOldFile, sNewFile, fRawRows);
+  CMetrics::EndPhase(CMetrics::PHASE_WRITE_ERRORS);
+}
@@ -0,0 +1,209 @@
+//++
+// Partition.hpp -> update runs for DIRs that don't fit in memory
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   A normal update run keeps every dog from both DIRs in memory at once,
+// and for a full history, multi organization archive that's more than a small
+// VM has.  CPartitions does the same update run "out of core", as a grace hash
+// join on the dog number -
+//
+//    1) Both DIRs are streamed, one record at a time, into N pairs of
+//       partition files on disk by a hash of the dog ID (the same one that
+//       CShards uses), so a dog is in the same partition in both DIRs.  N is
+//       picked so that one pair fits in the memory budget (--memory).
+//
+//    2) Each pair is read back into a pair of CDogs, one at a time, and goes
+//       thru CompareDogs(), BuildUpdates() and CDomainChecker just like a
+//       whole DIR would.  Then it's thrown away before the next pair is read.
+//
+//    3) The errors and updates from all the pairs are merged back together
+//       in exactly the order a normal run would have produced them.
+//
+//   The results are identical to a normal run, byte for byte - the diff
+// harness idea applies here too.  That takes a bit of work, because some of
+// the checks need to see every dog.  Those are done during the streaming
+// pass in step 1, which keeps a few compact things about every dog -
+//
+//    * the dog keys and microchips of each DIR.  CDogs::Add() rejects a dog
+//      whose number or microchip was already seen, and that depends on every
+//      dog before it, so the streaming pass makes that decision (and reports
+//      it) instead.  Only the dogs that a normal run would keep are written to
+//      the partitions.  The new DIR's microchips are also what FindSimilarChips()
+//      needs at the end.
+//
+//    * the adopter keys for CHouseholds, and which adopter goes with which
+//      dog.  Households are built from both whole DIRs before any pair is
+//      compared.
+//
+//    * the count of adopter email domains in the old DIR, for CDomainChecker.
+//
+//    * the new dogs that aren't in the old DIR, in one more file on disk.
+//      Only those can be re-entries (see CDogMatcher), so after all the pairs
+//      are done, and we know which old dogs went missing, the ones that share
+//      a blocking key with a missing dog are read back and matched.
+//
+//   The errors are put back in order by remembering where each one came
+// from - reading the DIRs, one of the CompareDogs() passes (which is why
+// those are run one at a time here), similar microchips, re-entered dogs,
+// BuildUpdates() or the email domains - and the key of the dog it's about.
+// Within any one of those a normal run goes thru the dogs in key order, and
+// a dog is only ever in one partition, so a stable sort on those two puts
+// every error back exactly where it belongs.  The updates file is written in
+// CChips order, which is the hash table order after the updates have been
+// added by key, so we do just that with the finished rows.
+//
+//   Note that the errors and the updates are kept in memory until the end,
+// the same as in a normal run, as is everything listed above.  That's all
+// much smaller than the dogs themselves, but it isn't counted against the
+// budget.  The partition files go in the --spill directory and are deleted
+// when the run is done.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include <unordered_set>        // C++ std::unordered_set ...
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "CSVRow.hpp"           // CSV file row object
+#include "Household.hpp"        // adopter household index
+#include "DomainChecker.hpp"    // misspelled email domains
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::unordered_map;       // ...
+using std::unordered_set;       // ...
+
+
+class CPartitions {
+  //++
+  // Out of core update run ...
+  //--
+
+public:
+  enum {
+    MAX_PARTITIONS      = 256,          // maximum number of partitions
+    MEMORY_FACTOR       = 4,            // bytes of CDogs per byte of DIR (a guess)
+  };
+  //   Where an error came from.  These are in the order that a normal update
+  // run finds them, and there's one STAGE_COMPARE for each CompareDogs() pass.
+  enum {
+    STAGE_READ          = 0,            // reading the DIRs
+    STAGE_COMPARE       = 1,            // first CompareDogs() pass
+    STAGE_SIMILAR_CHIPS = 8,            // CDogs::FindSimilarChips()
+    STAGE_REENTERED     = 9,            // CDogMatcher
+    STAGE_UPDATES       = 10,           // BuildUpdates()
+    STAGE_DOMAINS       = 11,           // CDomainChecker
+  };
+  // File names in the spill directory ...
+  static const char *m_pszPrefix;       // in front of every file name
+
+public:
+  // Constructor and destructor ...
+  CPartitions();
+  virtual ~CPartitions() {};
+  // Copy and assignment constructors ...
+  CPartitions (const CPartitions &p) = delete;
+  CPartitions& operator= (const CPartitions &p) = delete;
+
+  // CPartitions properties ...
+public:
+  // Set the memory budget, in megabytes ...
+  void SetMemory (uint64_t nMegabytes) {m_nMemory = nMegabytes << 20;}
+  // Set the number of partitions (zero means figure it out) ...
+  void SetPartitions (unsigned nPartitions) {m_nPartitions = nPartitions;}
+  // Set the directory for the partition files ...
+  void SetDirectory (const string &sDirectory) {m_sDirectory = sDirectory;}
+  // Return the number of partitions actually used ...
+  unsigned GetPartitions() const {return m_nUsed;}
+
+  // CPartitions public methods ...
+public:
+  //   Do one whole update run, with the same arguments (and the same results)
+  // as RunUpdate() ...
+  void Run (const string &sOldFile, bool fOldFormat, const string &sNewFile, bool fNewFormat,
+            uint32_t nCutoff, const string &sUpdatesFile, const string &sErrorsFile, bool fRawRows=false);
+
+  // Private internal CPartitions methods ...
+protected:
+  // What we remember about each dog with a microchip ...
+  struct CHIP_DOG {
+    string    sName, sID, sContact; // for the errors file
+  };
+  typedef unordered_map<string, CHIP_DOG> CHIP_MAP;
+  // Everything the streaming pass keeps for one DIR ...
+  struct DIR_SUMMARY {
+    unordered_set<uint64_t>       setKeys;      // keys of all the dogs kept
+    CHIP_MAP                      mapChips;     // microchip -> dog
+    unordered_map<uint64_t, uint32_t> mapAdopters; // dog key -> adopter number
+  };
+  // One error, and where it came from ...
+  struct ERROR_ROW {
+    uint32_t  nStage;               // STAGE_READ, etc
+    uint64_t  nKey;                 // dog key (or just a sequence number)
+    CCSVRow   row;                  // the CBadDogs row
+  };
+  // One update for Found.org ...
+  struct UPDATE_ROW {
+    uint64_t  nKey;                 // dog key
+    string    sChip;                // microchip (the CChips hash key)
+    CCSVRow   row;                  // the CChips row
+  };
+  // Return the name of a file in the spill directory ...
+  string GetFileName (const string &sName) const;
+  string GetPartitionName (const char *pszWhich, unsigned nPartition) const;
+  // Figure out how many partitions we need ...
+  unsigned ChoosePartitions (const string &sOldFile, const string &sNewFile) const;
+  // Stream one DIR into the partitions ...
+  void SplitFile (const string &sFileName, bool fNew, bool fOld, uint32_t nCutoff, DIR_SUMMARY &dir);
+  // Read back a partition (or just the dogs that share a key in setKeys) ...
+  void ReadPartition (const string &sFileName, bool fNew, CDogs &Dogs, const unordered_set<string> *pKeys=NULL) const;
+  // Compare one pair of partitions ...
+  void ComparePartition (unsigned nPartition, bool fOldFormat, bool fNewFormat);
+  // Find similar microchips across the whole new DIR ...
+  void FindSimilarChips();
+  // Find the re-entries of the old dogs that went missing ...
+  void FindReentered (bool fNewFormat);
+  // Move everything in this thread's CBadDogs to m_vecErrors ...
+  void TakeErrors (uint32_t nStage, bool fByKey);
+  // Write the merged results ...
+  void WriteUpdates (const string &sFileName);
+  void WriteErrors (const string &sFileName, const string &sOldFile, const string &sNewFile, bool fRawRows);
+  // Delete all the partition files ...
+  void RemoveFiles() const;
+
+  // Local CPartitions members ...
+protected:
+  uint64_t            m_nMemory;        // memory budget, in bytes
+  unsigned            m_nPartitions;    // number of partitions requested
+  unsigned            m_nUsed;          //   "    "     "   actually used
+  string              m_sDirectory;     // directory for the partition files
+  DIR_SUMMARY         m_Old, m_New;     // what we know about each DIR
+  unordered_map<string, uint32_t> m_mapDomains; // adopter email domains in the old DIR
+  CHouseholds         m_Households;     // adopter households in both DIRs
+  CDomainChecker      m_Domains;        // known good email domains
+  CDogs               m_MissingDogs;    // old dogs not in the new DIR
+  vector<ERROR_ROW>   m_vecErrors;      // all the errors found so far
+  vector<UPDATE_ROW>  m_vecUpdates;     // and all the updates
+};
@@ -0,0 +1,333 @@
+//++
+// RowIndex.cpp - implementation of the CRowIndex class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CRowIndex class, which records where each record
+// is in a CSV file.  See RowIndex.hpp for the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Key on the whole dog ID, organization and all.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdio.h>              // remove() ...
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string.h>             // memcmp(), memcpy() ...
+#include <assert.h>             // assert() (what else??)
+#include <sys/types.h>          // ...
+#include <sys/stat.h>           // stat() ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <sstream>              // std::istringstream, std::ostringstream
+#include <algorithm>            // std::stable_sort(), std::lower_bound() ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // one row of a spreadsheet
+#include "Encoding.hpp"         // UTF-8 normalization
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "Dog.hpp"              // CDog::ParseDogID() ...
+#include "RowIndex.hpp"         // declarations for this module
+
+// Default sidecar file type ...
+const char *const CRowIndex::m_pszExtension = ".idx";
+
+//   The sidecar file starts with this header, and the ENTRY array follows
+// immediately after it ...
+struct INDEX_HEADER {
+  char      achMagic[4];                // always "RIDX"
+  uint32_t  nVersion;                   // CRowIndex::VERSION
+  uint32_t  nKeyColumn;                 // key column this index is for
+  uint32_t  nEntries;                   // number of ENTRYs that follow
+  CRowIndex::SIGNATURE Signature;       // the CSV file's size, time and hash
+  char      chDelimiter;                // the CSV file's dialect ...
+  char      chQuote;                    //   ...
+  char      chEndOfLine;                //   ...
+  char      fCRLF;                      //   ...
+  char      fEquals;                    //   ...
+  char      achSpare[3];                // (just padding)
+};
+static const char g_achMagic[4] = {'R', 'I', 'D', 'X'};
+
+// FNV-1a constants (64 bit version) ...
+#define FNV_OFFSET  14695981039346656037ULL
+#define FNV_PRIME   1099511628211ULL
+
+
+static uint64_t HashBytes (const char *pData, size_t nLength, uint64_t nHash)
+{
+  //++
+  // Add some bytes to an FNV-1a hash ...
+  //--
+  for (size_t i = 0;  i < nLength;  ++i) {
+    nHash ^= (uint8_t) pData[i];  nHash *= FNV_PRIME;
+  }
+  return nHash;
+}
+
+
+CRowIndex::CRowIndex (const string &sFileName, uint32_t nKeyColumn)
+{
+  //++
+  //   The constructor just remembers the file name - nothing happens until
+  // Open() is called ...
+  //--
+  m_sFileName = sFileName;  m_nKeyColumn = nKeyColumn;
+  memset(&m_Signature, 0, sizeof(m_Signature));
+}
+
+
+/*static*/ bool CRowIndex::GetFileStatus (const string &sFileName, uint64_t &nSize, int64_t &nModified)
+{
+  //++
+  // Return the size and modification time of a file ...
+  //--
+  struct stat st;
+  if (stat(sFileName.c_str(), &st) != 0) return false;
+  nSize = (uint64_t) st.st_size;  nModified = (int64_t) st.st_mtime;
+  return true;
+}
+
+
+/*static*/ uint64_t CRowIndex::HashEnds (const char *pData, size_t nLength)
+{
+  //++
+  //   Hash the first HASH_BYTES and the last HASH_BYTES of the data (if the
+  // data is short these overlap, and that's fine) ...
+  //--
+  size_t nBytes = std::min(nLength, (size_t) HASH_BYTES);
+  uint64_t nHash = HashBytes(pData, nBytes, FNV_OFFSET);
+  return HashBytes(pData+nLength-nBytes, nBytes, nHash);
+}
+
+
+/*static*/ bool CRowIndex::HashFile (std::ifstream &stm, uint64_t nSize, uint64_t &nHash)
+{
+  //++
+  //   Same as HashEnds(), but read just the bytes we need from the file.  If
+  // the file is short then it's just read once ...
+  //--
+  size_t nBytes = (size_t) std::min(nSize, (uint64_t) HASH_BYTES);
+  string sData(nBytes, '\0');
+  stm.clear();  stm.seekg(0);
+  if (nBytes > 0) stm.read(&sData[0], nBytes);
+  if ((size_t) stm.gcount() != nBytes) return false;
+  nHash = HashBytes(sData.data(), nBytes, FNV_OFFSET);
+  if (nSize > nBytes) {
+    stm.seekg((std::streamoff) (nSize-nBytes));  stm.read(&sData[0], nBytes);
+    if ((size_t) stm.gcount() != nBytes) return false;
+  }
+  nHash = HashBytes(sData.data(), nBytes, nHash);
+  return true;
+}
+
+
+/*static*/ uint64_t CRowIndex::MakeKey (uint32_t nOrg, uint32_t nNumber)
+{
+  //++
+  //   Make the key for a dog ID.  The top half is a hash of the organization
+  // prefix rather than CDog's code for it, because the key is saved in the
+  // sidecar and the codes can be different next time.  NGRR (no prefix) is
+  // always zero, and no other prefix ever is ...
+  //--
+  if (nOrg == CDog::NGRR_ORG) return CDog::MakeKey(0, nNumber);
+  string sPrefix = CDog::GetOrgPrefix(nOrg);
+  uint64_t nHash = HashBytes(sPrefix.data(), sPrefix.length(), FNV_OFFSET);
+  uint32_t nOrgHash = (uint32_t) (nHash ^ (nHash >> 32));
+  return CDog::MakeKey((nOrgHash != 0) ? nOrgHash : 1, nNumber);
+}
+
+
+/*static*/ bool CRowIndex::ParseKey (const string &sKey, uint64_t &nKey)
+{
+  //++
+  //   Parse the key field of a record, exactly the same way that the DIR's
+  // dog numbers are parsed.  If it's not a valid dog ID then the record isn't
+  // indexed (e.g. the header row!) ...
+  //--
+  uint32_t nOrg, nNumber;
+  if (!CDog::ParseDogID(sKey, nOrg, nNumber)) return false;
+  nKey = MakeKey(nOrg, nNumber);
+  return true;
+}
+
+
+bool CRowIndex::Build()
+{
+  //++
+  //   Read the whole CSV file and record the offset and length of every
+  // record.  This uses the same dialect and CCSVRow::Read() as CCSVFile, so
+  // a record that spans lines is one entry here too.  The data isn't passed
+  // through CEncoding - that never changes the line endings, delimiters or
+  // quotes - so the offsets are for the file exactly as it is on disk ...
+  //--
+  TRACE_SCOPE("build row index");
+  std::filebuf fb;
+  if (!fb.open(m_sFileName, std::ios::in | std::ios::binary)) return false;
+  std::ostringstream os;
+  if (fb.sgetc() != std::filebuf::traits_type::eof()) os << &fb;
+  fb.close();
+  string sData = os.str();
+  uint64_t nSize;
+  if (!GetFileStatus(m_sFileName, nSize, m_Signature.nModified)) return false;
+  if (nSize != sData.length()) return false;
+  m_Signature.nSize = nSize;
+  m_Signature.nHash = HashEnds(sData.data(), sData.length());
+  m_Dialect = CCSVDialect::Sniff(sData);
+
+  m_vecEntries.clear();
+  std::istringstream is(sData);  CCSVRow row;  uint32_t nLine = 0;
+  while (!is.eof()) {
+    uint64_t nStart = (uint64_t) is.tellg();
+    row.Read(is, m_Dialect, nLine);
+    if (is.eof() && (row.size() == 0)) break;
+    uint64_t nEnd = is.eof() ? sData.length() : (uint64_t) is.tellg();
+    // Don't include the line ending in the length ...
+    if ((nEnd > nStart) && (sData[nEnd-1] == m_Dialect.GetEndOfLine())) --nEnd;
+    if (m_Dialect.IsCRLF() && (nEnd > nStart) && (sData[nEnd-1] == '\r')) --nEnd;
+    uint64_t nKey;
+    if ((row.size() > m_nKeyColumn) && ParseKey(row[m_nKeyColumn], nKey))
+      m_vecEntries.push_back({nKey, (uint32_t) (nEnd-nStart), 0, nStart});
+  }
+  std::stable_sort(m_vecEntries.begin(), m_vecEntries.end(),
+    [](const ENTRY &e1, const ENTRY &e2) {return e1.nKey < e2.nKey;});
+  return true;
+}
+
+
+bool CRowIndex::Save() const
+{
+  //++
+  //   Write the index to the sidecar file.  If that fails (say the DIR is in
+  // a read only directory) it's not fatal - it just means we'll have to build
+  // it again next time ...
+  //--
+  INDEX_HEADER hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.achMagic, g_achMagic, sizeof(hdr.achMagic));
+  hdr.nVersion = VERSION;  hdr.nKeyColumn = m_nKeyColumn;
+  hdr.nEntries = (uint32_t) m_vecEntries.size();  hdr.Signature = m_Signature;
+  hdr.chDelimiter = m_Dialect.GetDelimiter();  hdr.chQuote = m_Dialect.GetQuote();
+  hdr.chEndOfLine = m_Dialect.GetEndOfLine();
+  hdr.fCRLF = m_Dialect.IsCRLF();  hdr.fEquals = m_Dialect.HasEquals();
+
+  std::filebuf fb;
+  if (!fb.open(GetIndexName(), std::ios::out | std::ios::binary)) return false;
+  std::ostream os(&fb);
+  os.write((const char *) &hdr, sizeof(hdr));
+  if (!m_vecEntries.empty())
+    os.write((const char *) m_vecEntries.data(), m_vecEntries.size()*sizeof(ENTRY));
+  bool fOK = os.good();
+  fb.close();
+  if (!fOK) remove(GetIndexName().c_str());
+  return fOK;
+}
+
+
+bool CRowIndex::Load()
+{
+  //++
+  //   Load the sidecar file, but only if it's for this key column and the
+  // CSV file's size, time and hash all still match.  Returns false if the
+  // index needs to be built again.  The CSV file must already be open ...
+  //--
+  std::ifstream stm(GetIndexName(), std::ios::in | std::ios::binary);
+  if (!stm.is_open()) return false;
+  INDEX_HEADER hdr;
+  if (!stm.read((char *) &hdr, sizeof(hdr))) return false;
+  if ((memcmp(hdr.achMagic, g_achMagic, sizeof(hdr.achMagic)) != 0)
+   || (hdr.nVersion != VERSION) || (hdr.nKeyColumn != m_nKeyColumn)) return false;
+
+  // Make sure the CSV file hasn't changed ...
+  uint64_t nSize, nHash;  int64_t nModified;
+  if (!GetFileStatus(m_sFileName, nSize, nModified)) return false;
+  if ((nSize != hdr.Signature.nSize) || (nModified != hdr.Signature.nModified)) return false;
+  if (!HashFile(m_stm, nSize, nHash) || (nHash != hdr.Signature.nHash)) return false;
+
+  // It's good - read the entries ...
+  m_vecEntries.resize(hdr.nEntries);
+  if ((hdr.nEntries > 0) && !stm.read((char *) m_vecEntries.data(), hdr.nEntries*sizeof(ENTRY))) {
+    m_vecEntries.clear();  return false;
+  }
+  m_Signature = hdr.Signature;
+  m_Dialect = CCSVDialect(hdr.chDelimiter, hdr.chQuote, hdr.chEndOfLine, hdr.fCRLF != 0, hdr.fEquals != 0);
+  return true;
+}
+
+
+bool CRowIndex::Open()
+{
+  //++
+  //   Open the CSV file and load its index.  If the sidecar is missing or
+  // stale then build a new index and save it ...
+  //--
+  if (m_stm.is_open()) m_stm.close();
+  m_stm.open(m_sFileName, std::ios::in | std::ios::binary);
+  if (!m_stm.is_open()) return false;
+  if (Load()) return true;
+  MSGS("Building row index for " << m_sFileName);
+  if (!Build()) {m_stm.close();  return false;}
+  if (!Save()) MSGS("CRowIndex::Open() unable to write " << GetIndexName());
+  return true;
+}
+
+
+const CRowIndex::ENTRY *CRowIndex::Find (uint64_t nKey) const
+{
+  //++
+  //   Return the first entry with this key (if the same key appears more
+  // than once, they're in file order) or NULL if there isn't one ...
+  //--
+  ENTRY_VECTOR::const_iterator it = std::lower_bound(m_vecEntries.begin(), m_vecEntries.end(), nKey,
+    [](const ENTRY &e, uint64_t n) {return e.nKey < n;});
+  if ((it == m_vecEntries.end()) || (it->nKey != nKey)) return NULL;
+  return &*it;
+}
+
+
+bool CRowIndex::ReadRaw (uint64_t nKey, string &sRecord)
+{
+  //++
+  //   Return the text of the record with this key, exactly as it is in the
+  // file (minus the line ending).  This is one seek and one read ...
+  //--
+  sRecord.clear();
+  if (!m_stm.is_open()) return false;
+  const ENTRY *pEntry = Find(nKey);
+  if (pEntry == NULL) return false;
+  sRecord.resize(pEntry->nLength);
+  m_stm.clear();  m_stm.seekg((std::streamoff) pEntry->nOffset);
+  if (pEntry->nLength > 0) m_stm.read(&sRecord[0], pEntry->nLength);
+  if ((size_t) m_stm.gcount() != pEntry->nLength) {sRecord.clear();  return false;}
+  return true;
+}
+
+
+bool CRowIndex::ReadRow (uint64_t nKey, CCSVRow &row)
+{
+  //++
+  //   Read the record with this key and parse it, the same way CCSVFile
+  // would have (including the conversion to UTF-8) ...
+  //--
+  string sRecord;  size_t nConverted;
+  if (!ReadRaw(nKey, sRecord)) return false;
+  CEncoding::Normalize(sRecord, nConverted);
+  std::istringstream is(sRecord);
+  row.Read(is, m_Dialect);
+  return true;
+}
@@ -0,0 +1,151 @@
+//++
+// RowIndex.hpp -> sidecar index of the records in a CSV file
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   When somebody asks "what does the DIR actually say for dog #12345?" the
+// only answer used to be grep.  A CRowIndex records the byte offset and length
+// of every record in a CSV file along with the dog ID in its key column (for
+// a DIR that's the dog number), so any record can be fetched with one seek
+// and one read.  The offsets are in the raw file, before any conversion by
+// CEncoding, so the record comes back exactly as it is in the file.
+//
+//   The index is saved in a sidecar file next to the CSV (e.g. "dogs.csv.idx")
+// so that it only has to be built once.  The sidecar remembers the size and
+// modification time of the CSV file, and a hash of its first and last
+// HASH_BYTES, and if any of those don't match then the index is stale and is
+// built again.  The hash catches a file that's been replaced by one of the
+// same size within the same second (e.g. by a copy that preserves the time
+// stamp) without having to read the whole file every time.
+//
+//   The sidecar is a binary INDEX_HEADER (see RowIndex.cpp) followed by the
+// ENTRY array, sorted by key.  It's in the native byte order - it's only a
+// cache, and if it's copied to a machine where it doesn't make sense then
+// it'll just be rebuilt.
+//
+//   The keys are parsed by CDog::ParseDogID(), so "ABC-123" and NGRR's own
+// dog #123 are different records.  The organization codes that CDog hands
+// out depend on the order the prefixes are seen, so they can't go in the
+// sidecar - instead the top 32 bits of a key are a hash of the prefix (zero
+// for NGRR) and the bottom 32 bits are the number.  See MakeKey().
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Key on the whole dog ID, organization and all.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <fstream>              // std::ifstream ...
+#include "CSVDialect.hpp"       // delimiter, quote and line ending conventions
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+class CCSVRow;                  // ...
+
+
+class CRowIndex {
+  //++
+  // Byte offsets of the records in a CSV file, sorted by key ...
+  //--
+
+public:
+  enum {
+    VERSION             = 2,            // sidecar file format version
+    HASH_BYTES          = 65536,        // bytes hashed at each end of the file
+    DOG_NUMBER_COLUMN   = 1,            // key column for a DIR (zero based!)
+  };
+  // Default file type for the sidecar (appended to the CSV file name) ...
+  static const char *const m_pszExtension;
+
+  // One record in the index ...
+  struct ENTRY {
+    uint64_t  nKey;                     // dog ID in the key column (see MakeKey())
+    uint32_t  nLength;                  // length of the record (no line end)
+    uint32_t  nSpare;                   // (just padding)
+    uint64_t  nOffset;                  // offset of the record in the file
+  };
+  typedef vector<ENTRY> ENTRY_VECTOR;
+
+  // What we remember about the CSV file, to tell if the index is stale ...
+  struct SIGNATURE {
+    uint64_t  nSize;                    // file size in bytes
+    int64_t   nModified;                // modification time (time_t)
+    uint64_t  nHash;                    // hash of the first and last HASH_BYTES
+  };
+
+public:
+  // Constructor and destructor ...
+  CRowIndex (const string &sFileName, uint32_t nKeyColumn=DOG_NUMBER_COLUMN);
+  virtual ~CRowIndex() {};
+  // Copy and assignment constructors ...
+  CRowIndex (const CRowIndex &ri) = delete;
+  CRowIndex& operator= (const CRowIndex &ri) = delete;
+
+  // CRowIndex properties ...
+public:
+  // Return the CSV file and sidecar file names ...
+  string GetFileName() const {return m_sFileName;}
+  string GetIndexName() const {return m_sFileName + m_pszExtension;}
+  // Return the number of records indexed ...
+  size_t size() const {return m_vecEntries.size();}
+  // Return true if Open() has been called successfully ...
+  bool IsOpen() const {return m_stm.is_open();}
+
+  // CRowIndex public methods ...
+public:
+  //   Load the sidecar, or build a new one if it's missing or stale.  Returns
+  // false only if the CSV file itself can't be read ...
+  bool Open();
+  // Return the raw text of the record with this key ...
+  bool ReadRaw (uint64_t nKey, string &sRecord);
+  // Read and parse the record with this key ...
+  bool ReadRow (uint64_t nKey, CCSVRow &row);
+  // Parse a dog ID (e.g. "12345" or "ABC-123") into a key ...
+  static bool ParseKey (const string &sKey, uint64_t &nKey);
+  // Make the key for an organization code and dog number ...
+  static uint64_t MakeKey (uint32_t nOrg, uint32_t nNumber);
+
+  // Private internal CRowIndex methods ...
+protected:
+  // Find the first entry with this key ...
+  const ENTRY *Find (uint64_t nKey) const;
+  // Build the index by reading the whole CSV file ...
+  bool Build();
+  // Load and save the sidecar file ...
+  bool Load();
+  bool Save() const;
+  // Get the size and modification time of a file ...
+  static bool GetFileStatus (const string &sFileName, uint64_t &nSize, int64_t &nModified);
+  // Hash the first and last HASH_BYTES of some data ...
+  static uint64_t HashEnds (const char *pData, size_t nLength);
+  // Same, but read them from the file ...
+  static bool HashFile (std::ifstream &stm, uint64_t nSize, uint64_t &nHash);
+
+  // Local CRowIndex members ...
+protected:
+  string        m_sFileName;    // CSV file that we index
+  uint32_t      m_nKeyColumn;   // zero based index of the key column
+  SIGNATURE     m_Signature;    // size, time and hash of the CSV file
+  CCSVDialect   m_Dialect;      // the CSV file's dialect
+  ENTRY_VECTOR  m_vecEntries;   // all the records, sorted by key
+  std::ifstream m_stm;          // the CSV file, open for reading records
+};
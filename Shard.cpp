@@ -0,0 +1,510 @@
+//++
+// Shard.cpp - implementation of the CShards class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CShards class, which splits a pair of DIRs into
+// shards that can be processed separately and then merges the results.  See
+// Shard.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Find re-entered dogs and count email domains in Split().
+// 17-Oct-26  AGT   Find the households in Split() too.  Manifest file names
+//                  are relative to the manifest.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <tchar.h>              // _T(), et al ...
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::ifstream, std::ofstream ...
+#include <algorithm>            // std::sort(), std::stable_sort() ...
+#include <unordered_set>        // std::unordered_set ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVDialect.hpp"       // CSV file format conventions
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Encoding.hpp"         // UTF-8 normalization
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "DogMatcher.hpp"       // CDogMatcher::Score(), et al ...
+#include "DomainChecker.hpp"    // CDomainChecker::GetDomain(), et al ...
+#include "Chip.hpp"             // CChip::m_sFoundHeaders, et al ...
+#include "Batch.hpp"            // CBatch manifest format
+#include "Trace.hpp"            // TRACE_SCOPE() macro, et al ...
+#include "Shard.hpp"            // declarations for this module
+
+// File names in the shard directory ...
+const char *CShards::m_pszManifest   = "shards.csv";
+const char *CShards::m_pszChipErrors = "errors.chips.csv";
+const char *CShards::m_pszDomains    = "domains.csv";
+
+
+CShards::CShards()
+{
+  //++
+  // The defaults are the same as a normal update run ...
+  //--
+  m_nShards = DEFAULT_SHARDS;  m_nCutoff = 2019;
+  m_fOldFormat = m_fNewFormat = true;  m_sDirectory = ".";
+}
+
+
+/*static*/ unsigned CShards::GetShard (const string &sID, unsigned nShards)
+{
+  //++
+  //   Return the shard for a dog.  This has to give the same answer on every
+  // machine and every run, so it's a 64 bit FNV-1a hash of the dog's ID (e.g.
+  // "1234" or "GRRA-56") and not the CDog key, which depends on the order the
+  // organization prefixes were seen in ...
+  //--
+  assert(nShards > 0);
+  uint64_t nHash = 0xCBF29CE484222325ULL;
+  for (size_t i = 0;  i < sID.length();  ++i) {
+    nHash ^= (uint8_t) sID[i];  nHash *= 0x100000001B3ULL;
+  }
+  return (unsigned) (nHash % nShards);
+}
+
+
+string CShards::GetFileName (const string &sName) const
+{
+  //++
+  // Return the full name of a file in the shard directory ...
+  //--
+  return m_sDirectory.empty() ? sName : (m_sDirectory + "/" + sName);
+}
+
+
+string CShards::GetShardName (const char *pszWhich, unsigned nShard) const
+{
+  //++
+  // Return the full name of one shard file, e.g. ".../old.003.csv" ...
+  //--
+  return GetFileName(GetManifestName(pszWhich, nShard));
+}
+
+
+/*static*/ string CShards::GetManifestName (const char *pszWhich, unsigned nShard)
+{
+  //++
+  //   Return the name of one shard file as it appears in the manifest, e.g.
+  // "old.003.csv".  The manifest is in the same directory, so that's all ...
+  //--
+  return CBadDogs::Print("%s.%03u.csv", pszWhich, nShard);
+}
+
+
+void CShards::SplitFile (const string &sFileName, bool fNew, const char *pszWhich, CHIP_MAP &mapChips,
+                         KEY_SET &setKeys, MATCH_VECTOR &vecDogs, DOMAIN_MAP *pDomains)
+{
+  //++
+  //   Copy every record of one DIR to its shard, one record at a time.  The
+  // dialect is sniffed from the start of the file the same way CCSVFile
+  // does, and each record is converted to UTF-8 by itself (CEncoding treats
+  // every byte the same way no matter what's around it, so that's the same
+  // as doing the whole file at once).
+  //
+  //   Each dog is also put through the same tests that CDogs::ReadFile() and
+  // CDogs::Add() use to decide whether it's kept.  A record that isn't even a
+  // valid dog is passed on to a shard anyway, so that the update run for that
+  // shard reports it.  A dog acquired before the cutoff year is dropped.  And
+  // a dog whose microchip was already seen is reported here and dropped.
+  //
+  //   The keys of the dogs that are kept go in setKeys, and the ones that
+  // CDogMatcher could find go in vecDogs too.  Their adopters go in the
+  // households.  If pDomains isn't NULL then their adopter email domains are
+  // counted as well ...
+  //--
+  TRACE_SCOPE("split dir");
+  const string &sHeader = fNew ? CDog::m_sNewColumnHeaders : CDog::m_sOldColumnHeaders;
+  std::ifstream stm(sFileName, std::ios::in | std::ios::binary);
+  if (!stm.is_open()) ERRS("CShards::Split() unable to open " << sFileName);
+
+  // Figure out the dialect and skip any byte order mark ...
+  string sSample(CCSVDialect::SNIFF_BYTES, '\0');
+  stm.read(&sSample[0], sSample.length());  sSample.resize((size_t) stm.gcount());
+  bool fBOM = CEncoding::StripBOM(sSample);
+  CCSVDialect dialect = CCSVDialect::Sniff(sSample);
+  stm.clear();  stm.seekg(fBOM ? 3 : 0);
+
+  // Check the header and write it to all the shards ...
+  CCSVRow row;  uint32_t nLine = 0;  string sRecord;  size_t nConverted;
+  if (!CCSVRow::ReadRecord(stm, dialect, nLine, sRecord))
+    ERRS("CShards::Split() " << sFileName << " is empty");
+  CEncoding::Normalize(sRecord, nConverted);  row.Parse(sRecord, dialect);
+  if (!row.Verify(sHeader)) MSGS("CShards::Split() header does not match in " << sFileName);
+  size_t nColumns = fNew ? CDog::TOTAL_NEW_COLUMNS : CDog::TOTAL_OLD_COLUMNS;
+  vector<std::ofstream> vecShards(m_nShards);
+  for (unsigned i = 0;  i < m_nShards;  ++i) {
+    string sShard = GetShardName(pszWhich, i);
+    vecShards[i].open(sShard, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!vecShards[i].is_open()) ERRS("CShards::Split() unable to create " << sShard);
+    vecShards[i] << CCSVRow(sHeader).Format() << '\n';
+  }
+
+  //   Now split the records.  Note that the dog keys are only used to mimic
+  // CDogs::Add() - the shard comes from the dog's ID.  CDog::FromRow() and
+  // friends complain about bad dogs as they go, but those complaints will come
+  // from the update runs for the shards, so the console is silenced here.
+  // The exception is a dog that's dropped for a duplicate microchip - no
+  // shard will ever see that one, so whatever was said about it (e.g. "no
+  // acquisition date recorded") goes in our errors along with the duplicate ...
+  size_t nRecords = 0, nCutoff = 0, nDuplicates = 0;
+  CBadDogs *pBadDogs = CBadDogs::Get();
+  std::streambuf *pCout = std::cout.rdbuf(NULL);
+  while (CCSVRow::ReadRecord(stm, dialect, nLine, sRecord)) {
+    if (sRecord.empty()) continue;
+    CEncoding::Normalize(sRecord, nConverted);  row.Parse(sRecord, dialect);  ++nRecords;
+    CDog dog;  unsigned nShard;  size_t nFirstError = pBadDogs->size();
+    if ((row.size() != nColumns) || !dog.FromRow(row, fNew)) {
+      nShard = GetShard((row.size() > 1) ? row[1] : string(), m_nShards);
+    } else if (!dog.WasAcquiredAfter(m_nCutoff)) {
+      ++nCutoff;  continue;
+    } else {
+      nShard = GetShard(dog.GetID(), m_nShards);
+      string sChip = dog.GetChip();
+      if (setKeys.insert(dog.GetKey()).second) {
+        CHIP_DOG Dog = {dog.GetName(), dog.GetID(), dog.GetResponsiblePerson(), nShard};
+        CHIP_MAP::const_iterator it = sChip.empty() ? mapChips.end() : mapChips.find(sChip);
+        if (it != mapChips.end()) {
+          for (size_t i = nFirstError;  i < pBadDogs->size();  ++i) {
+            const CCSVRow &error = *(*pBadDogs)[i];
+            m_vecErrors.push_back({{error[CBadDogs::COL_DOG_NAME-1], error[CBadDogs::COL_DOG_NUMBER-1],
+              error[CBadDogs::COL_CONTACT_MEMBER-1], nShard}, error[CBadDogs::COL_MESSAGE-1]});
+          }
+          m_vecErrors.push_back({Dog, "and " + it->second.sName + " #" + it->second.sID + " have the same microchip"});
+          setKeys.erase(dog.GetKey());  ++nDuplicates;  continue;
+        }
+        if (!sChip.empty()) mapChips.insert({sChip, Dog});
+        MATCH_DOG Match = {dog.GetKey(), Dog, CDogMatcher::GetFields(&dog)};
+        if (!Match.Fields.sChip.empty() || !Match.Fields.sSurrender.empty() || !CDogMatcher::NameKey(Match.Fields).empty())
+          vecDogs.push_back(Match);
+        uint32_t nAdopter = m_Households.AddAdopter(&dog);
+        if (nAdopter != CHouseholds::NOHOUSEHOLD) m_vecAdopters.push_back({nShard, pszWhich, dog.GetID(), nAdopter});
+        if (pDomains != NULL) {
+          string sDomain = CDomainChecker::GetDomain(dog.GetAdoptioneMail());
+          if (!sDomain.empty()) ++(*pDomains)[sDomain];
+        }
+      }
+    }
+    vecShards[nShard] << row.Format() << '\n';
+  }
+  std::cout.rdbuf(pCout);  std::cout.clear();
+
+  for (unsigned i = 0;  i < m_nShards;  ++i) {
+    vecShards[i].close();
+    if (vecShards[i].fail()) ERRS("CShards::Split() error writing " << GetShardName(pszWhich, i));
+  }
+  MSGS("Split " << nRecords << " rows from " << sFileName << " into " << m_nShards << " shards ("
+       << nCutoff << " before " << m_nCutoff << ", " << nDuplicates << " duplicate microchips)");
+}
+
+
+void CShards::FindSimilarChips (const CHIP_MAP &mapChips)
+{
+  //++
+  //   Find the similar microchips in the new DIR, exactly the way that
+  // CDogs::FindSimilarChips() does, but only keep the pairs where the two
+  // dogs ended up in different shards.  The rest will be found by the
+  // update runs for the shards ...
+  //--
+  TRACE_SCOPE("similar chips");
+  vector<const CHIP_MAP::value_type *> vecDogs;
+  for (CHIP_MAP::const_iterator it = mapChips.begin();  it != mapChips.end();  ++it)
+    if (CDogs::IsISOChip(it->first)) vecDogs.push_back(&*it);
+  std::sort(vecDogs.begin(), vecDogs.end(),
+    [](const CHIP_MAP::value_type *p1, const CHIP_MAP::value_type *p2) {return p1->first < p2->first;});
+  vector<string> vecChips;  vecChips.reserve(vecDogs.size());
+  for (size_t i = 0;  i < vecDogs.size();  ++i) vecChips.push_back(vecDogs[i]->first);
+
+  vector<CDogs::SIMILAR_CHIPS> vecSimilar;
+  CDogs::FindSimilarChips(vecChips, vecSimilar);
+  for (vector<CDogs::SIMILAR_CHIPS>::const_iterator it = vecSimilar.begin();  it != vecSimilar.end();  ++it) {
+    const CHIP_DOG &Dog1 = vecDogs[it->n1]->second, &Dog2 = vecDogs[it->n2]->second;
+    if (Dog1.nShard == Dog2.nShard) continue;
+    m_vecErrors.push_back({Dog1, "microchip " + vecChips[it->n1] + " is similar to microchip " + vecChips[it->n2]
+                                 + " of " + Dog2.sName + " #" + Dog2.sID + " (" + it->pszWhy + ")"});
+  }
+}
+
+
+size_t CShards::FindReentries (const MATCH_VECTOR &vecOld, const MATCH_VECTOR &vecNew,
+                              const KEY_SET &setOld, const KEY_SET &setNew)
+{
+  //++
+  //   Find the likely re-entries of every old dog that isn't in the new DIR,
+  // exactly the way CDogMatcher::ReportMissingDogs() does, but with just the
+  // FIELDS that SplitFile() kept.  Unlike the similar microchips these are
+  // all reported here, even when both dogs ended up in the same shard.  Only
+  // the best MAX_MATCHES candidates in the whole new DIR are reported, and no
+  // one shard can know which those are.  Returns the number of missing dogs
+  // that had at least one match ...
+  //--
+  TRACE_SCOPE("re-entered dogs");
+  typedef unordered_map<string, vector<size_t> > BLOCK_INDEX;
+  BLOCK_INDEX mapChip, mapName, mapSurrender;
+  for (size_t i = 0;  i < vecNew.size();  ++i) {
+    //   A dog that's also in the old DIR can't be a re-entry, so it's never
+    // even indexed.  Other than that, these are CDogMatcher's indexes ...
+    const CDogMatcher::FIELDS &Fields = vecNew[i].Fields;
+    if (setOld.count(vecNew[i].nKey) != 0) continue;
+    string sKey = CDogMatcher::NameKey(Fields);
+    if (!Fields.sChip.empty()) mapChip[Fields.sChip].push_back(i);
+    if (!sKey.empty()) mapName[sKey].push_back(i);
+    if (!Fields.sSurrender.empty()) mapSurrender[Fields.sSurrender].push_back(i);
+  }
+
+  size_t nFound = 0;
+  for (MATCH_VECTOR::const_iterator it = vecOld.begin();  it != vecOld.end();  ++it) {
+    if (setNew.count(it->nKey) != 0) continue;
+    const BLOCK_INDEX *apIndex[3] = {&mapChip, &mapName, &mapSurrender};
+    string asKeys[3] = {it->Fields.sChip, CDogMatcher::NameKey(it->Fields), it->Fields.sSurrender};
+    vector<size_t> vecCandidates;
+    for (unsigned i = 0;  i < 3;  ++i) {
+      BLOCK_INDEX::const_iterator itb = asKeys[i].empty() ? apIndex[i]->end() : apIndex[i]->find(asKeys[i]);
+      if (itb != apIndex[i]->end())
+        vecCandidates.insert(vecCandidates.end(), itb->second.begin(), itb->second.end());
+    }
+    std::sort(vecCandidates.begin(), vecCandidates.end());
+    vecCandidates.erase(std::unique(vecCandidates.begin(), vecCandidates.end()), vecCandidates.end());
+
+    // Score them, best first and lowest dog key first for a tie ...
+    vector<std::pair<uint32_t, size_t> > vecMatches;
+    for (vector<size_t>::const_iterator itc = vecCandidates.begin();  itc != vecCandidates.end();  ++itc) {
+      uint32_t nScore = CDogMatcher::Score(it->Fields, vecNew[*itc].Fields);
+      if (nScore >= CDogMatcher::MIN_SCORE) vecMatches.push_back({nScore, *itc});
+    }
+    std::sort(vecMatches.begin(), vecMatches.end(),
+      [&vecNew](const std::pair<uint32_t, size_t> &m1, const std::pair<uint32_t, size_t> &m2)
+      {return (m1.first != m2.first) ? (m1.first > m2.first) : (vecNew[m1.second].nKey < vecNew[m2.second].nKey);});
+    if (vecMatches.size() > CDogMatcher::MAX_MATCHES) vecMatches.resize(CDogMatcher::MAX_MATCHES);
+    if (vecMatches.empty()) continue;
+    ++nFound;
+    for (vector<std::pair<uint32_t, size_t> >::const_iterator itm = vecMatches.begin();  itm != vecMatches.end();  ++itm) {
+      const CHIP_DOG &Dog = vecNew[itm->second].Dog;
+      m_vecErrors.push_back({it->Dog, "may have been re-entered as " + Dog.sName + " #" + Dog.sID
+                                      + " (score " + std::to_string(itm->first) + ")"});
+    }
+  }
+  return nFound;
+}
+
+
+void CShards::WriteHouseholds()
+{
+  //++
+  //   Build the households for the whole DIR pair and write each shard's dogs
+  // and their households to that shard's file (see CHouseholds::ReadFile()).
+  // The adopters aren't needed after that ...
+  //--
+  TRACE_SCOPE("households");
+  m_Households.Build();
+  vector<CCSVFile> vecFiles(m_nShards);
+  for (vector<ADOPTER>::const_iterator it = m_vecAdopters.begin();  it != m_vecAdopters.end();  ++it) {
+    CCSVRow row(3);
+    row[0] = it->pszWhich;  row[1] = it->sID;
+    row[2] = std::to_string(m_Households.GetAdopterHousehold(it->nAdopter));
+    vecFiles[it->nShard].AddRow(row);
+  }
+  for (unsigned i = 0;  i < m_nShards;  ++i)
+    vecFiles[i].Write(GetShardName("households", i), CHouseholds::m_sColumnHeaders);
+  MSGS("Wrote " << m_vecAdopters.size() << " adopters in " << m_Households.HouseholdCount() << " households to " << m_nShards << " shards");
+  m_vecAdopters.clear();  m_vecAdopters.shrink_to_fit();
+}
+
+
+void CShards::WriteManifest() const
+{
+  //++
+  //   Write the manifest for the shards.  It's a CBatch manifest with one job
+  // per shard, so the whole thing can be run with "batch", or the rows can
+  // be handed out to separate machines (along with the domains file, which
+  // every shard needs, and that shard's households file).  Either way,
+  // Merge() reads it to find the output files.  The file names are relative
+  // to the manifest, which is in the same directory.  Edit the Org column if
+  // these aren't NGRR's dogs.
+  //--
+  CCSVFile csv;
+  for (unsigned i = 0;  i < m_nShards;  ++i) {
+    CCSVRow row(CBatch::TOTAL_COLUMNS);
+    row[CBatch::COL_ORG-1]        = COrgProfile::GetNGRR()->GetOrg();
+    row[CBatch::COL_OLD_DIR-1]    = GetManifestName("old", i);
+    row[CBatch::COL_NEW_DIR-1]    = GetManifestName("new", i);
+    row[CBatch::COL_UPDATES-1]    = GetManifestName("updates", i);
+    row[CBatch::COL_ERRORS-1]     = GetManifestName("errors", i);
+    row[CBatch::COL_DOMAINS-1]    = m_pszDomains;
+    row[CBatch::COL_HOUSEHOLDS-1] = GetManifestName("households", i);
+    csv.AddRow(row);
+  }
+  csv.Write(GetFileName(m_pszManifest), CBatch::m_sShardColumnHeaders);
+  MSGS("Wrote " << m_nShards << " jobs to " << GetFileName(m_pszManifest));
+}
+
+
+void CShards::Split (const string &sOldFile, const string &sNewFile)
+{
+  //++
+  //   Split both DIRs and then do the checks that need to see all the dogs.
+  // The bad dogs that CDog::FromRow() finds along the way go to a CBadDogs
+  // with no file (see SplitFile(), which keeps the ones about dogs that it
+  // drops), and the errors we do want are written to their own file at the
+  // end.  The old dogs' microchips are only needed to find the duplicates in
+  // the old DIR, but their FIELDS are needed until the new DIR is done ...
+  //--
+  assert((m_nShards > 0) && (m_nShards <= MAX_SHARDS));
+  assert(m_Households.AdopterCount() == 0);
+  CHIP_MAP mapOld, mapNew;  KEY_SET setOld, setNew;  MATCH_VECTOR vecOld, vecNew;  DOMAIN_MAP mapDomains;
+  m_vecErrors.clear();  m_vecAdopters.clear();
+  CBadDogs *pIgnored = new CBadDogs("");
+  try {
+    SplitFile(sOldFile, m_fOldFormat, "old", mapOld, setOld, vecOld, &mapDomains);
+    mapOld.clear();
+    SplitFile(sNewFile, m_fNewFormat, "new", mapNew, setNew, vecNew, NULL);
+  } catch (...) {
+    delete pIgnored;  throw;
+  }
+  delete pIgnored;
+
+  FindSimilarChips(mapNew);  mapNew.clear();
+  size_t nFound = FindReentries(vecOld, vecNew, setOld, setNew);
+  MSGS("Found " << nFound << " dogs that may have been re-entered");
+  CDomainChecker::WriteCounts(GetFileName(m_pszDomains), mapDomains);
+  MSGS("Wrote " << mapDomains.size() << " email domains to " << GetFileName(m_pszDomains));
+  WriteHouseholds();
+  WriteManifest();
+  CBadDogs Errors(GetFileName(m_pszChipErrors));
+  for (vector<CHIP_ERROR>::const_iterator it = m_vecErrors.begin();  it != m_vecErrors.end();  ++it)
+    Errors.AddError(it->Dog.sName, it->Dog.sID, it->Dog.sContact, it->sMessage);
+  Errors.WriteFile();
+}
+
+
+/*static*/ void CShards::ReadPart (const string &sFileName, const string &sHeader, CCSVFile &csv)
+{
+  //++
+  //   Read one shard's updates or errors file and add its rows to the merged
+  // collection ...
+  //--
+  CCSVFile part;
+  part.Read(sFileName, sHeader);
+  csv.AddRows(part);
+}
+
+
+/*static*/ void CShards::SortByDog (CCSVFile &csv, size_t nColumn, bool fNotes)
+{
+  //++
+  //   Sort a merged file by dog number - organization prefix first, then
+  // the number.  For the updates the number is at the end of the notes
+  // field ("NGRR #1234").  The sort is stable, so the errors for one dog stay
+  // in the order its shard reported them, and anything that doesn't parse
+  // goes at the end ...
+  //--
+  struct ORDER {
+    bool      fValid;               // true if the dog number parsed
+    string    sPrefix;              // organization prefix
+    uint32_t  nNumber;              // and dog number
+    string    sText;                // the original text
+    CCSVRow  *pRow;                 // the row itself
+  };
+  vector<ORDER> vecOrder;  vecOrder.reserve(csv.size());
+  for (CCSVFile::iterator it = csv.begin();  it != csv.end();  ++it) {
+    ORDER order;  uint32_t nOrg = 0;
+    order.sText = (nColumn < (*it)->size()) ? (**it)[nColumn] : string();
+    if (fNotes) {
+      size_t nHash = order.sText.rfind(" #");
+      order.sText = (nHash != string::npos) ? order.sText.substr(nHash+2) : string();
+    }
+    order.nNumber = 0;
+    order.fValid = CDog::ParseDogID(order.sText, nOrg, order.nNumber);
+    order.sPrefix = order.fValid ? CDog::GetOrgPrefix(nOrg) : string();
+    order.pRow = *it;  vecOrder.push_back(order);
+  }
+  std::stable_sort(vecOrder.begin(), vecOrder.end(), [](const ORDER &o1, const ORDER &o2) {
+    if (o1.fValid != o2.fValid) return o1.fValid;
+    if (!o1.fValid) return o1.sText < o2.sText;
+    if (o1.sPrefix != o2.sPrefix) return o1.sPrefix < o2.sPrefix;
+    return o1.nNumber < o2.nNumber;
+  });
+  //   Put the rows back in the new order.  It's the same row pointers, just
+  // shuffled, so the collection still owns every one of them exactly once ...
+  CCSVFile::iterator itRow = csv.begin();
+  for (vector<ORDER>::const_iterator it = vecOrder.begin();  it != vecOrder.end();  ++it, ++itRow)
+    *itRow = it->pRow;
+}
+
+
+/*static*/ void CShards::Merge (const string &sManifest, const string &sUpdatesFile, const string &sErrorsFile)
+{
+  //++
+  //   Merge the updates and errors files for all the shards in the manifest,
+  // plus the errors that Split() found, into one updates file and one errors
+  // file.  Every shard has to be there - a missing one is an error, not an
+  // empty shard.  If any of the shards were run without the files from
+  // Split() (e.g. from a hand made manifest) that's listed at the end, so
+  // nobody mistakes the result for a single run's.  The file names in the
+  // manifest are already relative to it (see CBatch::ReadManifestFile()) ...
+  //--
+  CCSVFile manifest;
+  size_t nColumns = CBatch::ReadManifestFile(sManifest, manifest);
+  if (manifest.size() == 0) ERRS("CShards::Merge() no shards in " << sManifest);
+
+  // The errors from Split() are in the same directory as the manifest ...
+  string sChipErrors = CBatch::ResolveFileName(sManifest, m_pszChipErrors);
+
+  //   The errors files all have the same header, but it might be the one
+  // with the raw DIR rows.  Take it from the first one ...
+  string sErrorHeaders = CBadDogs::m_sColumnHeaders;
+  if (manifest[0]->size() == nColumns) {
+    std::ifstream stm((*manifest[0])[CBatch::COL_ERRORS-1]);  CCSVRow hdr;
+    if (stm.is_open() && (hdr.Read(stm) > 0) && hdr.Verify(CBadDogs::m_sRawColumnHeaders))
+      sErrorHeaders = CBadDogs::m_sRawColumnHeaders;
+  }
+
+  CCSVFile Updates, Errors;  bool fAllDomains = true, fAllHouseholds = true;
+  for (size_t i = 0;  i < manifest.size();  ++i) {
+    const CCSVRow &row = *manifest[i];
+    if (row.size() != nColumns)
+      ERRS("wrong number of columns in row " << (i+2) << " of " << sManifest);
+    if ((nColumns < CBatch::COL_DOMAINS) || row[CBatch::COL_DOMAINS-1].empty()) fAllDomains = false;
+    if ((nColumns < CBatch::COL_HOUSEHOLDS) || row[CBatch::COL_HOUSEHOLDS-1].empty()) fAllHouseholds = false;
+    ReadPart(row[CBatch::COL_UPDATES-1], CChip::m_sFoundHeaders, Updates);
+    ReadPart(row[CBatch::COL_ERRORS-1], sErrorHeaders, Errors);
+  }
+  ReadPart(sChipErrors, sErrorHeaders, Errors);
+  MSGS("Read " << Updates.size() << " updates and " << Errors.size() << " errors from " << manifest.size() << " shards");
+
+  SortByDog(Updates, CChip::COL_FOUND_NOTES-1, true);
+  SortByDog(Errors, CBadDogs::COL_DOG_NUMBER-1, false);
+  size_t nUpdates = Updates.Write(sUpdatesFile, CChip::m_sFoundHeaders);
+  MSGS("Wrote " << nUpdates << " rows to " << sUpdatesFile);
+  size_t nErrors = Errors.Write(sErrorsFile, sErrorHeaders);
+  MSGS("Wrote " << nErrors << " bad dogs to " << sErrorsFile);
+
+  //   A shard without the domains file learned its email domains from just
+  // its own piece of the old DIR, and it looked for re-entered dogs by itself
+  // as well as Split().  And a shard without the households file found its
+  // households from just its own adopters ...
+  if (!fAllDomains)
+    MSGS("WARNING - some shards had no domains file, so their email domains were only learned from that shard and their re-entered dogs may be reported twice");
+  if (!fAllHouseholds)
+    MSGS("WARNING - some shards had no households file, so their households were only found within that shard and \"adopting family changed\" may not be the same as a single run");
+}
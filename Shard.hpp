@@ -0,0 +1,213 @@
+//++
+// Shard.hpp -> split a DIR pair into shards and merge the results
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The biggest combined archives don't fit in one machine's memory, even
+// with a batch run.  CShards splits the old and new DIRs into N pairs of
+// smaller DIRs ("shards") by a hash of the dog number, so every dog lands in
+// the same shard in both DIRs.  Each pair is then an ordinary update run,
+// with the same -c and -o options, on whatever machine has room for it.
+// Afterwards Merge() combines all the updates and errors files into one of
+// each, sorted by dog number so the result doesn't depend on the number of
+// shards or the order they finished in.
+//
+//   Split() makes one streaming pass over each DIR, one record at a time, so
+// it never holds a whole DIR in memory.  The records are written to the
+// shards in the plain NGRR CSV format (converted to UTF-8 too) no matter
+// what dialect the DIR is in.  Dogs acquired before the cutoff year are left
+// out entirely, since no update run would look at them anyway.  It also
+// writes a manifest for the shards (in the same format as a CBatch manifest,
+// so "batch" can run them all on one machine) and a separate errors file for
+// the checks that need to see every dog -
+//
+//    * two dogs in the same DIR with the same microchip.  CDogs::Add() keeps
+//      the first one and rejects the second, and that decision depends on
+//      every dog before it, so Split() makes it here instead.  The dog that's
+//      rejected isn't written to any shard, which leaves each shard with
+//      exactly the dogs that a single update run would have kept.  Any other
+//      errors for that dog (e.g. no acquisition date) are reported here too.
+//
+//    * microchips in the new DIR that are one typo away from another dog's
+//      (see CDogs::FindSimilarChips()).  Pairs in the same shard are found by
+//      that shard's update run, so only the pairs that span two shards are
+//      reported here.
+//
+//    * dogs that disappeared from the new DIR and were likely re-entered
+//      under another number (see CDogMatcher).  The new record usually has a
+//      different number, and so a different shard, and only the best few
+//      candidates from the whole new DIR are reported.  So ALL of these are
+//      found here, and the shard runs don't look for them at all.
+//
+// For these only the name, number, contact and shard of each dog are kept,
+// plus the handful of fields that CDogMatcher compares, which is a small
+// fraction of the DIR.
+//
+//   Split() also counts the adopter email domains in the whole old DIR, the
+// same way CDomainChecker does, and writes the counts to their own file.
+// The manifest gives that file to every shard (it's the optional Domains
+// column in a CBatch manifest), and each shard run learns its domains from
+// it rather than from its own small piece of the old DIR.  Otherwise a
+// domain that's common in the whole DIR, but not in any one shard, is never
+// learned and its misspellings are never caught.
+//
+//   The adopter households (see CHouseholds) are the same story - two
+// adopters can be tied together by a third one whose dog went to another
+// shard.  So Split() adds every kept dog's adopter to one CHouseholds, the
+// same way CPartitions does, and builds the households for the whole DIR
+// pair at the end.  Each shard gets a file with its own dogs' households
+// ("households.nnn.csv", in the optional Households column of the manifest),
+// and its update run uses those instead of building its own.  Only the
+// adopter keys, and each dog's ID and adopter number, are kept for this.
+//
+//   The shard files are named "old.nnn.csv" and "new.nnn.csv", the manifest
+// is "shards.csv", the domain counts are in "domains.csv", and the errors from
+// the checks above are in "errors.chips.csv", all in the same directory.  The
+// file names in the manifest are relative to the manifest (see CBatch), and
+// Merge() expects to find errors.chips.csv next to it as well.  So the whole
+// directory can be moved, or run from anywhere, as long as it stays together.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Find re-entered dogs and count email domains in Split().
+// 17-OCT-26  AGT   Find the households in Split() too.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include <unordered_set>        // C++ std::unordered_set ...
+#include "DogMatcher.hpp"       // CDogMatcher::FIELDS
+#include "Household.hpp"        // adopter household index
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::unordered_map;       // ...
+class CCSVFile;                 // ...
+
+
+class CShards {
+  //++
+  // Split DIRs into shards by dog number and merge the results ...
+  //--
+
+public:
+  enum {
+    MAX_SHARDS          = 256,          // maximum number of shards
+    DEFAULT_SHARDS      = 4,            // default number of shards
+  };
+  // File names in the shard directory ...
+  static const char *m_pszManifest;     // manifest for the shards
+  static const char *m_pszChipErrors;   // errors found by Split()
+  static const char *m_pszDomains;      // email domain counts
+
+public:
+  // Constructor and destructor ...
+  CShards();
+  virtual ~CShards() {};
+  // Copy and assignment constructors ...
+  CShards (const CShards &s) = delete;
+  CShards& operator= (const CShards &s) = delete;
+
+  // CShards properties ...
+public:
+  // Set the number of shards ...
+  void SetShards (unsigned nShards) {m_nShards = nShards;}
+  // Set the cutoff year and the DIR formats ...
+  void SetCutoffYear (uint32_t nYear) {m_nCutoff = nYear;}
+  void SetFormats (bool fOldFormat, bool fNewFormat)
+    {m_fOldFormat = fOldFormat;  m_fNewFormat = fNewFormat;}
+  // Set the directory for the shard files ...
+  void SetDirectory (const string &sDirectory) {m_sDirectory = sDirectory;}
+
+  // CShards public methods ...
+public:
+  // Split both DIRs into shards ...
+  void Split (const string &sOldFile, const string &sNewFile);
+  // Merge the updates and errors from all the shards ...
+  static void Merge (const string &sManifest, const string &sUpdatesFile, const string &sErrorsFile);
+  // Return the shard for a dog number ...
+  static unsigned GetShard (const string &sID, unsigned nShards);
+
+  // Private internal CShards methods ...
+protected:
+  // What Split() remembers about each dog with a microchip ...
+  struct CHIP_DOG {
+    string    sName, sID, sContact; // for the errors file
+    unsigned  nShard;               // and the shard it went to
+  };
+  typedef unordered_map<string, CHIP_DOG> CHIP_MAP;
+  // And what it remembers about every dog for CDogMatcher ...
+  struct MATCH_DOG {
+    uint64_t  nKey;                 // CDog::GetKey() (for breaking ties)
+    CHIP_DOG  Dog;                  // name, number, contact and shard
+    CDogMatcher::FIELDS Fields;     // the fields that get scored
+  };
+  typedef vector<MATCH_DOG> MATCH_VECTOR;
+  // The keys of all the dogs that were kept from one DIR ...
+  typedef std::unordered_set<uint64_t> KEY_SET;
+  // And the number of adopters at each email domain ...
+  typedef unordered_map<string, uint32_t> DOMAIN_MAP;
+  // A dog with an adopter, until the households are built ...
+  struct ADOPTER {
+    unsigned  nShard;               // the shard the dog went to
+    const char *pszWhich;           // which DIR it's from ("old" or "new")
+    string    sID;                  // the dog's ID (e.g. "GRRA-56")
+    uint32_t  nAdopter;             // and its CHouseholds adopter number
+  };
+  // An error found by Split() ...
+  struct CHIP_ERROR {
+    CHIP_DOG  Dog;                  // the dog with the problem
+    string    sMessage;             // and what it is
+  };
+  // Return the name of a file in the shard directory ...
+  string GetFileName (const string &sName) const;
+  string GetShardName (const char *pszWhich, unsigned nShard) const;
+  // Return the name of one shard file in the manifest ...
+  static string GetManifestName (const char *pszWhich, unsigned nShard);
+  // Split one DIR ...
+  void SplitFile (const string &sFileName, bool fNew, const char *pszWhich, CHIP_MAP &mapChips,
+                  KEY_SET &setKeys, MATCH_VECTOR &vecDogs, DOMAIN_MAP *pDomains);
+  // Find similar microchips in different shards ...
+  void FindSimilarChips (const CHIP_MAP &mapChips);
+  // Find the likely re-entries of every dog that disappeared ...
+  size_t FindReentries (const MATCH_VECTOR &vecOld, const MATCH_VECTOR &vecNew,
+                        const KEY_SET &setOld, const KEY_SET &setNew);
+  // Write the households file for every shard ...
+  void WriteHouseholds();
+  // Write the manifest for the shards ...
+  void WriteManifest() const;
+  // Read one shard's output file and add it to the merged one ...
+  static void ReadPart (const string &sFileName, const string &sHeader, CCSVFile &csv);
+  // Sort a merged file by the dog number in one column ...
+  static void SortByDog (CCSVFile &csv, size_t nColumn, bool fNotes);
+
+  // Local CShards members ...
+protected:
+  unsigned            m_nShards;        // number of shards
+  uint32_t            m_nCutoff;        // cutoff year
+  bool                m_fOldFormat;     // true if the old DIR is the new format
+  bool                m_fNewFormat;     //   "   "  "  new  "   "   "   "    "
+  string              m_sDirectory;     // directory for the shard files
+  vector<CHIP_ERROR>  m_vecErrors;      // errors found by Split()
+  CHouseholds         m_Households;     // adopter households in both DIRs
+  vector<ADOPTER>     m_vecAdopters;    // every dog with an adopter
+};
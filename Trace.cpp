@@ -0,0 +1,190 @@
+//++
+// Trace.cpp - implementation of the CTracer class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CTracer class, which records a timeline of the
+// run and writes it in the Chrome trace event JSON format.  The format is
+// documented in Google's "Trace Event Format" document - all we use are the
+// "B" (begin) and "E" (end) duration events plus the "M" (metadata) events
+// that give each thread a name.  Time stamps are in microseconds.
+//
+//   Each thread finds its own buffer through a thread_local pointer.  The
+// pointer is tagged with the generation of the CTracer that created it so
+// that a stale pointer left over from a previous instance is never used.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   The destructor doesn't write the file any more.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <fstream>              // std::filebuf
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "Metrics.hpp"          // CMetrics::JSONString()
+#include "Trace.hpp"            // declarations for this module
+
+// Initialize all the static members of CTracer ...
+CTracer *CTracer::m_pTracer = NULL;
+uint32_t CTracer::m_nGenerations = 0;
+
+// This thread's event buffer (owned by the CTracer object) ...
+static thread_local CTracer::BUFFER *t_pBuffer = NULL;
+
+// Category names, as they appear in the trace file ...
+static const char *const g_apszCategories[CTracer::MAXCATEGORY] = {
+  "stage", "pass", "chunk"
+};
+
+
+CTracer::CTracer (const string &sFileName)
+{
+  //++
+  //   The constructor remembers the one and only instance and the name of
+  // the file that WriteFile() will write ...
+  //--
+  assert(m_pTracer == NULL);
+  assert(!sFileName.empty());
+  m_sFileName = sFileName;  m_tCreated = CLOCK::now();
+  m_nGeneration = ++m_nGenerations;
+  m_pTracer = this;
+}
+
+
+CTracer::~CTracer()
+{
+  //++
+  //   The destructor deletes all the buffers and then forgets about this
+  // instance.  It does NOT write the trace file - call WriteFile() first for
+  // that.  Note that it's up to the caller to ensure that no other threads
+  // are still recording events at this point!
+  //--
+  assert(m_pTracer == this);
+  m_pTracer = NULL;
+  for (vector<BUFFER *>::iterator it = m_vecBuffers.begin();  it != m_vecBuffers.end();  ++it)
+    delete *it;
+  m_vecBuffers.clear();
+}
+
+
+size_t CTracer::GetEventCount() const
+{
+  //++
+  // Return the total number of events in all buffers ...
+  //--
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  size_t nEvents = 0;
+  for (vector<BUFFER *>::const_iterator it = m_vecBuffers.begin();  it != m_vecBuffers.end();  ++it)
+    nEvents += (*it)->vecEvents.size();
+  return nEvents;
+}
+
+
+CTracer::BUFFER *CTracer::GetBuffer()
+{
+  //++
+  //   Return the event buffer for the current thread.  The first time a
+  // thread records an event we have to create a buffer for it and add it to
+  // the list, and that takes the lock.  After that it's just a thread_local.
+  //--
+  if ((t_pBuffer != NULL) && (t_pBuffer->nGeneration == m_nGeneration)) return t_pBuffer;
+  BUFFER *pBuffer = new BUFFER;
+  pBuffer->nGeneration = m_nGeneration;
+  pBuffer->vecEvents.reserve(1024);
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  pBuffer->nThread = (uint32_t) m_vecBuffers.size() + 1;
+  m_vecBuffers.push_back(pBuffer);
+  t_pBuffer = pBuffer;
+  return pBuffer;
+}
+
+
+void CTracer::Record (const char *pszName, CATEGORY nCategory, char chType, int64_t nArg)
+{
+  //++
+  // Add one event to the current thread's buffer ...
+  //--
+  EVENT e;
+  e.pszName = pszName;  e.nCategory = (uint8_t) nCategory;
+  e.chType = chType;  e.nArg = nArg;
+  e.nTime = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(CLOCK::now() - m_tCreated).count();
+  GetBuffer()->vecEvents.push_back(e);
+}
+
+
+/*static*/ void CTracer::SetThreadName (const string &sName)
+{
+  //++
+  // Name the current thread's track in the timeline ...
+  //--
+  if (m_pTracer == NULL) return;
+  m_pTracer->GetBuffer()->sName = sName;
+}
+
+
+void CTracer::WriteFile (ostream &stm) const
+{
+  //++
+  //   Write all the events, for all threads, in the trace event format.  The
+  // events for each thread are already in time order, and the viewers don't
+  // care if the threads are interleaved or not, so we just write one thread's
+  // buffer after another ...
+  //--
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  const char *pszSeparator = "\n";
+  stm << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for (vector<BUFFER *>::const_iterator it = m_vecBuffers.begin();  it != m_vecBuffers.end();  ++it) {
+    const BUFFER *pBuffer = *it;
+    string sName = !pBuffer->sName.empty() ? pBuffer->sName
+                 : (pBuffer->nThread == 1) ? string("main") : ("thread " + std::to_string(pBuffer->nThread));
+    stm << pszSeparator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << pBuffer->nThread
+        << ", \"args\": {\"name\": " << CMetrics::JSONString(sName) << "}}";
+    pszSeparator = ",\n";
+    for (vector<EVENT>::const_iterator ite = pBuffer->vecEvents.begin();  ite != pBuffer->vecEvents.end();  ++ite) {
+      stm << pszSeparator << "{\"name\": " << CMetrics::JSONString(ite->pszName)
+          << ", \"cat\": \"" << g_apszCategories[ite->nCategory] << "\""
+          << ", \"ph\": \"" << ite->chType << "\""
+          << ", \"ts\": " << (ite->nTime / 1000) << "." << CBadDogs::Print("%03u", (unsigned) (ite->nTime % 1000))
+          << ", \"pid\": 1, \"tid\": " << pBuffer->nThread;
+      if (ite->nArg != NOARG) stm << ", \"args\": {\"n\": " << ite->nArg << "}";
+      stm << "}";
+    }
+  }
+  stm << "\n]}\n";
+}
+
+
+void CTracer::WriteFile (const string &sFileName) const
+{
+  //++
+  //   Same as the above, but handle opening and closing the file too.  If no
+  // file name is specified, then use the one passed to the constructor ...
+  //--
+  string sFN = sFileName.empty() ? m_sFileName : sFileName;
+  std::filebuf fb;
+  if (!fb.open(sFN, std::ios::out))
+    ERRS("CTracer::WriteFile() unable to create " << sFN);
+  std::ostream os(&fb);
+  WriteFile(os);
+  fb.close();
+  MSGS("Wrote trace to " << sFN);
+}
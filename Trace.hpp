@@ -0,0 +1,160 @@
+//++
+// Trace.hpp -> Chrome/Perfetto trace event timeline
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The CTracer class records begin and end events for the stages of a run,
+// and for smaller units of work inside them (e.g. each chunk of rows while
+// reading a DIR), and writes them to a JSON file in the Chrome "trace event"
+// format.  That file can be loaded into chrome://tracing or ui.perfetto.dev
+// to see a timeline of the run, one track per thread.
+//
+//   Every thread records its events in its own buffer, so recording an event
+// takes no locks - it's just a read of the clock and a push_back().  The
+// buffers are only merged when the file is written.  The names passed to
+// Begin() and End() must be string constants (we only keep the pointer!).
+//
+//   Like CBadDogs, CTracer is a singleton, and like CBadDogs the file is only
+// written by an explicit call to WriteFile() - never by the destructor, which
+// can't report a failure without terminating the program.  If no instance
+// exists (i.e. there was no --trace option) then all the
+// static methods and the TRACE_SCOPE() macros quietly do nothing.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   The destructor doesn't write the file any more.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <chrono>               // std::chrono::steady_clock, et al ...
+#include <mutex>                // std::mutex, std::lock_guard ...
+#include <iostream>             // C++ style output ...
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::ostream;             // ...
+
+// Trace a stage or a chunk of work from here to the end of the block ...
+#define TRACE_CONCAT2(a,b)      a##b
+#define TRACE_CONCAT(a,b)       TRACE_CONCAT2(a,b)
+#define TRACE_SCOPE(name)       CTraceScope TRACE_CONCAT(_trace_,__LINE__)(name)
+#define TRACE_CHUNK(name, n)    CTraceScope TRACE_CONCAT(_trace_,__LINE__)(name, CTracer::CHUNK, n)
+
+
+class CTracer {
+  //++
+  // Trace event recorder ...
+  //--
+
+public:
+  // Categories of events ...
+  enum CATEGORY {
+    STAGE,                      // a pipeline stage (aka phase)
+    PASS,                       // one pass of a stage (e.g. CompareDogs())
+    CHUNK,                      // one chunk of work inside a stage
+    MAXCATEGORY                 // number of categories
+  };
+  enum {NOARG = -1};            // event has no argument
+
+  // One recorded event ...
+  struct EVENT {
+    const char *pszName;        // name of the event (a constant!)
+    uint8_t     nCategory;      // CATEGORY of the event
+    char        chType;         // 'B' for begin or 'E' for end
+    int64_t     nArg;           // chunk number or NOARG
+    uint64_t    nTime;          // nanoseconds since the tracer was created
+  };
+  // All the events recorded by one thread ...
+  struct BUFFER {
+    uint32_t      nThread;      // thread number, in order of first event
+    uint32_t      nGeneration;  // CTracer instance that owns this buffer
+    string        sName;        // thread name (if any)
+    vector<EVENT> vecEvents;    // events, in the order recorded
+  };
+
+public:
+  // Constructor and destructor ...
+  CTracer (const string &sFileName);
+  virtual ~CTracer();
+  // Copy and assignment constructors ...
+  CTracer (const CTracer &t) = delete;
+  CTracer& operator= (const CTracer &t) = delete;
+
+  // CTracer properties ...
+public:
+  // Return a pointer to the one and only CTracer object (or NULL) ...
+  static CTracer *Get() {return m_pTracer;}
+  // Return the trace file name ...
+  string GetFileName() const {return m_sFileName;}
+  // Return the total number of events recorded so far ...
+  size_t GetEventCount() const;
+
+  // CTracer public methods ...
+public:
+  // Record the beginning or end of an event on the current thread ...
+  static void Begin (const char *pszName, CATEGORY nCategory=STAGE, int64_t nArg=NOARG)
+    {if (m_pTracer != NULL) m_pTracer->Record(pszName, nCategory, 'B', nArg);}
+  static void End (const char *pszName, CATEGORY nCategory=STAGE, int64_t nArg=NOARG)
+    {if (m_pTracer != NULL) m_pTracer->Record(pszName, nCategory, 'E', nArg);}
+  // Give the current thread a name for the timeline ...
+  static void SetThreadName (const string &sName);
+  // Write all the events to a stream or file (by default, the constructor's) ...
+  void WriteFile (ostream &stm) const;
+  void WriteFile (const string &sFileName="") const;
+
+  // Private internal CTracer methods ...
+protected:
+  typedef std::chrono::steady_clock CLOCK;
+  // Record one event ...
+  void Record (const char *pszName, CATEGORY nCategory, char chType, int64_t nArg);
+  // Return this thread's buffer, creating it if necessary ...
+  BUFFER *GetBuffer();
+
+  // Local CTracer members ...
+protected:
+  static CTracer   *m_pTracer;          // the one and only instance
+  static uint32_t   m_nGenerations;     // number of instances created so far
+  uint32_t          m_nGeneration;      // this instance's generation
+  string            m_sFileName;        // default file for WriteFile()
+  CLOCK::time_point m_tCreated;         // time zero for all events
+  mutable std::mutex m_Mutex;           // protects m_vecBuffers
+  vector<BUFFER *>  m_vecBuffers;       // one buffer for every thread
+};
+
+
+class CTraceScope {
+  //++
+  //   This little helper records a begin event when it's created and the
+  // matching end event when it goes out of scope ...
+  //--
+public:
+  CTraceScope (const char *pszName, CTracer::CATEGORY nCategory=CTracer::PASS, int64_t nArg=CTracer::NOARG)
+    : m_pszName(pszName), m_nCategory(nCategory), m_nArg(nArg)
+    {CTracer::Begin(m_pszName, m_nCategory, m_nArg);}
+  ~CTraceScope() {CTracer::End(m_pszName, m_nCategory, m_nArg);}
+  CTraceScope (const CTraceScope &t) = delete;
+  CTraceScope& operator= (const CTraceScope &t) = delete;
+protected:
+  const char       *m_pszName;          // name of the event
+  CTracer::CATEGORY m_nCategory;        // and its category
+  int64_t           m_nArg;             // and its argument
+};
@@ -0,0 +1,313 @@
+//++
+// WhatIf.cpp - implementation of the CWhatIf class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CWhatIf class, which runs the pipeline for a
+// list of cutoff years after reading the DIRs only once, and runs the rules
+// that look at only one dog only once too.  See WhatIf.hpp.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   Run the one dog rules once and count them by year.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <assert.h>             // assert() (what else??)
+#include <iostream>             // std::ios, std::istream, std::cout
+#include <algorithm>            // std::sort(), std::unique() ...
+#include <unordered_map>        // C++ std::unordered_map (aka a hash table)
+#include <chrono>               // std::chrono::steady_clock, et al ...
+#include "Messages.hpp"         // ERRS() macro, et al ...
+#include "CSVRow.hpp"           // CSV file row object
+#include "CSVFile.hpp"          // a collection of spreadsheet rows
+#include "Dog.hpp"              // CDog data and CDogs collection
+#include "Chip.hpp"             // CChip data and CChips collection
+#include "Household.hpp"        // adopter household index
+#include "DogMatcher.hpp"       // find re-entered dogs
+#include "DomainChecker.hpp"    // misspelled email domains
+#include "MicrochipUpdate.hpp"  // CompareDogs(), BuildUpdates(), etc
+#include "WhatIf.hpp"           // declarations for this module
+
+// All the CompareDogs() passes that only look at one dog ...
+static const uint32_t COMPARE_ONE_DOG = COMPARE_ALL & ~COMPARE_FAMILY;
+
+
+void CWhatIf::SetCutoffs (const vector<uint32_t> &vecCutoffs)
+{
+  //++
+  // Set the list of cutoff years, in ascending order and with no duplicates ...
+  //--
+  m_vecCutoffs = vecCutoffs;
+  std::sort(m_vecCutoffs.begin(), m_vecCutoffs.end());
+  m_vecCutoffs.erase(std::unique(m_vecCutoffs.begin(), m_vecCutoffs.end()), m_vecCutoffs.end());
+}
+
+
+/*static*/ void CWhatIf::DeleteDogs (DOG_VECTOR &vecDogs)
+{
+  //++
+  // Delete all the CDog objects in a DOG_VECTOR ...
+  //--
+  for (DOG_VECTOR::iterator it = vecDogs.begin();  it != vecDogs.end();  ++it) delete it->pDog;
+  vecDogs.clear();
+}
+
+
+void CWhatIf::DeleteBuckets()
+{
+  //++
+  // Delete all the buckets, and the dogs saved in them ...
+  //--
+  for (BUCKET_MAP::iterator it = m_mapBuckets.begin();  it != m_mapBuckets.end();  ++it) delete it->second.pUpdated;
+  m_mapBuckets.clear();
+}
+
+
+void CWhatIf::ReadDogs (const string &sFileName, bool fNew, DOG_VECTOR &vecDogs) const
+{
+  //++
+  //   Read a DIR and turn every row into a dog, the same way CDogs::ReadFile()
+  // does, except that instead of adding the dogs to a collection we keep them
+  // in DIR order and remember the year each one was acquired.  Dogs acquired
+  // before the earliest cutoff are thrown away now, and so are the rows that
+  // aren't dogs at all.  A dog with no acquisition date is kept with a year
+  // of zero - ReadFile() keeps those for every cutoff (and complains about
+  // them every time) ...
+  //--
+  assert(!m_vecCutoffs.empty());
+  CCSVFile csv;
+  csv.Read(sFileName, fNew ? CDog::m_sNewColumnHeaders : CDog::m_sOldColumnHeaders);
+  for (CCSVFile::const_iterator it = csv.begin();  it != csv.end();  ++it) {
+    DOG dog;  dog.pDog = new CDog;
+    if (!dog.pDog->FromRow(**it, fNew)) {delete dog.pDog;  continue;}
+    uint32_t nDay, nMonth;
+    if (!dog.pDog->GetDateAcquired(nDay, nMonth, dog.nYear)) dog.nYear = 0;
+    if ((dog.nYear != 0) && (dog.nYear < m_vecCutoffs.front())) {delete dog.pDog;  continue;}
+    vecDogs.push_back(dog);
+  }
+}
+
+
+/*static*/ void CWhatIf::SelectDogs (const DOG_VECTOR &vecDogs, uint32_t nCutoff, CDogs &Dogs)
+{
+  //++
+  //   Copy all the dogs acquired in nCutoff or later into a collection, in DIR
+  // order so that any duplicates are found the same way they'd be found by
+  // ReadFile().  For the dogs with no date WasAcquiredAfter() does the
+  // complaining (and always says yes) ...
+  //--
+  for (DOG_VECTOR::const_iterator it = vecDogs.begin();  it != vecDogs.end();  ++it) {
+    if ((it->nYear != 0) && (it->nYear < nCutoff)) continue;
+    CDog *pDog = new CDog(*it->pDog);
+    if (it->nYear == 0) pDog->WasAcquiredAfter(nCutoff);
+    if (!Dogs.Add(pDog)) delete pDog;
+  }
+}
+
+
+void CWhatIf::FindUnstableDogs()
+{
+  //++
+  //   Find the dogs whose one dog rules can't be counted by the year they were
+  // acquired (see WhatIf.hpp).  That's any dog whose number or microchip is
+  // in the same DIR more than once, and any dog whose old and new copies were
+  // acquired in different years (or only one of them has a date).  Whatever
+  // is wrong with one copy of the dog number, the whole number is unstable ...
+  //--
+  m_setUnstable.clear();
+  const DOG_VECTOR *apDogs[2] = {&m_vecOld, &m_vecNew};
+  for (unsigned i = 0;  i < 2;  ++i) {
+    unordered_map<uint64_t, unsigned> mapKeys;  unordered_map<string, unsigned> mapChips;
+    for (DOG_VECTOR::const_iterator it = apDogs[i]->begin();  it != apDogs[i]->end();  ++it) {
+      ++mapKeys[it->pDog->GetKey()];
+      if (!it->pDog->GetChip().empty()) ++mapChips[it->pDog->GetChip()];
+    }
+    for (DOG_VECTOR::const_iterator it = apDogs[i]->begin();  it != apDogs[i]->end();  ++it) {
+      if ((mapKeys[it->pDog->GetKey()] > 1)
+       || (!it->pDog->GetChip().empty() && (mapChips[it->pDog->GetChip()] > 1)))
+        m_setUnstable.insert(it->pDog->GetKey());
+    }
+  }
+  unordered_map<uint64_t, uint32_t> mapOldYears;
+  for (DOG_VECTOR::const_iterator it = m_vecOld.begin();  it != m_vecOld.end();  ++it)
+    mapOldYears[it->pDog->GetKey()] = it->nYear;
+  for (DOG_VECTOR::const_iterator it = m_vecNew.begin();  it != m_vecNew.end();  ++it) {
+    unordered_map<uint64_t, uint32_t>::const_iterator ity = mapOldYears.find(it->pDog->GetKey());
+    if ((ity != mapOldYears.end()) && (ity->second != it->nYear)) m_setUnstable.insert(it->pDog->GetKey());
+  }
+}
+
+
+bool CWhatIf::IsUnstable (const CDog *pDog) const
+{
+  //++
+  // Return true if this dog's one dog rules have to be run for every cutoff ...
+  //--
+  return m_setUnstable.find(pDog->GetKey()) != m_setUnstable.end();
+}
+
+
+void CWhatIf::SelectUnstable (const CDogs &Dogs, CDogs &Unstable) const
+{
+  //++
+  //   Copy the unstable dogs that survived SelectDogs() for this cutoff into
+  // another collection.  They're all unique by now, so Add() never fails ...
+  //--
+  for (CDogs::dog_number_const_iterator it = Dogs.dog_begin();  it != Dogs.dog_end();  ++it) {
+    if (!IsUnstable(it->second)) continue;
+    CDog *pDog = new CDog(*it->second);
+    if (!Unstable.Add(pDog)) delete pDog;
+  }
+}
+
+
+void CWhatIf::RunBuckets()
+{
+  //++
+  //   Sort all the stable dogs by the year they were acquired and run the one
+  // dog rules, and BuildUpdates(), for each year.  Those rules only ever pair
+  // a new dog with the old dog that has the same number, and both of those
+  // are always in the same year, so this is the same as running them once on
+  // all the dogs.  The errors and updates for each year go in its bucket,
+  // along with a copy of the dogs that have updates for CheckDogs() ...
+  //--
+  DeleteBuckets();
+  std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+  map<uint32_t, CDogs> mapOld, mapNew;
+  for (DOG_VECTOR::const_iterator it = m_vecOld.begin();  it != m_vecOld.end();  ++it) {
+    if (IsUnstable(it->pDog)) continue;
+    CDog *pDog = new CDog(*it->pDog);
+    if (!mapOld[it->nYear].Add(pDog)) delete pDog;
+  }
+  for (DOG_VECTOR::const_iterator it = m_vecNew.begin();  it != m_vecNew.end();  ++it) {
+    if (IsUnstable(it->pDog)) continue;
+    CDog *pDog = new CDog(*it->pDog);
+    if (!mapNew[it->nYear].Add(pDog)) delete pDog;
+  }
+  // A year with only old dogs (they all went missing!) still needs a bucket ...
+  for (map<uint32_t, CDogs>::iterator ito = mapOld.begin();  ito != mapOld.end();  ++ito) mapNew[ito->first];
+
+  CBadDogs *pBadDogs = new CBadDogs("");
+  for (map<uint32_t, CDogs>::iterator it = mapNew.begin();  it != mapNew.end();  ++it) {
+    CDogs &OldDogs = mapOld[it->first], &NewDogs = it->second;
+    size_t nErrors = pBadDogs->size();
+    BUCKET bucket;  bucket.pUpdated = new CDogs;
+    {
+      CChips Chips;
+      CompareDogs(OldDogs, NewDogs, NULL, COMPARE_ONE_DOG);
+      BuildUpdates(NewDogs, Chips);
+      bucket.nUpdates = Chips.size();
+    }
+    bucket.nErrors = pBadDogs->size() - nErrors;
+    for (CDogs::dog_number_const_iterator itd = NewDogs.dog_begin();  itd != NewDogs.dog_end();  ++itd) {
+      if (!itd->second->IsUpdateRequired()) continue;
+      CDog *pDog = new CDog(*itd->second);
+      if (!bucket.pUpdated->Add(pDog)) delete pDog;
+    }
+    m_mapBuckets[it->first] = bucket;
+    OldDogs.DeleteAll();  NewDogs.DeleteAll();
+  }
+  delete pBadDogs;
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - tStart;
+  m_dSeconds = dt.count();
+}
+
+
+CWhatIf::RESULT CWhatIf::RunOne (uint32_t nCutoff) const
+{
+  //++
+  //   Count the updates and bad dogs that a real run would find for one cutoff
+  // year.  The rules that look at more than one dog are run on all the dogs
+  // from this year on, the one dog rules are run on just the unstable dogs,
+  // and everything else comes from the buckets for this year and later (plus
+  // the dogs with no date, which are in every cutoff).  The CBadDogs has no
+  // file, so it just collects the errors ...
+  //--
+  RESULT result;  result.nCutoff = nCutoff;
+  std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+  CBadDogs *pBadDogs = new CBadDogs("");
+  {
+    CDogs OldDogs, NewDogs, OldUnstable, NewUnstable;  CChips Chips;
+    SelectDogs(m_vecOld, nCutoff, OldDogs);
+    SelectDogs(m_vecNew, nCutoff, NewDogs);
+    result.nOldDogs = OldDogs.DogCount();  result.nNewDogs = NewDogs.DogCount();
+    CHouseholds Households(OldDogs, NewDogs);
+    CompareDogs(OldDogs, NewDogs, &Households, COMPARE_FAMILY);
+    NewDogs.FindSimilarChips();
+    CDogMatcher(NewDogs).ReportMissingDogs(OldDogs);
+    SelectUnstable(OldDogs, OldUnstable);  SelectUnstable(NewDogs, NewUnstable);
+    CompareDogs(OldUnstable, NewUnstable, NULL, COMPARE_ONE_DOG);
+    BuildUpdates(NewUnstable, Chips);
+    CDomainChecker Checker(OldDogs);
+    Checker.CheckDogs(NewUnstable);
+    result.nUpdates = Chips.size();  result.nErrors = 0;
+    for (BUCKET_MAP::const_iterator it = m_mapBuckets.begin();  it != m_mapBuckets.end();  ++it) {
+      if ((it->first != 0) && (it->first < nCutoff)) continue;
+      Checker.CheckDogs(*it->second.pUpdated);
+      result.nUpdates += it->second.nUpdates;  result.nErrors += it->second.nErrors;
+    }
+  }
+  result.nErrors += m_nParseErrors + pBadDogs->size();
+  delete pBadDogs;
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - tStart;
+  result.dSeconds = dt.count();
+  return result;
+}
+
+
+void CWhatIf::Run (const string &sOldFile, bool fOldFormat, const string &sNewFile, bool fNewFormat)
+{
+  //++
+  //   Read both DIRs (once!), run the one dog rules (once!), and then run the
+  // rest of the rules for every cutoff.  All
+  // the usual chatter on stdout is turned off while we do it, the same as the
+  // benchmark does, or there'd be a copy of every bad dog for every cutoff ...
+  //--
+  if (m_vecCutoffs.empty()) return;
+  DeleteDogs(m_vecOld);  DeleteDogs(m_vecNew);  m_vecResults.clear();
+  std::streambuf *pCout = std::cout.rdbuf(NULL);
+  CBadDogs *pBadDogs = new CBadDogs("");
+  ReadDogs(sOldFile, fOldFormat, m_vecOld);
+  ReadDogs(sNewFile, fNewFormat, m_vecNew);
+  m_nParseErrors = pBadDogs->size();
+  delete pBadDogs;
+  FindUnstableDogs();
+  RunBuckets();
+  for (vector<uint32_t>::const_iterator it = m_vecCutoffs.begin();  it != m_vecCutoffs.end();  ++it)
+    m_vecResults.push_back(RunOne(*it));
+  std::cout.rdbuf(pCout);  std::cout.clear();
+  MSGS("Read " << m_vecOld.size() << " old dogs and " << m_vecNew.size() << " new dogs acquired in "
+       << m_vecCutoffs.front() << " or later (or with no date)");
+  MSGS("Ran the one dog rules once for " << m_mapBuckets.size() << " years in " << CBadDogs::Print("%.3f", m_dSeconds)
+       << " seconds (" << m_setUnstable.size() << " unstable dogs are run for every cutoff)");
+}
+
+
+void CWhatIf::Report() const
+{
+  //++
+  // Print the results table on stdout, one line per cutoff year ...
+  //--
+  MSGS(CBadDogs::Print("%6s %10s %10s %10s %10s %10s", "Cutoff", "Old dogs", "New dogs", "Updates", "Errors", "Seconds"));
+  for (RESULT_VECTOR::const_iterator it = m_vecResults.begin();  it != m_vecResults.end();  ++it)
+    MSGS(CBadDogs::Print("%6u %10zu %10zu %10zu %10zu %10.3f", it->nCutoff,
+         it->nOldDogs, it->nNewDogs, it->nUpdates, it->nErrors, it->dSeconds));
+}
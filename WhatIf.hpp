@@ -0,0 +1,160 @@
+//++
+// WhatIf.hpp -> compare the results for several cutoff years
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   Picking the cutoff year (-cnnnn) is a guess - too recent and we miss dogs
+// that need updates, too old and errors.csv fills up with ancient junk.  A
+// CWhatIf answers "what if the cutoff was X?" for a whole list of years at
+// once, and prints a table of the number of dogs, updates and errors that a
+// real run with each cutoff would have produced.
+//
+//   Each DIR is read and parsed only once, keeping every dog for the earliest
+// cutoff, and each dog is tagged with the year it was acquired.  Most of the
+// rules (missing, acquired, adoption, disposition and returned dogs, and
+// everything BuildUpdates() checks) only ever look at one dog and its old
+// copy, so they're run only once, in a single pass, and their updates and
+// errors are counted into a bucket for the year the dog was acquired.  The
+// answer for each cutoff is then just the sum of the buckets for that year
+// and later.
+//
+//   That doesn't work for every dog.  If a dog number or microchip appears
+// more than once in a DIR, then which of them CDogs::Add() keeps depends on
+// the cutoff, and if the old and new copies of a dog have different dates
+// then for some cutoffs one of them is there without the other.  There are
+// never many of these "unstable" dogs, so they just get the one dog rules
+// run again for each cutoff.
+//
+//   The rules that look at more than one dog - the family change check
+// (households depend on every other adopter), duplicate and similar chips,
+// re-entered dogs and email domains - still have to be run for each cutoff,
+// on exactly the same dogs that a real run would give them.  For these the
+// dogs from that year on are copied into a fresh pair of CDogs collections,
+// which is a lot cheaper than parsing them again.  The email domain check
+// only looks at the dogs that get updates, so the bucket keeps a copy of
+// those (as BuildUpdates() left them) for it.
+//
+//   The bad dogs found while parsing (e.g. an invalid dog number) are counted
+// once and added to every cutoff, since a real run finds them before it even
+// looks at the acquisition date.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   Explain why the rules run once per cutoff.
+// 17-OCT-26  AGT   Run the one dog rules once and count them by year.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+#include <map>                  // C++ map (sorted) collection ...
+#include <unordered_set>        // C++ unordered_set collection ...
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+using std::map;                 // ...
+using std::unordered_set;       // ...
+class CDog;                     // ...
+class CDogs;                    // ...
+
+
+class CWhatIf {
+  //++
+  // Results of the whole pipeline for a list of cutoff years ...
+  //--
+
+public:
+  // The results for one cutoff year ...
+  struct RESULT {
+    uint32_t  nCutoff;                  // the cutoff year
+    size_t    nOldDogs;                 // dogs kept from the old DIR
+    size_t    nNewDogs;                 //   "    "    "   "  new  "
+    size_t    nUpdates;                 // updates for Found.org
+    size_t    nErrors;                  // bad dog errors
+    double    dSeconds;                 // time to run the rules for this year
+  };
+  typedef vector<RESULT> RESULT_VECTOR;
+
+public:
+  // Constructor and destructor ...
+  CWhatIf() {m_nParseErrors = 0;  m_dSeconds = 0.0;}
+  virtual ~CWhatIf() {DeleteDogs(m_vecOld);  DeleteDogs(m_vecNew);  DeleteBuckets();}
+  // Copy and assignment constructors ...
+  CWhatIf (const CWhatIf &w) = delete;
+  CWhatIf& operator= (const CWhatIf &w) = delete;
+
+  // CWhatIf public properties ...
+public:
+  // Set the cutoff years (they're sorted and duplicates are removed) ...
+  void SetCutoffs (const vector<uint32_t> &vecCutoffs);
+  const vector<uint32_t> &GetCutoffs() const {return m_vecCutoffs;}
+  // Return the results so far ...
+  const RESULT_VECTOR &GetResults() const {return m_vecResults;}
+
+  // CWhatIf public methods ...
+public:
+  // Read both DIRs and run the pipeline for every cutoff ...
+  void Run (const string &sOldFile, bool fOldFormat, const string &sNewFile, bool fNewFormat);
+  // Print the results table ...
+  void Report() const;
+
+  // Private internal CWhatIf methods ...
+protected:
+  // One parsed dog and the year it was acquired (zero if we don't know) ...
+  struct DOG {
+    CDog     *pDog;                     // the dog, in DIR order
+    uint32_t  nYear;                    // year acquired
+  };
+  typedef vector<DOG> DOG_VECTOR;
+  // Read a DIR, keeping the dogs for the earliest cutoff ...
+  void ReadDogs (const string &sFileName, bool fNew, DOG_VECTOR &vecDogs) const;
+  // The one dog rules' results for all the stable dogs acquired in one year ...
+  struct BUCKET {
+    size_t    nErrors;                  // bad dog errors
+    size_t    nUpdates;                 // updates for Found.org
+    CDogs    *pUpdated;                 // copies of the dogs with updates
+  };
+  typedef map<uint32_t, BUCKET> BUCKET_MAP;
+  // Copy the dogs for one cutoff into a CDogs collection ...
+  static void SelectDogs (const DOG_VECTOR &vecDogs, uint32_t nCutoff, CDogs &Dogs);
+  // Find the dogs that can't be counted in a bucket ...
+  void FindUnstableDogs();
+  bool IsUnstable (const CDog *pDog) const;
+  // Copy just the unstable dogs from a collection ...
+  void SelectUnstable (const CDogs &Dogs, CDogs &Unstable) const;
+  // Run the one dog rules for every stable dog and fill in the buckets ...
+  void RunBuckets();
+  // Run the rest of the rules for one cutoff ...
+  RESULT RunOne (uint32_t nCutoff) const;
+  // Delete all the parsed dogs and the buckets ...
+  static void DeleteDogs (DOG_VECTOR &vecDogs);
+  void DeleteBuckets();
+
+  // Local CWhatIf members ...
+protected:
+  vector<uint32_t>  m_vecCutoffs;       // cutoff years, in ascending order
+  DOG_VECTOR        m_vecOld;           // all the dogs from the old DIR
+  DOG_VECTOR        m_vecNew;           //  "   "   "    "   "  new  "
+  size_t            m_nParseErrors;     // bad dogs found while parsing
+  unordered_set<uint64_t> m_setUnstable; // keys of the unstable dogs
+  BUCKET_MAP        m_mapBuckets;       // one dog results by year acquired
+  double            m_dSeconds;         // time to run the one dog rules
+  RESULT_VECTOR     m_vecResults;       // results for each cutoff
+};
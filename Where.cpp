@@ -0,0 +1,631 @@
+//++
+// Where.cpp - implementation of the CWhere class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CWhere class, which compiles and runs the
+// "--where" filter expressions.  See Where.hpp for the language.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+// 17-Oct-26  AGT   "number" is a dog ID, organization prefix and all.
+// 17-Oct-26  AGT   Parse dog ID fields in place.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string.h>             // strlen(), _stricmp() ...
+#include <ctype.h>              // isspace(), tolower() ...
+#include <assert.h>             // assert() (what else??)
+#include "CSVDialect.hpp"       // delimiter, quote and line ending conventions
+#include "CSVRow.hpp"           // one row of a spreadsheet
+#include "Dog.hpp"              // CDog::ParseDogID() ...
+#include "Where.hpp"            // declarations for this module
+
+//   The field names, and the zero based column for each one in a new format
+// DIR.  The old format is the same except that there's no county, so every
+// column after that is one less ...
+#define COUNTY_COLUMN  20
+static const struct {
+  const char   *pszName;        // field name used in expressions
+  uint32_t      nColumn;        // new format DIR column
+  CWhere::TYPE  nType;          // and how it's compared
+} g_aFields[] = {
+  {"name",              0,  CWhere::TYPE_STRING},
+  {"number",            1,  CWhere::TYPE_DOGID},
+  {"chip",              2,  CWhere::TYPE_STRING},
+  {"microchip",         2,  CWhere::TYPE_STRING},
+  {"age",               3,  CWhere::TYPE_STRING},
+  {"sex",               4,  CWhere::TYPE_STRING},
+  {"breed",             5,  CWhere::TYPE_STRING},
+  {"neuter",            6,  CWhere::TYPE_STRING},
+  {"status",            7,  CWhere::TYPE_STRING},
+  {"location",          8,  CWhere::TYPE_STRING},
+  {"how",               9,  CWhere::TYPE_STRING},
+  {"how_acquired",      9,  CWhere::TYPE_STRING},
+  {"acquired",          10, CWhere::TYPE_DATE},
+  {"date_acquired",     10, CWhere::TYPE_DATE},
+  {"contact_first",     11, CWhere::TYPE_STRING},
+  {"contact_last",      12, CWhere::TYPE_STRING},
+  {"surrender_first",   13, CWhere::TYPE_STRING},
+  {"surrender_last",    14, CWhere::TYPE_STRING},
+  {"surrender_address", 15, CWhere::TYPE_STRING},
+  {"surrender_city",    16, CWhere::TYPE_STRING},
+  {"surrender_state",   17, CWhere::TYPE_STRING},
+  {"surrender_zip",     18, CWhere::TYPE_STRING},
+  {"area",              19, CWhere::TYPE_STRING},
+  {"county",            COUNTY_COLUMN, CWhere::TYPE_STRING},
+  {"adopter_first",     21, CWhere::TYPE_STRING},
+  {"adopter_last",      22, CWhere::TYPE_STRING},
+  {"ac_first",          23, CWhere::TYPE_STRING},
+  {"ac_last",           24, CWhere::TYPE_STRING},
+  {"adoption_address",  25, CWhere::TYPE_STRING},
+  {"adoption_city",     26, CWhere::TYPE_STRING},
+  {"adoption_state",    27, CWhere::TYPE_STRING},
+  {"adoption_zip",      28, CWhere::TYPE_STRING},
+  {"adoption_area",     29, CWhere::TYPE_STRING},
+  {"email",             30, CWhere::TYPE_STRING},
+  {"home_phone",        31, CWhere::TYPE_STRING},
+  {"work_phone",        32, CWhere::TYPE_STRING},
+  {"cell_phone",        33, CWhere::TYPE_STRING},
+  {"adoption_status",   34, CWhere::TYPE_STRING},
+  {"disposition",       35, CWhere::TYPE_DATE},
+  {"disposition_date",  35, CWhere::TYPE_DATE},
+};
+#define FIELD_COUNT  (sizeof(g_aFields) / sizeof(g_aFields[0]))
+
+
+///////////////////////////////////////////////////////////////////////////////
+//////////////////////////   L E X I C A L   S T U F F   //////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+CWhere::TOKEN CWhere::Scan()
+{
+  //++
+  //   Scan the next token from the expression, leave it in m_nToken (and the
+  // text of a word or string in m_sToken) and return it.  A word is anything
+  // up to the next space, parenthesis, comma, quote or relation, so dates and
+  // things like "St.Louis" don't need quotes ...
+  //--
+  m_sToken.clear();
+  while ((m_nNext < m_sExpression.length()) && isspace((unsigned char) m_sExpression[m_nNext])) ++m_nNext;
+  if (m_nNext >= m_sExpression.length()) return m_nToken = TOK_END;
+  char ch = m_sExpression[m_nNext++];
+  char chNext = (m_nNext < m_sExpression.length()) ? m_sExpression[m_nNext] : '\0';
+  switch (ch) {
+    case '(':  return m_nToken = TOK_LPAREN;
+    case ')':  return m_nToken = TOK_RPAREN;
+    case ',':  return m_nToken = TOK_COMMA;
+    case '=':
+      if (chNext == '=') ++m_nNext;
+      return m_nToken = TOK_EQ;
+    case '!':
+      if (chNext != '=') return m_nToken = TOK_ERROR;
+      ++m_nNext;  return m_nToken = TOK_NE;
+    case '<':
+      if (chNext == '=') {++m_nNext;  return m_nToken = TOK_LE;}
+      if (chNext == '>') {++m_nNext;  return m_nToken = TOK_NE;}
+      return m_nToken = TOK_LT;
+    case '>':
+      if (chNext == '=') {++m_nNext;  return m_nToken = TOK_GE;}
+      return m_nToken = TOK_GT;
+    case '"':
+    case '\'':
+      //   A quoted string, and a doubled quote inside it is a quote just like
+      // it is in a CSV file ...
+      for (;;) {
+        if (m_nNext >= m_sExpression.length()) return m_nToken = TOK_ERROR;
+        char chText = m_sExpression[m_nNext++];
+        if (chText == ch) {
+          if ((m_nNext >= m_sExpression.length()) || (m_sExpression[m_nNext] != ch)) break;
+          ++m_nNext;
+        }
+        m_sToken.push_back(chText);
+      }
+      return m_nToken = TOK_STRING;
+    default:
+      m_sToken.push_back(ch);
+      while ((m_nNext < m_sExpression.length())
+          && !isspace((unsigned char) m_sExpression[m_nNext])
+          && (strchr("()=,!<>\"'", m_sExpression[m_nNext]) == NULL))
+        m_sToken.push_back(m_sExpression[m_nNext++]);
+      return m_nToken = TOK_WORD;
+  }
+}
+
+
+bool CWhere::IsKeyword (const char *pszKeyword) const
+{
+  //++
+  // Return true if the current token is this keyword (in any case) ...
+  //--
+  return (m_nToken == TOK_WORD) && (_stricmp(m_sToken.c_str(), pszKeyword) == 0);
+}
+
+
+bool CWhere::Error (const string &sError)
+{
+  //++
+  //   Remember why Compile() failed, and where, and return false (so a
+  // parse routine can just say "return Error(...)") ...
+  //--
+  if (m_sError.empty()) {
+    m_sError = (m_nToken == TOK_ERROR) ? string("syntax error") : sError;
+    if (m_nToken == TOK_END)
+      m_sError += " at end of expression";
+    else
+      m_sError += " near \"" + m_sExpression.substr(0, m_nNext) + "\"";
+  }
+  return false;
+}
+
+
+bool CWhere::Expect (TOKEN nToken, const char *pszWhat)
+{
+  //++
+  // Skip over the current token if it's the one we want, otherwise fail ...
+  //--
+  if (m_nToken != nToken) return Error(string(pszWhat) + " expected");
+  Scan();  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+////////////////////////////   P A R S E R   //////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+size_t CWhere::Emit (OPCODE nOpcode, uint32_t nColumn, uint32_t nTarget, uint8_t nRelation, uint8_t nType, uint64_t nLow, uint64_t nHigh)
+{
+  //++
+  // Add an instruction to the program and return its index ...
+  //--
+  INSTRUCTION ins;
+  ins.nOpcode = (uint8_t) nOpcode;  ins.nRelation = nRelation;  ins.nType = nType;
+  ins.nColumn = nColumn;  ins.nTarget = nTarget;  ins.nLow = nLow;  ins.nHigh = nHigh;
+  m_vecProgram.push_back(ins);
+  return m_vecProgram.size()-1;
+}
+
+
+bool CWhere::Compile (const string &sExpression, bool fNew)
+{
+  //++
+  //   Compile an expression.  The grammar is just what you'd expect -
+  //
+  //      or-expr   := and-expr  { "or" and-expr }
+  //      and-expr  := not-expr  { "and" not-expr }
+  //      not-expr  := "not" not-expr | "(" or-expr ")" | test
+  //      test      := field relation value
+  //                 | field ["not"] "in" "(" value { "," value } ")"
+  //                 | field ["not"] "between" value "and" value
+  //                 | field ["not"] "contains" value
+  //
+  // and the code is generated as we go.  If anything is wrong, the program
+  // is thrown away and we return false ...
+  //--
+  m_vecProgram.clear();  m_vecStrings.clear();  m_nColumns = 0;
+  m_sError.clear();  m_fNew = fNew;
+  m_sExpression = sExpression;  m_nNext = 0;  Scan();
+  bool fOK;
+  if (m_nToken == TOK_END)
+    fOK = Error("empty expression");
+  else
+    fOK = ParseOr() && ((m_nToken == TOK_END) || Error("\"and\" or \"or\" expected"));
+  if (!fOK) {m_vecProgram.clear();  m_vecStrings.clear();  m_nColumns = 0;}
+  return fOK;
+}
+
+
+bool CWhere::ParseOr()
+{
+  //++
+  //   Parse a list of and-exprs separated by "or".  As soon as any one of
+  // them is true we jump to the end, with the register still true ...
+  //--
+  vector<size_t> vecJumps;
+  if (!ParseAnd()) return false;
+  while (IsKeyword("or")) {
+    vecJumps.push_back(Emit(OP_JUMP_TRUE));
+    Scan();
+    if (!ParseAnd()) return false;
+  }
+  for (vector<size_t>::const_iterator it = vecJumps.begin();  it != vecJumps.end();  ++it) Patch(*it);
+  return true;
+}
+
+
+bool CWhere::ParseAnd()
+{
+  //++
+  //   Parse a list of not-exprs separated by "and".  This time the first one
+  // that's false jumps to the end ...
+  //--
+  vector<size_t> vecJumps;
+  if (!ParseNot()) return false;
+  while (IsKeyword("and")) {
+    vecJumps.push_back(Emit(OP_JUMP_FALSE));
+    Scan();
+    if (!ParseNot()) return false;
+  }
+  for (vector<size_t>::const_iterator it = vecJumps.begin();  it != vecJumps.end();  ++it) Patch(*it);
+  return true;
+}
+
+
+bool CWhere::ParseNot()
+{
+  //++
+  // Parse "not" something, a parenthesized expression, or a single test ...
+  //--
+  if (IsKeyword("not")) {
+    Scan();
+    if (!ParseNot()) return false;
+    Emit(OP_NOT);  return true;
+  } else if (m_nToken == TOK_LPAREN) {
+    Scan();
+    return ParseOr() && Expect(TOK_RPAREN, "\")\"");
+  } else
+    return ParseTest();
+}
+
+
+bool CWhere::ParseValue (string &sValue)
+{
+  //++
+  // Parse a value - either a quoted string or a single word ...
+  //--
+  if ((m_nToken != TOK_WORD) && (m_nToken != TOK_STRING)) return Error("value expected");
+  sValue = m_sToken;  Scan();  return true;
+}
+
+
+bool CWhere::ParseTest()
+{
+  //++
+  // Parse one test of a field ...
+  //--
+  if (m_nToken != TOK_WORD) return Error("field name expected");
+  size_t nField;
+  for (nField = 0;  nField < FIELD_COUNT;  ++nField)
+    if (_stricmp(m_sToken.c_str(), g_aFields[nField].pszName) == 0) break;
+  if (nField >= FIELD_COUNT) return Error("unknown field \"" + m_sToken + "\"");
+  uint32_t nColumn = g_aFields[nField].nColumn;  TYPE nType = g_aFields[nField].nType;
+  if (!m_fNew) {
+    if (nColumn == COUNTY_COLUMN) return Error("there's no county in the old DIR format");
+    if (nColumn > COUNTY_COLUMN) --nColumn;
+  }
+  if (nColumn+1 > m_nColumns) m_nColumns = nColumn+1;
+  Scan();
+
+  // First the simple relations ...
+  RELATION nRelation;  string sValue, sHigh;
+  switch (m_nToken) {
+    case TOK_EQ:  nRelation = REL_EQ;  break;
+    case TOK_NE:  nRelation = REL_NE;  break;
+    case TOK_LT:  nRelation = REL_LT;  break;
+    case TOK_LE:  nRelation = REL_LE;  break;
+    case TOK_GT:  nRelation = REL_GT;  break;
+    case TOK_GE:  nRelation = REL_GE;  break;
+    default:      nRelation = REL_CONTAINS;  break;
+  }
+  if (nRelation != REL_CONTAINS) {
+    Scan();
+    return ParseValue(sValue) && CompileRelation(nColumn, nType, nRelation, sValue);
+  }
+
+  // And then the keyword ones, any of which can have a "not" in front ...
+  bool fNot = IsKeyword("not");
+  if (fNot) Scan();
+  if (IsKeyword("in")) {
+    //   "in" is just a list of "="s joined by "or", so the first one that
+    // matches jumps to the end ...
+    Scan();
+    if (!Expect(TOK_LPAREN, "\"(\"")) return false;
+    vector<size_t> vecJumps;
+    for (;;) {
+      if (!ParseValue(sValue) || !CompileRelation(nColumn, nType, REL_EQ, sValue)) return false;
+      if (m_nToken != TOK_COMMA) break;
+      vecJumps.push_back(Emit(OP_JUMP_TRUE));  Scan();
+    }
+    if (!Expect(TOK_RPAREN, "\")\"")) return false;
+    for (vector<size_t>::const_iterator it = vecJumps.begin();  it != vecJumps.end();  ++it) Patch(*it);
+  } else if (IsKeyword("between")) {
+    Scan();
+    if (!ParseValue(sValue)) return false;
+    if (!IsKeyword("and")) return Error("\"and\" expected");
+    Scan();
+    if (!ParseValue(sHigh) || !CompileRange(nColumn, nType, sValue, sHigh)) return false;
+  } else if (IsKeyword("contains")) {
+    Scan();
+    if (!ParseValue(sValue) || !CompileRelation(nColumn, TYPE_STRING, REL_CONTAINS, sValue)) return false;
+  } else
+    return Error("relation expected");
+  if (fNot) Emit(OP_NOT);
+  return true;
+}
+
+
+/*static*/ bool CWhere::ParseLiteral (const string &sValue, TYPE nType, uint64_t &nFirst, uint64_t &nLast)
+{
+  //++
+  //   Convert a value for a dog ID or date field into the range of field
+  // values that it stands for.  For a dog ID or a complete date that's just
+  // the one value, but a year alone is every day in that year.  Returns false
+  // if the value isn't a dog ID (or a date) at all ...
+  //--
+  if (nType == TYPE_DOGID) {
+    if (!ParseDogID(sValue.c_str(), sValue.length(), nFirst)) return false;
+    nLast = nFirst;  return true;
+  } else if (nType == TYPE_DATE) {
+    uint32_t nDate, nYear;
+    if (ParseDate(sValue.c_str(), sValue.length(), nDate)) {nFirst = nLast = nDate;  return true;}
+    if ((sValue.length() != 4) || !ParseNumber(sValue.c_str(), 4, nYear)) return false;
+    if ((nYear < 1990) || (nYear > 2099)) return false;
+    nFirst = nYear*10000 + 101;  nLast = nYear*10000 + 1231;  return true;
+  }
+  return false;
+}
+
+
+bool CWhere::CompileRelation (uint32_t nColumn, TYPE nType, RELATION nRelation, const string &sValue)
+{
+  //++
+  //   Generate the code for one relation.  For a dog ID or date field every
+  // relation turns into an OP_RANGE (and "!=" is an OP_RANGE followed by an
+  // OP_NOT).  A dog ID range never leaves the organization of the value - the
+  // top half of the key.  Anything else is a string comparison ...
+  //--
+  uint64_t nFirst, nLast;
+  if ((nType != TYPE_STRING) && (nRelation != REL_CONTAINS) && ParseLiteral(sValue, nType, nFirst, nLast)) {
+    uint64_t nMin = (nType == TYPE_DOGID) ? (nFirst & ~(uint64_t) UINT32_MAX) : 0;
+    uint64_t nMax = nMin | UINT32_MAX;
+    uint64_t nLow = nMin, nHigh = nMax;
+    switch (nRelation) {
+      case REL_EQ:
+      case REL_NE:  nLow = nFirst;  nHigh = nLast;  break;
+      case REL_LT:  if (nFirst == nMin) {nLow = 1;  nHigh = 0;} else nHigh = nFirst-1;  break;
+      case REL_LE:  nHigh = nLast;  break;
+      case REL_GT:  if (nLast == nMax) {nLow = 1;  nHigh = 0;} else nLow = nLast+1;  break;
+      case REL_GE:  nLow = nFirst;  break;
+      default:      assert(false);
+    }
+    Emit(OP_RANGE, nColumn, 0, 0, (uint8_t) nType, nLow, nHigh);
+    if (nRelation == REL_NE) Emit(OP_NOT);
+  } else {
+    string sLower(sValue);
+    for (string::iterator it = sLower.begin();  it != sLower.end();  ++it) *it = (char) tolower((unsigned char) *it);
+    m_vecStrings.push_back(sLower);
+    Emit(OP_STRING, nColumn, (uint32_t) (m_vecStrings.size()-1), (uint8_t) nRelation);
+  }
+  return true;
+}
+
+
+bool CWhere::CompileRange (uint32_t nColumn, TYPE nType, const string &sLow, const string &sHigh)
+{
+  //++
+  //   Generate the code for "between".  For a dog ID or date that's a single
+  // OP_RANGE, and for a string it's ">= low and <= high".  Dog IDs from two
+  // different organizations don't have anything between them ...
+  //--
+  uint64_t nFirst, nLast, nFirst2, nLast2;
+  if ((nType != TYPE_STRING) && ParseLiteral(sLow, nType, nFirst, nLast) && ParseLiteral(sHigh, nType, nFirst2, nLast2)) {
+    if ((nType == TYPE_DOGID) && ((nFirst >> 32) != (nLast2 >> 32)))
+      Emit(OP_RANGE, nColumn, 0, 0, (uint8_t) nType, 1, 0);
+    else
+      Emit(OP_RANGE, nColumn, 0, 0, (uint8_t) nType, nFirst, nLast2);
+  } else {
+    CompileRelation(nColumn, TYPE_STRING, REL_GE, sLow);
+    size_t nJump = Emit(OP_JUMP_FALSE);
+    CompileRelation(nColumn, TYPE_STRING, REL_LE, sHigh);
+    Patch(nJump);
+  }
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+/////////////////////////   R U N   T I M E   S T U F F   /////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+/*static*/ bool CWhere::ParseNumber (const char *pszText, size_t nLength, uint32_t &nValue)
+{
+  //++
+  //   Convert a field to a number.  It has to be all digits, and no more than
+  // nine of them so that we don't have to worry about overflow ...
+  //--
+  if ((nLength == 0) || (nLength > 9)) return false;
+  nValue = 0;
+  for (size_t i = 0;  i < nLength;  ++i) {
+    if ((pszText[i] < '0') || (pszText[i] > '9')) return false;
+    nValue = nValue*10 + (pszText[i] - '0');
+  }
+  return true;
+}
+
+
+/*static*/ bool CWhere::ParseDogID (const char *pszText, size_t nLength, uint64_t &nKey)
+{
+  //++
+  //   Convert a dog ID (e.g. "12345" or "ABC-123") to its 64 bit key.  This
+  // is CDog::ParseDogID(), so it accepts exactly what the DIR reader does,
+  // and it works on the field in place - nothing is copied ...
+  //--
+  uint32_t nOrg, nNumber;
+  if (!CDog::ParseDogID(pszText, nLength, nOrg, nNumber)) return false;
+  nKey = CDog::MakeKey(nOrg, nNumber);
+  return true;
+}
+
+
+/*static*/ bool CWhere::ParseDate (const char *pszText, size_t nLength, uint32_t &nDate)
+{
+  //++
+  //   Convert a YYYY-MM-DD date to YYYYMMDD.  This accepts exactly the same
+  // dates as CDog::ParseDate(), but it doesn't need a string or a regex ...
+  //--
+  uint32_t nYear, nMonth, nDay;
+  if ((nLength != 10) || (pszText[4] != '-') || (pszText[7] != '-')) return false;
+  if (!ParseNumber(pszText, 4, nYear) || !ParseNumber(pszText+5, 2, nMonth) || !ParseNumber(pszText+8, 2, nDay)) return false;
+  if ((nMonth == 0) || (nMonth > 12)) return false;
+  if ((nDay == 0) || (nDay > 31)) return false;
+  if ((nYear < 1990) || (nYear > 2099)) return false;
+  nDate = nYear*10000 + nMonth*100 + nDay;
+  return true;
+}
+
+
+/*static*/ int CWhere::CompareNoCase (const FIELD &field, const string &sValue)
+{
+  //++
+  // Compare a field with a lower case string, ignoring the field's case ...
+  //--
+  size_t nLength = (field.nLength < sValue.length()) ? field.nLength : sValue.length();
+  for (size_t i = 0;  i < nLength;  ++i) {
+    int nDiff = tolower((unsigned char) field.pszText[i]) - (unsigned char) sValue[i];
+    if (nDiff != 0) return nDiff;
+  }
+  return (field.nLength < sValue.length()) ? -1 : (field.nLength > sValue.length()) ? 1 : 0;
+}
+
+
+/*static*/ bool CWhere::ContainsNoCase (const FIELD &field, const string &sValue)
+{
+  //++
+  // Return true if the field contains this lower case string anywhere ...
+  //--
+  if (sValue.length() > field.nLength) return false;
+  for (size_t nStart = 0;  nStart+sValue.length() <= field.nLength;  ++nStart) {
+    size_t i;
+    for (i = 0;  i < sValue.length();  ++i)
+      if (tolower((unsigned char) field.pszText[nStart+i]) != (unsigned char) sValue[i]) break;
+    if (i == sValue.length()) return true;
+  }
+  return false;
+}
+
+
+/*static*/ size_t CWhere::Split (const string &sRecord, char chDelimiter, FIELD *pFields, size_t nMaxFields)
+{
+  //++
+  //   Find the first nMaxFields fields of a record that has no quotes in it.
+  // Each field is trimmed and any "=" in front of it is skipped, which gives
+  // exactly what CCSVRow::Parse() would have, but without copying anything.
+  // Returns the number of fields found ...
+  //--
+  size_t nFields = 0, nStart = 0, nLength = sRecord.length();
+  const char *pszRecord = sRecord.data();
+  if (nLength == 0) return 0;
+  while (nFields < nMaxFields) {
+    size_t nEnd = nStart;
+    while ((nEnd < nLength) && (pszRecord[nEnd] != chDelimiter)) ++nEnd;
+    size_t nFirst = nStart, nLast = nEnd;
+    while ((nFirst < nLast) && ((pszRecord[nFirst] == ' ') || (pszRecord[nFirst] == '\t'))) ++nFirst;
+    if ((nFirst < nLast) && (pszRecord[nFirst] == '=')) ++nFirst;
+    while ((nFirst < nLast) && ((pszRecord[nFirst] == ' ') || (pszRecord[nFirst] == '\t'))) ++nFirst;
+    while ((nLast > nFirst) && ((pszRecord[nLast-1] == ' ') || (pszRecord[nLast-1] == '\t'))) --nLast;
+    pFields[nFields].pszText = pszRecord+nFirst;  pFields[nFields].nLength = nLast-nFirst;
+    ++nFields;
+    if (nEnd >= nLength) break;
+    nStart = nEnd+1;
+  }
+  return nFields;
+}
+
+
+bool CWhere::Execute (const FIELD *pFields, size_t nFields) const
+{
+  //++
+  //   Run the program against one record and return the final value of the
+  // register.  A column past the end of a short record is just empty ...
+  //--
+  static const FIELD EMPTY = {"", 0};
+  bool fResult = true;
+  for (size_t nPC = 0;  nPC < m_vecProgram.size();  ) {
+    const INSTRUCTION &ins = m_vecProgram[nPC++];
+    switch (ins.nOpcode) {
+      case OP_STRING: {
+        const FIELD &field = (ins.nColumn < nFields) ? pFields[ins.nColumn] : EMPTY;
+        const string &sValue = m_vecStrings[ins.nTarget];
+        if (ins.nRelation == REL_CONTAINS) {
+          fResult = ContainsNoCase(field, sValue);  break;
+        }
+        int nCompare = CompareNoCase(field, sValue);
+        switch (ins.nRelation) {
+          case REL_EQ:  fResult = (nCompare == 0);  break;
+          case REL_NE:  fResult = (nCompare != 0);  break;
+          case REL_LT:  fResult = (nCompare <  0);  break;
+          case REL_LE:  fResult = (nCompare <= 0);  break;
+          case REL_GT:  fResult = (nCompare >  0);  break;
+          case REL_GE:  fResult = (nCompare >= 0);  break;
+        }
+        break;
+      }
+      case OP_RANGE: {
+        const FIELD &field = (ins.nColumn < nFields) ? pFields[ins.nColumn] : EMPTY;
+        uint64_t nValue;  uint32_t nDate;  bool fValid;
+        if (ins.nType == TYPE_DOGID)
+          fValid = ParseDogID(field.pszText, field.nLength, nValue);
+        else
+          {fValid = ParseDate(field.pszText, field.nLength, nDate);  nValue = nDate;}
+        fResult = fValid && (nValue >= ins.nLow) && (nValue <= ins.nHigh);
+        break;
+      }
+      case OP_NOT:        fResult = !fResult;  break;
+      case OP_JUMP_FALSE: if (!fResult) nPC = ins.nTarget;  break;
+      case OP_JUMP_TRUE:  if (fResult) nPC = ins.nTarget;  break;
+    }
+  }
+  return fResult;
+}
+
+
+bool CWhere::Match (const CCSVRow &row) const
+{
+  //++
+  // Test a record that's already been parsed into a CCSVRow ...
+  //--
+  FIELD aFields[MAXFIELDS];
+  size_t nFields = (row.size() < m_nColumns) ? row.size() : m_nColumns;
+  for (size_t i = 0;  i < nFields;  ++i) {
+    aFields[i].pszText = row[i].data();  aFields[i].nLength = row[i].length();
+  }
+  return Execute(aFields, nFields);
+}
+
+
+bool CWhere::Match (const string &sRecord, const CCSVDialect &dialect) const
+{
+  //++
+  //   Test the raw text of a record, as read by CCSVRow::ReadRecord().  If it
+  // has no quotes then it's just split at the delimiters in place, and only
+  // as far as the last column that the program uses.  Otherwise it's parsed
+  // the usual way - quotes are rare enough that it's not worth doing anything
+  // clever about them ...
+  //--
+  if (m_vecProgram.empty()) return true;
+  if (sRecord.find(dialect.GetQuote()) == string::npos) {
+    FIELD aFields[MAXFIELDS];
+    size_t nFields = Split(sRecord, dialect.GetDelimiter(), aFields, m_nColumns);
+    return Execute(aFields, nFields);
+  } else {
+    CCSVRow row;  row.Parse(sRecord, dialect);
+    return Match(row);
+  }
+}
@@ -0,0 +1,194 @@
+//++
+// Where.hpp -> "--where" expressions for filtering DIR records
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   A CWhere is a little filter language for pulling dogs out of a DIR, so
+// that "all the dogs in the Bay Area acquired last year that are still
+// available" doesn't need yet another loop in MicrochipUpdate.cpp.  It looks
+// like this -
+//
+//      status = Available and area in ("Bay Area", Sacramento)
+//      acquired between 2022-01-01 and 2022-06-30 and not chip = ""
+//      (number >= 20000 or acquired >= 2023) and email contains gmail
+//
+// The relations are =, !=, <, <=, >, >=, contains, in (...) and between ...
+// and ..., and they can be combined with and, or, not and parentheses (and
+// binds tighter than or, as usual).  Field names, keywords and string
+// comparisons are all case insensitive.  A value is either quoted (with
+// "..." or '...') or a single word.  The field names are listed in the
+// g_aFields table in Where.cpp, and they're mostly the DIR column names.
+//
+//   "number" is compared as a dog ID, the same way CDog::ParseDogID() reads
+// them, and "acquired" and "disposition" are compared as dates (YYYY-MM-DD,
+// same as the DIR).  A dog ID comparison only ever matches dogs from the same
+// organization as the value, so "number >= 20000" is NGRR's own dogs from
+// #20000 up and "number < ABC-500" is ABC's dogs below 500.  A year alone
+// means the whole year, so "acquired = 2022" is every dog acquired in 2022
+// and "acquired > 2022" means 2023 or later.  A dog with no valid date (or
+// dog ID) never satisfies a date (or dog ID) comparison, although "!=" is
+// always exactly "not =".  If the value for one of these fields isn't a dog
+// ID or a date then it's compared as a string instead, so "acquired = ''"
+// finds the dogs with no acquisition date at all.
+//
+//   Compile() turns the expression into a short program for a one register
+// machine.  Every comparison sets the register, "and" and "or" compile into
+// conditional jumps (so they short circuit) and "not" flips it.  "in" is
+// just a string of "or"s.  Match() runs the program against the raw text of
+// a record before it's turned into a CCSVRow - if the record has no quotes,
+// which is nearly always, the fields are never copied anywhere, and a record
+// that doesn't match is never parsed at all.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+// 17-OCT-26  AGT   "number" is a dog ID, organization prefix and all.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+#include <vector>               // C++ vector collection ...
+using std::size_t;              // ...
+using std::string;              // ...
+using std::vector;              // ...
+class CCSVRow;                  // ...
+class CCSVDialect;              // ...
+
+
+class CWhere {
+  //++
+  // Compiled "--where" expression ...
+  //--
+
+public:
+  enum {
+    MAXFIELDS   = 64,           // most fields in a record we can filter
+  };
+  // Field types ...
+  enum TYPE {
+    TYPE_STRING,                // compared as a case insensitive string
+    TYPE_DOGID,                 // compared as a dog ID (see CDog::MakeKey())
+    TYPE_DATE,                  // compared as a YYYY-MM-DD date
+  };
+  // Instructions ...
+  enum OPCODE {
+    OP_STRING,                  // compare a field with a string
+    OP_RANGE,                   // check a number or date field for nLow..nHigh
+    OP_NOT,                     // invert the register
+    OP_JUMP_FALSE,              // jump to nTarget if the register is false
+    OP_JUMP_TRUE,               //   "   "     "     "  "     "     "  true
+  };
+  // String relations for OP_STRING ...
+  enum RELATION {
+    REL_EQ, REL_NE, REL_LT, REL_LE, REL_GT, REL_GE, REL_CONTAINS
+  };
+
+  // One instruction in the program ...
+  struct INSTRUCTION {
+    uint8_t   nOpcode;          // OP_xyz
+    uint8_t   nRelation;        // REL_xyz (OP_STRING only)
+    uint8_t   nType;            // TYPE_xyz of the field (OP_RANGE only)
+    uint32_t  nColumn;          // zero based column number
+    uint32_t  nTarget;          // string index (OP_STRING) or jump target
+    uint64_t  nLow, nHigh;      // range for OP_RANGE (inclusive)
+  };
+  typedef vector<INSTRUCTION> PROGRAM;
+
+  // The text of one field in a record (no trailing null!) ...
+  struct FIELD {
+    const char *pszText;        // first character
+    size_t      nLength;        // and the length
+  };
+
+public:
+  // Constructor and destructor ...
+  CWhere() {m_nColumns = 0;  m_fNew = true;}
+  virtual ~CWhere() {};
+  // Copy and assignment constructors ...
+  CWhere (const CWhere &w) = delete;
+  CWhere& operator= (const CWhere &w) = delete;
+
+  // CWhere properties ...
+public:
+  // Return true if there's an expression ...
+  bool IsEmpty() const {return m_vecProgram.empty();}
+  // Return the reason that Compile() failed ...
+  string GetError() const {return m_sError;}
+  // Return the compiled program ...
+  const PROGRAM &GetProgram() const {return m_vecProgram;}
+
+  // CWhere public methods ...
+public:
+  //   Compile an expression for a DIR in the new (or old) format.  Returns
+  // false and sets the error text if it's bogus ...
+  bool Compile (const string &sExpression, bool fNew=true);
+  // Test the raw text of one record ...
+  bool Match (const string &sRecord, const CCSVDialect &dialect) const;
+  // Test a record that's already been parsed ...
+  bool Match (const CCSVRow &row) const;
+
+  // Private internal CWhere methods ...
+protected:
+  // The lexical analyzer ...
+  enum TOKEN {
+    TOK_END, TOK_WORD, TOK_STRING, TOK_LPAREN, TOK_RPAREN, TOK_COMMA,
+    TOK_EQ, TOK_NE, TOK_LT, TOK_LE, TOK_GT, TOK_GE, TOK_ERROR
+  };
+  TOKEN Scan();
+  bool IsKeyword (const char *pszKeyword) const;
+  bool Expect (TOKEN nToken, const char *pszWhat);
+  bool Error (const string &sError);
+  // The parser (it generates code as it goes) ...
+  bool ParseOr();
+  bool ParseAnd();
+  bool ParseNot();
+  bool ParseTest();
+  bool ParseValue (string &sValue);
+  bool CompileRelation (uint32_t nColumn, TYPE nType, RELATION nRelation, const string &sValue);
+  bool CompileRange (uint32_t nColumn, TYPE nType, const string &sLow, const string &sHigh);
+  // Code generation ...
+  size_t Emit (OPCODE nOpcode, uint32_t nColumn=0, uint32_t nTarget=0, uint8_t nRelation=0, uint8_t nType=0, uint64_t nLow=0, uint64_t nHigh=0);
+  void Patch (size_t nInstruction) {m_vecProgram[nInstruction].nTarget = (uint32_t) m_vecProgram.size();}
+  // Convert a literal to a dog ID key or to a first..last date range ...
+  static bool ParseLiteral (const string &sValue, TYPE nType, uint64_t &nFirst, uint64_t &nLast);
+  // Convert a field to a number, a dog ID key or a YYYYMMDD date ...
+  static bool ParseNumber (const char *pszText, size_t nLength, uint32_t &nValue);
+  static bool ParseDogID (const char *pszText, size_t nLength, uint64_t &nKey);
+  static bool ParseDate (const char *pszText, size_t nLength, uint32_t &nDate);
+  // Compare a field with a (lower case) string ...
+  static int CompareNoCase (const FIELD &field, const string &sValue);
+  static bool ContainsNoCase (const FIELD &field, const string &sValue);
+  // Split a record with no quotes into fields ...
+  static size_t Split (const string &sRecord, char chDelimiter, FIELD *pFields, size_t nMaxFields);
+  // Run the program ...
+  bool Execute (const FIELD *pFields, size_t nFields) const;
+
+  // Local CWhere members ...
+protected:
+  PROGRAM         m_vecProgram;   // the compiled expression
+  vector<string>  m_vecStrings;   // string literals (lower case)
+  uint32_t        m_nColumns;     // highest column used, plus one
+  bool            m_fNew;         // true for the new DIR format
+  string          m_sError;       // why Compile() failed
+  // The lexical analyzer state (only used by Compile()) ...
+  string          m_sExpression;  // the expression being compiled
+  size_t          m_nNext;        // index of the next character
+  TOKEN           m_nToken;       // the current token
+  string          m_sToken;       // and its text
+};
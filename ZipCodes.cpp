@@ -0,0 +1,211 @@
+//++
+// ZipCodes.cpp - implementation of the CZipCodes class
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   This file implements the CZipCodes class, which knows what state (and,
+// for a few places, what city) goes with a zip code.  See ZipCodes.hpp for
+// the details.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-Oct-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#include <stdlib.h>             // exit(), system(), etc ...
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string.h>             // strlen(), strncmp() ...
+#include <assert.h>             // assert() (what else??)
+#include <ctype.h>              // isdigit(), toupper() ...
+#include "ZipCodes.hpp"         // declarations for this module
+
+//   USPS three digit zip prefixes and the states they belong to.  Prefixes
+// that aren't listed are either unassigned or military (APO/FPO) and we
+// don't know (or care) about those ...
+static const struct {
+  uint16_t    nFirst, nLast;    // range of three digit prefixes
+  const char *pszState;         // and the state they're in
+} g_aPrefixRanges[] = {
+  {  5,   5, "NY"}, {  6,   7, "PR"}, {  8,   8, "VI"}, {  9,   9, "PR"},
+  { 10,  27, "MA"}, { 28,  29, "RI"}, { 30,  38, "NH"}, { 39,  49, "ME"},
+  { 50,  59, "VT"}, { 60,  69, "CT"}, { 70,  89, "NJ"}, {100, 149, "NY"},
+  {150, 196, "PA"}, {197, 199, "DE"}, {200, 205, "DC"}, {201, 201, "VA"},
+  {206, 219, "MD"}, {220, 246, "VA"}, {247, 268, "WV"}, {270, 289, "NC"},
+  {290, 299, "SC"}, {300, 319, "GA"}, {320, 349, "FL"}, {350, 369, "AL"},
+  {370, 385, "TN"}, {386, 397, "MS"}, {398, 399, "GA"}, {400, 427, "KY"},
+  {430, 459, "OH"}, {460, 479, "IN"}, {480, 499, "MI"}, {500, 528, "IA"},
+  {530, 549, "WI"}, {550, 567, "MN"}, {569, 569, "DC"}, {570, 577, "SD"},
+  {580, 588, "ND"}, {590, 599, "MT"}, {600, 629, "IL"}, {630, 658, "MO"},
+  {660, 679, "KS"}, {680, 693, "NE"}, {700, 714, "LA"}, {716, 729, "AR"},
+  {730, 749, "OK"}, {733, 733, "TX"}, {750, 799, "TX"}, {800, 816, "CO"},
+  {820, 831, "WY"}, {832, 838, "ID"}, {840, 847, "UT"}, {850, 865, "AZ"},
+  {870, 884, "NM"}, {885, 885, "TX"}, {889, 898, "NV"}, {900, 961, "CA"},
+  {967, 968, "HI"}, {969, 969, "GU"}, {970, 979, "OR"}, {980, 994, "WA"},
+  {995, 999, "AK"},
+  //   Note that the ranges are applied in order, so the odd ones (e.g. 201
+  // is Virginia even though it's in the middle of DC) must come later!
+  {0, 0, NULL}
+};
+
+//   Cities where our adopters usually live, and the zip prefixes that serve
+// each one.  This list MUST be in alphabetical order (ignoring case) because
+// CheckCity() does a binary search on it!
+static const struct {
+  const char *pszCity;          // city name
+  const char *pszPrefixes;      // zip prefixes, separated by spaces
+} g_aCities[] = {
+  {"Alameda", "945"},           {"Antioch", "945"},           {"Aptos", "950"},
+  {"Auburn", "956"},            {"Belmont", "940"},           {"Benicia", "945"},
+  {"Berkeley", "947"},          {"Burlingame", "940"},        {"Campbell", "950"},
+  {"Carmel", "939"},            {"Carson City", "897"},       {"Chico", "959"},
+  {"Clovis", "936"},            {"Concord", "945"},           {"Cupertino", "950"},
+  {"Daly City", "940"},         {"Danville", "945"},          {"Davis", "956"},
+  {"Dublin", "945"},            {"El Dorado Hills", "957"},   {"Elk Grove", "956 957"},
+  {"Eureka", "955"},            {"Fairfield", "945"},         {"Folsom", "956"},
+  {"Fremont", "945"},           {"Fresno", "936 937"},        {"Gilroy", "950"},
+  {"Grass Valley", "959"},      {"Half Moon Bay", "940"},     {"Hayward", "945"},
+  {"Healdsburg", "954"},        {"Hollister", "950"},         {"Livermore", "945"},
+  {"Lodi", "952"},              {"Los Altos", "940"},         {"Los Gatos", "950"},
+  {"Manteca", "953"},           {"Martinez", "945"},          {"Menlo Park", "940"},
+  {"Merced", "953"},            {"Mill Valley", "949"},       {"Milpitas", "950"},
+  {"Modesto", "953"},           {"Monterey", "939"},          {"Morgan Hill", "950"},
+  {"Mountain View", "940"},     {"Napa", "945"},              {"Newark", "945"},
+  {"Novato", "949"},            {"Oakland", "946"},           {"Palo Alto", "943"},
+  {"Petaluma", "949"},          {"Pleasanton", "945"},        {"Redding", "960"},
+  {"Redwood City", "940"},      {"Reno", "895"},              {"Richmond", "948"},
+  {"Rocklin", "956 957"},       {"Roseville", "956 957"},     {"Sacramento", "942 956 957 958"},
+  {"Salinas", "939"},           {"San Carlos", "940"},        {"San Francisco", "941"},
+  {"San Jose", "950 951"},      {"San Leandro", "945"},       {"San Mateo", "944"},
+  {"San Rafael", "949"},        {"San Ramon", "945"},         {"Santa Clara", "950"},
+  {"Santa Cruz", "950"},        {"Santa Rosa", "954"},        {"Sparks", "894"},
+  {"Stockton", "952"},          {"Sunnyvale", "940"},         {"Tracy", "953"},
+  {"Truckee", "961"},           {"Turlock", "953"},           {"Ukiah", "954"},
+  {"Vacaville", "956"},         {"Vallejo", "945"},           {"Walnut Creek", "945"},
+  {"Watsonville", "950"},       {"Yuba City", "959"}
+};
+#define CITY_COUNT  (sizeof(g_aCities) / sizeof(g_aCities[0]))
+
+
+/*static*/ bool CZipCodes::BuildStates (const char *apszStates[])
+{
+  //++
+  //   Fill in the prefix to state table from the list of ranges.  This is
+  // called exactly once, the first time GetState() is used ...
+  //--
+  for (uint32_t i = 0;  i < PREFIXES;  ++i) apszStates[i] = NULL;
+  for (uint32_t i = 0;  g_aPrefixRanges[i].pszState != NULL;  ++i) {
+    assert(g_aPrefixRanges[i].nLast < PREFIXES);
+    for (uint32_t j = g_aPrefixRanges[i].nFirst;  j <= g_aPrefixRanges[i].nLast;  ++j)
+      apszStates[j] = g_aPrefixRanges[i].pszState;
+  }
+  return true;
+}
+
+
+/*static*/ uint32_t CZipCodes::GetPrefix (const string &sZip)
+{
+  //++
+  //   Return the first three digits of a zip code as a number, or NOPREFIX
+  // if the zip code doesn't start with at least five digits ...
+  //--
+  if (sZip.length() < 5) return NOPREFIX;
+  for (uint32_t i = 0;  i < 5;  ++i)
+    if (!isdigit((unsigned char) sZip[i])) return NOPREFIX;
+  return (sZip[0]-'0')*100 + (sZip[1]-'0')*10 + (sZip[2]-'0');
+}
+
+
+/*static*/ const char *CZipCodes::GetState (const string &sZip)
+{
+  //++
+  //   Return the two letter state abbreviation for this zip code, or NULL
+  // if the zip is invalid or we just don't know.  The table is a function
+  // static so that it's built, thread safely, the first time we need it ...
+  //--
+  static const char *s_apszStates[PREFIXES];
+  static bool s_fBuilt = BuildStates(s_apszStates);
+  assert(s_fBuilt);
+  uint32_t nPrefix = GetPrefix(sZip);
+  return (nPrefix == NOPREFIX) ? NULL : s_apszStates[nPrefix];
+}
+
+
+/*static*/ bool CZipCodes::IsInState (const string &sZip, const string &sState)
+{
+  //++
+  //   Return true if this zip code belongs to this state.  If we don't know
+  // what state the zip belongs to, then give it the benefit of the doubt ...
+  //--
+  const char *pszState = GetState(sZip);
+  if (pszState == NULL) return true;
+  return strcmp(pszState, sState.c_str()) == 0;
+}
+
+
+/*static*/ int CZipCodes::CompareCity (const string &sCity, const char *pszCity)
+{
+  //++
+  //   Compare a city name, as the adopter typed it, with one from our table.
+  // Case doesn't matter, leading and trailing spaces are ignored, and any run
+  // of spaces counts as one.  The result is <0, 0 or >0, just like strcmp()
+  // and nothing gets allocated ...
+  //--
+  size_t i = 0, nLength = sCity.length();
+  while ((i < nLength) && isspace((unsigned char) sCity[i])) ++i;
+  while ((nLength > i) && isspace((unsigned char) sCity[nLength-1])) --nLength;
+  for (;;) {
+    int ch1 = (i < nLength) ? toupper((unsigned char) sCity[i]) : 0;
+    int ch2 = toupper((unsigned char) *pszCity);
+    if (ch1 != ch2) return ch1 - ch2;
+    if (ch1 == 0) return 0;
+    if (isspace(ch1)) {
+      while ((i < nLength) && isspace((unsigned char) sCity[i])) ++i;
+    } else
+      ++i;
+    ++pszCity;
+  }
+}
+
+
+/*static*/ CZipCodes::CITY_CHECK CZipCodes::CheckCity (const string &sCity, const string &sZip)
+{
+  //++
+  //   Check a city name against a zip code.  If we don't know the city (or
+  // the zip code is invalid) then the answer is CITY_UNKNOWN.  Otherwise it's
+  // CITY_MATCH if the zip prefix is one of the ones that serves the city, and
+  // CITY_MISMATCH if it isn't ...
+  //--
+  uint32_t nPrefix = GetPrefix(sZip);
+  if (nPrefix == NOPREFIX) return CITY_UNKNOWN;
+  size_t nLow = 0, nHigh = CITY_COUNT;
+  while (nLow < nHigh) {
+    size_t nMiddle = (nLow + nHigh) / 2;
+    int nCompare = CompareCity(sCity, g_aCities[nMiddle].pszCity);
+    if (nCompare < 0) {
+      nHigh = nMiddle;
+    } else if (nCompare > 0) {
+      nLow = nMiddle + 1;
+    } else {
+      const char *psz = g_aCities[nMiddle].pszPrefixes;
+      for (;  strlen(psz) >= 3;  psz += (psz[3] == ' ') ? 4 : 3)
+        if (strncmp(psz, sZip.c_str(), 3) == 0) return CITY_MATCH;
+      return CITY_MISMATCH;
+    }
+  }
+  return CITY_UNKNOWN;
+}
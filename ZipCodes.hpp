@@ -0,0 +1,86 @@
+//++
+// ZipCodes.hpp -> USPS zip code prefix to state and city tables
+//
+//   COPYRIGHT (C) 2015-2022 BY SPARE TIME GIZMOS.  ALL RIGHTS RESERVED.
+//
+// LICENSE:
+//    This file is part of the NGRR Microchip Data project.  This program is
+// free software; you may redistribute it and/or modify it under the terms of
+// the GNU General Public License as published by the Free Software Foundation,
+// either version 3 of the License, or (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE.See the GNU General Public License for
+// more details.  You should have received a copy of the GNU General Public
+// License along with this program. If not, see https://www.gnu.org/licenses/.
+//
+// DESCRIPTION:
+//   The first three digits of a zip code identify the USPS sectional center
+// facility, and every one of those lies in exactly one state.  The CZipCodes
+// class has a table, indexed directly by that three digit prefix, that gives
+// the state.  It's built from a short list of prefix ranges the first time
+// it's needed, and after that a lookup is just an array index - no hashing
+// and no memory allocation.
+//
+//   There's also a list of the cities that our adopters usually live in and
+// the zip prefixes that serve them.  That list is far from complete, so a
+// city that isn't on it is never an error - we only complain when a city we
+// DO know about has a zip code that can't possibly be right.
+//
+//                                                      agent [17-Oct-2026]
+//
+// REVISION HISTORY:
+// 17-OCT-26  AGT   New file.
+//--
+//000000001111111111222222222233333333334444444444555555555566666666667777777777
+//234567890123456789012345678901234567890123456789012345678901234567890123456789
+#pragma once
+#include <stdint.h>	        // uint8_t, uint32_t, etc ...
+#include <string>               // C++ std::string class, et al ...
+using std::string;              // ...
+
+
+class CZipCodes {
+  //++
+  // USPS zip code prefix tables ...
+  //--
+
+public:
+  enum {
+    PREFIXES            = 1000,         // number of three digit zip prefixes
+    NOPREFIX            = 0xFFFFFFFF,   // returned for an invalid zip code
+  };
+  // Results of CheckCity() ...
+  enum CITY_CHECK {
+    CITY_UNKNOWN,                       // we don't know this city
+    CITY_MATCH,                         // the zip code is right for the city
+    CITY_MISMATCH,                      // the zip code is wrong for the city
+  };
+
+  // The constructor and destructor are private - everything here is static!
+private:
+  CZipCodes() {};
+  virtual ~CZipCodes() {};
+  // Copy and assignment constructors ...
+  CZipCodes (const CZipCodes &z) = delete;
+  CZipCodes& operator= (const CZipCodes &z) = delete;
+
+  // CZipCodes public methods ...
+public:
+  // Return the three digit prefix of a zip code, or NOPREFIX ...
+  static uint32_t GetPrefix (const string &sZip);
+  // Return the state for a zip code, or NULL if we don't know ...
+  static const char *GetState (const string &sZip);
+  // Return true if the zip code is in the state given ...
+  static bool IsInState (const string &sZip, const string &sState);
+  // Check a city name against a zip code ...
+  static CITY_CHECK CheckCity (const string &sCity, const string &sZip);
+
+  // Private internal CZipCodes methods ...
+private:
+  // Build the prefix to state table ...
+  static bool BuildStates (const char *apszStates[]);
+  // Compare a city name with one of our table entries ...
+  static int CompareCity (const string &sCity, const char *pszCity);
+};